@@ -36,6 +36,13 @@
 #include "mem.h"
 #include "doorway.h"
 #include "string.h"
+#include "args.h"
+#include "ddio.h"
+#include "CFILE.H"
+#include "descent.h"
+#include <atomic>
+#include <thread>
+#include <vector>
 
 #define BOA_VERSION 25
 
@@ -954,240 +961,252 @@ void compute_costs()
 	}
 }
 
-void update_path_info(q_item* node_list[MAX_ROOMS], int start, int end)
-{
-	int cur_room;
-	int par_room;
+#define BOA_NUM_NODES		(MAX_ROOMS + MAX_BOA_TERRAIN_REGIONS)
 
-	while (end != start)
-	{
-		cur_room = end;
-		par_room = node_list[end]->parent;
+// Parent value for nodes the search never reached
+#define BOA_UNREACHED		-2
 
-		while (par_room != -1)
-		{
-			BOA_Array[par_room][end] = cur_room;
+// Search state for FindPath.  Everything is kept in flat arrays so a search never allocates and
+// one of these can be reused for every search a thread does.
+struct boa_search
+{
+	float cost[BOA_NUM_NODES];
+	short parent[BOA_NUM_NODES];
+	ubyte state[BOA_NUM_NODES];		// see BSS_ defines
+	short queue[BOA_NUM_NODES];
+	int queue_len;
+	bool unstable;					// set if a node's path changed after it was popped
+};
 
-			cur_room = node_list[cur_room]->parent;
-			par_room = node_list[cur_room]->parent;
-		}
+#define BSS_UNSEEN		0
+#define BSS_QUEUED		1
+#define BSS_POPPED		2
 
-		end = node_list[end]->parent;
+// Pops the cheapest node off the queue.  The queue behaves exactly like the old linked list pq:
+// new nodes go on the head, and ties go to whichever node is closest to the head.  The head is
+// the end of the array here.
+static int boa_pop(boa_search* search)
+{
+	if (search->queue_len == 0)
+		return -1;
+
+	int best = search->queue_len - 1;
+	for (int i = search->queue_len - 2; i >= 0; i--)
+	{
+		if (search->cost[search->queue[i]] < search->cost[search->queue[best]])
+			best = i;
 	}
+
+	int node = search->queue[best];
+	search->queue_len--;
+	memmove(&search->queue[best], &search->queue[best + 1], (search->queue_len - best) * sizeof(short));
+
+	return node;
 }
 
-void FindPath(int i, int j)
+// Runs a search from start, stopping once stop_at is popped.  If stop_at is -1, the whole
+// graph is searched.  Returns true if stop_at was reached.
+// Only reads level data, so searches for different starts can run at the same time.
+static bool boa_search_run(boa_search* search, int start, int stop_at)
 {
-	pq PQPath;
 	int counter;
-	q_item* start_node = new q_item(BOA_INDEX(i), -1, 0.0);
-	q_item* cur_node;
+	int cur;
 
-	q_item* node_list[MAX_ROOMS + MAX_BOA_TERRAIN_REGIONS];
-
-	//	mprintf((0, "Find path for %d to %d\n", i, j));
-
-	if (i == -1 || j == -1)
+	for (counter = 0; counter <= Highest_room_index + MAX_BOA_TERRAIN_REGIONS; counter++)
 	{
-		delete start_node;
-		return;
+		search->parent[counter] = BOA_UNREACHED;
+		search->state[counter] = BSS_UNSEEN;
 	}
+	search->queue_len = 0;
+	search->unstable = false;
 
-	memset(node_list, 0, sizeof(q_item*) * (MAX_ROOMS + MAX_BOA_TERRAIN_REGIONS));
-
-	PQPath.push(start_node);
-	ASSERT(start_node->roomnum <= Highest_room_index + BOA_num_terrain_regions);
+	start = BOA_INDEX(start);
+	ASSERT(start <= Highest_room_index + BOA_num_terrain_regions);
+	search->cost[start] = 0.0f;
+	search->parent[start] = -1;
+	search->state[start] = BSS_QUEUED;
+	search->queue[search->queue_len++] = start;
 
-	while (cur_node = PQPath.pop())
+	while ((cur = boa_pop(search)) != -1)
 	{
-		node_list[BOA_INDEX(cur_node->roomnum)] = cur_node;
-		ASSERT(BOA_INDEX(cur_node->roomnum) >= 0 && BOA_INDEX(cur_node->roomnum) <= Highest_room_index + MAX_BOA_TERRAIN_REGIONS);
+		ASSERT(cur >= 0 && cur <= Highest_room_index + MAX_BOA_TERRAIN_REGIONS);
+		search->state[cur] = BSS_POPPED;
+
+		if (cur == stop_at)
+			return true;
 
-		if (cur_node->roomnum == j)
+		int num_portals;
+		bool f_room = true;
+		int t_index;
+
+		if (cur <= Highest_room_index)
 		{
-			update_path_info(node_list, i, j);
-			goto done;
+			num_portals = Rooms[cur].num_portals;
 		}
-
-		if (i > j)
+		else
 		{
-			int num_portals;
-			bool f_room = true;
-			int t_index;
-
-			if (cur_node->roomnum <= Highest_room_index)
-			{
-				num_portals = Rooms[cur_node->roomnum].num_portals;
-			}
-			else
-			{
-				t_index = cur_node->roomnum - Highest_room_index - 1;
-				num_portals = BOA_num_connect[t_index];
-				f_room = false;
-			}
-
-			for (counter = 0; counter < num_portals; counter++)
-			{
-				int next_room;
-				q_item* list_item;
-				float new_cost;
+			t_index = cur - Highest_room_index - 1;
+			num_portals = BOA_num_connect[t_index];
+			f_room = false;
+		}
 
-				if (!BOA_PassablePortal(cur_node->roomnum, counter))
-					continue;
+		for (counter = 0; counter < num_portals; counter++)
+		{
+			int next_room;
+			float new_cost;
 
-				if (f_room)
-					next_room = Rooms[cur_node->roomnum].portals[counter].croom;
-				else
-					next_room = BOA_connect[t_index][counter].roomnum;
+			if (!BOA_PassablePortal(cur, counter))
+				continue;
 
-				if (next_room < 0 || next_room == BOA_NO_PATH)
-					continue;
+			if (f_room)
+				next_room = Rooms[cur].portals[counter].croom;
+			else
+				next_room = BOA_connect[t_index][counter].roomnum;
 
-				if ((next_room <= Highest_room_index) && (Rooms[next_room].flags & RF_EXTERNAL))
-				{
-					ASSERT(cur_node->roomnum <= Highest_room_index);
+			if (next_room < 0 || next_room == BOA_NO_PATH)
+				continue;
 
-					int cell = GetTerrainCellFromPos(&Rooms[cur_node->roomnum].portals[counter].path_pnt);
-					ASSERT(cell >= 0 && cell < TERRAIN_WIDTH * TERRAIN_DEPTH);
+			if ((next_room <= Highest_room_index) && (Rooms[next_room].flags & RF_EXTERNAL))
+			{
+				ASSERT(cur <= Highest_room_index);
 
-					next_room = Highest_room_index + TERRAIN_REGION(cell) + 1;
-					ASSERT(next_room <= Highest_room_index + BOA_num_terrain_regions);
-				}
+				int cell = GetTerrainCellFromPos(&Rooms[cur].portals[counter].path_pnt);
+				ASSERT(cell >= 0 && cell < TERRAIN_WIDTH * TERRAIN_DEPTH);
 
-				int next_portal;
-				if (BOA_INDEX(next_room) != BOA_INDEX(cur_node->roomnum))
-				{
-					next_portal = BOA_DetermineStartRoomPortal(next_room, NULL, cur_node->roomnum, NULL);
-				}
+				next_room = Highest_room_index + TERRAIN_REGION(cell) + 1;
+				ASSERT(next_room <= Highest_room_index + BOA_num_terrain_regions);
+			}
 
-				new_cost = cur_node->cost + BOA_cost_array[BOA_INDEX(cur_node->roomnum)][counter] + BOA_cost_array[BOA_INDEX(next_room)][next_portal];
+			int next_portal;
+			if (BOA_INDEX(next_room) != BOA_INDEX(cur))
+			{
+				next_portal = BOA_DetermineStartRoomPortal(next_room, NULL, cur, NULL);
+			}
 
-				list_item = node_list[BOA_INDEX(next_room)];
-				if (list_item != NULL && list_item->cost <= new_cost)
-					continue;
+			new_cost = search->cost[cur] + BOA_cost_array[BOA_INDEX(cur)][counter] + BOA_cost_array[BOA_INDEX(next_room)][next_portal];
 
-				if (list_item == NULL)
-				{
-					list_item = new q_item(BOA_INDEX(next_room), cur_node->roomnum, new_cost);
-					node_list[BOA_INDEX(next_room)] = list_item;
-					PQPath.push(list_item);
-					ASSERT(list_item->roomnum <= Highest_room_index + BOA_num_terrain_regions);
-				}
-				else
-				{
-					list_item->cost = new_cost;
-					list_item->parent = cur_node->roomnum;
-				}
-			}
-		}
-		else
-		{
-			int num_portals;
-			bool f_room = true;
-			int t_index;
+			int next = BOA_INDEX(next_room);
+			if (search->state[next] != BSS_UNSEEN && search->cost[next] <= new_cost)
+				continue;
 
-			if (cur_node->roomnum <= Highest_room_index)
+			if (search->state[next] == BSS_UNSEEN)
 			{
-				num_portals = Rooms[cur_node->roomnum].num_portals;
+				search->state[next] = BSS_QUEUED;
+				search->queue[search->queue_len++] = next;
+				ASSERT(next <= Highest_room_index + BOA_num_terrain_regions);
 			}
-			else
+			else if (search->state[next] == BSS_POPPED)
 			{
-				t_index = cur_node->roomnum - Highest_room_index - 1;
-				num_portals = BOA_num_connect[t_index];
-				f_room = false;
+				// Only possible with negative costs.  The paths of nodes popped before now may
+				// change, so this search's tree can't stand in for searches stopped earlier.
+				search->unstable = true;
 			}
 
-			for (counter = 0; counter < num_portals; counter++)
-			{
-				int next_room;
-				q_item* list_item;
-				float new_cost;
+			search->cost[next] = new_cost;
+			search->parent[next] = cur;
+		}
+	}
 
-				if (!BOA_PassablePortal(cur_node->roomnum, counter))
-					continue;
+	return false;
+}
 
-				if (f_room)
-					next_room = Rooms[cur_node->roomnum].portals[counter].croom;
-				else
-					next_room = BOA_connect[t_index][counter].roomnum;
+// Fills in the next room for every pair of rooms along the path from start to end
+void update_path_info(const short* parent, int start, int end)
+{
+	int cur_room;
+	int par_room;
 
-				if (next_room < 0 || next_room == BOA_NO_PATH)
-					continue;
+	while (end != start)
+	{
+		cur_room = end;
+		par_room = parent[end];
 
-				if ((next_room <= Highest_room_index) && (Rooms[next_room].flags & RF_EXTERNAL))
-				{
-					ASSERT(cur_node->roomnum <= Highest_room_index);
-					int cell = GetTerrainCellFromPos(&Rooms[cur_node->roomnum].portals[counter].path_pnt);
-					ASSERT(cell != -1);		//DAJ -1FIX
-					next_room = Highest_room_index + TERRAIN_REGION(cell) + 1;
-				}
+		while (par_room != -1)
+		{
+			BOA_Array[par_room][end] = cur_room;
 
-				int next_portal;
-				if (BOA_INDEX(next_room) != BOA_INDEX(cur_node->roomnum))
-				{
-					next_portal = BOA_DetermineStartRoomPortal(next_room, NULL, cur_node->roomnum, NULL);
-				}
+			cur_room = parent[cur_room];
+			par_room = parent[cur_room];
+		}
 
-				new_cost = cur_node->cost + BOA_cost_array[BOA_INDEX(cur_node->roomnum)][counter] + BOA_cost_array[BOA_INDEX(next_room)][next_portal];
+		end = parent[end];
+	}
+}
 
-				list_item = node_list[BOA_INDEX(next_room)];
-				if (list_item != NULL && list_item->cost <= new_cost)
-					continue;
+void FindPath(boa_search* search, int i, int j)
+{
+	//	mprintf((0, "Find path for %d to %d\n", i, j));
 
-				if (list_item == NULL)
-				{
-					list_item = new q_item(BOA_INDEX(next_room), cur_node->roomnum, new_cost);
-					node_list[BOA_INDEX(next_room)] = list_item;
-					PQPath.push(list_item);
-					ASSERT(list_item->roomnum <= Highest_room_index + BOA_num_terrain_regions);
-				}
-				else
-				{
-					list_item->cost = new_cost;
-					list_item->parent = cur_node->roomnum;
-				}
-			}
-		}
+	if (i == -1 || j == -1)
+		return;
+
+	if (boa_search_run(search, i, j))
+	{
+		update_path_info(search->parent, i, j);
+		return;
 	}
 
 	//Mark as an impossible path.
 	BOA_Array[i][j] = BOA_NO_PATH;
 
 	//	mprintf((0, "Found an impossible path\n"));
+}
 
-done:
-	for (counter = 0; counter <= Highest_room_index + MAX_BOA_TERRAIN_REGIONS; counter++)
-	{
-		if (node_list[counter]) delete node_list[counter];
-	}
+// Determines if compute_next_segs finds paths starting from node i
+static bool boa_is_path_node(int i)
+{
+	if (i <= Highest_room_index && (!Rooms[i].used))
+		return false;
+
+	if (i <= Highest_room_index && (Rooms[i].flags & RF_EXTERNAL))
+		return false;
+
+	if (i > Highest_room_index + BOA_num_terrain_regions)
+		return false;
 
-	return;
+	return true;
 }
 
-void compute_next_segs()
+// Shared state for the threads building path trees
+struct boa_tree_work
 {
-	int i, j;
+	short(*trees)[BOA_NUM_NODES];		// parent of every node in the full search from each start
+	bool* unstable;
+	std::atomic<int> next_start;
+};
 
-	for (i = 0; i <= Highest_room_index + MAX_BOA_TERRAIN_REGIONS; i++)
+static void boa_build_trees(boa_tree_work* work, boa_search* search)
+{
+	int i;
+
+	while ((i = work->next_start++) <= Highest_room_index + BOA_num_terrain_regions)
 	{
-		if (i <= Highest_room_index && (!Rooms[i].used))
+		if (!boa_is_path_node(i))
 			continue;
 
-		if (i <= Highest_room_index && (Rooms[i].flags & RF_EXTERNAL))
-			continue;
+		boa_search_run(search, i, -1);
+		memcpy(work->trees[i], search->parent, sizeof(work->trees[i]));
+		work->unstable[i] = search->unstable;
+	}
+}
 
-		if (i > Highest_room_index + BOA_num_terrain_regions)
+// Walks every pair in the same order as the original implementation, so pairs that get filled
+// in by an earlier path are skipped and overwritten exactly like before.
+// If trees is NULL, every path gets its own search.  Otherwise the path from i to j is read out
+// of the full search tree from i, which is the same tree the search stopped at j would have
+// built, unless the search from i was unstable.
+static void boa_fill_next_segs(short(*trees)[BOA_NUM_NODES], bool* unstable, boa_search* search)
+{
+	int i, j;
+
+	for (i = 0; i <= Highest_room_index + MAX_BOA_TERRAIN_REGIONS; i++)
+	{
+		if (!boa_is_path_node(i))
 			continue;
 
 		for (j = Highest_room_index + MAX_BOA_TERRAIN_REGIONS; j >= 0; j--)
 		{
-			if (j <= Highest_room_index && (!Rooms[j].used))
-				continue;
-
-			if (j <= Highest_room_index && (Rooms[j].flags & RF_EXTERNAL))
-				continue;
-
-			if (j > Highest_room_index + BOA_num_terrain_regions)
+			if (!boa_is_path_node(j))
 				continue;
 
 			if (i == Highest_room_index + 1 && j > Highest_room_index)
@@ -1204,12 +1223,88 @@ void compute_next_segs()
 				continue;
 			}
 
-			if (i != j && BOA_Array[i][j] == i) FindPath(i, j);
-			if (i != j && BOA_Array[j][i] == j) FindPath(j, i);
+			for (int pass = 0; pass < 2; pass++)
+			{
+				int from = pass ? j : i;
+				int to = pass ? i : j;
+
+				if (from == to || BOA_Array[from][to] != from)
+					continue;
+
+				if (!trees || unstable[from])
+					FindPath(search, from, to);
+				else if (trees[from][to] != BOA_UNREACHED)
+					update_path_info(trees[from], from, to);
+				else
+					BOA_Array[from][to] = BOA_NO_PATH;
+			}
 		}
 	}
 }
 
+// Finds the next room on the path between every pair of rooms
+// The searches are independent, so one full search per room is run across all cores first.
+// Filling in BOA_Array from those is cheap and has to happen in the original order to give the same results.
+void compute_next_segs()
+{
+	int num_threads = std::thread::hardware_concurrency();
+	if (num_threads < 1)
+		num_threads = 1;
+
+	boa_tree_work work;
+	work.trees = (short(*)[BOA_NUM_NODES])mem_malloc(sizeof(short) * BOA_NUM_NODES * BOA_NUM_NODES);
+	work.unstable = (bool*)mem_malloc(sizeof(bool) * BOA_NUM_NODES);
+	work.next_start = 0;
+	boa_search* searches = (boa_search*)mem_malloc(sizeof(boa_search) * num_threads);
+	ASSERT(work.trees && work.unstable && searches);
+
+	std::vector<std::thread> threads;
+	for (int t = 1; t < num_threads; t++)
+		threads.push_back(std::thread(boa_build_trees, &work, &searches[t]));
+
+	boa_build_trees(&work, &searches[0]);
+
+	for (std::thread& thread : threads)
+		thread.join();
+
+	boa_fill_next_segs(work.trees, work.unstable, &searches[0]);
+
+	mem_free(searches);
+	mem_free(work.unstable);
+	mem_free(work.trees);
+}
+
+// Times compute_next_segs against the old one search per pair approach, and makes sure they agree
+static void benchmark_next_segs()
+{
+	int size = sizeof(BOA_Array);
+	unsigned short* start_state = (unsigned short*)mem_malloc(size);
+	unsigned short* serial_result = (unsigned short*)mem_malloc(size);
+	boa_search* search = (boa_search*)mem_malloc(sizeof(boa_search));
+	ASSERT(start_state && serial_result && search);
+
+	memcpy(start_state, BOA_Array, size);
+
+	double start_time = timer_GetTime64();
+	boa_fill_next_segs(NULL, NULL, search);
+	double serial_time = timer_GetTime64() - start_time;
+	memcpy(serial_result, BOA_Array, size);
+
+	memcpy(BOA_Array, start_state, size);
+	start_time = timer_GetTime64();
+	compute_next_segs();
+	double parallel_time = timer_GetTime64() - start_time;
+
+	bool match = memcmp(serial_result, BOA_Array, size) == 0;
+	mprintf((0, "BOA benchmark: %d rooms, serial %.3fs, parallel %.3fs (%d threads), results %s\n",
+		Highest_room_index + 1, serial_time, parallel_time, std::thread::hardware_concurrency(), match ? "match" : "DIFFER"));
+	ASSERT(match);
+
+	mem_free(search);
+	mem_free(serial_result);
+	mem_free(start_state);
+}
+
 void compute_blockage_info()
 {
 	int i, j;
@@ -2249,7 +2344,10 @@ void MakeBOA(void)
 	mprintf((0, "  Done computing %d terrain regions.\n", BOA_num_terrain_regions));
 
 	mprintf((0, "  Making designers wait for no particular reason...\n"));
-	compute_next_segs();
+	if (FindArg("-boabench"))
+		benchmark_next_segs();
+	else
+		compute_next_segs();
 	mprintf((0, "  Done with the sodomy...\n"));
 
 	mprintf((0, "  Start computing blockage info.\n"));
@@ -3354,3 +3452,447 @@ void ComputeAABB(bool f_full)
 
 	mprintf((0, "Done Computing AABB's.\n"));
 }
+
+#ifndef NEWEDITOR
+//
+//	BOA cache
+//
+// Levels without up to date BOA or AABB chunks have to build them on every load, so whatever gets
+// built is saved under the user directory and mapped back in the next time the same mine is loaded.
+
+#define BOA_CACHE_ID		"BOAC"
+#define BOA_CACHE_VERSION	1
+
+struct boa_cache_header
+{
+	char id[4];
+	int version;
+	int boa_version;
+	int max_rooms;
+	int max_path_portals;
+	int size;						// size of the whole file, to catch partial writes
+	int mine_checksum;
+	uint geometry_hash;
+	int highest_room_index;
+	int num_mines;
+	int num_terrain_regions;
+};
+
+// The mine checksum is only a sum, so the file name uses it but everything the cached data depends
+// on is hashed as well before the data is trusted.
+static uint boa_cache_hash(uint hash, const void* data, int len)
+{
+	const ubyte* bytes = (const ubyte*)data;
+
+	for (int i = 0; i < len; i++)
+	{
+		hash ^= bytes[i];
+		hash *= 16777619;
+	}
+
+	return hash;
+}
+
+static uint BOAGetGeometryHash()
+{
+	uint hash = 2166136261;
+	int i, j;
+
+	hash = boa_cache_hash(hash, &Highest_room_index, sizeof(int));
+
+	for (i = 0; i <= Highest_room_index; i++)
+	{
+		room* rp = &Rooms[i];
+
+		if (!rp->used)
+			continue;
+
+		int flags = rp->flags & (RF_EXTERNAL | RF_DOOR | RF_MANUAL_PATH_PNT);
+		hash = boa_cache_hash(hash, &i, sizeof(int));
+		hash = boa_cache_hash(hash, &flags, sizeof(int));
+		if (flags & RF_MANUAL_PATH_PNT)
+			hash = boa_cache_hash(hash, &rp->path_pnt, sizeof(vector));
+
+		hash = boa_cache_hash(hash, &rp->num_verts, sizeof(rp->num_verts));
+		hash = boa_cache_hash(hash, rp->verts, rp->num_verts * sizeof(vector));
+
+		hash = boa_cache_hash(hash, &rp->num_faces, sizeof(rp->num_faces));
+		for (j = 0; j < rp->num_faces; j++)
+		{
+			face* fp = &rp->faces[j];
+			hash = boa_cache_hash(hash, &fp->num_verts, sizeof(fp->num_verts));
+			hash = boa_cache_hash(hash, fp->face_verts, fp->num_verts * sizeof(short));
+		}
+
+		hash = boa_cache_hash(hash, &rp->num_portals, sizeof(rp->num_portals));
+		for (j = 0; j < rp->num_portals; j++)
+		{
+			portal* pp = &rp->portals[j];
+			int data[5];
+
+			// Passability depends on these flags and on whether the portal face can be broken
+			data[0] = pp->flags & (PF_BLOCK | PF_BLOCK_REMOVABLE | PF_RENDER_FACES | PF_RENDERED_FLYTHROUGH);
+			data[1] = pp->portal_face;
+			data[2] = pp->croom;
+			data[3] = pp->cportal;
+			data[4] = GameTextures[rp->faces[pp->portal_face].tmap].flags & (TF_BREAKABLE | TF_FORCEFIELD);
+			hash = boa_cache_hash(hash, data, sizeof(data));
+		}
+	}
+
+	for (i = 0; i < TERRAIN_WIDTH * TERRAIN_DEPTH; i++)
+		hash = boa_cache_hash(hash, &Terrain_seg[i].ypos, sizeof(ubyte));
+
+	return hash;
+}
+
+static void BOAGetCacheFilename(char* filename, int checksum)
+{
+	char name[_MAX_PATH];
+
+	sprintf(name, "boa%08x.cache", (uint)checksum);
+	ddio_MakePath(filename, User_directory, "boacache", name, NULL);
+}
+
+// Reads pieces of a mapped cache file, failing on anything past the end
+struct boa_cache_reader
+{
+	const ubyte* data;
+	int size;
+	int pos;
+
+	bool Read(void* dest, int len)
+	{
+		if (len < 0 || pos + len > size)
+			return false;
+
+		memcpy(dest, data + pos, len);
+		pos += len;
+		return true;
+	}
+
+	// Returns a pointer to the data, or NULL if it runs off the end
+	const ubyte* Skip(int len)
+	{
+		if (len < 0 || pos + len > size)
+			return NULL;
+
+		const ubyte* ret = data + pos;
+		pos += len;
+		return ret;
+	}
+};
+
+static bool BOAReadCacheRoomAABB(boa_cache_reader* reader, room* rp)
+{
+	int j;
+
+	for (j = 0; j < rp->num_faces; j++)
+	{
+		if (!reader->Read(&rp->faces[j].min_xyz, sizeof(vector)) || !reader->Read(&rp->faces[j].max_xyz, sizeof(vector)))
+			return false;
+	}
+
+	short num_regions;
+	if (!reader->Read(&rp->bbf_min_xyz, sizeof(vector)) || !reader->Read(&rp->bbf_max_xyz, sizeof(vector)) ||
+		!reader->Read(&num_regions, sizeof(short)))
+		return false;
+
+	const short* num_bbf = (const short*)reader->Skip(num_regions * sizeof(short));
+	if (!num_bbf)
+		return false;
+
+	if (rp->num_bbf_regions != 0)
+	{
+		for (j = 0; j < rp->num_bbf_regions; j++)
+			mem_free(rp->bbf_list[j]);
+
+		mem_free(rp->bbf_list);
+		mem_free(rp->num_bbf);
+		mem_free(rp->bbf_list_min_xyz);
+		mem_free(rp->bbf_list_max_xyz);
+		mem_free(rp->bbf_list_sector);
+		rp->num_bbf_regions = 0;
+	}
+
+	rp->num_bbf = (short*)mem_malloc(sizeof(short) * num_regions);
+	rp->bbf_list = (short**)mem_malloc(sizeof(short*) * num_regions);
+	rp->bbf_list_min_xyz = (vector*)mem_malloc(sizeof(vector) * num_regions);
+	rp->bbf_list_max_xyz = (vector*)mem_malloc(sizeof(vector) * num_regions);
+	rp->bbf_list_sector = (unsigned char*)mem_malloc(sizeof(char) * num_regions);
+	memcpy(rp->num_bbf, num_bbf, sizeof(short) * num_regions);
+
+	for (j = 0; j < num_regions; j++)
+	{
+		rp->bbf_list[j] = (short*)mem_malloc(sizeof(short) * rp->num_bbf[j]);
+		rp->num_bbf_regions++;
+
+		if (!reader->Read(rp->bbf_list[j], sizeof(short) * rp->num_bbf[j]) ||
+			!reader->Read(&rp->bbf_list_min_xyz[j], sizeof(vector)) ||
+			!reader->Read(&rp->bbf_list_max_xyz[j], sizeof(vector)) ||
+			!reader->Read(&rp->bbf_list_sector[j], sizeof(ubyte)))
+			return false;
+	}
+
+	return rp->num_bbf_regions == num_regions;
+}
+
+static bool BOAReadCache(boa_cache_reader* reader, const boa_cache_header* header, bool f_boa, bool f_aabb)
+{
+	int i, j;
+	int num_nodes = Highest_room_index + MAX_BOA_TERRAIN_REGIONS + 1;
+
+	// BOA tables and the level data MakeBOA fills in
+	for (i = 0; i < num_nodes; i++)
+	{
+		const ubyte* row = reader->Skip(num_nodes * sizeof(short));
+		if (!row)
+			return false;
+		if (f_boa)
+			memcpy(BOA_Array[i], row, num_nodes * sizeof(short));
+	}
+
+	const ubyte* costs = reader->Skip(num_nodes * MAX_PATH_PORTALS * sizeof(float));
+	const ubyte* num_connect = reader->Skip(sizeof(BOA_num_connect));
+	const ubyte* connect = reader->Skip(sizeof(BOA_connect));
+	const ubyte* regions = reader->Skip(TERRAIN_WIDTH * TERRAIN_DEPTH);
+	if (!costs || !num_connect || !connect || !regions)
+		return false;
+
+	if (f_boa)
+	{
+		memcpy(BOA_cost_array, costs, num_nodes * MAX_PATH_PORTALS * sizeof(float));
+		memcpy(BOA_num_connect, num_connect, sizeof(BOA_num_connect));
+		memcpy(BOA_connect, connect, sizeof(BOA_connect));
+		BOA_num_mines = header->num_mines;
+		BOA_num_terrain_regions = header->num_terrain_regions;
+
+		for (i = 0; i < TERRAIN_WIDTH * TERRAIN_DEPTH; i++)
+			Terrain_seg[i].flags = (Terrain_seg[i].flags & ~TFM_REGION_MASK) | (regions[i] << 5);
+	}
+
+	for (i = 0; i <= Highest_room_index; i++)
+	{
+		room* rp = &Rooms[i];
+
+		if (!rp->used)
+			continue;
+
+		int mine;
+		vector path_pnt;
+		if (!reader->Read(&mine, sizeof(int)) || !reader->Read(&path_pnt, sizeof(vector)))
+			return false;
+
+		if (f_boa)
+		{
+			rp->flags = (rp->flags & ~RFM_MINE) | (mine & RFM_MINE);
+			rp->path_pnt = path_pnt;
+		}
+
+		for (j = 0; j < rp->num_portals; j++)
+		{
+			ubyte small_portal;
+			if (!reader->Read(&path_pnt, sizeof(vector)) || !reader->Read(&small_portal, sizeof(ubyte)))
+				return false;
+
+			if (f_boa)
+			{
+				rp->portals[j].path_pnt = path_pnt;
+				if (small_portal)
+					rp->portals[j].flags |= PF_TOO_SMALL_FOR_ROBOT;
+				else
+					rp->portals[j].flags &= ~PF_TOO_SMALL_FOR_ROBOT;
+			}
+		}
+	}
+
+	// Room AABBs
+	if (f_aabb)
+	{
+		for (i = 0; i <= Highest_room_index; i++)
+		{
+			if (!reader->Read(&BOA_AABB_ROOM_checksum[i], sizeof(int)))
+				return false;
+
+			if (Rooms[i].used && !BOAReadCacheRoomAABB(reader, &Rooms[i]))
+				return false;
+		}
+	}
+
+	return true;
+}
+
+// Tries to load the BOA tables (if f_boa) and the room AABBs (if f_aabb) for the current mine from
+// the cache.  Returns true if everything asked for was loaded.
+bool BOA_LoadCache(bool f_boa, bool f_aabb)
+{
+	if (FindArg("-noboacache"))
+		return false;
+
+	char filename[_MAX_PATH];
+	int checksum = BOAGetMineChecksum();
+	BOAGetCacheFilename(filename, checksum);
+
+	int length;
+	ubyte* data = (ubyte*)ddio_MapFile(filename, &length);
+	if (!data)
+		return false;
+
+	boa_cache_reader reader;
+	reader.data = data;
+	reader.size = length;
+	reader.pos = 0;
+
+	boa_cache_header header;
+	bool ok = reader.Read(&header, sizeof(header)) &&
+		!strncmp(header.id, BOA_CACHE_ID, 4) &&
+		header.version == BOA_CACHE_VERSION &&
+		header.boa_version == BOA_VERSION &&
+		header.max_rooms == MAX_ROOMS &&
+		header.max_path_portals == MAX_PATH_PORTALS &&
+		header.size == length &&
+		header.mine_checksum == checksum &&
+		header.highest_room_index == Highest_room_index &&
+		header.geometry_hash == BOAGetGeometryHash();
+
+	if (ok)
+	{
+		ok = BOAReadCache(&reader, &header, f_boa, f_aabb);
+
+		if (!ok)
+		{
+			// Something may have been half loaded, so make sure it all gets rebuilt
+			mprintf((0, "BOA cache %s is damaged\n", filename));
+			BOA_mine_checksum = BOA_AABB_checksum = 0;
+			for (int i = 0; i <= Highest_room_index; i++)
+				BOA_AABB_ROOM_checksum[i] = 0;
+		}
+		else
+		{
+			if (f_boa)
+				BOA_mine_checksum = checksum;
+			if (f_aabb)
+				BOA_AABB_checksum = checksum;
+			mprintf((0, "Loaded BOA from cache %s\n", filename));
+		}
+	}
+
+	ddio_UnmapFile(data, length);
+	return ok;
+}
+
+// Saves the BOA tables and room AABBs for the current mine to the cache
+void BOA_SaveCache()
+{
+	if (FindArg("-noboacache"))
+		return;
+
+	char dirname[_MAX_PATH], filename[_MAX_PATH], tempname[_MAX_PATH];
+	int i, j;
+	int num_nodes = Highest_room_index + MAX_BOA_TERRAIN_REGIONS + 1;
+
+	ddio_MakePath(dirname, User_directory, "boacache", NULL);
+	if (!ddio_DirExists(dirname) && !ddio_CreateDir(dirname))
+		return;
+
+	BOAGetCacheFilename(filename, BOA_mine_checksum);
+
+	// Write to a temp file of our own and rename it over, so two servers sharing a user directory
+	// can't read a half written cache or write into each other's
+	if (!ddio_GetTempFileName(dirname, "boa", tempname))
+		return;
+
+	CFILE* fp = cfopen(tempname, "wb");
+	if (!fp)
+	{
+		ddio_DeleteFile(tempname);
+		return;
+	}
+
+	boa_cache_header header;
+	memcpy(header.id, BOA_CACHE_ID, 4);
+	header.version = BOA_CACHE_VERSION;
+	header.boa_version = BOA_VERSION;
+	header.max_rooms = MAX_ROOMS;
+	header.max_path_portals = MAX_PATH_PORTALS;
+	header.size = 0;
+	header.mine_checksum = BOA_mine_checksum;
+	header.geometry_hash = BOAGetGeometryHash();
+	header.highest_room_index = Highest_room_index;
+	header.num_mines = BOA_num_mines;
+	header.num_terrain_regions = BOA_num_terrain_regions;
+	cf_WriteBytes((ubyte*)&header, sizeof(header), fp);
+
+	for (i = 0; i < num_nodes; i++)
+		cf_WriteBytes((ubyte*)BOA_Array[i], num_nodes * sizeof(short), fp);
+
+	cf_WriteBytes((ubyte*)BOA_cost_array, num_nodes * MAX_PATH_PORTALS * sizeof(float), fp);
+	cf_WriteBytes((ubyte*)BOA_num_connect, sizeof(BOA_num_connect), fp);
+	cf_WriteBytes((ubyte*)BOA_connect, sizeof(BOA_connect), fp);
+
+	for (i = 0; i < TERRAIN_WIDTH * TERRAIN_DEPTH; i++)
+		cf_WriteByte(fp, (Terrain_seg[i].flags & TFM_REGION_MASK) >> 5);
+
+	for (i = 0; i <= Highest_room_index; i++)
+	{
+		room* rp = &Rooms[i];
+
+		if (!rp->used)
+			continue;
+
+		int mine = rp->flags & RFM_MINE;
+		cf_WriteBytes((ubyte*)&mine, sizeof(int), fp);
+		cf_WriteBytes((ubyte*)&rp->path_pnt, sizeof(vector), fp);
+
+		for (j = 0; j < rp->num_portals; j++)
+		{
+			cf_WriteBytes((ubyte*)&rp->portals[j].path_pnt, sizeof(vector), fp);
+			cf_WriteByte(fp, (rp->portals[j].flags & PF_TOO_SMALL_FOR_ROBOT) ? 1 : 0);
+		}
+	}
+
+	for (i = 0; i <= Highest_room_index; i++)
+	{
+		room* rp = &Rooms[i];
+
+		cf_WriteBytes((ubyte*)&BOA_AABB_ROOM_checksum[i], sizeof(int), fp);
+
+		if (!rp->used)
+			continue;
+
+		for (j = 0; j < rp->num_faces; j++)
+		{
+			cf_WriteBytes((ubyte*)&rp->faces[j].min_xyz, sizeof(vector), fp);
+			cf_WriteBytes((ubyte*)&rp->faces[j].max_xyz, sizeof(vector), fp);
+		}
+
+		cf_WriteBytes((ubyte*)&rp->bbf_min_xyz, sizeof(vector), fp);
+		cf_WriteBytes((ubyte*)&rp->bbf_max_xyz, sizeof(vector), fp);
+		cf_WriteBytes((ubyte*)&rp->num_bbf_regions, sizeof(short), fp);
+		cf_WriteBytes((ubyte*)rp->num_bbf, rp->num_bbf_regions * sizeof(short), fp);
+
+		for (j = 0; j < rp->num_bbf_regions; j++)
+		{
+			cf_WriteBytes((ubyte*)rp->bbf_list[j], rp->num_bbf[j] * sizeof(short), fp);
+			cf_WriteBytes((ubyte*)&rp->bbf_list_min_xyz[j], sizeof(vector), fp);
+			cf_WriteBytes((ubyte*)&rp->bbf_list_max_xyz[j], sizeof(vector), fp);
+			cf_WriteByte(fp, rp->bbf_list_sector[j]);
+		}
+	}
+
+	// Now that the size is known, fill it in
+	header.size = cftell(fp);
+	cfseek(fp, 0, SEEK_SET);
+	cf_WriteBytes((ubyte*)&header, sizeof(header), fp);
+	cfclose(fp);
+
+	ddio_DeleteFile(filename);
+	if (!ddio_RenameFile(tempname, filename))
+	{
+		ddio_DeleteFile(tempname);
+		return;
+	}
+
+	mprintf((0, "Saved BOA to cache %s\n", filename));
+}
+#endif
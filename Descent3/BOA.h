@@ -176,4 +176,13 @@ bool BOA_LockedDoor(object *obj, int roomnum);
 void BOA_ComputePathPoints(char *message = NULL, int len = 0);
 int BOAGetMineChecksum ();
 
+#ifndef NEWEDITOR
+// Loads the BOA tables (if f_boa) and room AABBs (if f_aabb) for the current mine from the
+// cache in the user directory.  Returns true if everything asked for was loaded.
+bool BOA_LoadCache(bool f_boa, bool f_aabb);
+
+// Saves the BOA tables and room AABBs for the current mine to the cache
+void BOA_SaveCache();
+#endif
+
 #endif
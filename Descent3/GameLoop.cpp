@@ -94,6 +94,7 @@
 #include "renderobject.h"
 #include "vibeinterface.h"
 #include "gamespy.h"
+#include "timedemo.h"
 
 #ifdef EDITOR
 #include "editor\d3edit.h"
@@ -2022,6 +2023,8 @@ void GameRenderFrame(void)
 			RenderHUDText(GR_RGB(255, 40, 40), 255, 1, x, y, buffer); y += height;
 			sprintf(buffer, "Uploads=%d", stats.texture_uploads);
 			RenderHUDText(GR_RGB(255, 40, 40), 255, 1, x, y, buffer); y += height;
+			sprintf(buffer, "Batches=%d", stats.batch_count);
+			RenderHUDText(GR_RGB(255, 40, 40), 255, 1, x, y, buffer); y += height;
 			grtext_Flush();
 			EndFrame();
 		}
@@ -2399,7 +2402,9 @@ void GameFrame(void)
 		Clear_screen = 4;
 
 	// Setup sound for new frame
+	TIMEDEMO_START(td_sound_begin);
 	Sound_system.BeginSoundFrame();
+	TIMEDEMO_END(TDS_SOUND, td_sound_begin);
 
 #ifdef USE_RTP
 	RTP_GETCLOCK(curr_time);
@@ -2427,17 +2432,21 @@ void GameFrame(void)
 
 		//Global AI Frame Stuff  -- must be before ObjMoveAll
 		RTP_tSTARTTIME(aiframeall_time, curr_time);
+		TIMEDEMO_START(td_ai);
 		if (DoAI)
 			AIFrameAll();
 
 		a_life.DoFrame();
+		TIMEDEMO_END(TDS_AI, td_ai);
 		RTP_tENDTIME(aiframeall_time, curr_time);
 
 		//ApplyShadowsToRooms ();
 
 		//Move objects for this frame
 		RTP_tSTARTTIME(objframe_time, curr_time);
+		TIMEDEMO_START(td_objects);
 		ObjDoFrameAll();
+		TIMEDEMO_END(TDS_OBJECTS, td_objects);
 		RTP_tENDTIME(objframe_time, curr_time);
 
 		RTP_tSTARTTIME(matcenframe_time, curr_time);
@@ -2469,11 +2478,13 @@ void GameFrame(void)
 
 		// Ambient sounds
 		RTP_tSTARTTIME(ambsound_frame_time, curr_time);
+		TIMEDEMO_START(td_sound);
 		DoAmbientSounds();
 		RTP_tENDTIME(ambsound_frame_time, curr_time);
 
 		//Terrain sound
 		UpdateTerrainSound();
+		TIMEDEMO_END(TDS_SOUND, td_sound);
 
 
 		//Call the interval script for the level script
@@ -2502,7 +2513,9 @@ void GameFrame(void)
 
 	// do music always.
 	RTP_tSTARTTIME(musicframe_time, curr_time);
+	TIMEDEMO_START(td_music);
 	GameProcessMusic();
+	TIMEDEMO_END(TDS_SOUND, td_music);
 	RTP_tENDTIME(musicframe_time, curr_time);
 
 	if ((Demo_paused) && (Demo_flags == DF_PLAYBACK) && !is_game_idle)
@@ -2531,10 +2544,12 @@ void GameFrame(void)
 	if (!is_game_idle)
 	{
 		RTP_tSTARTTIME(renderframe_time, curr_time);
+		TIMEDEMO_START(td_render);
 		if (!Skip_render_game_frame)
 			//Render the frame
 			GameRenderFrame();
 
+		TIMEDEMO_END(TDS_RENDER, td_render);
 		RTP_tENDTIME(renderframe_time, curr_time);
 	}
 
@@ -2550,14 +2565,20 @@ void GameFrame(void)
 		if (!Skip_render_game_frame && !Dedicated_server)
 		{
 			if (Game_interface_mode == GAME_INTERFACE && !Menu_interface_mode)
+			{
+				TIMEDEMO_START(td_flip);
 				rend_Flip();
+				TIMEDEMO_END(TDS_RENDER, td_flip);
+			}
 		}
 
 		//float start_delay = timer_GetTime();
 		//Slow down the game if the user asked us to
 		double current_timer = timer_GetTime64();
 		double target_time = last_timer + Min_allowed_frametime;
-		if (current_timer > target_time) //If running slow, drop frames
+		if (Dedicated_server && Dedicated_tick_rate > 0) //Fixed tick rate, handle traffic until the next tick
+			target_time = DedicatedWaitForTick(last_timer);
+		else if (current_timer > target_time || Timedemo_on) //If running slow, drop frames. Timedemos never wait
 			target_time = current_timer;
 		else
 		{
@@ -2602,7 +2623,9 @@ void GameFrame(void)
 
 
 	// End Gameloop Loop stuff
+	TIMEDEMO_START(td_sound_end);
 	Sound_system.EndSoundFrame();
+	TIMEDEMO_END(TDS_SOUND, td_sound_end);
 	DoDestroyedLightsForFrame();
 
 	// Clear lod stuff
@@ -2614,8 +2637,14 @@ void GameFrame(void)
 	if (fvi_graph_id >= 0)
 		DebugGraph_Update(fvi_graph_id, FVI_counter);
 
+	TimedemoEndFrame();
+
 #ifdef USE_RTP
 	RTP_RECORDVALUE(frame_time, Frametime);
+	RTP_COUNTER(Physics_normal_counter, Physics_normal_counter);
+	RTP_COUNTER(Physics_walking_counter, Physics_walking_counter);
+	RTP_COUNTER(FVI_counter, FVI_counter);
+	RTP_COUNTER(FVI_room_counter, FVI_room_counter);
 	rtp_RecordFrame();
 
 	/*
@@ -76,6 +76,7 @@
 #include "soundload.h"
 #include "bnode.h"
 #include "localization.h"
+#include "vclip.h"
 
 #ifdef EDITOR
 #include "editor\d3edit.h"
@@ -2675,6 +2676,8 @@ int LoadLevel(char* filename, void (*cb_fn)(const char*, int, int))
 
 	int version;
 	bool f_read_AABB = false;
+	bool f_need_BOA = false;
+	bool f_cached = false;
 	bool no_128s = true;
 	int total = 0;
 #ifdef EDITOR
@@ -3193,6 +3196,15 @@ int LoadLevel(char* filename, void (*cb_fn)(const char*, int, int))
 	// aabbs
 	LoadLevelProgress(LOAD_PROGRESS_LOADING_LEVEL, 1.0f, NULL);
 
+#ifndef NEWEDITOR
+	//Pick up whatever the level file didn't have from the BOA cache
+	f_need_BOA = (BOA_mine_checksum != BOAGetMineChecksum());
+	if (f_need_BOA || !f_read_AABB)
+		f_cached = BOA_LoadCache(f_need_BOA, !f_read_AABB);
+	if (f_cached)
+		f_read_AABB = true;
+#endif
+
 	//Compute the bounding boxes
 	if (!f_read_AABB)
 		ComputeAABB(true);
@@ -3204,6 +3216,9 @@ int LoadLevel(char* filename, void (*cb_fn)(const char*, int, int))
 
 #ifndef NEWEDITOR /* we call MakeBoa AFTER textures are marked in use */
 	MakeBOA();
+
+	if ((f_need_BOA || !f_read_AABB) && !f_cached)
+		BOA_SaveCache();
 #endif
 
 	// Decrement lightmap counters - this must be done because multiple faces can 
@@ -3272,6 +3287,10 @@ int LoadLevel(char* filename, void (*cb_fn)(const char*, int, int))
 
 	ConsolidateMineMirrors();
 
+	//[ISB] Bake the static room geometry for the new renderer
+	if (!Dedicated_server)
+		MeshRooms();
+
 	// paging data.
 	LoadLevelProgress(LOAD_PROGRESS_PAGING_DATA, 0.0f, NULL);
 
@@ -4569,16 +4588,34 @@ ubyte texture_counted[MAX_BITMAPS];
 ubyte sound_counted[MAX_SOUNDS];
 ubyte poly_counted[MAX_POLY_MODELS];
 
+// Bitmaps of non-animated level textures that aren't resident yet.  PageInLevelBitmaps() decodes
+// these in parallel before the rest of the data is paged in.
+short Level_bitmaps_to_page[MAX_BITMAPS];
+int Num_level_bitmaps_to_page = 0;
+
 
 void AlmostPageInLevelTexture(int id)
 {
 	if (id == -1 || id == 0)
 		return;
 
-	if ((texture_counted[id] == 0) && (GameBitmaps[id].flags & BF_NOT_RESIDENT))
+	if (texture_counted[id] || !GameTextures[id].used)
+		return;
+
+	// Animated textures page in a vclip, everything else pages in a single bitmap
+	bool resident;
+	if (GameTextures[id].flags & TF_ANIMATED)
+		resident = !(GameVClips[GameTextures[id].bm_handle].flags & VCF_NOT_RESIDENT);
+	else
+		resident = !(GameBitmaps[GameTextures[id].bm_handle].flags & BF_NOT_RESIDENT);
+
+	if (!resident)
 	{
 		texture_counted[id] = 1;
 		need_to_page_num++;
+
+		if (!(GameTextures[id].flags & TF_ANIMATED))
+			Level_bitmaps_to_page[Num_level_bitmaps_to_page++] = GameTextures[id].bm_handle;
 		/*
 		//Get the size and add it to the count
 		CFILE * infile = cfopen (GameBitmaps[id].name,"rb");
@@ -5008,6 +5045,7 @@ int CountDataToPageIn()
 
 	need_to_page_num = 0;
 	need_to_page_in = 0;
+	Num_level_bitmaps_to_page = 0;
 
 	int i;
 
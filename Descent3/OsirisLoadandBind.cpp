@@ -36,6 +36,13 @@
 #include "player.h"
 #include "gamecinematics.h"
 #include "demofile.h"
+#include "args.h"
+#include "../md5/md5.h"
+
+#if defined(__LINUX__) && !defined(MACOSX)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
 
 #ifdef _DEBUG
 #define OSIRISDEBUG
@@ -127,11 +134,16 @@ struct
 
 #define OESF_USED		0x0001
 #define OESF_MISSION	0x0002	//mission dlls
+//	Scripts are only pulled out of their hog when a level actually loads them.  They go into
+//	a memfd where the platform allows it, otherwise into the script cache directory under the
+//	MD5 of their contents, so an unchanged script is written to disk once and then reused.
 struct tExtractedScriptInfo
 {
 	ubyte flags;
-	char* temp_filename;
-	char* real_filename;
+	char* temp_filename;	//name of the file in the script cache, NULL until extracted
+	char* real_filename;	//name the script is looked up by (no extension)
+	char* lib_filename;		//name of the script inside the hog
+	int mem_fd;				//memfd holding the script, -1 if none
 };
 tExtractedScriptInfo OSIRIS_Extracted_scripts[MAX_LOADED_MODULES];
 char* OSIRIS_Extracted_script_dir = NULL;
@@ -191,6 +203,8 @@ void Osiris_ShutdownModuleLoader(void)
 }
 
 
+static void osiris_BenchmarkTimers(void);
+
 //	Osiris_InitModuleLoader
 //	Purpose:
 //		Initializes the OSIRIS module loader and handling system
@@ -233,6 +247,9 @@ void Osiris_InitModuleLoader(void)
 	tOSIRISCurrentMission.mission_loaded = false;
 	tOSIRISCurrentMission.dll_id = 0;
 
+	Osiris_ResetAllTimers();
+	if (FindArg("-timerbench"))
+		osiris_BenchmarkTimers();
 	Osiris_InitMemoryManager();
 	Osiris_InitOMMS();
 
@@ -571,14 +588,14 @@ int _get_full_path_to_module(char* module_name, char* fullpath, char* basename)
 		if (!OSIRIS_Extracted_script_dir)
 			return -2;
 
-		//search through our list of extracted files to find it...
+		//search through our list of scripts in hogs to find it...
 		for (int i = 0; i < MAX_LOADED_MODULES; i++) {
 			if (OSIRIS_Extracted_scripts[i].flags & OESF_USED)
 			{
 				if (!stricmp(basename, OSIRIS_Extracted_scripts[i].real_filename))
 				{
-					//this is it
-					ddio_MakePath(fullpath, OSIRIS_Extracted_script_dir, OSIRIS_Extracted_scripts[i].temp_filename, NULL);
+					//this is it, it gets extracted when it is loaded
+					strcpy(fullpath, OSIRIS_Extracted_scripts[i].lib_filename);
 					return i;
 				}
 			}
@@ -592,6 +609,18 @@ int _get_full_path_to_module(char* module_name, char* fullpath, char* basename)
 	return -2;
 }
 
+bool _load_extracted_script(module* mod, int id, char* fullpath);
+
+//	Loads the module found by _get_full_path_to_module(), pulling it out of its hog first
+//	if it hasn't been extracted yet
+bool _load_module_file(module* mod, char* fullpath, int extracted_id)
+{
+	if (extracted_id < 0)
+		return mod_LoadModule(mod, fullpath);
+
+	return _load_extracted_script(mod, extracted_id, fullpath);
+}
+
 //	Osiris_LoadLevelModule
 //	Purpose:
 //		Given a module name, it will attempt to load the module as a level module.  If it succeeds
@@ -668,7 +697,7 @@ int Osiris_LoadLevelModule(char* module_name)
 	}
 
 	//the module exists, now attempt to load it
-	if (!mod_LoadModule(&OSIRIS_loaded_modules[loaded_id].mod, fullpath))
+	if (!_load_module_file(&OSIRIS_loaded_modules[loaded_id].mod, fullpath, ret_val))
 	{
 		//there was an error trying to load the module
 		mprintf((0, "OSIRIS: Osiris_LoadLevelModule(%s): Unable to load module\n", module_name));
@@ -883,7 +912,7 @@ int Osiris_LoadGameModule(char* module_name)
 	}
 
 	//the module exists, now attempt to load it
-	if (!mod_LoadModule(&OSIRIS_loaded_modules[loaded_id].mod, fullpath))
+	if (!_load_module_file(&OSIRIS_loaded_modules[loaded_id].mod, fullpath, ret_val))
 	{
 		//there was an error trying to load the module
 		mprintf((0, "OSIRIS: Osiris_LoadGameModule(%s): Unable to load module\n", module_name));
@@ -2057,12 +2086,13 @@ bool Osiris_CallEvent(object* obj, int event, tOSIRISEventInfo* data)
 	return (bool)((ret & CONTINUE_DEFAULT) != 0);
 }
 
-#define MAX_OSIRIS_TIMERS	64
+#define MAX_OSIRIS_TIMERS	16384
 #define OITF_USED			0x0001
 #define OITF_REPEATCALL		0x0002
 #define OITF_TRIGGERTIMER	0x0004
 #define OITF_LEVELTIMER		0x0008
 #define OITF_CANCELONDEAD	0x0010
+#define OITF_DETONATED		0x0020		//the detonator died, cancel at the next Osiris_ProcessTimers
 struct tOSIRISINTERNALTIMER
 {
 	ushort flags;
@@ -2078,153 +2108,504 @@ struct tOSIRISINTERNALTIMER
 	float timer_interval;
 	float timer_next_signal;
 	float timer_end;
+
+	//scheduling, not saved
+	float key;					//when this timer next needs looking at
+	int heap_index;				//-1 if not in Osiris_timer_heap
+	int obj_list, obj_prev, obj_next;	//object number whose list of owned timers this is in, or -1
+	int det_list, det_prev, det_next;	//object number whose list of detonated timers this is in, or -1
 };
 tOSIRISINTERNALTIMER OsirisTimers[MAX_OSIRIS_TIMERS];
 
+//Live timers, as a min-heap on key.  Only timers that are due get looked at each frame.
+static int Osiris_timer_heap[MAX_OSIRIS_TIMERS];
+static int Osiris_num_timer_heap = 0;
+
+//Unused timer slots, as a stack
+static int Osiris_free_timers[MAX_OSIRIS_TIMERS];
+static int Osiris_num_free_timers = 0;
+static int Osiris_timer_high_water = 0;		//one past the highest slot used since the last reset
+
+//First timer owned by, and first timer detonated by, each object
+static int Osiris_object_timers[MAX_OBJECTS];
+static int Osiris_detonator_timers[MAX_OBJECTS];
+
+#define OSIRIS_TIMER_SLOT_BITS	14
+
 inline int FORM_HANDLE(int counter, int slot)
 {
-	return (((counter & 0xFFFFFF) << 8) | (slot & 0xFF));
+	return (((counter & 0x1FFFF) << OSIRIS_TIMER_SLOT_BITS) | (slot & (MAX_OSIRIS_TIMERS - 1)));
 }
 
 inline int GET_SLOT(int handle)
 {
-	return (handle & 0xFF);
+	return (handle & (MAX_OSIRIS_TIMERS - 1));
 }
 
 int Osiris_timer_counter = 0;
 
+static inline bool osiris_TimerBefore(int a, int b)
+{
+	return OsirisTimers[Osiris_timer_heap[a]].key < OsirisTimers[Osiris_timer_heap[b]].key;
+}
+
+static inline void osiris_TimerHeapSwap(int a, int b)
+{
+	int t = Osiris_timer_heap[a];
+	Osiris_timer_heap[a] = Osiris_timer_heap[b];
+	Osiris_timer_heap[b] = t;
+	OsirisTimers[Osiris_timer_heap[a]].heap_index = a;
+	OsirisTimers[Osiris_timer_heap[b]].heap_index = b;
+}
+
+static void osiris_TimerHeapUp(int i)
+{
+	while (i > 0)
+	{
+		int parent = (i - 1) / 2;
+		if (!osiris_TimerBefore(i, parent))
+			break;
+		osiris_TimerHeapSwap(i, parent);
+		i = parent;
+	}
+}
+
+static void osiris_TimerHeapDown(int i)
+{
+	while (1)
+	{
+		int child = 2 * i + 1;
+		if (child >= Osiris_num_timer_heap)
+			break;
+		if (child + 1 < Osiris_num_timer_heap && osiris_TimerBefore(child + 1, child))
+			child++;
+		if (!osiris_TimerBefore(child, i))
+			break;
+		osiris_TimerHeapSwap(i, child);
+		i = child;
+	}
+}
+
+//Puts a timer in the heap at key, or moves it there if it's already in
+static void osiris_ScheduleTimer(int slot, float key)
+{
+	tOSIRISINTERNALTIMER* t = &OsirisTimers[slot];
+
+	t->key = key;
+
+	if (t->heap_index == -1)
+	{
+		t->heap_index = Osiris_num_timer_heap;
+		Osiris_timer_heap[Osiris_num_timer_heap++] = slot;
+		osiris_TimerHeapUp(t->heap_index);
+	}
+	else
+	{
+		osiris_TimerHeapUp(t->heap_index);
+		osiris_TimerHeapDown(t->heap_index);
+	}
+}
+
+static void osiris_UnscheduleTimer(int slot)
+{
+	int i = OsirisTimers[slot].heap_index;
+	if (i == -1)
+		return;
+
+	OsirisTimers[slot].heap_index = -1;
+	Osiris_num_timer_heap--;
+
+	if (i != Osiris_num_timer_heap)
+	{
+		Osiris_timer_heap[i] = Osiris_timer_heap[Osiris_num_timer_heap];
+		OsirisTimers[Osiris_timer_heap[i]].heap_index = i;
+		osiris_TimerHeapUp(i);
+		osiris_TimerHeapDown(i);
+	}
+}
+
+//The next time a timer signals or expires
+static float osiris_TimerKey(tOSIRISINTERNALTIMER* t)
+{
+	float key = t->timer_next_signal;
+
+	if (!((t->flags & OITF_REPEATCALL) && (t->repeat_count == -1)) && t->timer_end < key)
+		key = t->timer_end;
+
+	return key;
+}
+
+//Hooks a timer into the lists of its owner and detonator objects
+static void osiris_LinkTimerObjects(int slot)
+{
+	tOSIRISINTERNALTIMER* t = &OsirisTimers[slot];
+	object* obj;
+
+	t->obj_list = t->obj_prev = t->obj_next = -1;
+	t->det_list = t->det_prev = t->det_next = -1;
+
+	if (!(t->flags & (OITF_TRIGGERTIMER | OITF_LEVELTIMER)) && (obj = ObjGet(t->objhandle)) != NULL)
+	{
+		int objnum = OBJNUM(obj);
+		t->obj_list = objnum;
+		t->obj_next = Osiris_object_timers[objnum];
+		if (t->obj_next != -1)
+			OsirisTimers[t->obj_next].obj_prev = slot;
+		Osiris_object_timers[objnum] = slot;
+	}
+
+	if ((t->flags & OITF_CANCELONDEAD) && (obj = ObjGet(t->objhandle_detonator)) != NULL)
+	{
+		int objnum = OBJNUM(obj);
+		t->det_list = objnum;
+		t->det_next = Osiris_detonator_timers[objnum];
+		if (t->det_next != -1)
+			OsirisTimers[t->det_next].det_prev = slot;
+		Osiris_detonator_timers[objnum] = slot;
+	}
+}
+
+static void osiris_UnlinkTimerObjects(int slot)
+{
+	tOSIRISINTERNALTIMER* t = &OsirisTimers[slot];
+
+	if (t->obj_list != -1)
+	{
+		if (t->obj_prev != -1)
+			OsirisTimers[t->obj_prev].obj_next = t->obj_next;
+		else
+			Osiris_object_timers[t->obj_list] = t->obj_next;
+		if (t->obj_next != -1)
+			OsirisTimers[t->obj_next].obj_prev = t->obj_prev;
+	}
+
+	if (t->det_list != -1)
+	{
+		if (t->det_prev != -1)
+			OsirisTimers[t->det_prev].det_next = t->det_next;
+		else
+			Osiris_detonator_timers[t->det_list] = t->det_next;
+		if (t->det_next != -1)
+			OsirisTimers[t->det_next].det_prev = t->det_prev;
+	}
+
+	t->obj_list = t->obj_prev = t->obj_next = -1;
+	t->det_list = t->det_prev = t->det_next = -1;
+}
+
+//Takes a slot off the free stack and clears it out
+static int osiris_AllocTimer(void)
+{
+	int slot;
+
+	if (Osiris_num_free_timers)
+		slot = Osiris_free_timers[--Osiris_num_free_timers];
+	else if (Osiris_timer_high_water < MAX_OSIRIS_TIMERS)
+		slot = Osiris_timer_high_water++;
+	else
+		return -1;
+
+	tOSIRISINTERNALTIMER* t = &OsirisTimers[slot];
+	t->flags = 0;
+	t->id = 0;
+	t->objhandle = 0;
+	t->repeat_count = 0;
+	t->timer_end = 0;
+	t->timer_interval = 0;
+	t->timer_next_signal = 0;
+	t->handle = 0;
+	t->objhandle_detonator = OBJECT_HANDLE_NONE;
+	t->heap_index = -1;
+	t->obj_list = t->obj_prev = t->obj_next = -1;
+	t->det_list = t->det_prev = t->det_next = -1;
+
+	return slot;
+}
+
+//Marks a timer unused and gives its slot back.  Doesn't call any events
+static void osiris_FreeTimer(int slot)
+{
+	if (!(OsirisTimers[slot].flags & OITF_USED))
+		return;
+
+	osiris_UnscheduleTimer(slot);
+	osiris_UnlinkTimerObjects(slot);
+	OsirisTimers[slot].flags &= ~OITF_USED;
+	Osiris_free_timers[Osiris_num_free_timers++] = slot;
+}
+
+//Returns true if a cancel-on-dead timer's detonator is gone
+static bool osiris_DetonatorDead(tOSIRISINTERNALTIMER* t)
+{
+	if (t->flags & OITF_DETONATED)
+		return true;
+
+	object* obj = ObjGet(t->objhandle_detonator);
+	return (!obj || (obj->type == OBJ_GHOST) || (obj->type == OBJ_PLAYER && Players[obj->id].flags & (PLAYER_FLAGS_DYING | PLAYER_FLAGS_DEAD)));
+}
+
+//Sends EVT_TIMERCANCEL to whoever owns a timer
+static void osiris_SendTimerCancel(tOSIRISINTERNALTIMER* t, int detonated)
+{
+	tOSIRISEventInfo ei;
+	ei.evt_timercancel.detonated = detonated;
+	ei.evt_timercancel.handle = t->handle;
+
+	if (t->flags & OITF_TRIGGERTIMER)
+	{
+		Osiris_CallTriggerEvent(t->trignum, EVT_TIMERCANCEL, &ei);
+	}
+	else if (t->flags & OITF_LEVELTIMER)
+	{
+		Osiris_CallLevelEvent(EVT_TIMERCANCEL, &ei);
+	}
+	else
+	{
+		object* obj = ObjGet(t->objhandle);
+		if (obj)
+			Osiris_CallEvent(obj, EVT_TIMERCANCEL, &ei);
+	}
+}
+
 //	Osiris_ProcessTimers
 //	Purpose:
-//		This function checks all timers currently running, if any need to be signaled it signals them.
+//		This function signals all timers that are due.
 void Osiris_ProcessTimers(void)
 {
 	object* obj;
 	bool signal, kill;
 	tOSIRISEventInfo ei;
+	static int due[MAX_OSIRIS_TIMERS];
+	static int due_handles[MAX_OSIRIS_TIMERS];
+	int num_due = 0;
+
+	//Take everything that's due off the heap first.  Events can create and cancel timers, and
+	//anything they add waits for the next frame.
+	while (Osiris_num_timer_heap && OsirisTimers[Osiris_timer_heap[0]].key <= Gametime)
+	{
+		int slot = Osiris_timer_heap[0];
+		osiris_UnscheduleTimer(slot);
+		due[num_due] = slot;
+		due_handles[num_due++] = OsirisTimers[slot].handle;
+	}
 
-	for (int i = 0; i < MAX_OSIRIS_TIMERS; i++)
+	for (int d = 0; d < num_due; d++)
 	{
+		int i = due[d];
+		tOSIRISINTERNALTIMER* t = &OsirisTimers[i];
+
+		//an earlier event might have cancelled this one
+		if (!(t->flags & OITF_USED) || t->handle != due_handles[d])
+			continue;
+
 		signal = false;
 		kill = false;
 
-		if (OsirisTimers[i].flags & OITF_USED)
+		if ((t->flags & OITF_CANCELONDEAD) && osiris_DetonatorDead(t))
 		{
-			if (OsirisTimers[i].flags & OITF_CANCELONDEAD)
-			{
-				obj = ObjGet(OsirisTimers[i].objhandle_detonator);
-				if (!obj || (obj->type == OBJ_GHOST) || (obj->type == OBJ_PLAYER && Players[obj->id].flags & (PLAYER_FLAGS_DYING | PLAYER_FLAGS_DEAD))) {
-					//the detontator died...cancel the timer!					
-					OsirisTimers[i].flags &= ~OITF_USED;
-					OsirisTimers[i].repeat_count = 0;
-
-					tOSIRISEventInfo ei;
-					ei.evt_timercancel.detonated = 1;
-					ei.evt_timercancel.handle = OsirisTimers[i].handle;
+			//the detontator died...cancel the timer!
+			mprintf((0, "OSIRIS TIMER: Cancelling Timer (%d/%d)\n", t->handle, i));
 
-					if (OsirisTimers[i].flags & OITF_TRIGGERTIMER)
-					{
-						Osiris_CallTriggerEvent(OsirisTimers[i].trignum, EVT_TIMERCANCEL, &ei);
-					}
-					else if (OsirisTimers[i].flags & OITF_LEVELTIMER)
-					{
-						Osiris_CallLevelEvent(EVT_TIMERCANCEL, &ei);
-					}
-					else
-					{
-						object* obj = ObjGet(OsirisTimers[i].objhandle);
-						if (obj)
-							Osiris_CallEvent(obj, EVT_TIMERCANCEL, &ei);
-					}
+			t->repeat_count = 0;
+			osiris_FreeTimer(i);
+			osiris_SendTimerCancel(t, 1);
+			continue;
+		}
 
-					mprintf((0, "OSIRIS TIMER: Cancelling Timer (%d/%d)\n", OsirisTimers[i].handle, i));
-					continue;
-				}
-			}
+		if (t->timer_next_signal <= Gametime)
+		{
+			//this timer needs to be signaled
+			signal = true;
 
-			if (OsirisTimers[i].timer_next_signal <= Gametime)
+			if (t->flags & OITF_REPEATCALL)
 			{
-				//this timer needs to be signaled
-				signal = true;
-
-				if (OsirisTimers[i].flags & OITF_REPEATCALL)
+				//this is a repeater
+				if (t->repeat_count != -1)
 				{
-					//this is a repeater
-					if (OsirisTimers[i].repeat_count != -1)
+					//it has a finite repeat
+					t->repeat_count--;
+					if (t->repeat_count <= 0)
 					{
-						//it has a finite repeat
-						OsirisTimers[i].repeat_count--;
-						if (OsirisTimers[i].repeat_count <= 0)
-						{
-							//remove the timer
-							kill = true;
-							OsirisTimers[i].repeat_count = 0;
-						}
-						else
-						{
-							//adjust for next signal
-							OsirisTimers[i].timer_next_signal += OsirisTimers[i].timer_interval;
-						}
+						//remove the timer
+						kill = true;
+						t->repeat_count = 0;
 					}
 					else
 					{
-						//infinite repeat
-						OsirisTimers[i].timer_next_signal += OsirisTimers[i].timer_interval;
+						//adjust for next signal
+						t->timer_next_signal += t->timer_interval;
 					}
-
-
+				}
+				else
+				{
+					//infinite repeat
+					t->timer_next_signal += t->timer_interval;
 				}
 			}
+		}
 
-			if ((!((OsirisTimers[i].flags & OITF_REPEATCALL) && (OsirisTimers[i].repeat_count == -1))) &&
-				OsirisTimers[i].timer_end <= Gametime)
-			{
+		if ((!((t->flags & OITF_REPEATCALL) && (t->repeat_count == -1))) &&
+			t->timer_end <= Gametime)
+		{
+			//this timer has expired, remove it
+			kill = true;
+			//signal timer
+			signal = true;
+		}
 
-				//this timer has expired, remove it
-				kill = true;
-				//signal timer
-				signal = true;
-			}
+		if (signal)
+		{
+			ei.evt_timer.game_time = Gametime;
+			ei.evt_timer.id = t->id;
+		}
 
+		//see what kind of timer it is
+		if (t->flags & OITF_TRIGGERTIMER)
+		{
+			//trigger timer
 			if (signal)
+				Osiris_CallTriggerEvent(t->trignum, EVT_TIMER, &ei);
+		}
+		else if (t->flags & OITF_LEVELTIMER)
+		{
+			//level timer
+			if (signal)
+				Osiris_CallLevelEvent(EVT_TIMER, &ei);
+		}
+		else
+		{
+			//object timer
+			obj = ObjGet(t->objhandle);
+			if (obj)
 			{
-				ei.evt_timer.game_time = Gametime;
-				ei.evt_timer.id = OsirisTimers[i].id;
-			}
-
-			//this timer is currently in use, see what kind of trigger it is
-			if (OsirisTimers[i].flags & OITF_TRIGGERTIMER)
-			{
-				//trigger timer
+				//process this object timer
 				if (signal)
-					Osiris_CallTriggerEvent(OsirisTimers[i].trignum, EVT_TIMER, &ei);
+					Osiris_CallEvent(obj, EVT_TIMER, &ei);
 			}
-			else if (OsirisTimers[i].flags & OITF_LEVELTIMER)
+			else
 			{
-				//level timer
-				if (signal)
-					Osiris_CallLevelEvent(EVT_TIMER, &ei);
+				//this object no longer exists, remove the timer
+				kill = true;
 			}
-			else
+		}
+
+		//the event might have cancelled it
+		if (!(t->flags & OITF_USED) || t->handle != due_handles[d])
+			continue;
+
+		if (kill)
+			osiris_FreeTimer(i);
+		else
+			osiris_ScheduleTimer(i, (t->flags & OITF_DETONATED) ? -1.0f : osiris_TimerKey(t));
+	}
+}
+
+//	Osiris_DetonateObjectTimers
+//	Purpose:
+//		Call this when an object dies, or a player starts dying or becomes a ghost.  Timers that
+//	cancel when this object dies are cancelled the next time timers are processed.
+void Osiris_DetonateObjectTimers(object* obj)
+{
+	int objnum = OBJNUM(obj);
+
+	for (int i = Osiris_detonator_timers[objnum]; i != -1; i = OsirisTimers[i].det_next)
+	{
+		if (OsirisTimers[i].objhandle_detonator != obj->handle)
+			continue;
+
+		//timers being signaled right now get rescheduled once their event is done
+		OsirisTimers[i].flags |= OITF_DETONATED;
+		if (OsirisTimers[i].heap_index != -1)
+			osiris_ScheduleTimer(i, -1.0f);
+	}
+}
+
+//	osiris_BenchmarkTimers
+//	Purpose:
+//		Runs 1k-10k live repeating timers through Osiris_ProcessTimers, and through a scan of every
+//	slot like the old per frame loop, and prints how long a frame takes with each.  Run with -timerbench
+static void osiris_BenchmarkTimers(void)
+{
+	static const int counts[] = { 1000, 2500, 5000, 10000 };
+	const int frames = 600;
+	const float frametime = 1.0f / 60.0f;
+	float save_gametime = Gametime;
+	tOSIRISTIMER ot;
+	int c, i, f;
+
+	for (c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
+	{
+		int num = counts[c];
+
+		Osiris_ResetAllTimers();
+		Gametime = 0;
+		srand(num);
+
+		memset(&ot, 0, sizeof(ot));
+		ot.flags = OTF_LEVEL | OTF_REPEATER;
+		ot.repeat_count = -1;
+		for (i = 0; i < num; i++)
+		{
+			ot.id = i;
+			ot.timer_interval = 0.5f + (rand() % 1000) / 100.0f;
+			Osiris_CreateTimer(&ot);
+		}
+
+		double start = timer_GetTime64();
+		for (f = 0; f < frames; f++)
+		{
+			Gametime += frametime;
+			Osiris_ProcessTimers();
+		}
+		double heap_time = timer_GetTime64() - start;
+
+		//now the same timers the old way, looking at every slot every frame
+		Gametime = 0;
+		for (i = 0; i < Osiris_timer_high_water; i++)
+			OsirisTimers[i].timer_next_signal = OsirisTimers[i].timer_interval;
+
+		int signals = 0;
+		start = timer_GetTime64();
+		for (f = 0; f < frames; f++)
+		{
+			Gametime += frametime;
+			for (i = 0; i < Osiris_timer_high_water; i++)
 			{
-				//object timer
-				obj = ObjGet(OsirisTimers[i].objhandle);
-				if (obj)
-				{
-					//process this object timer
-					if (signal)
-						Osiris_CallEvent(obj, EVT_TIMER, &ei);
-				}
-				else
+				if ((OsirisTimers[i].flags & OITF_USED) && OsirisTimers[i].timer_next_signal <= Gametime)
 				{
-					//this object no longer exists, remove the timer
-					kill = true;
+					OsirisTimers[i].timer_next_signal += OsirisTimers[i].timer_interval;
+					signals++;
 				}
 			}
-
-			if (kill)
-				OsirisTimers[i].flags &= ~OITF_USED;
 		}
+		double scan_time = timer_GetTime64() - start;
+
+		mprintf((0, "OSIRIS timer benchmark: %d timers, %d signals in %d frames, heap %.2fus/frame, scan %.2fus/frame\n",
+			num, signals, frames, heap_time * 1000000.0 / frames, scan_time * 1000000.0 / frames));
 	}
+
+	Osiris_ResetAllTimers();
+	Gametime = save_gametime;
+}
+
+//	Osiris_DetachTimersFromObject
+//	Purpose:
+//		Call this function when an object is about to be destroyed.  Timers owned by the object
+//	are removed without any events, and timers it detonates are cancelled.
+void Osiris_DetachTimersFromObject(object* obj)
+{
+	int objnum = OBJNUM(obj);
+	int i = Osiris_object_timers[objnum];
+
+	while (i != -1)
+	{
+		int next = OsirisTimers[i].obj_next;
+		if (OsirisTimers[i].objhandle == obj->handle)
+			osiris_FreeTimer(i);
+		i = next;
+	}
+
+	Osiris_DetonateObjectTimers(obj);
 }
 
 
@@ -2233,10 +2614,23 @@ void Osiris_ProcessTimers(void)
 //		Flushes all the timers
 void Osiris_ResetAllTimers(void)
 {
-	for (int i = 0; i < MAX_OSIRIS_TIMERS; i++)
+	int i;
+
+	for (i = 0; i < MAX_OSIRIS_TIMERS; i++)
 	{
 		OsirisTimers[i].flags = 0;
+		OsirisTimers[i].heap_index = -1;
+	}
+
+	for (i = 0; i < MAX_OBJECTS; i++)
+	{
+		Osiris_object_timers[i] = -1;
+		Osiris_detonator_timers[i] = -1;
 	}
+
+	Osiris_num_timer_heap = 0;
+	Osiris_num_free_timers = 0;
+	Osiris_timer_high_water = 0;
 }
 
 
@@ -2247,27 +2641,10 @@ void Osiris_ResetAllTimers(void)
 int Osiris_CreateTimer(tOSIRISTIMER* ot)
 {
 	//find an empty timer
-	int i;
-	for (i = 0; i < MAX_OSIRIS_TIMERS; i++)
-	{
-		if (!(OsirisTimers[i].flags & OITF_USED))
-			break;
-	}
-
-	if (i >= MAX_OSIRIS_TIMERS)
+	int i = osiris_AllocTimer();
+	if (i == -1)
 		return -1;//no more slots available
 
-	//clear out the slots
-	OsirisTimers[i].flags = 0;
-	OsirisTimers[i].id = 0;
-	OsirisTimers[i].objhandle = 0;
-	OsirisTimers[i].repeat_count = 0;
-	OsirisTimers[i].timer_end = 0;
-	OsirisTimers[i].timer_interval = 0;
-	OsirisTimers[i].timer_next_signal = 0;
-	OsirisTimers[i].handle = 0;
-	OsirisTimers[i].objhandle_detonator = OBJECT_HANDLE_NONE;
-
 	//fill in the data
 	OsirisTimers[i].flags |= OITF_USED;
 	OsirisTimers[i].id = ot->id;
@@ -2313,6 +2690,15 @@ int Osiris_CreateTimer(tOSIRISTIMER* ot)
 
 	OsirisTimers[i].handle = handle;
 
+	osiris_LinkTimerObjects(i);
+
+	//if the owner or detonator is already gone, look at it next frame
+	bool gone = (!(OsirisTimers[i].flags & (OITF_TRIGGERTIMER | OITF_LEVELTIMER)) && !ObjGet(OsirisTimers[i].objhandle));
+	if ((OsirisTimers[i].flags & OITF_CANCELONDEAD) && osiris_DetonatorDead(&OsirisTimers[i]))
+		gone = true;
+
+	osiris_ScheduleTimer(i, gone ? -1.0f : osiris_TimerKey(&OsirisTimers[i]));
+
 	return handle;
 }
 
@@ -2332,26 +2718,8 @@ void Osiris_CancelTimer(int handle)
 	if (OsirisTimers[slot].handle != handle)	//not the same timer
 		return;
 
-	OsirisTimers[slot].flags &= ~OITF_USED;
-
-	tOSIRISEventInfo ei;
-	ei.evt_timercancel.detonated = 0;
-	ei.evt_timercancel.handle = handle;
-
-	if (OsirisTimers[slot].flags & OITF_TRIGGERTIMER)
-	{
-		Osiris_CallTriggerEvent(OsirisTimers[slot].trignum, EVT_TIMERCANCEL, &ei);
-	}
-	else if (OsirisTimers[slot].flags & OITF_LEVELTIMER)
-	{
-		Osiris_CallLevelEvent(EVT_TIMERCANCEL, &ei);
-	}
-	else
-	{
-		object* obj = ObjGet(OsirisTimers[slot].objhandle);
-		if (obj)
-			Osiris_CallEvent(obj, EVT_TIMERCANCEL, &ei);
-	}
+	osiris_FreeTimer(slot);
+	osiris_SendTimerCancel(&OsirisTimers[slot], 0);
 }
 
 //	Osiris_GetTimerHandle
@@ -2360,7 +2728,7 @@ void Osiris_CancelTimer(int handle)
 int Osiris_GetTimerHandle(int id)
 {
 	//Look for timer with this ID
-	for (int i = 0; i < MAX_OSIRIS_TIMERS; i++)
+	for (int i = 0; i < Osiris_timer_high_water; i++)
 	{
 		if ((OsirisTimers[i].flags & OITF_USED) && (OsirisTimers[i].id == id))
 			return OsirisTimers[i].handle;
@@ -2375,7 +2743,7 @@ int Osiris_GetTimerHandle(int id)
 void Osiris_CancelTimerID(int id)
 {
 	//Look for timer with this ID
-	for (int i = 0; i < MAX_OSIRIS_TIMERS; i++)
+	for (int i = 0; i < Osiris_timer_high_water; i++)
 	{
 		if ((OsirisTimers[i].flags & OITF_USED) && (OsirisTimers[i].id == id))
 		{
@@ -2425,7 +2793,7 @@ float Osiris_TimerTimeRemaining(int handle)
 }
 
 
-#define OSIRIS_SYSTEM_FILEVERSION	0x01
+#define OSIRIS_SYSTEM_FILEVERSION	0x02	//0x02: only used timers are saved, with a count first
 //	Osiris_SaveSystemState
 //	Purpose:
 //		Saves the current state of the system (not the scripts!) to file
@@ -2445,12 +2813,19 @@ void Osiris_SaveSystemState(CFILE* file)
 	cf_WriteInt(file, Osiris_timer_counter);
 
 	//save out the timer state
-	for (i = 0; i < MAX_OSIRIS_TIMERS; i++)
+	int num_timers = 0;
+	for (i = 0; i < Osiris_timer_high_water; i++)
+	{
+		if (OsirisTimers[i].flags & OITF_USED)
+			num_timers++;
+	}
+	cf_WriteInt(file, num_timers);
+
+	for (i = 0; i < Osiris_timer_high_water; i++)
 	{
 		if (OsirisTimers[i].flags & OITF_USED) {
 			//write out information about this timer
-			cf_WriteByte(file, 1);	//timer exists
-			cf_WriteShort(file, OsirisTimers[i].flags);
+			cf_WriteShort(file, OsirisTimers[i].flags & ~OITF_DETONATED);
 			cf_WriteInt(file, OsirisTimers[i].id);
 			cf_WriteInt(file, OsirisTimers[i].repeat_count);
 			cf_WriteFloat(file, OsirisTimers[i].timer_interval);
@@ -2460,10 +2835,6 @@ void Osiris_SaveSystemState(CFILE* file)
 			cf_WriteInt(file, OsirisTimers[i].objhandle_detonator);
 			cf_WriteInt(file, OsirisTimers[i].handle);
 		}
-		else
-		{
-			cf_WriteByte(file, 0);
-		}
 	}
 
 	//auto-save script mallocs
@@ -2570,26 +2941,50 @@ bool Osiris_RestoreSystemState(CFILE* file)
 	Osiris_timer_counter = cf_ReadInt(file);
 
 	//restore timer state	
-	for (i = 0; i < MAX_OSIRIS_TIMERS; i++)
-	{
-		if (cf_ReadByte(file))
+	Osiris_ResetAllTimers();
+
+	//version 1 saved a flag for each of its 64 slots
+	int num_timers = (version < 0x02) ? 64 : cf_ReadInt(file);
+	for (i = 0; i < num_timers; i++)
+	{
+		if (version < 0x02 && !cf_ReadByte(file))
+			continue;
+
+		tOSIRISINTERNALTIMER t;
+		t.flags = cf_ReadShort(file);
+		t.id = cf_ReadInt(file);
+		t.repeat_count = cf_ReadInt(file);
+		t.timer_interval = cf_ReadFloat(file);
+		t.timer_next_signal = cf_ReadFloat(file);
+		t.timer_end = cf_ReadFloat(file);
+		t.objhandle = cf_ReadInt(file);
+		t.objhandle_detonator = cf_ReadInt(file);
+		t.handle = cf_ReadInt(file);
+
+		//the handle says which slot the timer lives in
+		int slot = GET_SLOT(t.handle);
+		if (OsirisTimers[slot].flags & OITF_USED)
 		{
-			//timer is used
-			OsirisTimers[i].flags = cf_ReadShort(file);
-			OsirisTimers[i].id = cf_ReadInt(file);
-			OsirisTimers[i].repeat_count = cf_ReadInt(file);
-			OsirisTimers[i].timer_interval = cf_ReadFloat(file);
-			OsirisTimers[i].timer_next_signal = cf_ReadFloat(file);
-			OsirisTimers[i].timer_end = cf_ReadFloat(file);
-			OsirisTimers[i].objhandle = cf_ReadInt(file);
-			OsirisTimers[i].objhandle_detonator = cf_ReadInt(file);
-			OsirisTimers[i].handle = cf_ReadInt(file);
-
+			mprintf((0, "OSIRIS: Dropping restored timer %d, slot %d is taken\n", t.handle, slot));
+			continue;
 		}
-		else
+
+		OsirisTimers[slot] = t;
+		if (slot >= Osiris_timer_high_water)
+			Osiris_timer_high_water = slot + 1;
+	}
+
+	//the slots in between are free, lowest on top
+	for (i = Osiris_timer_high_water - 1; i >= 0; i--)
+	{
+		if (OsirisTimers[i].flags & OITF_USED)
 		{
-			OsirisTimers[i].flags = 0;
+			OsirisTimers[i].heap_index = -1;
+			osiris_LinkTimerObjects(i);
+			osiris_ScheduleTimer(i, osiris_TimerKey(&OsirisTimers[i]));
 		}
+		else
+			Osiris_free_timers[Osiris_num_free_timers++] = i;
 	}
 
 	//restore auto-saved memory chunks
@@ -3039,11 +3434,193 @@ void Osiris_RestoreMemoryChunks(CFILE* file)
 }
 
 
-void _extractscript(char* script, char* tempfilename)
+#if defined(__LINUX__) && !defined(MACOSX) && defined(SYS_memfd_create)
+#define OSIRIS_USE_MEMFD
+static bool Osiris_memfd_unavailable = false;
+#endif
+
+//	reads the whole script out of its hog, the caller must mem_free() the result
+ubyte* _readscript(tExtractedScriptInfo* es, int* size)
+{
+	CFILE* file = cfopen(es->lib_filename, "rb");
+	if (!file)
+		return NULL;
+
+	int len = cfilelength(file);
+	ubyte* data = (ubyte*)mem_malloc(len > 0 ? len : 1);
+	if (!data)
+		Error("Out of memory");
+
+	if (cf_ReadBytes(data, len, file) != len)
+	{
+		mprintf((0, "OSIRIS: Unable to read %s out of the hog\n", es->lib_filename));
+		cfclose(file);
+		mem_free(data);
+		return NULL;
+	}
+	cfclose(file);
+
+	*size = len;
+	return data;
+}
+
+//	copies the script into an anonymous memory file, returns the descriptor or -1
+int _memfdscript(tExtractedScriptInfo* es)
+{
+#ifdef OSIRIS_USE_MEMFD
+	if (Osiris_memfd_unavailable)
+		return -1;
+
+	int size;
+	ubyte* data = _readscript(es, &size);
+	if (!data)
+		return -1;
+
+	int fd = syscall(SYS_memfd_create, es->real_filename, 0);
+	if (fd == -1)
+	{
+		//old kernel, use the script cache from now on
+		mprintf((0, "OSIRIS: memfd_create not available, extracting scripts to disk\n"));
+		Osiris_memfd_unavailable = true;
+		mem_free(data);
+		return -1;
+	}
+
+	int written = 0;
+	while (written < size)
+	{
+		int ret = write(fd, data + written, size - written);
+		if (ret <= 0)
+		{
+			close(fd);
+			mem_free(data);
+			return -1;
+		}
+		written += ret;
+	}
+
+	mem_free(data);
+	return fd;
+#else
+	return -1;
+#endif
+}
+
+//	makes sure the script is in the script cache, named by the MD5 of its contents
+bool _cachescript(tExtractedScriptInfo* es)
 {
-	cf_CopyFile(tempfilename, script);
+	int size;
+	ubyte* data = _readscript(es, &size);
+	if (!data)
+		return false;
+
+	MD5 md5;
+	unsigned char digest[16];
+	md5.MD5Init();
+	md5.MD5Update(data, (unsigned int)size);
+	md5.MD5Final(digest);
+
+	char cache_name[_MAX_PATH], ext[_MAX_EXT], fullpath[_MAX_PATH];
+	ddio_SplitPath(es->lib_filename, NULL, NULL, ext);
+	for (char* p = ext; *p; p++)
+		*p = tolower(*p);
+	for (int i = 0; i < 16; i++)
+		sprintf(&cache_name[i * 2], "%02x", digest[i]);
+	strcat(cache_name, ext);
+	ddio_MakePath(fullpath, OSIRIS_Extracted_script_dir, cache_name, NULL);
+
+	//the name is the hash of the contents, so a file of the right size is the same script
+	bool cached = false;
+	CFILE* file = cfopen(fullpath, "rb");
+	if (file)
+	{
+		cached = (cfilelength(file) == size);
+		cfclose(file);
+	}
+
+	if (cached)
+	{
+		mprintf((0, "OSIRIS: Using cached %s for %s\n", cache_name, es->lib_filename));
+	}
+	else
+	{
+		//write to a temp file and rename it, so nobody sharing the cache sees half a script
+		char temp_filename[_MAX_PATH];
+		if (!ddio_GetTempFileName(OSIRIS_Extracted_script_dir, "d3s", temp_filename))
+		{
+			mem_free(data);
+			return false;
+		}
+
+		file = cfopen(temp_filename, "wb");
+		if (!file)
+		{
+			mem_free(data);
+			return false;
+		}
+		int written = cf_WriteBytes(data, size, file);
+		cfclose(file);
+
+		if (written != size)
+		{
+			ddio_DeleteFile(temp_filename);
+			mem_free(data);
+			return false;
+		}
+
+		mprintf((0, "OSIRIS: Extracting %s to %s\n", es->lib_filename, cache_name));
+		ddio_DeleteFile(fullpath);
+		if (!ddio_RenameFile(temp_filename, fullpath))
+		{
+			ddio_DeleteFile(temp_filename);
+			if (cfexist(fullpath) != CF_ON_DISK)
+			{
+				mem_free(data);
+				return false;
+			}
+		}
+	}
+
+	mem_free(data);
+	es->temp_filename = mem_strdup(cache_name);
+	if (!es->temp_filename)
+		Error("Out of memory");
+	return true;
 }
 
+//	Loads a script that lives in a hog.  It is loaded straight from memory where possible,
+//	otherwise from the script cache.  fullpath gets the path used.
+bool _load_extracted_script(module* mod, int id, char* fullpath)
+{
+	tExtractedScriptInfo* es = &OSIRIS_Extracted_scripts[id];
+
+	if (es->mem_fd == -1 && !es->temp_filename)
+		es->mem_fd = _memfdscript(es);
+
+#ifdef OSIRIS_USE_MEMFD
+	if (es->mem_fd != -1)
+	{
+		if (mod_LoadModuleFromFD(mod, es->mem_fd))
+		{
+			sprintf(fullpath, "/proc/self/fd/%d", es->mem_fd);
+			return true;
+		}
+
+		//the loader didn't like it, go through the disk instead
+		close(es->mem_fd);
+		es->mem_fd = -1;
+	}
+#endif
+
+	if (!es->temp_filename && !_cachescript(es))
+	{
+		mprintf((0, "OSIRIS: Unable to extract %s\n", es->lib_filename));
+		return false;
+	}
+
+	ddio_MakePath(fullpath, OSIRIS_Extracted_script_dir, es->temp_filename, NULL);
+	return mod_LoadModule(mod, fullpath);
+}
 
 int _getfreeextractslot(void)
 {
@@ -3066,24 +3643,22 @@ int Osiris_ExtractScriptsFromHog(int library_handle, bool is_mission_hog)
 	if (library_handle == 0)
 		return 0;
 
-	mprintf((0, "OSIRIS: Extracting Scripts From Hog\n"));
+	mprintf((0, "OSIRIS: Indexing Scripts In Hog\n"));
 
-	char filename[_MAX_PATH], temp_filename[_MAX_PATH];
-	char tempdir[_MAX_PATH], temp_file[_MAX_PATH], temp_fileext[_MAX_EXT];
-	char temp_realname[_MAX_PATH];
+	char filename[_MAX_PATH], temp_realname[_MAX_PATH];
 
 	if (!OSIRIS_Extracted_script_dir)
 	{
-		strcpy(tempdir, Descent3_temp_directory);
-		//ddio_MakePath(tempdir,LocalD3Dir,"custom","cache",NULL);	//TODO: make real path here
-		OSIRIS_Extracted_script_dir = mem_strdup(tempdir);
+		//the script cache outlives the game, so keep it apart from the temp files
+		char cachedir[_MAX_PATH];
+		ddio_MakePath(cachedir, Descent3_temp_directory, "scripts", NULL);
+		if (!ddio_DirExists(cachedir) && !ddio_CreateDir(cachedir))
+			strcpy(cachedir, Descent3_temp_directory);
+
+		OSIRIS_Extracted_script_dir = mem_strdup(cachedir);
 		if (!OSIRIS_Extracted_script_dir)
 			Error("Out of memory");
 	}
-	else
-	{
-		strcpy(tempdir, OSIRIS_Extracted_script_dir);
-	}
 
 	int count = 0;
 
@@ -3098,85 +3673,37 @@ int Osiris_ExtractScriptsFromHog(int library_handle, bool is_mission_hog)
 	script_extension = "*.dll";
 #endif
 
-	int index;
-	index = _getfreeextractslot();
-	if (index == -1)
+	//only remember where the scripts are, they get extracted when a level loads them
+	bool found = cf_LibraryFindFirst(library_handle, script_extension, filename);
+	while (found)
 	{
-		mprintf((0, "OSIRIS: Out of slots extracting scripts!!!!!!!!\n"));
-		Int3();
-		goto ex_error;
-	}
-
-	mprintf((0, "Search started\n"));
-	if (cf_LibraryFindFirst(library_handle, script_extension, filename))
-	{
-		mprintf((0, "	Found: %s...", filename));
-		if (!ddio_GetTempFileName(tempdir, "d3s", temp_filename))
-			Int3();
-		else
+		int index = _getfreeextractslot();
+		if (index == -1)
 		{
-			ddio_SplitPath(temp_filename, NULL, temp_file, temp_fileext);
-			strcat(temp_file, temp_fileext);
-
-			OSIRIS_Extracted_scripts[index].flags = OESF_USED;
-			OSIRIS_Extracted_scripts[index].temp_filename = mem_strdup(temp_file);
-
-			ddio_SplitPath(filename, NULL, temp_realname, NULL);
-			OSIRIS_Extracted_scripts[index].real_filename = mem_strdup(temp_realname);
-
-			if (is_mission_hog)
-				OSIRIS_Extracted_scripts[index].flags |= OESF_MISSION;
-
-			//extract it out
-			mprintf((0, "Extracting..."));
-			_extractscript(filename, temp_filename);
-			mprintf((0, "Done\n"));
-
-			count++;
-
-			while (cf_LibraryFindNext(filename))
-			{
-				mprintf((0, "	Found: %s...", filename));
-
-				index = _getfreeextractslot();
-				if (index == -1)
-				{
-					mprintf((0, "OSIRIS: Out of slots extracting scripts!!!!!!!!\n"));
-					Int3();
-					goto ex_error;
-				}
-
-				//generate temp filename
-				if (!ddio_GetTempFileName(tempdir, "d3s", temp_filename))
-					Int3();
-				else
-				{
-					ddio_SplitPath(temp_filename, NULL, temp_file, temp_fileext);
-					strcat(temp_file, temp_fileext);
-
-					OSIRIS_Extracted_scripts[index].flags = OESF_USED;
-					OSIRIS_Extracted_scripts[index].temp_filename = mem_strdup(temp_file);
+			mprintf((0, "OSIRIS: Out of slots extracting scripts!!!!!!!!\n"));
+			Int3();
+			break;
+		}
 
-					ddio_SplitPath(filename, NULL, temp_realname, NULL);
-					OSIRIS_Extracted_scripts[index].real_filename = mem_strdup(temp_realname);
+		mprintf((0, "	Found: %s\n", filename));
 
-					if (is_mission_hog)
-						OSIRIS_Extracted_scripts[index].flags |= OESF_MISSION;
+		tExtractedScriptInfo* es = &OSIRIS_Extracted_scripts[index];
+		es->flags = OESF_USED;
+		if (is_mission_hog)
+			es->flags |= OESF_MISSION;
 
-					//extract it out
-					mprintf((0, "Extracting..."));
-					_extractscript(filename, temp_filename);
-					mprintf((0, "Done\n"));
+		ddio_SplitPath(filename, NULL, temp_realname, NULL);
+		es->real_filename = mem_strdup(temp_realname);
+		es->lib_filename = mem_strdup(filename);
+		es->temp_filename = NULL;
+		es->mem_fd = -1;
+		if (!es->real_filename || !es->lib_filename)
+			Error("Out of memory");
 
-					count++;
-				}
-			}
-		}
+		count++;
+		found = cf_LibraryFindNext(filename);
 	}
 
-	mprintf((0, "Done Extracting\n"));
-
-ex_error:
 	cf_LibraryFindClose();
 
 	static bool atex = false;
@@ -3194,7 +3721,6 @@ void Osiris_ClearExtractedScripts(bool mission_only)
 {
 	mprintf((0, "OSIRIS: Removing Extracted DLLs\n"));
 
-	char fullpath[_MAX_PATH];
 	if (!OSIRIS_Extracted_script_dir)
 		return;
 
@@ -3205,19 +3731,25 @@ void Osiris_ClearExtractedScripts(bool mission_only)
 			if (mission_only && (!(OSIRIS_Extracted_scripts[i].flags & OESF_MISSION)))
 				continue;
 
-			ASSERT(OSIRIS_Extracted_scripts[i].temp_filename);
-			ASSERT(OSIRIS_Extracted_scripts[i].real_filename);
-			if (!(OSIRIS_Extracted_scripts[i].temp_filename && OSIRIS_Extracted_scripts[i].real_filename))
-				continue;
+			tExtractedScriptInfo* es = &OSIRIS_Extracted_scripts[i];
 
-			ddio_MakePath(fullpath, OSIRIS_Extracted_script_dir, OSIRIS_Extracted_scripts[i].temp_filename, NULL);
-			ddio_DeleteFile(fullpath);
-
-			mem_free(OSIRIS_Extracted_scripts[i].temp_filename);
-			mem_free(OSIRIS_Extracted_scripts[i].real_filename);
-			OSIRIS_Extracted_scripts[i].temp_filename = NULL;
-			OSIRIS_Extracted_scripts[i].real_filename = NULL;
-			OSIRIS_Extracted_scripts[i].flags &= ~OESF_USED;
+			//files in the script cache are left for the next time the script is needed
+#ifdef OSIRIS_USE_MEMFD
+			if (es->mem_fd != -1)
+				close(es->mem_fd);
+#endif
+			es->mem_fd = -1;
+
+			if (es->temp_filename)
+				mem_free(es->temp_filename);
+			if (es->real_filename)
+				mem_free(es->real_filename);
+			if (es->lib_filename)
+				mem_free(es->lib_filename);
+			es->temp_filename = NULL;
+			es->real_filename = NULL;
+			es->lib_filename = NULL;
+			es->flags &= ~OESF_USED;
 		}
 	}
 
@@ -136,6 +136,7 @@ void InitPlayers()
 		ASSERT(index >= 0);
 		GameTextures[index].bm_handle = 0;
 		sprintf(GameTextures[index].name, "Player %d texture", i);
+		Texture_names.update(index);
 		Players[i].custom_texture_handle = index;
 	}
 
@@ -1099,6 +1100,7 @@ void InitiatePlayerDeath(object* playerobj, bool melee, int fate)
 	{
 		//	player is dying.  We don't want to make player dead yet.
 		Players[playerobj->id].flags |= PLAYER_FLAGS_DYING;
+		Osiris_DetonateObjectTimers(playerobj);
 
 		//Take care of stuff that should happen when you die
 		ClearPlayerFiring(playerobj, PW_PRIMARY);
@@ -83,9 +83,11 @@ bool ObjectsAreRelated(int o1, int o2)
 	if ((o1 < 0) || (o2 < 0))
 		return false;
 
-	const object* obj1 = &Objects[o1];
-	const object* obj2 = &Objects[o2];
+	return ObjectsAreRelated(&Objects[o1], &Objects[o2]);
+}
 
+bool ObjectsAreRelated(const object* obj1, const object* obj2)
+{
 	ASSERT(obj1->handle != OBJECT_HANDLE_NONE);
 	ASSERT(obj2->handle != OBJECT_HANDLE_NONE);
 
@@ -838,13 +840,9 @@ void HomingDoFrame(object* obj)
 	HomingTurnTowardObj(obj, HomingAquireTarget(obj));
 }
 
-void WeaponDoFrame(object* obj)
+// Counts down the parent and thrust timers
+static void WeaponDoTimers(object* obj)
 {
-	bool draw_effects = 1;
-
-	if (!Detail_settings.Weapon_coronas_enabled)
-		draw_effects = 0;
-
 	if (MAX_WEAPON_NOT_HIT_PARENT_TIME + obj->creation_time < Gametime)
 		obj->mtype.phys_info.flags &= (~PF_NO_COLLIDE_PARENT);
 
@@ -871,6 +869,26 @@ void WeaponDoFrame(object* obj)
 			obj->mtype.phys_info.flags |= PF_GRAVITY;
 		}
 	}
+}
+
+// Grows ring weapons over their lifetime
+static void WeaponDoRing(object* obj)
+{
+	if (Weapons[obj->id].flags & WF_RING)
+	{
+		float norm = ((Gametime - obj->creation_time) / obj->lifetime);
+		obj->size = Weapons[obj->id].size + (norm * Weapons[obj->id].size * 8);
+	}
+}
+
+void WeaponDoFrame(object* obj)
+{
+	bool draw_effects = 1;
+
+	if (!Detail_settings.Weapon_coronas_enabled)
+		draw_effects = 0;
+
+	WeaponDoTimers(obj);
 
 	if ((Weapons[obj->id].flags & WF_SMOKE) && draw_effects)
 	{
@@ -946,13 +964,20 @@ void WeaponDoFrame(object* obj)
 
 	}
 
+	WeaponDoRing(obj);
+}
 
-	if (Weapons[obj->id].flags & WF_RING)
-	{
-		float norm = ((Gametime - obj->creation_time) / obj->lifetime);
-		obj->size = Weapons[obj->id].size + (norm * Weapons[obj->id].size * 8);
-	}
+bool WeaponStageFrame(object* obj)
+{
+	// Homing and guided weapons steer by the objects around them
+	if (obj->mtype.phys_info.flags & (PF_HOMING | PF_GUIDED))
+		return false;
 
+	// The smoke and particles don't change the weapon's movement, so they're left to WeaponDoFrame()
+	WeaponDoTimers(obj);
+	WeaponDoRing(obj);
+
+	return true;
 }
 
 bool WeaponCalcGun(vector* gun_point, vector* gun_normal, object* obj, int gun_num)
@@ -68,6 +68,9 @@ ushort Dedicated_listen_port = 2092;
 char dedicated_telnet_password[65];
 int Dedicated_num_teams = 1;
 
+// Simulation ticks per second for the fixed tick loop, or 0 to run frames like a client
+int Dedicated_tick_rate = 0;
+
 int CheckMissionForScript(char* mission, char* script, int dedicated_server_num_teams);
 
 extern char Multi_message_of_the_day[];
@@ -117,6 +120,8 @@ cvar_entry CVars[] =
 {"SetLevel",CVAR_TYPE_INT,NULL,-1,-1,CVAR_GAMEINIT | CVAR_GAMEPLAY},//33
 {"SetDifficulty",CVAR_TYPE_INT,NULL,0,4,CVAR_GAMEINIT},//34
 {"MOTD",CVAR_TYPE_STRING,&Multi_message_of_the_day,-1,HUD_MESSAGE_LENGTH * 2,CVAR_GAMEINIT},//35 
+{"TickRate",CVAR_TYPE_INT,&Dedicated_tick_rate,0,MAX_DEDICATED_TICK_RATE,CVAR_GAMEINIT},//36
+{"TickStats",CVAR_TYPE_NONE,NULL,-1,-1,CVAR_GAMEPLAY},//37
 };
 
 #define CVAR_TIMELIMIT	1
@@ -142,6 +147,8 @@ cvar_entry CVars[] =
 #define CVAR_SETLEVEL		33
 #define CVAR_SETDIFF			34
 #define CVAR_MOTD			35
+#define CVAR_TICKRATE		36
+#define CVAR_TICKSTATS		37
 
 #define MAX_CVARS	(sizeof(CVars)/sizeof(cvar_entry))
 
@@ -317,6 +324,16 @@ void StartDedicatedServer()
 		return;
 
 	Dedicated_server = true;
+
+	t = FindArg("-tickrate");
+	if (t)
+	{
+		Dedicated_tick_rate = atoi(GameArgs[t + 1]);
+		if (Dedicated_tick_rate < 0)
+			Dedicated_tick_rate = 0;
+		if (Dedicated_tick_rate > MAX_DEDICATED_TICK_RATE)
+			Dedicated_tick_rate = MAX_DEDICATED_TICK_RATE;
+	}
 }
 
 // Sets the value for a cvar NONE type
@@ -349,6 +366,9 @@ void SetCVarNone(int index)
 	if (index == CVAR_STOPLOG)
 		rtp_StopLog();
 
+	if (index == CVAR_TICKSTATS)
+		PrintDedicatedTickStats();
+
 }
 
 // Sets the value for a cvar INT type
@@ -835,6 +855,8 @@ void PrintDedicatedMessage(const char* fmt, ...)
 #include <sys/types.h>
 #include <sys/time.h>
 #include <unistd.h>
+#include <poll.h>
+#include <time.h>
 
 #include "linux/linux_fix.h"
 #include "errno.h"
@@ -1162,3 +1184,176 @@ void DedicatedReadTelnet(void)
 			conn = conn->next;
 	}
 }
+
+// Most telnet connections the fixed tick loop watches while it sleeps
+#define MAX_WAIT_TELNET		16
+
+// A tick that finds itself more than this many ticks behind restarts the clock instead of catching up
+#define MAX_TICK_BACKLOG	4
+
+static tDedicatedTickStats Tick_stats;
+static double Tick_cpu_start = -1;
+
+// Returns how much cpu time the game thread has used.  Without a thread clock this is wall time.
+static double DedicatedCPUTime()
+{
+#ifdef __LINUX__
+	struct timespec ts;
+	if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) == 0)
+		return ts.tv_sec + ts.tv_nsec / 1000000000.0;
+#endif
+	return timer_GetTime64();
+}
+
+// Sleeps until the given time.  Network traffic and telnet connections wake the server early, get
+// handled, and it goes back to sleep.  The console is read through the keyboard driver, so typed
+// commands wait for the next tick.
+static void DedicatedSleepUntil(double when)
+{
+#ifdef __LINUX__
+	struct pollfd fds[MAX_WAIT_TELNET + 2];
+
+	while (1)
+	{
+		double now = timer_GetTime64();
+		if (now >= when)
+			break;
+
+		int net_fd;
+		if (!nw_BeginWait(&net_fd))
+		{
+			nw_DoNetworkIdle();
+			continue;
+		}
+
+		int num_fds = 0;
+		if (net_fd != -1)
+		{
+			fds[num_fds].fd = net_fd;
+			fds[num_fds++].events = POLLIN;
+		}
+		if (dedicated_listen_socket != INVALID_SOCKET)
+		{
+			fds[num_fds].fd = dedicated_listen_socket;
+			fds[num_fds++].events = POLLIN;
+		}
+		dedicated_socket* conn = Head_sock;
+		for (int i = 0; conn && i < MAX_WAIT_TELNET; i++, conn = conn->next)
+		{
+			fds[num_fds].fd = conn->sock;
+			fds[num_fds++].events = POLLIN;
+		}
+		for (int i = 0; i < num_fds; i++)
+			fds[i].revents = 0;
+
+		double wait = when - now;
+		struct timespec timeout;
+		timeout.tv_sec = (time_t)wait;
+		timeout.tv_nsec = (long)((wait - timeout.tv_sec) * 1000000000.0);
+
+		int ret = ppoll(fds, num_fds, &timeout, NULL);
+		nw_EndWait();
+
+		if (ret <= 0)
+			continue;
+
+		bool telnet_input = false;
+		for (int i = 0; i < num_fds; i++)
+		{
+			if (!fds[i].revents)
+				continue;
+			if (fds[i].fd == net_fd)
+				nw_DoNetworkIdle();
+			else
+				telnet_input = true;
+		}
+
+		if (telnet_input)
+		{
+			ListenDedicatedSocket();
+			DedicatedReadTelnet();
+		}
+	}
+#else
+	double now = timer_GetTime64();
+	if (now < when)
+		Sleep((unsigned int)((when - now) * 1000));
+#endif
+}
+
+// Runs the clock for the fixed tick loop.  last_tick is when the tick that just ran was due.
+// Sleeps until the next tick is due and returns when that is.
+double DedicatedWaitForTick(double last_tick)
+{
+	double tick = 1.0 / Dedicated_tick_rate;
+	double next_tick = last_tick + tick;
+	double now = timer_GetTime64();
+
+	// Account for the tick that just ran
+	if (Tick_cpu_start >= 0)
+	{
+		float cpu_time = DedicatedCPUTime() - Tick_cpu_start;
+
+		Tick_stats.ticks++;
+		Tick_stats.cpu_time += cpu_time;
+		if (cpu_time > Tick_stats.max_cpu_time)
+			Tick_stats.max_cpu_time = cpu_time;
+	}
+
+	if (now >= next_tick)
+	{
+		// Ran long, so start the next tick now.  If we're way behind, catching up would just
+		// run a burst of ticks back to back, so restart the clock instead.
+		Tick_stats.overruns++;
+		if (now - next_tick > tick * MAX_TICK_BACKLOG)
+			next_tick = now;
+	}
+	else
+	{
+		DedicatedSleepUntil(next_tick);
+		now = timer_GetTime64();
+	}
+
+	float late = now - next_tick;
+	if (late > 0)
+	{
+		Tick_stats.jitter += late;
+		if (late > Tick_stats.max_jitter)
+			Tick_stats.max_jitter = late;
+	}
+
+	Tick_cpu_start = DedicatedCPUTime();
+	return next_tick;
+}
+
+// Gets the fixed tick loop timing, and optionally starts a new sample
+void DedicatedGetTickStats(tDedicatedTickStats* stats, bool reset)
+{
+	*stats = Tick_stats;
+
+	if (reset)
+		memset(&Tick_stats, 0, sizeof(Tick_stats));
+}
+
+// Prints the fixed tick loop timing since the last time it was printed
+void PrintDedicatedTickStats()
+{
+	tDedicatedTickStats stats;
+
+	if (!Dedicated_tick_rate)
+	{
+		PrintDedicatedMessage("The server isn't running at a fixed tick rate.\n");
+		return;
+	}
+
+	DedicatedGetTickStats(&stats, true);
+	if (!stats.ticks)
+	{
+		PrintDedicatedMessage("No ticks have run yet.\n");
+		return;
+	}
+
+	PrintDedicatedMessage("%d ticks at %d/sec, %d overruns\n", stats.ticks, Dedicated_tick_rate, stats.overruns);
+	PrintDedicatedMessage("CPU per tick: %.2fms avg, %.2fms max\n", stats.cpu_time * 1000 / stats.ticks, stats.max_cpu_time * 1000);
+	PrintDedicatedMessage("Tick jitter: %.2fms avg, %.2fms max\n", stats.jitter * 1000 / stats.ticks, stats.max_jitter * 1000);
+}
@@ -46,6 +46,7 @@
 #include "multi_dll_mgr.h"
 #include "localization.h"
 #include "mem.h"
+#include "timedemo.h"
 
 //	---------------------------------------------------------------------------
 //	Variables
@@ -329,6 +330,8 @@ void MainLoop()
 			
 			cfclose(cfp);
 		}
+
+		TimedemoWriteReport();
 	}
 #if defined(OEM) 
 	if(!Dedicated_server)
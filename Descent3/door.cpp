@@ -30,6 +30,7 @@
 
 door Doors[MAX_DOORS];					// door info.
 int Num_doors=0;
+tNameIndex<MAX_DOORS> Door_names(Doors[0].name,sizeof(door));
 
 
 //	---------------------------------------------------------------------------
@@ -48,6 +49,7 @@ void InitDoors()
 		Doors[i].model_handle=-1;
 		//Doors[i].script_name[0] = 0;
 	}
+	Door_names.clear();
 	Num_doors=0;
 }
 
@@ -78,6 +80,7 @@ void FreeDoor (int n)
 	
 	Doors[n].used=0;
 	Doors[n].name[0]=0;
+	Door_names.update(n);
 	Num_doors--;
 }
 
@@ -132,15 +135,9 @@ int GetPrevDoor (int n)
 // or index of door with name
 int FindDoorName (char *name)
 {
-	int i;
-
 	ASSERT (name!=NULL);
 
-	for (i=0;i<MAX_DOORS;i++)
-		if (Doors[i].used && !stricmp (name,Doors[i].name))
-			return i;
-
-	return -1;
+	return Door_names.find (name);
 }
 
 // Given a filename, loads the model found in that file
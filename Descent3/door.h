@@ -29,6 +29,7 @@
 #include "pstypes.h"
 #include "manage.h"
 #include "object.h"
+#include "nameindex.h"
 
 
 // IMPORTANT!!!!!!!!!!!
@@ -68,6 +69,7 @@ struct door
 #define MAX_DOORS	60
 extern int Num_doors;				// number of actual doors in game.
 extern door Doors[];				
+extern tNameIndex<MAX_DOORS> Door_names;	// call Door_names.update(n) after changing Doors[n].name
 
 
 // Sets all doors to unused
@@ -50,6 +50,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include "psrand.h"
+#include "object_grid.h"
 #include <algorithm>
 
 // If an objects size is bigger than this, we create size/threshold extra explosions
@@ -1021,6 +1022,24 @@ void DoDyingFrame(object* objp)
 }
 extern void SetShakeMagnitude(float delta);
 // Pulls every object near the gravity field into its center
+// Fills list with the objects that might be within dist of pos, for the blast effects below
+// They measure with vm_VectorDistanceQuick, which can read up to 10% short, so the search is
+// widened to match.  Returns the number of objects in the list.
+static int GetBlastObjects(vector* pos, float dist, short* list)
+{
+	int num = ObjGridQueryRadius(pos, dist * 1.125f, list, MAX_OBJECTS);
+
+	// Too far for the object grid, so check everything
+	if (num < 0)
+	{
+		num = 0;
+		for (int i = 0; i <= Highest_object_index; i++)
+			list[num++] = i;
+	}
+
+	return num;
+}
+
 void DoGravityFieldEffect(object* obj)
 {
 	float max_size = obj->ctype.blast_info.max_size;
@@ -1161,8 +1180,11 @@ void DoGravityFieldEffect(object* obj)
 		}
 	}
 
-	for (i = 0; i <= Highest_object_index; i++)
+	short blast_objs[MAX_OBJECTS];
+	int num_blast_objs = GetBlastObjects(&obj->pos, max_size * 2, blast_objs);
+	for (int n = 0; n < num_blast_objs; n++)
 	{
+		i = blast_objs[n];
 		hit_obj_ptr = &Objects[i];
 		if (!(hit_obj_ptr->type == OBJ_PLAYER || hit_obj_ptr->type == OBJ_ROBOT || hit_obj_ptr->type == OBJ_WEAPON || hit_obj_ptr->type == OBJ_POWERUP || hit_obj_ptr->type == OBJ_CLUTTER || (hit_obj_ptr->type == OBJ_BUILDING && hit_obj_ptr->ai_info)))
 			continue;
@@ -1364,9 +1386,12 @@ void DoConcussiveForce(object* explode_obj_ptr, int parent_handle, float player_
 		float damage;
 		int i;
 		object* hit_obj_ptr;
+		short blast_objs[MAX_OBJECTS];
+		int num_blast_objs = GetBlastObjects(&explode_obj_ptr->pos, effect_distance, blast_objs);
 
-		for (i = 0; i <= Highest_object_index; i++)
+		for (int n = 0; n < num_blast_objs; n++)
 		{
+			i = blast_objs[n];
 			//	Weapons used to be affected by badass explosions, but this introduces serious problems.
 			//	When a smart bomb blows up, if one of its children goes right towards a nearby wall, it will
 			//	blow up, blowing up all the children.  So I remove it.  MK, 09/11/94
@@ -27,6 +27,7 @@
 
 gamefile Gamefiles[MAX_GAMEFILES];
 int Num_gamefiles = 0;
+tNameIndex<MAX_GAMEFILES> Gamefile_names(Gamefiles[0].name, sizeof(gamefile));
 
 // Sets all gamefiles to unused
 void InitGamefiles()
@@ -36,6 +37,7 @@ void InitGamefiles()
 		Gamefiles[i].used = 0;
 		Gamefiles[i].name[0] = 0;
 	}
+	Gamefile_names.clear();
 	Num_gamefiles = 0;
 }
 
@@ -47,6 +49,7 @@ int AllocGamefile()
 		if (Gamefiles[i].used == 0)
 		{
 			memset(&Gamefiles[i], 0, sizeof(gamefile));
+			Gamefile_names.update(i);
 			Gamefiles[i].used = 1;
 			Num_gamefiles++;
 			return i;
@@ -64,6 +67,7 @@ void FreeGamefile(int n)
 
 	Gamefiles[n].used = 0;
 	Gamefiles[n].name[0] = 0;
+	Gamefile_names.update(n);
 	Num_gamefiles--;
 }
 
@@ -117,9 +121,5 @@ int FindGamefileName(char* name)
 {
 	ASSERT(name != NULL);
 
-	for (int i = 0; i < MAX_GAMEFILES; i++)
-		if (Gamefiles[i].used && !stricmp(name, Gamefiles[i].name))
-			return i;
-
-	return -1;
+	return Gamefile_names.find(name);
 }
@@ -20,6 +20,7 @@
 
 #include "pstypes.h"
 #include "manage.h"
+#include "nameindex.h"
 
 #define MAX_GAMEFILES		1500
 
@@ -32,6 +33,7 @@ struct gamefile
 
 extern int Num_gamefiles;
 extern gamefile Gamefiles[MAX_GAMEFILES];
+extern tNameIndex<MAX_GAMEFILES> Gamefile_names;	// call Gamefile_names.update(n) after changing Gamefiles[n].name
 
 // Sets all gamefiles to unused
 void InitGamefiles ();
@@ -87,6 +87,8 @@
 #include "vibeinterface.h"
 
 #include "args.h"
+#include "jobs.h"
+#include "timedemo.h"
 void ResetHudMessages(void);
 
 //	Variables
@@ -227,7 +229,11 @@ bool GameSequencer()
 		case GAMESTATE_GAMEGAUGEDEMO:
 		{
 			char ggdemopath[_MAX_PATH * 2];
-			ddio_MakePath(ggdemopath, User_directory, "demo", Game_gauge_usefile, NULL);
+			//A timedemo can be given a path, or the name of a demo in the demo directory
+			if (Timedemo_on && cfexist(TimedemoFile()))
+				strcpy(ggdemopath, TimedemoFile());
+			else
+				ddio_MakePath(ggdemopath, User_directory, "demo", Timedemo_on ? TimedemoFile() : Game_gauge_usefile, NULL);
 			if (DemoPlaybackFile(ggdemopath))
 				SetGameState(GAMESTATE_LVLPLAYING);
 			else
@@ -1508,6 +1514,71 @@ int paged_in_num = 0;
 
 //#define PAGED_IN_CALC paged_in_count ? (float)paged_in_count/(float)need_to_page_in : 0.0f
 #define PAGED_IN_CALC paged_in_num ? (float)paged_in_num/(float)need_to_page_num : 0.0f
+
+extern short Level_bitmaps_to_page[];
+extern int Num_level_bitmaps_to_page;
+
+// How many bitmaps each job worker decodes between progress bar updates
+#define BITMAP_PAGE_BATCH_PER_WORKER	8
+
+// Job callback: reads and decodes a slice of a batch of level bitmaps
+static void DecodeLevelBitmaps(void* data, int start, int end, int)
+{
+	bm_decoded_file* batch = (bm_decoded_file*)data;
+
+	for (int i = start; i < end; i++)
+		bm_DecodeBitmapFile(batch[i].handle, &batch[i]);
+}
+
+// Pages in the level texture bitmaps that CountDataToPageIn() found.  The files are decoded on the
+// job workers a batch at a time, and each batch is handed to the bitmap system here, so the
+// texture walk in PageInAllData() finds them already resident.
+void PageInLevelBitmaps()
+{
+	if (Dedicated_server || !Num_level_bitmaps_to_page)
+		return;
+
+	int batch_size = job_NumWorkers() * BITMAP_PAGE_BATCH_PER_WORKER;
+	bm_decoded_file* batch = (bm_decoded_file*)mem_malloc(batch_size * sizeof(bm_decoded_file));
+	int i = 0, t;
+
+	while (i < Num_level_bitmaps_to_page)
+	{
+		int count = 0;
+
+		for (; i < Num_level_bitmaps_to_page && count < batch_size; i++)
+		{
+			int handle = Level_bitmaps_to_page[i];
+
+			if (!GameBitmaps[handle].used || !(GameBitmaps[handle].flags & BF_NOT_RESIDENT))
+				continue;
+
+			// Textures can share a bitmap
+			for (t = 0; t < count; t++)
+				if (batch[t].handle == handle)
+					break;
+
+			if (t == count)
+				batch[count++].handle = handle;
+		}
+
+		job_Run(count, DecodeLevelBitmaps, batch);
+
+		for (t = 0; t < count; t++)
+		{
+			if (bm_CommitBitmapFile(&batch[t]))
+				GameBitmaps[batch[t].handle].flags |= BF_CHANGED | BF_BRAND_NEW;
+			else
+				mprintf((0, "Error paging in bitmap %s!\n", GameBitmaps[batch[t].handle].name));
+		}
+
+		LoadLevelProgress(LOAD_PROGRESS_PAGING_DATA, PAGED_IN_CALC);
+	}
+
+	mem_free(batch);
+	Num_level_bitmaps_to_page = 0;
+}
+
 void PageInShip(int id)
 {
 	int i, t;
@@ -1751,6 +1822,9 @@ void PageInAllData()
 	memset(Sounds_to_free, 0, MAX_SOUNDS);
 	memset(Models_to_free, 0, MAX_POLY_MODELS);
 
+	// Decode the level's texture bitmaps in parallel before walking everything else
+	PageInLevelBitmaps();
+
 	PageInShip(Players[Player_num].ship_index);
 	LoadLevelProgress(LOAD_PROGRESS_PAGING_DATA, PAGED_IN_CALC);
 	/*
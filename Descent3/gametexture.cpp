@@ -36,6 +36,7 @@
 
 int Num_textures = 0;
 texture GameTextures[MAX_TEXTURES];
+tNameIndex<MAX_TEXTURES> Texture_names(GameTextures[0].name, sizeof(texture));
 
 extern bool Mem_superlow_memory_mode;
 
@@ -56,10 +57,12 @@ int InitTextures()
 	mprintf((0, "Initializing texture system.\n"));
 	for (int i = 0; i < MAX_TEXTURES; i++)
 		GameTextures[i].used = 0;
+	Texture_names.clear();
 
 	int tex = AllocTexture();
 	GameTextures[tex].bm_handle = BAD_BITMAP_HANDLE;
 	strcpy(GameTextures[tex].name, "SAMPLE TEXTURE");
+	Texture_names.update(tex);
 
 	// Initialize procedural tables and such
 	InitProcedurals();
@@ -91,6 +94,7 @@ int AllocTexture(void)
 	GameTextures[i].bumpmap = -1;
 	GameTextures[i].procedural = NULL;
 	GameTextures[i].name[0] = 0;
+	Texture_names.update(i);
 	GameTextures[i].flags = 0;		//default to no type
 	GameTextures[i].alpha = 1.0;
 	GameTextures[i].speed = 1.0;
@@ -105,21 +109,9 @@ int AllocTexture(void)
 // or index of texture with name
 int FindTextureName(char* name)
 {
-	int i, num_counted = 0;;
-
 	ASSERT(name != NULL);
 
-	for (i = 0; i < MAX_TEXTURES && num_counted < Num_textures; i++)
-	{
-		if (GameTextures[i].used)
-		{
-			num_counted++;
-			if (!stricmp(name, GameTextures[i].name))
-				return i;
-		}
-	}
-
-	return -1;
+	return Texture_names.find(name);
 }
 
 // Searches thru all textures for a bitmap of a specific name, returns -1 if not found
@@ -658,6 +650,7 @@ void FreeTexture(int n)
 
 	GameTextures[n].used = 0;
 	GameTextures[n].name[0] = 0;
+	Texture_names.update(n);
 	Num_textures--;
 
 	FreeProceduralForTexture(n);
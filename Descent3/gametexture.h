@@ -25,6 +25,7 @@
 #else
 
 #include "manage.h"
+#include "nameindex.h"
 
 #define TF_VOLATILE				1
 #define TF_WATER				(1<<1)
@@ -143,6 +144,7 @@ struct texture
 
 extern texture GameTextures[MAX_TEXTURES];
 extern int Num_textures;
+extern tNameIndex<MAX_TEXTURES> Texture_names;	// call Texture_names.update(n) after changing GameTextures[n].name
 
 // Inits the texture system, returning 1 if successful
 int InitTextures();
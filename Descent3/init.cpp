@@ -92,6 +92,8 @@
 #include "rocknride.h"
 #include "vibeinterface.h"
 #include "gamespy.h"
+#include "jobs.h"
+#include "timedemo.h"
 
 
 //Uncomment this to allow all languages
@@ -456,6 +458,10 @@ void LoadGameSettings()
 		strcpy(Game_gauge_usefile,GameArgs[tt_arg+1]);
 	}
 
+	// A timedemo is a game gauge run that isn't held back by the frame cap or vsync
+	if(TimedemoInit())
+		Game_gauge_do_time_test = true;
+
 	Detail_settings.Specular_lighting = false;
 	Detail_settings.Dynamic_lighting = true;
 	Detail_settings.Fast_headlight_on = true;
@@ -572,6 +578,8 @@ void LoadGameSettings()
 
 	if (FindArg ("-vsync"))
 		Render_preferred_state.vsync_on=true;
+	if (Timedemo_on)
+		Render_preferred_state.vsync_on=false;
 
 //@@	// Base missile camera if in wrong window
 //@@	if (Missile_camera_window==SVW_CENTER)
@@ -657,6 +665,10 @@ void LoadGameSettings()
 
 	// We only support OpenGL now...
 	PreferredRenderer = RENDERER_OPENGL;
+
+	// ...or the null renderer, which only counts the GL calls it gets, for profiling without a GPU
+	if(FindArg("-nullrenderer"))
+		PreferredRenderer = RENDERER_NONE;
 }
 
 
@@ -885,6 +897,10 @@ void InitIOSystems(bool editor)
 	RTP_ENABLEFLAGS(RTI_WEATHERFRAMETIME|RTI_PLAYERFRAMETIME|RTI_DOORFRAMETIME|RTI_LEVELGOALTIME|RTI_MATCENFRAMETIME);
 	RTP_ENABLEFLAGS(RTI_OBJFRAMETIME|RTI_AIFRAMETIME|RTI_PROCESSKEYTIME);
 
+	// -profile starts the performance log right away, for dedicated servers and benchmark runs
+	if (FindArg("-profile"))
+		rtp_StartLog();
+
 //	Read in stuff from the registry
 	LoadGameSettings();
 
@@ -909,6 +925,10 @@ void InitIOSystems(bool editor)
 	}
 
 	//Init hogfiles
+	//Hogs are memory mapped unless told otherwise, which may be needed if address space is tight
+	if (FindArg("-nohogmap"))
+		cf_SetLibraryMapping(false);
+
 	int d3_hid=-1,extra_hid=-1,extra1_hid=-1,merc_hid=-1,sys_hid=-1,extra13_hid=-1;
 	char fullname[_MAX_PATH];
 	
@@ -1361,6 +1381,9 @@ bool CheckCdForValidity(int cd);
 
 // Initializes the fvi structures for quicker operation
    InitFVI();
+
+// Starts the worker threads (needs the fvi stuff)
+	InitJobs();
 	
 // Initializes the matcens
 	InitMatcens();
@@ -0,0 +1,201 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "jobs.h"
+#include "args.h"
+#include "mono.h"
+#include "pserror.h"
+#include "rtperformance.h"
+
+#include <stdlib.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Batches smaller than this per worker aren't worth waking anyone up for
+#define MIN_JOB_ITEMS_PER_WORKER	4
+
+static int Num_job_workers=1;
+static std::thread Job_threads[MAX_JOB_WORKERS];
+static fvi_context *Job_fvi_contexts[MAX_JOB_WORKERS];
+
+static std::mutex Job_lock;
+static std::condition_variable Job_start_cv,Job_done_cv;
+
+// The batch currently being worked on
+static job_func Job_func;
+static void *Job_data;
+static int Job_count;
+static int Job_active_workers;
+static int Job_generation;
+static int Job_remaining;
+static bool Job_quit;
+
+// Works out the slice of the current batch that belongs to a worker
+static void GetJobSlice(int worker,int count,int num_workers,int *start,int *end)
+{
+	*start=(int)(((long long)count*worker)/num_workers);
+	*end=(int)(((long long)count*(worker+1))/num_workers);
+}
+
+static void JobWorkerThread(int worker)
+{
+	int last_generation=0;
+
+	while (1)
+	{
+		job_func func;
+		void *data;
+		int count,num_workers;
+
+		{
+			std::unique_lock<std::mutex> lock(Job_lock);
+			Job_start_cv.wait(lock,[&]{return Job_quit || Job_generation!=last_generation;});
+
+			if (Job_quit)
+				return;
+
+			last_generation=Job_generation;
+			func=Job_func;
+			data=Job_data;
+			count=Job_count;
+			num_workers=Job_active_workers;
+		}
+
+		if (worker<num_workers)
+		{
+			int start,end;
+			GetJobSlice(worker,count,num_workers,&start,&end);
+			if (start<end)
+			{
+				RTP_ZONE(job_slice);
+				(*func)(data,start,end,worker);
+			}
+
+			std::lock_guard<std::mutex> lock(Job_lock);
+			if (--Job_remaining==0)
+				Job_done_cv.notify_one();
+		}
+	}
+}
+
+// Starts the worker threads.  -jobthreads <n> overrides the count, 1 runs everything serially
+void InitJobs()
+{
+	int arg=FindArg("-jobthreads");
+
+	if (arg)
+		Num_job_workers=atoi(GameArgs[arg+1]);
+	else
+		Num_job_workers=std::thread::hardware_concurrency();
+
+	if (Num_job_workers<1)
+		Num_job_workers=1;
+	if (Num_job_workers>MAX_JOB_WORKERS)
+		Num_job_workers=MAX_JOB_WORKERS;
+
+	// The main thread is worker 0 and keeps using the main FVI context
+	Job_fvi_contexts[0]=&Fvi_main_context;
+	Job_quit=false;
+	Job_generation=0;
+
+	for (int i=1;i<Num_job_workers;i++)
+	{
+		Job_fvi_contexts[i]=fvi_CreateContext();
+		Job_threads[i]=std::thread(JobWorkerThread,i);
+	}
+
+	mprintf((0,"Job system using %d worker(s)\n",Num_job_workers));
+
+	atexit(CloseJobs);
+}
+
+// Stops the worker threads
+void CloseJobs()
+{
+	{
+		std::lock_guard<std::mutex> lock(Job_lock);
+		Job_quit=true;
+	}
+	Job_start_cv.notify_all();
+
+	for (int i=1;i<Num_job_workers;i++)
+	{
+		if (Job_threads[i].joinable())
+			Job_threads[i].join();
+
+		if (Job_fvi_contexts[i])
+		{
+			fvi_DestroyContext(Job_fvi_contexts[i]);
+			Job_fvi_contexts[i]=NULL;
+		}
+	}
+
+	Num_job_workers=1;
+}
+
+// Returns how many workers (including the main thread) a batch is split across
+int job_NumWorkers()
+{
+	return Num_job_workers;
+}
+
+// Runs func over count items and waits for all of them to finish
+void job_Run(int count,job_func func,void *data)
+{
+	if (count<=0)
+		return;
+
+	int num_workers=count/MIN_JOB_ITEMS_PER_WORKER;
+	if (num_workers>Num_job_workers)
+		num_workers=Num_job_workers;
+
+	if (num_workers<=1)
+	{
+		(*func)(data,0,count,0);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(Job_lock);
+		Job_func=func;
+		Job_data=data;
+		Job_count=count;
+		Job_active_workers=num_workers;
+		Job_remaining=num_workers-1;
+		Job_generation++;
+	}
+	Job_start_cv.notify_all();
+
+	// Do our own share while the others work
+	int start,end;
+	GetJobSlice(0,count,num_workers,&start,&end);
+	if (start<end)
+		(*func)(data,start,end,0);
+
+	std::unique_lock<std::mutex> lock(Job_lock);
+	Job_done_cv.wait(lock,[]{return Job_remaining==0;});
+}
+
+// Returns the private FVI context for a worker
+fvi_context *job_GetFVIContext(int worker)
+{
+	ASSERT(worker>=0 && worker<Num_job_workers);
+
+	return Job_fvi_contexts[worker];
+}
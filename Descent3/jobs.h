@@ -0,0 +1,47 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef JOBS_H
+#define JOBS_H
+
+#include "findintersection.h"
+
+// Most worker threads (including the main thread) that will ever be started
+#define MAX_JOB_WORKERS		16
+
+// A job works on items [start,end) of its batch.  worker is 0 for the main thread.
+typedef void (*job_func)(void *data,int start,int end,int worker);
+
+// Starts the worker threads.  -jobthreads <n> overrides the count, 1 runs everything serially
+void InitJobs();
+
+// Stops the worker threads
+void CloseJobs();
+
+// Returns how many workers (including the main thread) a batch is split across
+int job_NumWorkers();
+
+// Runs func over count items and waits for all of them to finish.
+// Each worker gets one contiguous slice, and the slices only depend on count and the
+// number of workers, so a batch is always split the same way.
+void job_Run(int count,job_func func,void *data);
+
+// Returns the private FVI context for a worker, so searches can run side by side
+fvi_context *job_GetFVIContext(int worker);
+
+#endif
@@ -26,6 +26,8 @@
 #include "room.h"
 #include <string.h>
 #include <stdlib.h>
+#include <vector>
+#include <algorithm>
 #include "findintersection.h"
 #include "lightmap_info.h"
 #include "polymodel.h"
@@ -35,6 +37,8 @@
 #include "dedicated_server.h"
 #include "objinfo.h"
 #include "Macros.h"
+#include "jobs.h"
+#include "cpufeatures.h"
 
 #define NUM_DYNAMIC_CLASSES	7
 #define MAX_DYNAMIC_FACES	2000
@@ -1127,23 +1131,287 @@ void ApplyLightingToObjects(vector* pos, int roomnum, float light_dist, float re
 	}
 }
 
-// Applys dynamic lightmap changes to rooms and room objects.  If light direction is non-null, we are applying a directional light
-void ApplyLightingToRooms(vector* pos, int roomnum, float light_dist, float red_scale, float green_scale, float blue_scale, vector* light_direction, float dot_range)
-{
-	fvi_face_room_list facelist[MAX_DYNAMIC_FACES];
-	ushort lmilist[MAX_DYNAMIC_FACES];
-	int num_spoken_for = 0;
+// Dynamic lights cast while queueing is on are stored here until FlushQueuedLighting()
+#define MAX_QUEUED_LIGHTS	256
 
-	int num_faces, i, t, lm_handle;
+typedef struct
+{
+	vector pos;
+	vector light_direction;
+	int roomnum;			// cell number for terrain lights
+	float light_dist;
+	float red_scale, green_scale, blue_scale;
+	float dot_range;
+	bool use_direction;
+	bool terrain;
+
+	// Where the search results for this light were put
+	int worker;
+	int first_element, num_elements;	// faces for room lights, cells for terrain lights
+} queued_light;
+
+static queued_light Queued_lights[MAX_QUEUED_LIGHTS];
+static int Num_queued_lights = 0;
+static bool Queue_lighting = false;
+
+// Search results for the queued lights, one set per job worker
+static std::vector<fvi_face_room_list> Queued_face_results[MAX_JOB_WORKERS];
+static std::vector<int> Queued_cell_results[MAX_JOB_WORKERS];
+
+// A light's effect on one rectangle of a lightmap.  ApplyLightingToFaceList() does all the
+// bookkeeping for a face and leaves the texels to CompositeLightmapWork()
+typedef struct
+{
+	const queued_light* light;
 	ushort* dest_data;
-	int faces_misreported = 0;
+	int lm_handle;
+	int texel_num;			// first texel of the rectangle
+	int lmw;				// width of the whole lightmap
+	int width, height;
+	vector base_vector;		// position of the first texel
+	vector xstep, ystep;	// distance between texels across and down
+} lightmap_work;
 
-	if (Dedicated_server)
-		return;
+static std::vector<lightmap_work> Lightmap_work;
+static std::vector<int> Lightmap_work_order;
+static std::vector<int> Lightmap_bins;
 
-	ApplyLightingToObjects(pos, roomnum, light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
+static void ApplyQueuedLights();
 
-	num_faces = fvi_QuickDistFaceList(roomnum, pos, light_dist, facelist, MAX_DYNAMIC_FACES);
+static void SetupLight(queued_light* ql, bool terrain, vector* pos, int roomnum, float light_dist, float red_scale, float green_scale, float blue_scale, vector* light_direction, float dot_range)
+{
+	ql->pos = *pos;
+	ql->roomnum = roomnum;
+	ql->light_dist = light_dist;
+	ql->red_scale = red_scale;
+	ql->green_scale = green_scale;
+	ql->blue_scale = blue_scale;
+	ql->dot_range = dot_range;
+	ql->terrain = terrain;
+
+	if (light_direction)
+	{
+		ql->light_direction = *light_direction;
+		ql->use_direction = true;
+	}
+	else
+		ql->use_direction = false;
+}
+
+// Adds a light to the queue, applying everything queued so far if it's full.  Only the face and
+// cell searches are queued, since they depend on nothing but the light and the level geometry.
+static void QueueLight(bool terrain, vector* pos, int roomnum, float light_dist, float red_scale, float green_scale, float blue_scale, vector* light_direction, float dot_range)
+{
+	if (Num_queued_lights == MAX_QUEUED_LIGHTS)
+		ApplyQueuedLights();
+
+	SetupLight(&Queued_lights[Num_queued_lights++], terrain, pos, roomnum, light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
+}
+
+#ifdef CPU_SIMD
+// Four texels at a time version of vm_VectorDistanceQuick() and, for directional lights,
+// the vm_NormalizeVectorFast() and vm_DotProduct() against the light direction.  Does the
+// same float operations in the same order, so the results are identical
+CPU_TARGET("sse2") static void TexelDistancesSSE2(const float* ex, const float* ey, const float* ez, int count, const vector* pos, const vector* light_direction, float* dist, float* dp)
+{
+	const __m128 sign = _mm_set1_ps(-0.0f);
+	const __m128 px = _mm_set1_ps(pos->x), py = _mm_set1_ps(pos->y), pz = _mm_set1_ps(pos->z);
+
+	for (int i = 0; i < count; i += 4)
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(ex + i), px);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(ey + i), py);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(ez + i), pz);
+
+		// Sort the absolute values so a >= b >= c
+		__m128 a = _mm_andnot_ps(sign, dx);
+		__m128 b = _mm_andnot_ps(sign, dy);
+		__m128 c = _mm_andnot_ps(sign, dz);
+		__m128 hi = _mm_max_ps(a, b);
+		__m128 lo = _mm_min_ps(a, b);
+		a = _mm_max_ps(hi, c);
+		b = _mm_max_ps(lo, _mm_min_ps(hi, c));
+		c = _mm_min_ps(lo, c);
+
+		__m128 bc = _mm_add_ps(_mm_mul_ps(b, _mm_set1_ps(0.25f)), _mm_mul_ps(c, _mm_set1_ps(0.125f)));
+		__m128 mag = _mm_add_ps(_mm_add_ps(a, bc), _mm_mul_ps(bc, _mm_set1_ps(0.5f)));
+		_mm_storeu_ps(dist + i, mag);
+
+		if (light_direction)
+		{
+			__m128 nonzero = _mm_cmpneq_ps(mag, _mm_setzero_ps());
+			__m128 nx = _mm_and_ps(nonzero, _mm_div_ps(dx, mag));
+			__m128 ny = _mm_and_ps(nonzero, _mm_div_ps(dy, mag));
+			__m128 nz = _mm_and_ps(nonzero, _mm_div_ps(dz, mag));
+			__m128 d = _mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, _mm_set1_ps(light_direction->x)), _mm_mul_ps(ny, _mm_set1_ps(light_direction->y))), _mm_mul_ps(nz, _mm_set1_ps(light_direction->z)));
+			_mm_storeu_ps(dp + i, d);
+		}
+	}
+}
+#endif
+
+// Gets the distance from the light to count texels, plus the dot product with the light
+// direction if there is one
+static void TexelDistances(const float* ex, const float* ey, const float* ez, int count, vector* pos, vector* light_direction, float* dist, float* dp)
+{
+	int i = 0;
+
+#ifdef CPU_SIMD
+	if (cpu_HaveSSE2())
+	{
+		i = count & ~3;
+		TexelDistancesSSE2(ex, ey, ez, i, pos, light_direction, dist, dp);
+	}
+#endif
+
+	for (; i < count; i++)
+	{
+		vector element_vec;
+		element_vec.x = ex[i];
+		element_vec.y = ey[i];
+		element_vec.z = ez[i];
+
+		dist[i] = vm_VectorDistanceQuick(&element_vec, pos);
+
+		if (light_direction)
+		{
+			vector lsubvec = element_vec - *pos;
+			vm_NormalizeVectorFast(&lsubvec);
+			dp[i] = vm_DotProduct(&lsubvec, light_direction);
+		}
+	}
+}
+
+// How many texels of a row CompositeLightmapWork() works out the distances for at once
+#define TEXEL_CHUNK	128
+
+// Changes each texel of a lightmap rectangle for the light that set it up
+static void CompositeLightmapWork(const lightmap_work* lw)
+{
+	const queued_light* ql = lw->light;
+	vector pos = ql->pos;
+	vector direction = ql->light_direction;
+	vector* light_direction = ql->use_direction ? &direction : NULL;
+	float light_dist = ql->light_dist;
+	float red_scale = ql->red_scale;
+	float green_scale = ql->green_scale;
+	float blue_scale = ql->blue_scale;
+	float dot_range = ql->dot_range;
+	ushort* dest_data = lw->dest_data;
+	int width = lw->width;
+
+	int red_limit = 31;
+	int green_limit = 31;
+	int blue_limit = 31;
+
+	float ex[TEXEL_CHUNK], ey[TEXEL_CHUNK], ez[TEXEL_CHUNK];
+	float dist[TEXEL_CHUNK], dp[TEXEL_CHUNK];
+
+	vector base_vector = lw->base_vector;
+	int texel_num = lw->texel_num;
+	for (int y = 0; y < lw->height; y++, base_vector -= lw->ystep, texel_num += lw->lmw)
+	{
+		vector element_vec = base_vector;
+
+		// Rows wider than the buffers are done a piece at a time
+		for (int first = 0; first < width; first += TEXEL_CHUNK)
+		{
+			int count = min(TEXEL_CHUNK, width - first);
+
+			for (int x = 0; x < count; x++, element_vec += lw->xstep)
+			{
+				ex[x] = element_vec.x;
+				ey[x] = element_vec.y;
+				ez[x] = element_vec.z;
+			}
+
+			TexelDistances(ex, ey, ez, count, &pos, light_direction, dist, dp);
+
+			for (int x = 0; x < count; x++)
+			{
+				int lightmap_texel_num = texel_num + first + x;
+
+				ushort lightmap_texel = dest_data[lightmap_texel_num];
+
+				if (!(lightmap_texel & OPAQUE_FLAG))
+					continue;
+
+				float scalar = 1.0 - (dist[x] / light_dist);
+
+				if (light_direction)
+				{
+					if (dp[x] < dot_range)
+						continue;
+					else
+					{
+
+						float add_scale = (dp[x] - dot_range) / (1.0 - dot_range);
+						scalar *= add_scale;
+					}
+				}
+
+				if (scalar <= 0)
+					continue;
+
+				int r = (lightmap_texel >> 10) & 0x1f;
+				int g = (lightmap_texel >> 5) & 0x1f;
+				int b = lightmap_texel & 0x1f;
+
+				if (red_scale < 0)
+				{
+					// we are subtracting light
+					r = max(0, r + (scalar * red_scale * 31));
+				}
+				else
+				{
+					// we are adding light
+					if (r < red_limit)
+						r = min(red_limit, r + (scalar * red_scale * 31));
+				}
+
+				if (green_scale < 0)
+				{
+					// we are subtracting light
+					g = max(0, g + (scalar * green_scale * 31));
+				}
+				else
+				{
+					// we are adding light
+					if (g < green_limit)
+						g = min(green_limit, g + (scalar * green_scale * 31));
+				}
+
+				if (blue_scale < 0)
+				{
+					// we are subtracting light
+					b = max(0, b + (scalar * blue_scale * 31));
+				}
+				else
+				{
+					if (b < blue_limit)
+						b = min(blue_limit, b + (scalar * blue_scale * 31));
+				}
+
+				lightmap_texel = OPAQUE_FLAG | (r << 10) | (g << 5) | b;
+
+				dest_data[lightmap_texel_num] = lightmap_texel;
+			}
+		}
+	}
+}
+
+// Sets up the dynamic lightmap changes for the faces found by fvi_QuickDistFaceList(),
+// adding the lightmap rectangles the light touches to Lightmap_work
+static void ApplyLightingToFaceList(fvi_face_room_list* facelist, int num_faces, queued_light* ql)
+{
+	vector* pos = &ql->pos;
+	float light_dist = ql->light_dist;
+	vector* light_direction = ql->use_direction ? &ql->light_direction : NULL;
+	ushort lmilist[MAX_DYNAMIC_FACES];
+	int num_spoken_for = 0;
+
+	int i, t, lm_handle;
+	ushort* dest_data;
 
 #ifdef _DEBUG
 	if (num_faces == MAX_DYNAMIC_FACES)
@@ -1155,10 +1423,6 @@ void ApplyLightingToRooms(vector* pos, int roomnum, float light_dist, float red_
 	if (num_faces < 1)
 		return;
 
-	int red_limit = 31;
-	int green_limit = 31;
-	int blue_limit = 31;
-
 	for (i = 0; i < num_faces; i++)
 	{
 		room* rp = &Rooms[facelist[i].room_index];
@@ -1363,7 +1627,7 @@ void ApplyLightingToRooms(vector* pos, int roomnum, float light_dist, float red_
 			Edges_to_blend[Num_edges_to_blend++] = fp->lmi_handle;
 		}
 
-		vector element_vec;
+		lightmap_work lw;
 
 		base_vector -= (start_y * (facematrix.uvec * lmi_ptr->yspacing));
 		base_vector += (start_x * (facematrix.rvec * lmi_ptr->xspacing));
@@ -1371,95 +1635,55 @@ void ApplyLightingToRooms(vector* pos, int roomnum, float light_dist, float red_
 		base_vector -= ((facematrix.uvec / 2) * lmi_ptr->yspacing);
 		base_vector += ((facematrix.rvec / 2) * lmi_ptr->xspacing);
 
-		// Go through and change each element of this lightmap
-		// SLOW!
-
-		int texel_num = ((start_y + lmi_ptr->y1) * lmw) + start_x + lmi_ptr->x1;
-		for (int y = 0; y < height; y++, base_vector -= (facematrix.uvec * lmi_ptr->yspacing), texel_num += lmw)
-		{
-			element_vec = base_vector;
-
-			for (int x = 0; x < width; x++, element_vec += (facematrix.rvec * lmi_ptr->xspacing))
-			{
-				int lightmap_texel_num = texel_num + x;
-
-				ushort lightmap_texel = dest_data[lightmap_texel_num];
-
-				if (!(lightmap_texel & OPAQUE_FLAG))
-					continue;
-
-				float dist = vm_VectorDistanceQuick(&element_vec, pos);
-				float scalar = 1.0 - (dist / light_dist);
-
-				if (light_direction)
-				{
-					vector lsubvec = element_vec - *pos;
-					vm_NormalizeVectorFast(&lsubvec);
-					float dp = vm_DotProduct(&lsubvec, light_direction);
-					if (dp < dot_range)
-						continue;
-					else
-					{
+		lw.light = ql;
+		lw.dest_data = dest_data;
+		lw.lm_handle = lm_handle;
+		lw.texel_num = ((start_y + lmi_ptr->y1) * lmw) + start_x + lmi_ptr->x1;
+		lw.lmw = lmw;
+		lw.width = width;
+		lw.height = height;
+		lw.base_vector = base_vector;
+		lw.xstep = facematrix.rvec * lmi_ptr->xspacing;
+		lw.ystep = facematrix.uvec * lmi_ptr->yspacing;
+		Lightmap_work.push_back(lw);
+	}
 
-						float add_scale = (dp - dot_range) / (1.0 - dot_range);
-						scalar *= add_scale;
-					}
-				}
+	for (i = 0; i < num_spoken_for; i++)
+	{
+		int index = lmilist[i];
+		Lmi_spoken_for[index / 8] = 0;
+	}
+}
 
-				if (scalar <= 0)
-					continue;
+// Applys dynamic lightmap changes to rooms and room objects.  If light direction is non-null, we are applying a directional light
+void ApplyLightingToRooms(vector* pos, int roomnum, float light_dist, float red_scale, float green_scale, float blue_scale, vector* light_direction, float dot_range)
+{
+	fvi_face_room_list facelist[MAX_DYNAMIC_FACES];
+	int num_faces;
 
-				int r = (lightmap_texel >> 10) & 0x1f;
-				int g = (lightmap_texel >> 5) & 0x1f;
-				int b = lightmap_texel & 0x1f;
+	if (Dedicated_server)
+		return;
 
-				if (red_scale < 0)
-				{
-					// we are subtracting light
-					r = max(0, r + (scalar * red_scale * 31));
-				}
-				else
-				{
-					// we are adding light
-					if (r < red_limit)
-						r = min(red_limit, r + (scalar * red_scale * 31));
-				}
+	// Objects are lit right away, while they're still where the light found them
+	ApplyLightingToObjects(pos, roomnum, light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
 
-				if (green_scale < 0)
-				{
-					// we are subtracting light
-					g = max(0, g + (scalar * green_scale * 31));
-				}
-				else
-				{
-					// we are adding light
-					if (g < green_limit)
-						g = min(green_limit, g + (scalar * green_scale * 31));
-				}
+	if (Queue_lighting)
+	{
+		QueueLight(false, pos, roomnum, light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
+		return;
+	}
 
-				if (blue_scale < 0)
-				{
-					// we are subtracting light
-					b = max(0, b + (scalar * blue_scale * 31));
-				}
-				else
-				{
-					if (b < blue_limit)
-						b = min(blue_limit, b + (scalar * blue_scale * 31));
-				}
+	num_faces = fvi_QuickDistFaceList(roomnum, pos, light_dist, facelist, MAX_DYNAMIC_FACES);
 
-				lightmap_texel = OPAQUE_FLAG | (r << 10) | (g << 5) | b;
+	queued_light ql;
+	SetupLight(&ql, false, pos, roomnum, light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
 
-				dest_data[lightmap_texel_num] = lightmap_texel;
-			}
-		}
-	}
+	Lightmap_work.clear();
+	ApplyLightingToFaceList(facelist, num_faces, &ql);
 
-	for (i = 0; i < num_spoken_for; i++)
-	{
-		int index = lmilist[i];
-		Lmi_spoken_for[index / 8] = 0;
-	}
+	int num_work = (int)Lightmap_work.size();
+	for (int i = 0; i < num_work; i++)
+		CompositeLightmapWork(&Lightmap_work[i]);
 }
 
 
@@ -1579,18 +1803,10 @@ void ClearDynamicLightmaps()
 	Num_edges_to_blend = 0;
 }
 
-// Changes the terrain shading to approximate lighting
-void ApplyLightingToTerrain(vector* pos, int cellnum, float light_dist, float red_scale, float green_scale, float blue_scale, vector* light_direction, float dot_range)
+// Changes the shading of the terrain cells found by fvi_QuickDistCellList()
+static void ApplyLightingToCellList(int* celllist, int num_cells, vector* pos, float light_dist, float red_scale, float green_scale, float blue_scale, vector* light_direction, float dot_range)
 {
-	int celllist[MAX_DYNAMIC_CELLS];
-	int num_cells, i;
-
-	if (Dedicated_server)
-		return;
-
-	ApplyLightingToObjects(pos, MAKE_ROOMNUM(cellnum), light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
-
-	num_cells = fvi_QuickDistCellList(cellnum, pos, light_dist, celllist, MAX_DYNAMIC_CELLS);
+	int i;
 
 	if (num_cells < 1)
 		return;
@@ -1740,6 +1956,156 @@ void ApplyLightingToTerrain(vector* pos, int cellnum, float light_dist, float re
 	}
 }
 
+// Changes the terrain shading to approximate lighting
+void ApplyLightingToTerrain(vector* pos, int cellnum, float light_dist, float red_scale, float green_scale, float blue_scale, vector* light_direction, float dot_range)
+{
+	int celllist[MAX_DYNAMIC_CELLS];
+	int num_cells;
+
+	if (Dedicated_server)
+		return;
+
+	// Objects are lit right away, while they're still where the light found them
+	ApplyLightingToObjects(pos, MAKE_ROOMNUM(cellnum), light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
+
+	if (Queue_lighting)
+	{
+		QueueLight(true, pos, cellnum, light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
+		return;
+	}
+
+	num_cells = fvi_QuickDistCellList(cellnum, pos, light_dist, celllist, MAX_DYNAMIC_CELLS);
+
+	ApplyLightingToCellList(celllist, num_cells, pos, light_dist, red_scale, green_scale, blue_scale, light_direction, dot_range);
+}
+
+// Job that does the face and cell searches for a range of queued lights
+static void SearchQueuedLights(void*, int start, int end, int worker)
+{
+	fvi_context* ctx = job_GetFVIContext(worker);
+	std::vector<fvi_face_room_list>& face_results = Queued_face_results[worker];
+	std::vector<int>& cell_results = Queued_cell_results[worker];
+
+	fvi_face_room_list facelist[MAX_DYNAMIC_FACES];
+	int celllist[MAX_DYNAMIC_CELLS];
+
+	for (int i = start; i < end; i++)
+	{
+		queued_light* ql = &Queued_lights[i];
+		int num;
+
+		ql->worker = worker;
+
+		if (ql->terrain)
+		{
+			num = fvi_QuickDistCellList(ql->roomnum, &ql->pos, ql->light_dist, celllist, MAX_DYNAMIC_CELLS);
+			ql->first_element = cell_results.size();
+			cell_results.insert(cell_results.end(), celllist, celllist + num);
+		}
+		else
+		{
+			num = fvi_QuickDistFaceList(ctx, ql->roomnum, &ql->pos, ql->light_dist, facelist, MAX_DYNAMIC_FACES);
+			ql->first_element = face_results.size();
+			face_results.insert(face_results.end(), facelist, facelist + num);
+		}
+		ql->num_elements = num;
+	}
+}
+
+// Job that composites the lightmap work for a range of lightmap bins.  Each bin is every
+// rectangle of one lightmap, in the order the lights were cast
+static void CompositeLightmapBins(void*, int start, int end, int)
+{
+	for (int i = start; i < end; i++)
+	{
+		for (int t = Lightmap_bins[i]; t < Lightmap_bins[i + 1]; t++)
+			CompositeLightmapWork(&Lightmap_work[Lightmap_work_order[t]]);
+	}
+}
+
+static bool LightmapWorkCompare(int a, int b)
+{
+	return Lightmap_work[a].lm_handle < Lightmap_work[b].lm_handle;
+}
+
+// Searches for everything the queued lights touch across the job workers, then
+// applies the lights one at a time in the order they were cast.  The lightmap texels
+// are left until the end, when each lightmap is composited on its own job
+static void ApplyQueuedLights()
+{
+	int i;
+
+	if (Num_queued_lights == 0)
+		return;
+
+	Lightmap_work.clear();
+
+	for (i = 0; i < job_NumWorkers(); i++)
+	{
+		Queued_face_results[i].clear();
+		Queued_cell_results[i].clear();
+	}
+
+	job_Run(Num_queued_lights, SearchQueuedLights, NULL);
+
+	for (i = 0; i < Num_queued_lights; i++)
+	{
+		queued_light* ql = &Queued_lights[i];
+		vector* light_direction = ql->use_direction ? &ql->light_direction : NULL;
+
+		if (ql->terrain)
+			ApplyLightingToCellList(Queued_cell_results[ql->worker].data() + ql->first_element, ql->num_elements, &ql->pos, ql->light_dist, ql->red_scale, ql->green_scale, ql->blue_scale, light_direction, ql->dot_range);
+		else
+			ApplyLightingToFaceList(Queued_face_results[ql->worker].data() + ql->first_element, ql->num_elements, ql);
+	}
+
+	// Bin the work by lightmap, keeping the cast order within each one
+	int num_work = (int)Lightmap_work.size();
+	Lightmap_work_order.resize(num_work);
+	for (i = 0; i < num_work; i++)
+		Lightmap_work_order[i] = i;
+
+	std::stable_sort(Lightmap_work_order.begin(), Lightmap_work_order.end(), LightmapWorkCompare);
+
+	Lightmap_bins.clear();
+	for (i = 0; i < num_work; i++)
+	{
+		if (i == 0 || Lightmap_work[Lightmap_work_order[i]].lm_handle != Lightmap_work[Lightmap_work_order[i - 1]].lm_handle)
+			Lightmap_bins.push_back(i);
+	}
+	int num_bins = Lightmap_bins.size();
+	Lightmap_bins.push_back(num_work);
+
+	if (num_bins > 0)
+		job_Run(num_bins, CompositeLightmapBins, NULL);
+
+	Num_queued_lights = 0;
+}
+
+// Starts queueing up lights cast by ApplyLightingToRooms() and ApplyLightingToTerrain()
+void StartQueuedLighting()
+{
+	ASSERT(!Queue_lighting);
+
+	// Not worth it if there's nobody to share the searches with.  Dedicated servers don't
+	// cast dynamic lights at all.
+	if (Dedicated_server || job_NumWorkers() < 2)
+		return;
+
+	Num_queued_lights = 0;
+	Queue_lighting = true;
+}
+
+// Applies all the queued lights and stops queueing
+void FlushQueuedLighting()
+{
+	if (!Queue_lighting)
+		return;
+
+	ApplyQueuedLights();
+	Queue_lighting = false;
+}
+
 
 // Sets pulse parameters for an entire room
 void SetRoomPulse(room* rp, ubyte pulse_time, ubyte pulse_offset)
@@ -71,6 +71,14 @@ void ClearDynamicLightmaps ();
 // Changes the terrain shading to approximate lighting
 void ApplyLightingToTerrain (vector *pos,int cellnum,float light_dist,float red_scale,float green_scale,float blue_scale,vector *light_direction=NULL,float dot_range=0);
 
+// Queues up the lights cast by ApplyLightingToRooms/ApplyLightingToTerrain so their face and
+// cell searches can be split across the job workers.  Objects are still lit as each light is
+// cast.  Does nothing with only one worker, or on a dedicated server.
+void StartQueuedLighting ();
+
+// Applies all the queued lights in the order they were cast and stops queueing
+void FlushQueuedLighting ();
+
 // Gets the viewable lightmap elements
 void FindValidLightmapElements (face *fp,dynamic_face *dynamic_fp,vector *light_pos,float light_dist);
 // Does a quad tree algo to find what lightmap elements are viewable from our lightsource
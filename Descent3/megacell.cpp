@@ -30,6 +30,7 @@
 
 megacell Megacells[MAX_MEGACELLS];
 int Num_megacells = 0;
+tNameIndex<MAX_MEGACELLS> Megacell_names(Megacells[0].name, sizeof(megacell));
 
 // Sets all megacells to unused
 void InitMegacells()
@@ -39,6 +40,7 @@ void InitMegacells()
 		Megacells[i].used = 0;
 		Megacells[i].name[0] = 0;
 	}
+	Megacell_names.clear();
 	Num_megacells = 0;
 }
 
@@ -50,6 +52,7 @@ int AllocMegacell()
 		if (Megacells[i].used == 0)
 		{
 			memset(&Megacells[i], 0, sizeof(megacell));
+			Megacell_names.update(i);
 			Megacells[i].used = 1;
 			Megacells[i].width = DEFAULT_MEGACELL_WIDTH;
 			Megacells[i].height = DEFAULT_MEGACELL_HEIGHT;
@@ -69,6 +72,7 @@ void FreeMegacell(int n)
 
 	Megacells[n].used = 0;
 	Megacells[n].name[0] = 0;
+	Megacell_names.update(n);
 	Num_megacells--;
 }
 
@@ -125,9 +129,5 @@ int FindMegacellName(char* name)
 {
 	ASSERT(name != NULL);
 
-	for (int i = 0; i < MAX_MEGACELLS; i++)
-		if (Megacells[i].used && !stricmp(name, Megacells[i].name))
-			return i;
-
-	return -1;
+	return Megacell_names.find(name);
 }
@@ -72,6 +72,7 @@
 #include "debuggraph.h"
 #include "levelgoal.h"
 #include "osiris_share.h"
+#include "osiris_dll.h"
 #include "cockpit.h"
 #include "hud.h"
 #include "gamespy.h"
@@ -258,17 +259,12 @@ void MultiSendBadChecksum(int slot)
 
 // Puts player "slot" position info into the passed in buffer
 // Returns the number of bytes used
-int MultiStuffPosition (int slot,ubyte *data)
+// Returns the MPF_ flags that go out with player "slot"s position
+static ubyte MultiGetPositionFlags (int slot)
 {
-	int size;
-	int count=0;
 	ubyte flags=0;
-	
 	object *obj=&Objects[Players[slot].objnum];
 
-	size=START_DATA (MP_PLAYER_POS,data,&count);
-	MultiAddByte (slot,data,&count);
-
 	if (slot==Player_num)
 	{
 		// tell the reciever to expect fire information, only if
@@ -278,6 +274,34 @@ int MultiStuffPosition (int slot,ubyte *data)
 			flags|=MPF_FIRED;
 	}
 
+	if (OBJECT_OUTSIDE(obj))
+		flags |=MPF_OUTSIDE;
+	if (Players[slot].flags & PLAYER_FLAGS_AFTERBURN_ON)
+		flags |=MPF_AFTERBURNER;
+	if (Players[slot].flags & PLAYER_FLAGS_THRUSTED)
+		flags |=MPF_THRUSTED;
+	if (obj->weapon_fire_flags & WFF_SPRAY)
+		flags |=MPF_SPRAY;
+	if (obj->weapon_fire_flags & WFF_ON_OFF)
+		flags |=MPF_ON_OFF;
+	if (Players[slot].flags & PLAYER_FLAGS_DEAD)// || Players[slot].flags & PLAYER_FLAGS_DYING)
+		flags |=MPF_DEAD;
+	if (Players[slot].flags & PLAYER_FLAGS_HEADLIGHT)
+		flags |=MPF_HEADLIGHT;
+
+	return flags;
+}
+
+int MultiStuffPosition (int slot,ubyte *data)
+{
+	int size;
+	int count=0;
+	
+	object *obj=&Objects[Players[slot].objnum];
+
+	size=START_DATA (MP_PLAYER_POS,data,&count);
+	MultiAddByte (slot,data,&count);
+
 	// Send timestamp
 	if (slot==Player_num)
 		MultiAddFloat (Gametime,data,&count);
@@ -299,23 +323,6 @@ int MultiStuffPosition (int slot,ubyte *data)
 	
 	MultiAddShort (CELLNUM (obj->roomnum),data,&count);
 
-	
-	// Fill flags
-	if (OBJECT_OUTSIDE(obj))
-		flags |=MPF_OUTSIDE;
-	if (Players[slot].flags & PLAYER_FLAGS_AFTERBURN_ON)
-		flags |=MPF_AFTERBURNER;
-	if (Players[slot].flags & PLAYER_FLAGS_THRUSTED)
-		flags |=MPF_THRUSTED;
-	if (Objects[Players[slot].objnum].weapon_fire_flags & WFF_SPRAY)
-		flags |=MPF_SPRAY;
-	if (Objects[Players[slot].objnum].weapon_fire_flags & WFF_ON_OFF)
-		flags |=MPF_ON_OFF;
-	if (Players[slot].flags & PLAYER_FLAGS_DEAD)// || Players[slot].flags & PLAYER_FLAGS_DYING)
-		flags |=MPF_DEAD;
-	if (Players[slot].flags & PLAYER_FLAGS_HEADLIGHT)
-		flags |=MPF_HEADLIGHT;
-	
 	// Do velocity
 	vector *vel=&obj->mtype.phys_info.velocity;
 	vector *rotvel=&obj->mtype.phys_info.rotvel;
@@ -339,7 +346,7 @@ int MultiStuffPosition (int slot,ubyte *data)
 	MultiAddByte (weapon_indices,data,&count);
 
 	MultiAddUbyte (Players[slot].energy,data,&count);
-	MultiAddByte (flags,data,&count);
+	MultiAddByte (MultiGetPositionFlags (slot),data,&count);
 	
 		
 	END_DATA (count,data,size);
@@ -347,6 +354,142 @@ int MultiStuffPosition (int slot,ubyte *data)
 	return count;
 }
 
+// The first field of each snapshot group, with an extra entry marking the end of the last one
+static const ubyte Snapshot_group_start[SNAP_NUM_GROUPS+1]={SNAP_POS_X,SNAP_ANG_P,SNAP_VEL_X,SNAP_ROTVEL_X,SNAP_ROOM,SNAP_WEAPONS,SNAP_ENERGY,SNAP_FLAGS,SNAP_NUM_FIELDS};
+
+#define SNAP_POS_SCALE	16.0f
+#define SNAP_VEL_SCALE	32.0f
+#define SNAP_ANG_BITS	12
+#define SNAP_ANG_MASK	((1<<SNAP_ANG_BITS)-1)
+
+// Zigzag varints, so small deltas of either sign take a single byte
+static inline void MultiAddVarInt (int element,ubyte *data,int *count)
+{
+	uint v=((uint)element<<1)^(uint)(element>>31);
+
+	while (v>=0x80)
+	{
+		MultiAddUbyte ((v & 0x7F)|0x80,data,count);
+		v>>=7;
+	}
+	MultiAddUbyte (v,data,count);
+}
+
+static inline int MultiGetVarInt (ubyte *data,int *count)
+{
+	uint v=0;
+	ubyte b;
+
+	for (int shift=0;shift<35;shift+=7)
+	{
+		b=MultiGetUbyte (data,count);
+		v|=(uint)(b & 0x7F)<<shift;
+		if (!(b & 0x80))
+			break;
+	}
+	return (int)(v>>1)^-(int)(v & 1);
+}
+
+static inline int SnapshotQuantize (float value,float scale)
+{
+	return (int)floor (value*scale+0.5f);
+}
+
+// Angles wrap, so their deltas take the short way round
+static inline bool SnapshotFieldIsAngle (int field)
+{
+	return (field>=SNAP_ANG_P && field<=SNAP_ANG_B);
+}
+
+void MultiGetSnapshotState (int slot,multi_snapshot_state *state)
+{
+	object *obj=&Objects[Players[slot].objnum];
+	int *f=state->field;
+
+	f[SNAP_POS_X]=SnapshotQuantize (obj->pos.x,SNAP_POS_SCALE);
+	f[SNAP_POS_Y]=SnapshotQuantize (obj->pos.y,SNAP_POS_SCALE);
+	f[SNAP_POS_Z]=SnapshotQuantize (obj->pos.z,SNAP_POS_SCALE);
+
+	angvec angs;
+	vm_ExtractAnglesFromMatrix (&angs,&obj->orient);
+	f[SNAP_ANG_P]=(angs.p>>(16-SNAP_ANG_BITS)) & SNAP_ANG_MASK;
+	f[SNAP_ANG_H]=(angs.h>>(16-SNAP_ANG_BITS)) & SNAP_ANG_MASK;
+	f[SNAP_ANG_B]=(angs.b>>(16-SNAP_ANG_BITS)) & SNAP_ANG_MASK;
+
+	vector *vel=&obj->mtype.phys_info.velocity;
+	f[SNAP_VEL_X]=SnapshotQuantize (vel->x,SNAP_VEL_SCALE);
+	f[SNAP_VEL_Y]=SnapshotQuantize (vel->y,SNAP_VEL_SCALE);
+	f[SNAP_VEL_Z]=SnapshotQuantize (vel->z,SNAP_VEL_SCALE);
+
+	if (Netgame.flags & NF_SENDROTVEL)
+	{
+		vector *rotvel=&obj->mtype.phys_info.rotvel;
+		f[SNAP_ROTVEL_X]=(short)(rotvel->x/4);
+		f[SNAP_ROTVEL_Y]=(short)(rotvel->y/4);
+		f[SNAP_ROTVEL_Z]=(short)(rotvel->z/4);
+		f[SNAP_TURNROLL]=(short)obj->mtype.phys_info.turnroll;
+	}
+	else
+		f[SNAP_ROTVEL_X]=f[SNAP_ROTVEL_Y]=f[SNAP_ROTVEL_Z]=f[SNAP_TURNROLL]=0;
+
+	f[SNAP_ROOM]=CELLNUM (obj->roomnum);
+	f[SNAP_WEAPONS]=(ubyte)(((Players[slot].weapon[PW_SECONDARY].index-10)<<4)|Players[slot].weapon[PW_PRIMARY].index);
+	f[SNAP_ENERGY]=(ubyte)Players[slot].energy;
+	f[SNAP_FLAGS]=MultiGetPositionFlags (slot);
+}
+
+void MultiAddSnapshotDelta (multi_snapshot_state *state,multi_snapshot_state *base,ubyte *data,int *count)
+{
+	ubyte groups=0;
+	int g,i;
+
+	for (g=0;g<SNAP_NUM_GROUPS;g++)
+	{
+		for (i=Snapshot_group_start[g];i<Snapshot_group_start[g+1];i++)
+		{
+			if (state->field[i]!=base->field[i])
+			{
+				groups|=(1<<g);
+				break;
+			}
+		}
+	}
+
+	MultiAddUbyte (groups,data,count);
+
+	for (g=0;g<SNAP_NUM_GROUPS;g++)
+	{
+		if (!(groups & (1<<g)))
+			continue;
+
+		for (i=Snapshot_group_start[g];i<Snapshot_group_start[g+1];i++)
+		{
+			int delta=state->field[i]-base->field[i];
+			if (SnapshotFieldIsAngle (i))
+				delta=((delta+(1<<(SNAP_ANG_BITS-1))) & SNAP_ANG_MASK)-(1<<(SNAP_ANG_BITS-1));
+			MultiAddVarInt (delta,data,count);
+		}
+	}
+}
+
+void MultiGetSnapshotDelta (multi_snapshot_state *state,ubyte *data,int *count)
+{
+	ubyte groups=MultiGetUbyte (data,count);
+
+	for (int g=0;g<SNAP_NUM_GROUPS;g++)
+	{
+		if (!(groups & (1<<g)))
+			continue;
+
+		for (int i=Snapshot_group_start[g];i<Snapshot_group_start[g+1];i++)
+		{
+			state->field[i]+=MultiGetVarInt (data,count);
+			if (SnapshotFieldIsAngle (i))
+				state->field[i]&=SNAP_ANG_MASK;
+		}
+	}
+}
+
 void DoNextPlayerFile(int playernum)
 {
 	NetPlayers[playernum].file_xfer_flags = NETFILE_NONE;
@@ -1399,6 +1542,7 @@ void MultiMakePlayerGhost (int slot)
 	MULTI_ASSERT (obj->id==slot,NULL);	// Get Jason
 	
 	obj->type=OBJ_GHOST;
+	Osiris_DetonateObjectTimers(obj);
 	obj->movement_type=MT_NONE;
 	obj->render_type=RT_NONE;
 	obj->mtype.phys_info.flags|=PF_NO_COLLIDE;
@@ -1574,82 +1718,15 @@ void MultiExtractMatrix (matrix *dest,multi_orientation *src)
 	dest->fvec.z=(float)src->multi_matrix[8]/32767.0;
 }
 
-void MultiDoPlayerPos (ubyte *data)
+// Moves player "slot" to a position we were sent, and sets up its weapon and ship state
+static void MultiApplyPlayerPos (int slot,vector pos,matrix *orient,int roomnum,vector vel,ubyte windex,ubyte energy,ubyte flags)
 {
 	int use_smoothing=(Netgame.flags & NF_USE_SMOOTHING);
-	int count=0; 
-	
-	// Skip header stuff
-	SKIP_HEADER (data,&count);
-
-	ubyte slot=MultiGetByte (data,&count);
-	
-
-	// Make sure its not out of order
-	float packet_time=MultiGetFloat (data,&count);
-	if (packet_time<NetPlayers[slot].packet_time)
-		return;
-	NetPlayers[slot].packet_time=packet_time;
-
-			
 	object *obj=&Objects[Players[slot].objnum];
 
-	vector pos;
-	matrix orient;
-	ushort short_roomnum;
-	int roomnum;
-
-	// Get position
-	MultiExtractPositionData (&pos,data,&count);
-	
-	// Get orientation
-	ushort p=MultiGetShort (data,&count);
-	ushort h=MultiGetShort (data,&count);
-	ushort b=MultiGetShort (data,&count);
-
-	vm_AnglesToMatrix (&orient,p,h,b);
-
-	// Get room and terrain flag
-	short_roomnum=MultiGetUshort (data,&count);
-
-	roomnum = short_roomnum;
-
-	vector vel={0,0,0},rotvel;
-	angle turnroll;
-
-//	float dist=vm_VectorDistance (&pos,&obj->pos);
-	
-		// Get velocity
-	vel.x=((float)MultiGetShort (data,&count))/128.0;
-	vel.y=((float)MultiGetShort (data,&count))/128.0;
-	vel.z=((float)MultiGetShort (data,&count))/128.0;
-
-	//mprintf ((0,"INCOMING x=%f y=%f z=%f dist=%f\n",vel.x,vel.y,vel.z,dist));
-	
-	// Get rotational velocity
-	if (Netgame.flags & NF_SENDROTVEL)
-	{
-		rotvel.x=MultiGetShort (data,&count)*4;
-		rotvel.y=MultiGetShort (data,&count)*4;
-		rotvel.z=MultiGetShort (data,&count)*4;
-
-		turnroll=MultiGetShort (data,&count);
-
-		obj->mtype.phys_info.rotvel=rotvel;
-		obj->mtype.phys_info.turnroll=turnroll;
-	}
-
-//	obj->mtype.phys_info.velocity=vel;
-
-// Get weapon states
-	ubyte windex=MultiGetByte (data,&count);
 	Players[slot].weapon[PW_PRIMARY].index=windex & 0x0F;
 	Players[slot].weapon[PW_SECONDARY].index=(windex >> 4) +10;
-
-	// Get energy
-	Players[slot].energy=MultiGetUbyte (data,&count);
-	// Get flags
-	ubyte flags=MultiGetByte (data,&count);
+	Players[slot].energy=energy;
 
 	// Do special stuff for non-visible objects
 	bool visible=true;
@@ -1767,7 +1844,7 @@ void MultiDoPlayerPos (ubyte *data)
 			//print some info to the server console...
 			//PrintDedicatedMessage("Discarded %d position updates from %s\n",Player_pos_fix[slot].ignored_pos,Players[slot].callsign);
 		}
-		ObjSetPos (obj,&pos,roomnum,&orient,true);
+		ObjSetPos (obj,&pos,roomnum,orient,true);
 	}
 	
 	if (Netgame.local_role==LR_SERVER)
@@ -1776,6 +1853,226 @@ void MultiDoPlayerPos (ubyte *data)
 	}
 }
 
+void MultiDoPlayerPos (ubyte *data)
+{
+	int count=0; 
+	
+	// Skip header stuff
+	SKIP_HEADER (data,&count);
+
+	ubyte slot=MultiGetByte (data,&count);
+	
+
+	// Make sure its not out of order
+	float packet_time=MultiGetFloat (data,&count);
+	if (packet_time<NetPlayers[slot].packet_time)
+		return;
+	NetPlayers[slot].packet_time=packet_time;
+
+			
+	object *obj=&Objects[Players[slot].objnum];
+
+	vector pos;
+	matrix orient;
+	ushort short_roomnum;
+	int roomnum;
+
+	// Get position
+	MultiExtractPositionData (&pos,data,&count);
+	
+	// Get orientation
+	ushort p=MultiGetShort (data,&count);
+	ushort h=MultiGetShort (data,&count);
+	ushort b=MultiGetShort (data,&count);
+
+	vm_AnglesToMatrix (&orient,p,h,b);
+
+	// Get room and terrain flag
+	short_roomnum=MultiGetUshort (data,&count);
+
+	roomnum = short_roomnum;
+
+	vector vel={0,0,0},rotvel;
+	angle turnroll;
+
+//	float dist=vm_VectorDistance (&pos,&obj->pos);
+	
+		// Get velocity
+	vel.x=((float)MultiGetShort (data,&count))/128.0;
+	vel.y=((float)MultiGetShort (data,&count))/128.0;
+	vel.z=((float)MultiGetShort (data,&count))/128.0;
+
+	//mprintf ((0,"INCOMING x=%f y=%f z=%f dist=%f\n",vel.x,vel.y,vel.z,dist));
+	
+	// Get rotational velocity
+	if (Netgame.flags & NF_SENDROTVEL)
+	{
+		rotvel.x=MultiGetShort (data,&count)*4;
+		rotvel.y=MultiGetShort (data,&count)*4;
+		rotvel.z=MultiGetShort (data,&count)*4;
+
+		turnroll=MultiGetShort (data,&count);
+
+		obj->mtype.phys_info.rotvel=rotvel;
+		obj->mtype.phys_info.turnroll=turnroll;
+	}
+
+//	obj->mtype.phys_info.velocity=vel;
+
+// Get weapon states
+	ubyte windex=MultiGetByte (data,&count);
+
+	// Get energy
+	ubyte energy=MultiGetUbyte (data,&count);
+	// Get flags
+	ubyte flags=MultiGetByte (data,&count);
+
+	MultiApplyPlayerPos (slot,pos,&orient,roomnum,vel,windex,energy,flags);
+}
+
+// Player states we have been sent, by snapshot sequence, so later records can be deltas of them
+struct snapshot_received
+{
+	int sequence;		// -1 if nothing here
+	multi_snapshot_state state;
+};
+
+static snapshot_received Snapshot_received[MAX_PLAYERS][SNAPSHOT_HISTORY];
+static int Snapshot_epoch=-1;		// Which run of snapshots the server is sending us
+static int Snapshot_last_seq=-1;	// Newest snapshot we have taken
+static int Snapshot_ack_seq=-1;		// Newest snapshot we could fully decode
+static bool Snapshot_ack_pending=false;
+
+void MultiResetSnapshotReceive ()
+{
+	for (int i=0;i<MAX_PLAYERS;i++)
+		for (int t=0;t<SNAPSHOT_HISTORY;t++)
+			Snapshot_received[i][t].sequence=-1;
+
+	Snapshot_epoch=-1;
+	Snapshot_last_seq=-1;
+	Snapshot_ack_seq=-1;
+	Snapshot_ack_pending=false;
+}
+
+// Server is telling us where the other players are
+void MultiDoPlayerSnapshot (ubyte *data)
+{
+	int count=0;
+
+	SKIP_HEADER (data,&count);
+
+	ubyte epoch=MultiGetUbyte (data,&count);
+	ushort sequence=MultiGetUshort (data,&count);
+	int num_records=MultiGetUbyte (data,&count);
+
+	// The server starts over with every level, so nothing from before is any use
+	if (epoch!=Snapshot_epoch)
+	{
+		MultiResetSnapshotReceive ();
+		Snapshot_epoch=epoch;
+	}
+	else if (Snapshot_last_seq!=-1 && (short)(sequence-Snapshot_last_seq)<=0)
+		return;		// Out of order
+
+	Snapshot_last_seq=sequence;
+
+	bool complete=true;
+
+	for (int i=0;i<num_records;i++)
+	{
+		ubyte slot=MultiGetUbyte (data,&count);
+		ubyte back=MultiGetUbyte (data,&count);
+
+		if (slot>=MAX_PLAYERS)
+		{
+			mprintf ((0,"Bad player snapshot record!\n"));
+			return;
+		}
+
+		multi_snapshot_state state;
+		bool have_base=true;
+
+		if (back==0)
+			memset (&state,0,sizeof(state));
+		else
+		{
+			ushort base_seq=sequence-back;
+			snapshot_received *base=&Snapshot_received[slot][base_seq % SNAPSHOT_HISTORY];
+
+			if (back<SNAPSHOT_HISTORY && base->sequence==base_seq)
+				state=base->state;
+			else
+			{
+				// We never got the baseline.  Read past the record and don't acknowledge this snapshot
+				memset (&state,0,sizeof(state));
+				have_base=false;
+				complete=false;
+			}
+		}
+
+		MultiGetSnapshotDelta (&state,data,&count);
+
+		if (!have_base)
+			continue;
+
+		snapshot_received *rcv=&Snapshot_received[slot][sequence % SNAPSHOT_HISTORY];
+		rcv->sequence=sequence;
+		rcv->state=state;
+
+		int *f=state.field;
+		object *obj=&Objects[Players[slot].objnum];
+
+		vector pos;
+		pos.x=f[SNAP_POS_X]/SNAP_POS_SCALE;
+		pos.y=f[SNAP_POS_Y]/SNAP_POS_SCALE;
+		pos.z=f[SNAP_POS_Z]/SNAP_POS_SCALE;
+
+		matrix orient;
+		int shift=16-SNAP_ANG_BITS;
+		vm_AnglesToMatrix (&orient,f[SNAP_ANG_P]<<shift,f[SNAP_ANG_H]<<shift,f[SNAP_ANG_B]<<shift);
+
+		vector vel;
+		vel.x=f[SNAP_VEL_X]/SNAP_VEL_SCALE;
+		vel.y=f[SNAP_VEL_Y]/SNAP_VEL_SCALE;
+		vel.z=f[SNAP_VEL_Z]/SNAP_VEL_SCALE;
+
+		if (Netgame.flags & NF_SENDROTVEL)
+		{
+			obj->mtype.phys_info.rotvel.x=f[SNAP_ROTVEL_X]*4;
+			obj->mtype.phys_info.rotvel.y=f[SNAP_ROTVEL_Y]*4;
+			obj->mtype.phys_info.rotvel.z=f[SNAP_ROTVEL_Z]*4;
+			obj->mtype.phys_info.turnroll=f[SNAP_TURNROLL];
+		}
+
+		MultiApplyPlayerPos (slot,pos,&orient,(ushort)f[SNAP_ROOM],vel,f[SNAP_WEAPONS],f[SNAP_ENERGY],f[SNAP_FLAGS]);
+	}
+
+	if (complete)
+	{
+		Snapshot_ack_seq=sequence;
+		Snapshot_ack_pending=true;
+	}
+}
+
+int MultiStuffSnapshotAck (ubyte *data)
+{
+	if (!Snapshot_ack_pending)
+		return 0;
+
+	int size;
+	int count=0;
+
+	size=START_DATA (MP_SNAPSHOT_ACK,data,&count);
+	MultiAddUbyte (Snapshot_epoch,data,&count);
+	MultiAddUshort (Snapshot_ack_seq,data,&count);
+	END_DATA (count,data,size);
+
+	Snapshot_ack_pending=false;
+
+	return count;
+}
+
 void MultiDoRobotPos (ubyte *data)
 {
 	int count=0;
@@ -8893,6 +9190,15 @@ void MultiProcessData (ubyte *data,int len,int slot,network_address *from_addr)
 			NetPlayers[Player_num].total_bytes_rcvd += len;
 			MultiDoPlayerPos(data);
 			break;
+		case MP_PLAYER_SNAPSHOT:
+			ACCEPT_CONDITION (NETSEQ_PLAYING,NETSEQ_PLAYING);
+			NetPlayers[Player_num].total_bytes_rcvd += len;
+			MultiDoPlayerSnapshot(data);
+			break;
+		case MP_SNAPSHOT_ACK:
+			ACCEPT_CONDITION (NETSEQ_PLAYING,NETSEQ_PLAYING);
+			MultiDoSnapshotAck(data,slot);
+			break;
 		case MP_DONE_PLAYERS:
 			MultiDoDonePlayers (data);
 			break;
@@ -43,7 +43,9 @@ extern bool Multi_bail_ui_menu;
 //Patch 1.1!
 //#define MULTI_VERSION	6
 //Patch 1.3
-#define MULTI_VERSION	10
+//#define MULTI_VERSION	10
+//Positional snapshots
+#define MULTI_VERSION	11
 #endif
 
 #define MULTI_PING_INTERVAL	3
@@ -172,6 +174,8 @@ extern bool Multi_bail_ui_menu;
 #define MP_MISSILE_RELEASE						121 // Informing about a guided missile being released from guided mode
 #define MP_STRIP_PLAYER							122 // Strips player of all weapons (but laser) and reduces energy to 0
 #define MP_REJECTED_CHECKSUM					123 // The server rejected the client checksum. This lets the client know.
+#define MP_PLAYER_SNAPSHOT						124 // Delta compressed positions of other players
+#define MP_SNAPSHOT_ACK							125 // Client got this player snapshot and can use it as a baseline
 
 // Shield request defines
 #define MAX_SHIELD_REQUEST_TYPES	1
@@ -241,6 +245,39 @@ inline void MultiMatrixMakeEndianFriendly(multi_orientation *mmat)
 // For firing players
 extern player_fire_packet Player_fire_packet[MAX_NET_PLAYERS];
 
+// Player positions go from the server to clients as snapshots.  Each record in a snapshot is
+// delta encoded against the last state of that player the client acknowledged.
+#define SNAPSHOT_HISTORY		16		// Snapshots remembered on each side, so the oldest usable baseline
+#define SNAPSHOT_DEFAULT_RATE	4000	// Bytes per second of snapshots a client gets, see -snapshotrate
+
+// Quantized fields of a player snapshot.  They are sent in groups, and a record only carries
+// the groups that changed.
+#define SNAP_POS_X				0		// Position in 1/16ths
+#define SNAP_POS_Y				1
+#define SNAP_POS_Z				2
+#define SNAP_ANG_P				3		// Orientation angles in 1/4096ths of a turn
+#define SNAP_ANG_H				4
+#define SNAP_ANG_B				5
+#define SNAP_VEL_X				6		// Velocity in 1/32ths
+#define SNAP_VEL_Y				7
+#define SNAP_VEL_Z				8
+#define SNAP_ROTVEL_X			9		// Rotational velocity and turnroll, if NF_SENDROTVEL
+#define SNAP_ROTVEL_Y			10
+#define SNAP_ROTVEL_Z			11
+#define SNAP_TURNROLL			12
+#define SNAP_ROOM				13
+#define SNAP_WEAPONS			14
+#define SNAP_ENERGY				15
+#define SNAP_FLAGS				16		// MPF_ flags
+#define SNAP_NUM_FIELDS			17
+
+#define SNAP_NUM_GROUPS			8
+
+struct multi_snapshot_state
+{
+	int field[SNAP_NUM_FIELDS];
+};
+
 // For powerup respawning
 #define MAX_RESPAWNS		300
 #define RESPAWN_TIME		60		// seconds until a powerup respawns
@@ -428,6 +465,22 @@ int MultiCountPlayers ();
 // Returns the number of bytes used
 int MultiStuffPosition (int slot,ubyte *data);
 
+// Fills in the quantized snapshot state of player "slot"
+void MultiGetSnapshotState (int slot,multi_snapshot_state *state);
+
+// Packs the groups of state that differ from base
+void MultiAddSnapshotDelta (multi_snapshot_state *state,multi_snapshot_state *base,ubyte *data,int *count);
+
+// Unpacks a delta on top of state, which should hold the baseline
+void MultiGetSnapshotDelta (multi_snapshot_state *state,ubyte *data,int *count);
+
+// Forgets all received snapshots.  Call when joining a game
+void MultiResetSnapshotReceive ();
+
+// Puts an acknowledgement of the newest snapshot into the buffer, if there is one to send
+// Returns the number of bytes used
+int MultiStuffSnapshotAck (ubyte *data);
+
 // Sends a full packet out the the server
 // Resets the send_size variable
 // If slot = -1, sends out to the server
@@ -386,6 +386,10 @@ void MultiDoClientFrame()
 				count += add_count;
 			}
 
+			// Let the server know which player snapshot we have
+			add_count = MultiStuffSnapshotAck(&data[count]);
+			count += add_count;
+
 			ASSERT(count < MAX_GAME_DATA_SIZE);
 
 			if (Netgame.flags & NF_PEER_PEER)
@@ -447,6 +451,8 @@ void MultiStartClient(char* scriptname)
 
 	Current_saved_move = 0;
 
+	MultiResetSnapshotReceive();
+
 	// Temporary name fix
 	Current_pilot.get_name(Players[Player_num].callsign);
 
@@ -81,6 +81,32 @@ ushort Num_changed_turret[MAX_NET_PLAYERS];
 float last_sent_bytes[MAX_NET_PLAYERS];
 float Multi_last_send_visible[MAX_NET_PLAYERS];
 uint Multi_visible_players[MAX_NET_PLAYERS];
+
+// What we have sent a client in player snapshots.  Baselines are the last state of each player
+// the client acknowledged, and records are delta encoded against them.
+struct snapshot_sent
+{
+	ushort sequence;
+	uint players;		// Which players this snapshot carried
+	multi_snapshot_state state[MAX_PLAYERS];
+};
+
+struct snapshot_client
+{
+	bool active;
+	ubyte epoch;			// Bumped every time the snapshots start over
+	ushort sequence;		// Sequence number of the next snapshot
+	float budget;			// Bytes this client can still be sent
+	float stale[MAX_PLAYERS];	// Seconds since each player was in a snapshot
+	uint have_base;			// Players with an acknowledged baseline
+	ushort base_seq[MAX_PLAYERS];
+	multi_snapshot_state base[MAX_PLAYERS];
+	snapshot_sent sent[SNAPSHOT_HISTORY];
+};
+
+static snapshot_client Snapshot_clients[MAX_NET_PLAYERS];
+int Snapshot_rate = SNAPSHOT_DEFAULT_RATE;
+
 extern int Buddy_handle[MAX_PLAYERS];
 extern char Multi_message_of_the_day[];
 
@@ -119,6 +145,7 @@ void MultiStartServer(int playing, char* scriptname, int dedicated_server_num_te
 		Multi_reliable_urgent[i] = 0;
 		Multi_last_send_visible[i] = 0;
 		Multi_visible_players[i] = 0xFFFFFFFF;
+		Snapshot_clients[i].active = false;
 
 		Num_moved_robots[i] = 0;
 		Num_changed_anim[i] = 0;
@@ -182,6 +209,14 @@ void MultiStartServer(int playing, char* scriptname, int dedicated_server_num_te
 		taunt_SetDelayTime(5.0f);
 	}
 
+	// Setup how much positional data each client gets
+	int snapshotratearg = FindArg("-snapshotrate");
+	if (snapshotratearg > 0)
+		Snapshot_rate = max(atoi(GameArgs[snapshotratearg + 1]), 500);
+	else
+		Snapshot_rate = SNAPSHOT_DEFAULT_RATE;
+	mprintf((0, "MULTI: Sending %d bytes of player snapshots a second to each client\n", Snapshot_rate));
+
 	// Temporary name fix
 	Current_pilot.get_name(Players[Player_num].callsign);
 
@@ -1544,16 +1579,113 @@ void MultiCheckToRespawnPowerups()
 }
 
 extern int Multi_occluded;
-// Sends out positional updates based on clients pps
+bool MultiIsRoomVisibleToPlayer(int roomnum, int to_slot);
+bool MultiIsGenericVisibleToPlayer(int test_objnum, int to_slot);
+
+// Type, size, epoch, sequence and record count
+#define SNAPSHOT_HEADER_SIZE	7
+
+// Ships closer than this all get the same, highest priority
+#define SNAPSHOT_NEAR_DIST		100.0f
+
+struct snapshot_candidate
+{
+	int slot;
+	bool forced;			// The server, or fired this frame, so it has to go now
+	float priority;
+};
+
+// Starts a new snapshot in data
+static void MultiStartSnapshot(snapshot_client* sc, ubyte* data, int* count, int* size)
+{
+	*count = 0;
+	*size = START_DATA(MP_PLAYER_SNAPSHOT, data, count);
+	MultiAddUbyte(sc->epoch, data, count);
+	MultiAddUshort(sc->sequence, data, count);
+	MultiAddUbyte(0, data, count);
+
+	snapshot_sent* sent = &sc->sent[sc->sequence % SNAPSHOT_HISTORY];
+	sent->sequence = sc->sequence;
+	sent->players = 0;
+}
+
+// Sends the snapshot in data, followed by the fire and guided missile info of its players
+static void MultiSendSnapshot(int to_slot, ubyte* data, int count, int size, int num_records, ubyte* extra, int extra_count)
+{
+	snapshot_client* sc = &Snapshot_clients[to_slot];
+
+	data[SNAPSHOT_HEADER_SIZE - 1] = num_records;
+	END_DATA(count, data, size);
+
+	memcpy(&data[count], extra, extra_count);
+	count += extra_count;
+	ASSERT(count <= MAX_GAME_DATA_SIZE);
+
+	nw_Send(&NetPlayers[to_slot].addr, data, count, 0);
+
+	NetPlayers[to_slot].total_bytes_sent += count;
+	sc->budget -= count;
+	sc->sequence++;
+}
+
+// Puts a record of player "slot" into the snapshot, delta encoded against the best baseline
+// the client has.  Returns the number of bytes used
+static int MultiStuffSnapshotRecord(snapshot_client* sc, int slot, multi_snapshot_state* state, ubyte* data)
+{
+	int count = 0;
+	ushort back = sc->sequence - sc->base_seq[slot];
+	multi_snapshot_state zero;
+
+	MultiAddUbyte(slot, data, &count);
+
+	if ((sc->have_base & (1 << slot)) && back < SNAPSHOT_HISTORY)
+	{
+		MultiAddUbyte(back, data, &count);
+		MultiAddSnapshotDelta(state, &sc->base[slot], data, &count);
+	}
+	else
+	{
+		memset(&zero, 0, sizeof(zero));
+		MultiAddUbyte(0, data, &count);
+		MultiAddSnapshotDelta(state, &zero, data, &count);
+	}
+
+	return count;
+}
+
+// Sends out player snapshots based on clients pps.  Each client has a byte budget, and players
+// are sent in order of how close they are, whether they are in front of the viewer, and how
+// long it has been since they were last sent.  The server's own ship, and players that fired, always
+// go out that frame.
 void MultiSendPositionalUpdates(int to_slot)
 {
-	ubyte data[MAX_GAME_DATA_SIZE];
+	snapshot_client* sc = &Snapshot_clients[to_slot];
+	snapshot_candidate candidates[MAX_PLAYERS];
+	int num_candidates = 0;
+	int i;
 
-	// Figure out if we should send positional updates to players
-	for (int i = 0; i < MAX_PLAYERS; i++)
+	if (!sc->active)
 	{
-		ubyte send_position = 0, timer_popped = 0;
+		ubyte epoch = sc->epoch + 1;
+		memset(sc, 0, sizeof(snapshot_client));
+		sc->epoch = epoch;
+		sc->active = true;
+	}
+
+	float pps = NetPlayers[to_slot].pps;
+	if (pps < 1)
+		pps = 1;
+
+	bool timer_popped = (Multi_last_sent_time[to_slot][Player_num] > (1.0 / pps));
+
+	// The budget fills up steadily, and can save up two snapshots worth
+	sc->budget = min(sc->budget + Snapshot_rate * Frametime, 2 * Snapshot_rate / pps);
 
+	object* viewer = &Objects[Players[to_slot].objnum];
+
+	// Figure out which players this client should hear about
+	for (i = 0; i < MAX_PLAYERS; i++)
+	{
 		if ((Netgame.flags & NF_PEER_PEER) && i != Player_num)
 			continue;		// Don't send out other positions if in peer mode
 
@@ -1565,184 +1697,174 @@ void MultiSendPositionalUpdates(int to_slot)
 		if (Objects[Players[i].objnum].type != OBJ_PLAYER)
 			continue;
 
-		if (i != Player_num)
-			Multi_last_sent_time[to_slot][i] += Frametime;
+		sc->stale[i] += Frametime;
 
 		if (i == to_slot)
 			continue;
 
-		if (!(NetPlayers[i].flags & NPF_CONNECTED))
+		if (!(NetPlayers[i].flags & NPF_CONNECTED) || NetPlayers[i].sequence != NETSEQ_PLAYING)
 		{
 			Multi_visible_players[i] &= ~(1 << to_slot);
 			Multi_visible_players[to_slot] &= ~(1 << i);
 			continue;
 		}
 
-		if (NetPlayers[i].sequence != NETSEQ_PLAYING)
+		bool fired = (Player_fire_packet[i].fired_on_this_frame != PFP_NO_FIRED);
+		if (!timer_popped && !fired)
+			continue;
+
+		//Always send the server position, because we always say that the server is visible.  This
+		//should fix some or all ghost ship problems.
+		bool visible = (i == Player_num) || MultiIsGenericVisibleToPlayer(Players[i].objnum, to_slot);
+
+		if (!visible && fired)
+		{
+			if (Player_fire_packet[i].wb_index >= SECONDARY_INDEX)
+				visible = true;
+			else
+				visible = MultiIsRoomVisibleToPlayer(Player_fire_packet[i].dest_roomnum, to_slot);
+		}
+
+		if (!visible)
 		{
-			Multi_visible_players[i] &= ~(1 << to_slot);
 			Multi_visible_players[to_slot] &= ~(1 << i);
+			Multi_occluded++;
 			continue;
 		}
 
-		// Find out the player priority of this player in relation to the to_slot player
-		float pps_check_time = NetPlayers[to_slot].pps;
+		object* obj = &Objects[Players[i].objnum];
+		vector subvec = obj->pos - viewer->pos;
+		float dist = vm_NormalizeVectorFast(&subvec);
+		float dp = vm_DotProduct(&subvec, &viewer->orient.fvec);
 
-		/*if (pps_check_time>=8)
-		{
-			vector subvec=Objects[Players[i].objnum].pos-Objects[Players[to_slot].objnum].pos;
-			float mag=vm_GetMagnitudeFast (&subvec);
-			subvec/=mag;
+		snapshot_candidate* c = &candidates[num_candidates++];
+		c->slot = i;
+		c->forced = fired || (i == Player_num);
+		c->priority = sc->stale[i] * (1.0f + (SNAPSHOT_NEAR_DIST / max(dist, SNAPSHOT_NEAR_DIST)) * (1.5f + dp));
+	}
 
-			float dp=vm_DotProduct (&subvec,&Objects[Players[to_slot].objnum].orient.fvec);
-			dp=fabs(dp);
+	if (!num_candidates)
+		return;
 
-			pps_check_time=((float)pps_check_time/2.0)+((dp*((float)pps_check_time/2.0))+(dp*.9));
-			pps_check_time=max (pps_check_time,6.0);
-			pps_check_time=min (pps_check_time,20.0);
+	// Forced players first, then by priority
+	for (i = 1; i < num_candidates; i++)
+	{
+		snapshot_candidate c = candidates[i];
+		int t = i - 1;
+		while (t >= 0 && (candidates[t].forced < c.forced || (candidates[t].forced == c.forced && candidates[t].priority < c.priority)))
+		{
+			candidates[t + 1] = candidates[t];
+			t--;
+		}
+		candidates[t + 1] = c;
+	}
 
-			int pps=pps_check_time;
-			pps_check_time=pps;
-		}*/
+	ubyte data[MAX_GAME_DATA_SIZE], extra[MAX_GAME_DATA_SIZE];
+	int count = 0, size = 0, extra_count = 0, num_records = 0;
+	int reliable_fire[MAX_PLAYERS], num_reliable_fire = 0;
 
-		// Set the timer as popped if it actually did				
-		if (Multi_last_sent_time[to_slot][i] > (1.0 / pps_check_time))
-			timer_popped = 1;
+	for (i = 0; i < num_candidates; i++)
+	{
+		int slot = candidates[i].slot;
+		multi_snapshot_state state;
+		ubyte record[MAX_GAME_DATA_SIZE], add[MAX_GAME_DATA_SIZE];
+		int record_count, add_count = 0;
 
+		MultiGetSnapshotState(slot, &state);
 
-		//if (i==Player_num)	// Always send server position
-		//	send_position=1;
+		// Send firing if needed
+		if (Player_fire_packet[slot].fired_on_this_frame == PFP_FIRED)
+			add_count += MultiStuffPlayerFire(slot, &add[add_count]);
+		// Add in guided stuff
+		if (Players[slot].guided_obj != NULL)
+			add_count += MultiStuffGuidedInfo(slot, &add[add_count]);
 
-		int num_src_to_check = 1;
-		int srcs[10];
-		srcs[0] = Players[to_slot].objnum;
+		if (num_records == 0)
+			MultiStartSnapshot(sc, data, &count, &size);
 
-		// Check for guideds
-		if (Players[to_slot].guided_obj != NULL)
-			srcs[num_src_to_check++] = Players[to_slot].guided_obj - Objects;
+		record_count = MultiStuffSnapshotRecord(sc, slot, &state, record);
 
-		if (Players[to_slot].small_dll_obj != -1)
-		{
-			int objnum = Players[to_slot].small_dll_obj;
-			if (Objects[objnum].flags & OF_DEAD || Objects[objnum].type == OBJ_NONE)
-			{
-				Players[to_slot].small_dll_obj = -1;
-			}
-			else
-			{
-				srcs[num_src_to_check] = objnum;
-				num_src_to_check++;
-			}
-		}
+		// Players that can wait do, once the budget is spent
+		int cost = record_count + add_count;
+		if (num_records == 0)
+			cost += SNAPSHOT_HEADER_SIZE;
+		else
+			cost += count + extra_count;
+		if (!candidates[i].forced && cost > sc->budget)
+			continue;
 
-		// See if there are any small views we need to send for
-		// Do left view
-		if (Players[to_slot].small_left_obj != -1)
+		if (count + record_count + extra_count + add_count > MAX_GAME_DATA_SIZE || num_records == 255)
 		{
-			int objnum = Players[to_slot].small_left_obj;
-			if (Objects[objnum].flags & OF_DEAD || Objects[objnum].type == OBJ_NONE || Objects[objnum].type == OBJ_WEAPON)
-			{
-				Players[to_slot].small_left_obj = -1;
-			}
-			else
-			{
-				srcs[num_src_to_check] = objnum;
-				num_src_to_check++;
-			}
-		}
+			MultiSendSnapshot(to_slot, data, count, size, num_records, extra, extra_count);
+			extra_count = 0;
+			num_records = 0;
 
-		// Do right view
-		if (Players[to_slot].small_right_obj != -1)
-		{
-			int objnum = Players[to_slot].small_right_obj;
-			if ((Objects[objnum].flags & OF_DEAD) || (Objects[objnum].type == OBJ_NONE) || (Objects[objnum].type == OBJ_WEAPON))
-			{
-				Players[to_slot].small_right_obj = -1;
-			}
-			else
-			{
-				srcs[num_src_to_check] = objnum;
-				num_src_to_check++;
-			}
+			// The new snapshot has a new sequence, so the record has to be done over
+			MultiStartSnapshot(sc, data, &count, &size);
+			record_count = MultiStuffSnapshotRecord(sc, slot, &state, record);
 		}
 
-		for (int t = 0; t < num_src_to_check; t++)
-		{
-			int room_a = Objects[srcs[t]].roomnum;
-			int room_b = Objects[Players[i].objnum].roomnum;
+		memcpy(&data[count], record, record_count);
+		count += record_count;
+		memcpy(&extra[extra_count], add, add_count);
+		extra_count += add_count;
+		num_records++;
 
-			if (BOA_IsVisible(room_a, room_b))
-				send_position = 1;
+		snapshot_sent* sent = &sc->sent[sc->sequence % SNAPSHOT_HISTORY];
+		sent->players |= (1 << slot);
+		sent->state[slot] = state;
 
-			if (Player_fire_packet[i].fired_on_this_frame != PFP_NO_FIRED)
-			{
-				timer_popped = 1;
+		sc->stale[slot] = 0;
+		Multi_visible_players[to_slot] |= (1 << slot);
 
-				if (Player_fire_packet[i].wb_index >= SECONDARY_INDEX)
-				{
-					send_position = 1;
-				}
-				else
-				{
-					if (BOA_IsVisible(Player_fire_packet[i].dest_roomnum, Objects[srcs[t]].roomnum))
-						send_position = 1;
+		if (Player_fire_packet[slot].fired_on_this_frame == PFP_FIRED_RELIABLE)
+			reliable_fire[num_reliable_fire++] = slot;
+	}
 
-				}
-			}
-		}
+	if (num_records)
+		MultiSendSnapshot(to_slot, data, count, size, num_records, extra, extra_count);
 
-		//Always send the server position, because we always say that the server is visible.  This
-		//should fix some or all ghost ship problems.
-		if (i == Player_num)
-		{
-			send_position = 1;
-		}
+	for (i = 0; i < num_reliable_fire; i++)
+	{
+		count = MultiStuffPlayerFire(reliable_fire[i], data);
+		nw_SendReliable(NetPlayers[to_slot].reliable_socket, data, count, true);
+	}
+}
 
-		if (timer_popped)
-		{
-			if (i != Player_num)
-				Multi_last_sent_time[to_slot][i] = 0;
+void MultiDoSnapshotAck(ubyte* data, int slot)
+{
+	if (Netgame.local_role != LR_SERVER || slot < 0 || slot >= MAX_NET_PLAYERS)
+		return;
 
+	int count = 0;
 
-			if (send_position)
-			{
-				Multi_visible_players[to_slot] |= (1 << i);
-
-				int count = MultiStuffPosition(i, data);
-				NetPlayers[to_slot].total_bytes_sent += count;
-
-				int add_count = 0;
-				// Send firing if needed
-				if (Player_fire_packet[i].fired_on_this_frame == PFP_FIRED)
-					add_count = MultiStuffPlayerFire(i, &data[count]);
-				count += add_count;
-				// Add in guided stuff
-				if (Players[i].guided_obj != NULL)
-				{
-					add_count = MultiStuffGuidedInfo(i, &data[count]);
-					count += add_count;
-				}
+	SKIP_HEADER(data, &count);
 
-				ASSERT(count < MAX_GAME_DATA_SIZE);
+	ubyte epoch = MultiGetUbyte(data, &count);
+	ushort sequence = MultiGetUshort(data, &count);
 
-				nw_Send(&NetPlayers[to_slot].addr, data, count, 0);
+	snapshot_client* sc = &Snapshot_clients[slot];
+	if (!sc->active || epoch != sc->epoch)
+		return;		// Left over from before the last restart
 
-				// TODO: SEND RELIABLE WEAPON FIRE HERE
-				if (Player_fire_packet[i].fired_on_this_frame == PFP_FIRED_RELIABLE)
-				{
-					//mprintf((0,"NEED TO SEND RELIABLE FIRE FOR %d\n",i));
-					count = MultiStuffPlayerFire(i, data);
-					nw_SendReliable(NetPlayers[to_slot].reliable_socket, data, count, true);
-				}
-			}
-			else
-			{
-				Multi_visible_players[to_slot] &= ~(1 << i);
-				Multi_occluded++;
-			}
-		}
+	snapshot_sent* sent = &sc->sent[sequence % SNAPSHOT_HISTORY];
+	if (sent->sequence != sequence || (ushort)(sc->sequence - sequence) > SNAPSHOT_HISTORY)
+		return;		// Too old, we don't have it anymore
+
+	for (int i = 0; i < MAX_PLAYERS; i++)
+	{
+		if (!(sent->players & (1 << i)))
+			continue;
+
+		if ((sc->have_base & (1 << i)) && (short)(sequence - sc->base_seq[i]) <= 0)
+			continue;
+
+		sc->base[i] = sent->state[i];
+		sc->base_seq[i] = sequence;
+		sc->have_base |= (1 << i);
 	}
 
+	sent->players = 0;
 }
 
 // Figures out which robots have moved since the last time this player slot was updated
@@ -1952,9 +2074,9 @@ void MultiDoNonVisGenericForSlot(int slot)
 
 }
 
-// Returns true or false based on whether or not the player can see this generic object in a multiplayer game
+// Returns true if player "to_slot" can see into this room in a multiplayer game
 // This takes into account markers, dll objects, and other stuff
-bool MultiIsGenericVisibleToPlayer(int test_objnum, int to_slot)
+bool MultiIsRoomVisibleToPlayer(int roomnum, int to_slot)
 {
 	int srcs[10], num_src_to_check = 1;
 
@@ -2009,7 +2131,7 @@ bool MultiIsGenericVisibleToPlayer(int test_objnum, int to_slot)
 
 	for (int t = 0; t < num_src_to_check; t++)
 	{
-		if (BOA_IsVisible(Objects[test_objnum].roomnum, Objects[srcs[t]].roomnum))
+		if (BOA_IsVisible(roomnum, Objects[srcs[t]].roomnum))
 			return true;
 	}
 
@@ -2017,6 +2139,12 @@ bool MultiIsGenericVisibleToPlayer(int test_objnum, int to_slot)
 
 }
 
+// Returns true or false based on whether or not the player can see this generic object in a multiplayer game
+bool MultiIsGenericVisibleToPlayer(int test_objnum, int to_slot)
+{
+	return MultiIsRoomVisibleToPlayer(Objects[test_objnum].roomnum, to_slot);
+}
+
 
 
 
@@ -2331,6 +2459,10 @@ void MultiDoServerFrame()
 			continue;
 		}
 
+		// Snapshots start over when this player is next in the game
+		if (!(NetPlayers[i].flags & NPF_CONNECTED) || NetPlayers[i].sequence != NETSEQ_PLAYING)
+			Snapshot_clients[i].active = false;
+
 		if (NetPlayers[i].flags & NPF_CONNECTED)
 		{
 			// Check to see if this guy as any special requests
@@ -84,4 +84,11 @@ void GetNewRankings (object *killed,object *killer);
 // Returns -1 if not a pxo game (ie no rankings in this game)
 int GetRankIndex (int pnum,char *rankbuf=NULL);
 
+// Bytes per second of player snapshots each client is sent
+extern int Snapshot_rate;
+
+// A client acknowledged a player snapshot, so its records can be used as baselines
+// Server only
+void MultiDoSnapshotAck (ubyte *data,int slot);
+
 #endif
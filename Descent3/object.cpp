@@ -64,6 +64,7 @@
 #include "hud.h"
 #include "demofile.h"
 #include "rtperformance.h"
+#include "timedemo.h"
 #include "osiris_dll.h"
 #include "gameloop.h"
 #include "mem.h"
@@ -71,6 +72,8 @@
 #include "levelgoal.h"
 #include "psrand.h"
 #include "vibeinterface.h"
+#include "object_grid.h"
+#include "jobs.h"
 
 #ifdef EDITOR
 #include "editor\d3edit.h"
@@ -310,6 +313,9 @@ void ResetObjectList()
 	//Say no big objects
 	InitBigObjects();
 
+	//Empty the object grid
+	ObjGridReset();
+
 	ObjResetPositionHistory();
 }
 
@@ -382,6 +388,8 @@ void ObjLink(int objnum, int roomnum)
 	ASSERT(Objects[0].prev != 0);
 	if (Objects[0].prev == 0)
 		Objects[0].prev = -1;
+
+	ObjGridLink(objnum);
 }
 
 void ObjUnlink(int objnum)
@@ -390,6 +398,8 @@ void ObjUnlink(int objnum)
 
 	ASSERT(objnum != -1);
 
+	ObjGridUnlink(objnum);
+
 	if (obj->flags & OF_BIG_OBJECT)
 	{
 		BigObjRemove(objnum);
@@ -602,6 +612,9 @@ void ObjSetAABB(object* obj)
 
 		obj->max_xyz = obj->pos + object_rad;
 	}
+
+	//Move the object to its new cell in the object grid
+	ObjGridUpdate(OBJNUM(obj));
 }
 
 //-----------------------------------------------------------------------------
@@ -669,6 +682,9 @@ int ObjCreate(ubyte type, ushort id, int roomnum, vector* pos, const matrix* ori
 	// Type specific should have set up the size, so now we can compute the bounding box.
 	ObjSetAABB(obj);
 
+	// Moves staged before the object pass didn't know about this object
+	PhysicsStagedMoveDisturb(obj);
+
 	//Let the demo system know about this object
 	DemoWriteObjCreate(type, id, roomnum, pos, orient, parent_handle, obj);
 
@@ -830,6 +846,9 @@ void ObjDelete(int objnum)
 	if (Player_camera_objnum == objnum)
 		Player_camera_objnum = -1;
 
+	// Kill any script timers that depend on this object
+	Osiris_DetachTimersFromObject(obj);
+
 #ifdef _DEBUG
 	if (print_object_info)
 	{
@@ -1659,10 +1678,10 @@ void ObjDoEffects(object* obj)
 //Check passed-through faces for triggers, etc.
 void ObjCheckTriggers(object* objp)
 {
-	for (int i = 0; i < Fvi_num_recorded_faces; i++)
+	for (int i = 0; i < Fvi_main_context.num_recorded_faces; i++)
 	{
-		int roomnum = Fvi_recorded_faces[i].room_index;
-		int facenum = Fvi_recorded_faces[i].face_index;
+		int roomnum = Fvi_main_context.recorded_faces[i].room_index;
+		int facenum = Fvi_main_context.recorded_faces[i].face_index;
 
 		CheckTrigger(roomnum, facenum, objp, TT_PASS_THROUGH);
 	}
@@ -1729,7 +1748,7 @@ void ObjDoFrame(object* obj)
 	case CT_NONE:
 		break;
 	case CT_FLYING: { RTP_STARTINCTIME(ct_flying_time);			DoFlyingControl(obj);	RTP_ENDINCTIME(ct_flying_time); }break;
-	case CT_AI:				if (DoAI) { RTP_STARTINCTIME(ct_aidoframe_time); AIDoFrame(obj);		RTP_ENDINCTIME(ct_aidoframe_time); }break;
+	case CT_AI:				if (DoAI) { RTP_STARTINCTIME(ct_aidoframe_time); TIMEDEMO_START(td_ai); AIDoFrame(obj); TIMEDEMO_END(TDS_AI, td_ai); RTP_ENDINCTIME(ct_aidoframe_time); }break;
 	case CT_WEAPON: { RTP_STARTINCTIME(ct_weaponframe_time);	WeaponDoFrame(obj);		RTP_ENDINCTIME(ct_weaponframe_time); }break;
 	case CT_EXPLOSION: { RTP_STARTINCTIME(ct_explosionframe_time); DoExplosionFrame(obj);	RTP_ENDINCTIME(ct_explosionframe_time); }break;
 	case CT_DEBRIS: { RTP_STARTINCTIME(ct_debrisframe_time);	DoDebrisFrame(obj);		RTP_ENDINCTIME(ct_debrisframe_time); }break;
@@ -1864,20 +1883,24 @@ void ObjDoFrame(object* obj)
 	case MT_PHYSICS:
 	{
 		RTP_STARTINCTIME(mt_physicsframe_time);
+		TIMEDEMO_START(td_physics);
 
 		do_physics_sim(obj);
 		DebugBlockPrint("DP");
 		ObjCheckTriggers(obj);
 
+		TIMEDEMO_END(TDS_PHYSICS, td_physics);
 		RTP_ENDINCTIME(mt_physicsframe_time);
 	}break;
 
 	case MT_WALKING:
 	{
 		RTP_STARTINCTIME(mt_walkingframe_time);
+		TIMEDEMO_START(td_physics);
 		do_walking_sim(obj);
 		DebugBlockPrint("DW");
 		ObjCheckTriggers(obj);
+		TIMEDEMO_END(TDS_PHYSICS, td_physics);
 		RTP_ENDINCTIME(mt_walkingframe_time);
 	}break;
 
@@ -1990,6 +2013,41 @@ int	Max_used_objects = MAX_OBJECTS - 20;
 float Last_position_history_update[MAX_POSITION_HISTORY];//gametime of the last position history update of the object
 float Last_position_history_update_time = 0.0f;
 
+// Job that does the start of ObjDoFrame() to copies of weapons and works out their moves
+static void StageObjectMoves(void*, int start, int end, int worker)
+{
+	fvi_context* ctx = job_GetFVIContext(worker);
+	object obj;
+
+	for (int i = start; i < end; i++)
+	{
+		const object* objp = &Objects[i];
+
+		if (objp->type != OBJ_WEAPON || objp->control_type != CT_WEAPON || objp->movement_type != MT_PHYSICS)
+			continue;
+
+		if (objp->flags & (OF_DEAD | OF_PING_ACCELERATE))
+			continue;
+
+		memcpy(&obj, objp, sizeof(object));
+
+		obj.lowest_attached_vis = -1;
+		obj.last_pos = obj.pos;
+
+		if (obj.flags & OF_USES_LIFELEFT)
+		{
+			obj.lifeleft -= Frametime;
+
+			// Dies of old age this frame
+			if (obj.lifeleft < 0)
+				continue;
+		}
+
+		if (WeaponStageFrame(&obj))
+			PhysicsStageMove(ctx, i, &obj);
+	}
+}
+
 //--------------------------------------------------------------------
 //Process all objects for the current frame
 #define OBJ_POS_SAMPLE_TIME			(1.0f/( ((float)MAX_POSITION_HISTORY)*20.0f) )//super sample at 20 fps
@@ -2023,6 +2081,15 @@ void ObjDoFrameAll()
 
 	Physics_NumLinked = 0;
 
+	// Dynamic lights cast this frame get their face and cell searches done all at once by the job workers
+	StartQueuedLighting();
+
+	// Work out the weapons' moves on the job workers, from the objects as they are now.  The pass
+	// below still does everything in object order, and only takes a staged move if the weapon and
+	// everything it could have hit are unchanged by the time it gets there.
+	job_Run(Highest_object_index + 1, StageObjectMoves, NULL);
+	PhysicsUseStagedMoves(Highest_object_index + 1);
+
 	//Process each object
 	for (i = 0, objp = Objects; i <= Highest_object_index; i++, objp++)
 	{
@@ -2030,6 +2097,7 @@ void ObjDoFrameAll()
 		{
 			RTP_STARTINCTIME(obj_do_frm);
 			ObjDoFrame(objp);
+			PhysicsStagedMoveDisturb(objp);
 
 			if (update_position_history)
 			{
@@ -2043,6 +2111,8 @@ void ObjDoFrameAll()
 		}
 	}
 
+	PhysicsUseStagedMoves(0);
+
 	// Account for linked objects
 	for (i = 0; i < Physics_NumLinked; i++)
 	{
@@ -2058,6 +2128,9 @@ void ObjDoFrameAll()
 		RTP_ENDINCTIME(vis_eff_move);
 	}
 
+	// Apply the lights in the order they were cast
+	FlushQueuedLighting();
+
 	// Blend all lights that are needed
 	BlendAllLightingEdges();
 
@@ -2295,6 +2368,9 @@ void ObjSetPos(object* obj, vector* pos, int roomnum, matrix* orient, bool f_upd
 			}
 		}
 	}
+
+	// Moves staged before the object pass saw this object where it was
+	PhysicsStagedMoveDisturb(obj);
 }
 
 
@@ -0,0 +1,288 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <math.h>
+#include <limits.h>
+
+#include "object_grid.h"
+#include "object.h"
+#include "pserror.h"
+
+// The number of hash buckets the cells share.  Must be a power of 2
+#define OBJGRID_BUCKETS		4096
+
+// The list of objects too big for the grid, after the hash buckets
+#define OBJGRID_LARGE		OBJGRID_BUCKETS
+
+// The first object in each bucket, and the large object list
+static short Grid_buckets[OBJGRID_BUCKETS + 1];
+
+// For each object, its bucket (-1 if not in the grid), its cell, and its neighbors in the bucket
+static short Grid_bucket[MAX_OBJECTS];
+static int Grid_cell[MAX_OBJECTS][3];
+static short Grid_next[MAX_OBJECTS];
+static short Grid_prev[MAX_OBJECTS];
+
+// The range of cells that have held an object since the grid was reset.  Queries are clipped to it,
+// so a tall query box over the terrain doesn't look at all the empty cells above and below it.
+static int Grid_min_cell[3];
+static int Grid_max_cell[3];
+
+static inline int GridCellCoord(float v)
+{
+	return (int)floorf(v / OBJGRID_CELL_SIZE);
+}
+
+static inline int GridHash(int x, int y, int z)
+{
+	return (((unsigned)x * 73856093u) ^ ((unsigned)y * 19349663u) ^ ((unsigned)z * 83492791u)) & (OBJGRID_BUCKETS - 1);
+}
+
+// Finds the bucket and cell an object belongs in
+static int GridPlaceObject(object *obj, int *cell)
+{
+	vector center = (obj->min_xyz + obj->max_xyz) / 2;
+
+	cell[0] = GridCellCoord(center.x);
+	cell[1] = GridCellCoord(center.y);
+	cell[2] = GridCellCoord(center.z);
+
+	if (obj->max_xyz.x - center.x > OBJGRID_MAX_EXTENT ||
+		obj->max_xyz.y - center.y > OBJGRID_MAX_EXTENT ||
+		obj->max_xyz.z - center.z > OBJGRID_MAX_EXTENT)
+		return OBJGRID_LARGE;
+
+	return GridHash(cell[0], cell[1], cell[2]);
+}
+
+static void GridAdd(int objnum, int bucket, int *cell)
+{
+	Grid_bucket[objnum] = bucket;
+	Grid_cell[objnum][0] = cell[0];
+	Grid_cell[objnum][1] = cell[1];
+	Grid_cell[objnum][2] = cell[2];
+
+	Grid_prev[objnum] = -1;
+	Grid_next[objnum] = Grid_buckets[bucket];
+	if (Grid_next[objnum] != -1)
+		Grid_prev[Grid_next[objnum]] = objnum;
+	Grid_buckets[bucket] = objnum;
+
+	if (bucket != OBJGRID_LARGE)
+	{
+		for (int i = 0; i < 3; i++)
+		{
+			if (cell[i] < Grid_min_cell[i])
+				Grid_min_cell[i] = cell[i];
+			if (cell[i] > Grid_max_cell[i])
+				Grid_max_cell[i] = cell[i];
+		}
+	}
+}
+
+static void GridRemove(int objnum)
+{
+	int bucket = Grid_bucket[objnum];
+
+	if (Grid_prev[objnum] == -1)
+		Grid_buckets[bucket] = Grid_next[objnum];
+	else
+		Grid_next[Grid_prev[objnum]] = Grid_next[objnum];
+
+	if (Grid_next[objnum] != -1)
+		Grid_prev[Grid_next[objnum]] = Grid_prev[objnum];
+
+	Grid_bucket[objnum] = -1;
+}
+
+void ObjGridReset()
+{
+	int i;
+
+	for (i = 0; i <= OBJGRID_BUCKETS; i++)
+		Grid_buckets[i] = -1;
+
+	for (i = 0; i < MAX_OBJECTS; i++)
+		Grid_bucket[i] = -1;
+
+	for (i = 0; i < 3; i++)
+	{
+		Grid_min_cell[i] = INT_MAX;
+		Grid_max_cell[i] = INT_MIN;
+	}
+}
+
+void ObjGridLink(int objnum)
+{
+	int cell[3];
+
+	ASSERT(objnum >= 0 && objnum < MAX_OBJECTS);
+
+	if (Grid_bucket[objnum] != -1)
+		GridRemove(objnum);
+
+	int bucket = GridPlaceObject(&Objects[objnum], cell);
+	GridAdd(objnum, bucket, cell);
+}
+
+void ObjGridUnlink(int objnum)
+{
+	ASSERT(objnum >= 0 && objnum < MAX_OBJECTS);
+
+	if (Grid_bucket[objnum] != -1)
+		GridRemove(objnum);
+}
+
+void ObjGridUpdate(int objnum)
+{
+	int cell[3];
+
+	ASSERT(objnum >= 0 && objnum < MAX_OBJECTS);
+
+	if (Grid_bucket[objnum] == -1)
+		return;
+
+	// Most moves stay in the same cell
+	int bucket = GridPlaceObject(&Objects[objnum], cell);
+	if (bucket == Grid_bucket[objnum] && cell[0] == Grid_cell[objnum][0] && cell[1] == Grid_cell[objnum][1] && cell[2] == Grid_cell[objnum][2])
+		return;
+
+	GridRemove(objnum);
+	GridAdd(objnum, bucket, cell);
+}
+
+static inline bool GridObjectInBox(object *obj, const vector *min_xyz, const vector *max_xyz)
+{
+	return !(obj->max_xyz.x < min_xyz->x || max_xyz->x < obj->min_xyz.x ||
+		obj->max_xyz.y < min_xyz->y || max_xyz->y < obj->min_xyz.y ||
+		obj->max_xyz.z < min_xyz->z || max_xyz->z < obj->min_xyz.z);
+}
+
+int ObjGridQueryBox(const vector *min_xyz, const vector *max_xyz, short *list, int max_elements)
+{
+	int lo[3], hi[3];
+	int num_objects = 0;
+	int objnum;
+	int i;
+
+	// Objects in the grid reach at most OBJGRID_MAX_EXTENT out of their cell
+	lo[0] = GridCellCoord(min_xyz->x - OBJGRID_MAX_EXTENT);
+	lo[1] = GridCellCoord(min_xyz->y - OBJGRID_MAX_EXTENT);
+	lo[2] = GridCellCoord(min_xyz->z - OBJGRID_MAX_EXTENT);
+	hi[0] = GridCellCoord(max_xyz->x + OBJGRID_MAX_EXTENT);
+	hi[1] = GridCellCoord(max_xyz->y + OBJGRID_MAX_EXTENT);
+	hi[2] = GridCellCoord(max_xyz->z + OBJGRID_MAX_EXTENT);
+
+	int num_cells = 1;
+	for (i = 0; i < 3; i++)
+	{
+		if (lo[i] < Grid_min_cell[i])
+			lo[i] = Grid_min_cell[i];
+		if (hi[i] > Grid_max_cell[i])
+			hi[i] = Grid_max_cell[i];
+
+		if (hi[i] < lo[i])
+			num_cells = 0;
+		else
+			num_cells *= hi[i] - lo[i] + 1;
+
+		if (num_cells > OBJGRID_MAX_QUERY_CELLS)
+			return -1;
+	}
+
+	if (num_cells > 0)
+	{
+		for (int x = lo[0]; x <= hi[0]; x++)
+		{
+			for (int y = lo[1]; y <= hi[1]; y++)
+			{
+				for (int z = lo[2]; z <= hi[2]; z++)
+				{
+					// Other cells share the bucket, so only take the objects in this one
+					for (objnum = Grid_buckets[GridHash(x, y, z)]; objnum != -1; objnum = Grid_next[objnum])
+					{
+						if (Grid_cell[objnum][0] != x || Grid_cell[objnum][1] != y || Grid_cell[objnum][2] != z)
+							continue;
+
+						if (GridObjectInBox(&Objects[objnum], min_xyz, max_xyz))
+						{
+							if (num_objects >= max_elements)
+								return num_objects;
+							list[num_objects++] = objnum;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	for (objnum = Grid_buckets[OBJGRID_LARGE]; objnum != -1; objnum = Grid_next[objnum])
+	{
+		if (GridObjectInBox(&Objects[objnum], min_xyz, max_xyz))
+		{
+			if (num_objects >= max_elements)
+				break;
+			list[num_objects++] = objnum;
+		}
+	}
+
+	return num_objects;
+}
+
+int ObjGridQueryRadius(const vector *pos, float rad, short *list, int max_elements)
+{
+	vector delta, min_xyz, max_xyz;
+
+	delta.x = delta.y = delta.z = rad;
+	min_xyz = *pos - delta;
+	max_xyz = *pos + delta;
+
+	int num_found = ObjGridQueryBox(&min_xyz, &max_xyz, list, max_elements);
+	if (num_found <= 0)
+		return num_found;
+
+	// Drop the objects that only touch the corners of the box
+	int num_objects = 0;
+	float rad_sq = rad * rad;
+
+	for (int i = 0; i < num_found; i++)
+	{
+		object *obj = &Objects[list[i]];
+		float dist_sq = 0;
+
+		if (pos->x < obj->min_xyz.x)
+			dist_sq += (obj->min_xyz.x - pos->x) * (obj->min_xyz.x - pos->x);
+		else if (pos->x > obj->max_xyz.x)
+			dist_sq += (pos->x - obj->max_xyz.x) * (pos->x - obj->max_xyz.x);
+
+		if (pos->y < obj->min_xyz.y)
+			dist_sq += (obj->min_xyz.y - pos->y) * (obj->min_xyz.y - pos->y);
+		else if (pos->y > obj->max_xyz.y)
+			dist_sq += (pos->y - obj->max_xyz.y) * (pos->y - obj->max_xyz.y);
+
+		if (pos->z < obj->min_xyz.z)
+			dist_sq += (obj->min_xyz.z - pos->z) * (obj->min_xyz.z - pos->z);
+		else if (pos->z > obj->max_xyz.z)
+			dist_sq += (pos->z - obj->max_xyz.z) * (pos->z - obj->max_xyz.z);
+
+		if (dist_sq <= rad_sq)
+			list[num_objects++] = list[i];
+	}
+
+	return num_objects;
+}
@@ -0,0 +1,59 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef OBJECT_GRID_H
+#define OBJECT_GRID_H
+
+#include "vecmat.h"
+
+// The object grid is a spatial hash of every linked object, so proximity queries only look at the
+// objects near them instead of walking rooms, terrain cells or the whole object list.  An object
+// is filed under the grid cell holding the center of its bounding box.  Objects are added and
+// removed as they're linked into rooms, and moved whenever their bounding box is recomputed.
+
+// The size of a grid cell
+#define OBJGRID_CELL_SIZE			64.0f
+
+// Objects whose bounding box reaches further than this from its center are kept in one list that
+// every query checks, so a query only has to look this far past its own box
+#define OBJGRID_MAX_EXTENT			(OBJGRID_CELL_SIZE / 2)
+
+// Queries that would look at more cells than this give up, and the caller searches some other way
+#define OBJGRID_MAX_QUERY_CELLS	512
+
+// Empties the grid.  Called when the object list is reset
+void ObjGridReset();
+
+// Adds an object to the grid
+void ObjGridLink(int objnum);
+
+// Takes an object out of the grid
+void ObjGridUnlink(int objnum);
+
+// Moves an object to the cell of its current bounding box
+void ObjGridUpdate(int objnum);
+
+// Fills list with the objects whose bounding boxes overlap the given box
+// Returns the number of objects found, or -1 if the box covers too many cells to search
+int ObjGridQueryBox(const vector *min_xyz, const vector *max_xyz, short *list, int max_elements);
+
+// Fills list with the objects whose bounding boxes come within rad of pos
+// Returns the number of objects found, or -1 if the sphere covers too many cells to search
+int ObjGridQueryRadius(const vector *pos, float rad, short *list, int max_elements);
+
+#endif
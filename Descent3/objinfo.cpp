@@ -34,6 +34,7 @@
 
 //The array with information for robots, powerups, buildings, etc.
 object_info Object_info[MAX_OBJECT_IDS];
+tNameIndex<MAX_OBJECT_IDS> Object_info_names(Object_info[0].name, sizeof(object_info));
 
 //The number of ids of each type in the list
 int Num_object_ids[MAX_OBJECT_TYPES];
@@ -71,6 +72,7 @@ void InitObjectInfo()
 		Object_info[i].multi_allowed = 1;
 		Object_info[i].module_name[0] = 0;
 	}
+	Object_info_names.clear();
 
 	for (i = 0; i < MAX_OBJECT_TYPES; i++)
 		Num_object_ids[i] = 0;
@@ -94,6 +96,7 @@ int AllocObjectID(int type, bool f_anim, bool f_weapons, bool f_ai)
 		{
 			mprintf((1, "%d ", type));
 			memset(&Object_info[i], 0, sizeof(*Object_info));
+			Object_info_names.update(i);
 
 			extern void AISetDefault(t_ai_info * ai_info_ptr);
 			if (f_ai)
@@ -179,6 +182,7 @@ void FreeObjectID(int n)
 	Num_object_ids[Object_info[n].type]--;
 	Object_info[n].type = OBJ_NONE;
 	Object_info[n].name[0] = 0;
+	Object_info_names.update(n);
 	Object_info[n].icon_name[0] = 0;
 	Object_info[n].script_name_override[0] = 0;
 	Object_info[n].module_name[0] = 0;
@@ -290,11 +294,7 @@ int FindObjectIDName(char* name)
 {
 	ASSERT(name != NULL);
 
-	for (int i = 0; i < MAX_OBJECT_IDS; i++)
-		if ((Object_info[i].type != OBJ_NONE) && !stricmp(name, Object_info[i].name))
-			return i;
-
-	return -1;
+	return Object_info_names.find(name);
 }
 
 // Given an object handle, returns an index to that object's model
@@ -377,15 +377,19 @@ void RemapStaticIDs()
 			if (new_index >= 0) //DAJ -1FIX
 			{
 				Object_info[new_index] = Object_info[i];
+				Object_info_names.update(new_index);
 				RemapObjects(i, new_index);
 			}
 		}
 
 		//Copy static ID into new slot
 		Object_info[i] = Object_info[cur_index];
+		Object_info_names.update(i);
 
 		//Free up the old slot
 		Object_info[cur_index].type = OBJ_NONE;
+		Object_info[cur_index].name[0] = 0;
+		Object_info_names.update(cur_index);
 
 		//Remap the objects that used this ID
 		RemapObjects(cur_index, i);
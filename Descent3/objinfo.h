@@ -22,6 +22,7 @@
 #include "object.h"
 #include "manage.h"
 #include "DeathInfo.h"
+#include "nameindex.h"
 
 #ifdef NEWEDITOR
 #include "..\neweditor\ned_Object.h"
@@ -231,6 +232,7 @@ struct object_info
 
 //The big array of object info
 extern object_info Object_info[];
+extern tNameIndex<MAX_OBJECT_IDS> Object_info_names;	// call Object_info_names.update(n) after changing Object_info[n].name
 
 #endif
 
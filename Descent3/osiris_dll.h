@@ -148,6 +148,18 @@ int Osiris_CreateTimer(tOSIRISTIMER *ot);
 //		Flushes all the timers
 void Osiris_ResetAllTimers(void);
 
+//	Osiris_DetonateObjectTimers
+//	Purpose:
+//		Call this when an object dies, or a player starts dying or becomes a ghost.  Timers that
+//	cancel when this object dies are cancelled the next time timers are processed.
+void Osiris_DetonateObjectTimers(object *obj);
+
+//	Osiris_DetachTimersFromObject
+//	Purpose:
+//		Call this function when an object is about to be destroyed.  Timers owned by the object
+//	are removed without any events, and timers it detonates are cancelled.
+void Osiris_DetachTimersFromObject(object *obj);
+
 //	Osiris_CancelTimer
 //	Purpose:
 //		Cancels a timer thats in use, given it's ID
@@ -206,12 +218,13 @@ void Osiris_RestoreMemoryChunks(CFILE *file);
 void Osiris_SaveMemoryChunks(CFILE *file);
 
 //	Osiris_ExtractScriptsFromHog
-//	Given the handle of a loaded hog file, this extracts all the scripts out to a temp directory
+//	Given the handle of a loaded hog file, this registers all the scripts in it.  A script is only
+//	extracted when a level loads it, into memory or the script cache (keyed by content hash)
 //	Pass false for the second parameter if it's a game hog (d3.hog for example)
 int Osiris_ExtractScriptsFromHog(int library_handle,bool is_mission_hog=true);
 
 //	Osiris_ClearExtractedScripts
-//	Deletes the temp files created when the scripts where extracted from the hog
+//	Forgets the scripts registered from hogs (the script cache on disk is kept)
 //	Pass false if you want it to remove _all_ extracted hogs...else only mission related ones
 void Osiris_ClearExtractedScripts(bool misson_only=true);
 
@@ -153,6 +153,9 @@ int Num_real_specular_faces_to_render = 0;	// Non-invisible specular faces
 //[ISB] temp: Should stick this in Room or a separate render-related struct later down the line (dynamic room limit at some point?)
 //These are the meshes of all normal room geometry. 
 MeshBuilder Room_meshes[MAX_ROOMS];
+//The texture each face of a room was meshed with, or -1 if the face isn't in the mesh and is drawn through RenderFace.
+//Empty when the room has no mesh.
+std::vector<short> Room_mesh_tmaps[MAX_ROOMS];
 
 struct smooth_spec_vert
 {
@@ -220,21 +223,142 @@ ubyte Mirrored_room_checked[MAX_ROOMS];
 short Mirror_rooms[MAX_ROOMS];
 int Num_mirror_rooms = 0;
 
+//Determines if a face can be baked into its room's static mesh. 
+//Faces that animate, slide, blend, need per-face effects (coronas, specular, breaking) or are portals are left to RenderFace.
+static bool FaceIsMeshable(face* fp)
+{
+	if (fp->portal_num != -1 || (fp->flags & FF_FLOATING_TRIG))
+		return false;
+
+	if (!(fp->flags & FF_LIGHTMAP) || fp->lmi_handle == BAD_LMI_INDEX)
+		return false;
+
+	texture* texp = &GameTextures[fp->tmap];
+	if (!texp->used)
+		return false;
+
+	if (texp->flags & (TF_ANIMATED | TF_PROCEDURAL | TF_DESTROYABLE | TF_TMAP2 | TF_ALPHA | TF_SATURATE | TF_SATURATE_LIGHTMAP |
+		TF_LIGHT | TF_SPECULAR | TF_SMOOTH_SPECULAR))
+		return false;
+
+	if (texp->alpha < 1.0 || texp->slide_u != 0 || texp->slide_v != 0)
+		return false;
+
+	return true;
+}
+
 //Meshes a given room. 
-//In time, this will create 
+//All the faces that never change how they're drawn are sorted by texture and lightmap and baked into Room_meshes[roomnum].
+//Everything else is still drawn a face at a time by RenderRoomUnsorted.
 void UpdateRoomMesh(int roomnum)
 {
 	Room_meshes[roomnum].Destroy(); //this kills the old mesh even if the room isn't used, since the stale mesh isn't used either. 
+	Room_mesh_tmaps[roomnum].clear();
 
 	room& rp = Rooms[roomnum];
 	if (!rp.used)
 		return; //unused room
+
+	//Gather all the faces that can be meshed
+	std::vector<SortableElement> sortfaces;
+	sortfaces.reserve(rp.num_faces);
+	for (int i = 0; i < rp.num_faces; i++)
+	{
+		face* fp = &rp.faces[i];
+		if (!FaceIsMeshable(fp))
+			continue;
+
+		SortableElement element;
+		element.element = i;
+		element.texturehandle = GetTextureBitmap(fp->tmap, 0);
+		element.lmhandle = LightmapInfo[fp->lmi_handle].lm_handle;
+		sortfaces.push_back(element);
+	}
+
+	if (sortfaces.empty())
+		return;
+
+	//Sort all the faces by their bitmap and lightmap
+	std::sort(sortfaces.begin(), sortfaces.end());
+
+	MeshBuilder& mesh = Room_meshes[roomnum];
+	Room_mesh_tmaps[roomnum].assign(rp.num_faces, -1);
+
+	int lasttexhandle = -1, lastlmhandle = -1;
+	RendVertex verts[MAX_VERTS_PER_FACE] = {};
+	short indicies[(MAX_VERTS_PER_FACE - 2) * 3];
+	for (SortableElement& element : sortfaces)
+	{
+		face* fp = &rp.faces[element.element];
+
+		//Indicies are 16-bit, so anything past that has to stay on the slow path.
+		int firstvert = mesh.NumVertices();
+		if (firstvert + fp->num_verts > USHRT_MAX + 1)
+			break;
+
+		if (element.texturehandle != lasttexhandle || element.lmhandle != lastlmhandle)
+		{
+			mesh.StartBatchTwoTex(element.texturehandle, element.lmhandle);
+			lasttexhandle = element.texturehandle;
+			lastlmhandle = element.lmhandle;
+		}
+
+		//The renderer stores lightmaps in square textures, so scale the lightmap UVs the same way the old path does
+		bms_lightmap& lm = GameLightmaps[element.lmhandle];
+		float xscalar = (float)lm.width / lm.square_res;
+		float yscalar = (float)lm.height / lm.square_res;
+
+		for (int vn = 0; vn < fp->num_verts; vn++)
+		{
+			RendVertex& vert = verts[vn];
+			roomUVL& uvl = fp->face_uvls[vn];
+			vert.position = rp.verts[fp->face_verts[vn]];
+			vert.normal = fp->normal;
+			vert.r = vert.g = vert.b = vert.a = 255;
+			vert.u1 = uvl.u;
+			vert.v1 = uvl.v;
+			vert.u2 = uvl.u2 * xscalar;
+			vert.v2 = uvl.v2 * yscalar;
+		}
+
+		//Faces are convex, so fan them out
+		int numindicies = 0;
+		for (int vn = 2; vn < fp->num_verts; vn++)
+		{
+			indicies[numindicies++] = (short)firstvert;
+			indicies[numindicies++] = (short)(firstvert + vn - 1);
+			indicies[numindicies++] = (short)(firstvert + vn);
+		}
+
+		mesh.SetIndicies(numindicies, indicies);
+		mesh.SetVertices(fp->num_verts, verts);
+
+		Room_mesh_tmaps[roomnum][element.element] = fp->tmap;
+	}
+
+	//All vertices are created, so finalize the mesh.
+	mesh.Build();
+}
+
+//Returns true if a face in a room's mesh has had its texture changed since the room was meshed
+static bool RoomMeshIsStale(room* rp, int roomnum)
+{
+	std::vector<short>& tmaps = Room_mesh_tmaps[roomnum];
+
+	for (int i = 0; i < (int)tmaps.size(); i++)
+	{
+		if (tmaps[i] != -1 && tmaps[i] != rp->faces[i].tmap)
+			return true;
+	}
+
+	return false;
 }
 
 //Called during LoadLevel, builds meshes for every room. 
 void MeshRooms()
 {
-	for (int i = 0; i < Highest_room_index; i++)
+	//Go over every slot so meshes left over from the last level get freed too
+	for (int i = 0; i < MAX_ROOMS; i++)
 	{
 		UpdateRoomMesh(i);
 	}
@@ -2559,11 +2683,29 @@ void SetupRoomFog(room* rp, vector* eye, matrix* orient, int viewer_room)
 	Room_fog_eye_distance = (*eye * Room_fog_plane) + Room_fog_distance;
 }
 
+//Determines if a room's static mesh can be drawn this frame
+//Anything that changes how the whole room looks from frame to frame still goes through RenderFace
+static bool CanDrawRoomMesh(room* rp)
+{
+	if (ROOMNUM(rp) >= MAX_ROOMS || In_editor_mode)
+		return false;
+	if (!UseHardware || NoLightmaps || (StateLimited && !UseMultitexture))
+		return false;
+	if (Render_mirror_for_room || rp->mirror_face != -1)
+		return false;
+	if ((rp->flags & (RF_FOG | RF_EXTERNAL)) || Room_light_val != 1.0)
+		return false;
+
+	return true;
+}
+
 //Renders the faces in a room without worrying about sorting.  Used in the game when Z-buffering is active
 void RenderRoomUnsorted(room* rp)
 {
 	int fn;
 	int rcount = 0;
+	int roomnum = ROOMNUM(rp);
+	short* mesh_tmaps = NULL;
 	ASSERT(rp->num_faces <= MAX_FACES_PER_ROOM);
 
 	// Rotate points in this room if need be
@@ -2591,6 +2733,27 @@ void RenderRoomUnsorted(room* rp)
 	if (rp->flags & RF_FOG)
 		SetupRoomFog(rp, &Viewer_eye, &Viewer_orient, Viewer_roomnum);
 
+	//Draw all the static faces of the room at once
+	if (CanDrawRoomMesh(rp))
+	{
+		//Scripts and the network change face textures directly, so check for that before drawing,
+		//or the face would be drawn by both the mesh and RenderFace
+		if (RoomMeshIsStale(rp, roomnum))
+			UpdateRoomMesh(roomnum);
+
+		if (!Room_mesh_tmaps[roomnum].empty())
+		{
+			rend_UseShaderTest();
+			rend_SetAlphaType(AT_ALWAYS);
+			rend_SetTextureType(TT_PERSPECTIVE);
+			rend_SetWrapType(WT_WRAP);
+			Room_meshes[roomnum].Draw();
+			rend_EndShaderTest();
+
+			mesh_tmaps = Room_mesh_tmaps[roomnum].data();
+		}
+	}
+
 	//Check for visible (non-backfacing) faces, & render
 	for (fn = 0; fn < rp->num_faces; fn++)
 	{
@@ -2640,6 +2803,24 @@ void RenderRoomUnsorted(room* rp)
 		}
 #endif
 
+		//Faces in the mesh were drawn above, so just do what RenderFace would have done after drawing them
+		if (mesh_tmaps && mesh_tmaps[fn] != -1)
+		{
+			ASSERT(mesh_tmaps[fn] == fp->tmap);
+
+			fp->flags &= ~FF_TRIANGULATED;
+			fp->renderframe = FrameCount % 256;
+
+			if (fp->flags & FF_SCORCHED)
+			{
+				if (!StateLimited)
+					DrawScorches(roomnum, fn);
+				else
+					Scorches_to_render[Num_scorches_to_render++] = fn;
+			}
+			continue;
+		}
+
 		if (fp->portal_num != -1 && !(rp->portals[fp->portal_num].flags & PF_RENDER_FACES) && (rp->flags & RF_FOG))
 		{
 			fogged_portal = 1;
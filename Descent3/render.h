@@ -170,6 +170,12 @@ void RenderFogFaces(room *rp);
 // Builds a list of mirror faces for each room and allocs memory accordingly
 void ConsolidateMineMirrors();
 
+// Rebuilds the static mesh for a room
+void UpdateRoomMesh(int roomnum);
+
+// Builds the static meshes for every room.  Called when a level is loaded
+void MeshRooms();
+
 extern int Num_specular_faces_to_render,Num_fog_faces_to_render;
 
 #endif
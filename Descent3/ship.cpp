@@ -33,6 +33,7 @@
 
 ship Ships[MAX_SHIPS];
 int Num_ships=0;
+tNameIndex<MAX_SHIPS> Ship_names(Ships[0].name,sizeof(ship));
 
 //There are no static ships
 char *Static_ship_names[1];
@@ -51,6 +52,7 @@ void InitShips ()
 	{
 		memset(&Ships[i], 0, sizeof(ship));
 	}
+	Ship_names.clear();
 	Num_ships=0;
 }
 
@@ -62,6 +64,7 @@ int AllocShip ()
 		if (Ships[i].used==0)
 		{
 			memset (&Ships[i],0,sizeof(ship));
+			Ship_names.update(i);
 			Ships[i].used=1;
 			Ships[i].size=DEFAULT_SHIP_SIZE;
 			Ships[i].dying_model_handle=-1;
@@ -100,6 +103,7 @@ void FreeShip (int n)
 
 	Ships[n].used=0;
 	Ships[n].name[0]=0;
+	Ship_names.update(n);
 	Num_ships--;
 }
 
@@ -156,15 +160,9 @@ int GetPrevShip (int n)
 // or index of ship with name
 int FindShipName (char *name)
 {
-	int i;
-
 	ASSERT (name!=NULL);
 
-	for (i=0;i<MAX_SHIPS;i++)
-		if (Ships[i].used && !stricmp (name,Ships[i].name))
-			return i;
-
-	return -1;
+	return Ship_names.find (name);
 }
 
 
@@ -24,6 +24,7 @@
 #include "object.h"
 #include "robotfirestruct.h"
 #include "player.h"
+#include "nameindex.h"
 
 #define MAX_SHIPS				30
 
@@ -82,6 +83,7 @@ struct ship
 
 extern int Num_ships;
 extern ship Ships[MAX_SHIPS];
+extern tNameIndex<MAX_SHIPS> Ship_names;	// call Ship_names.update(n) after changing Ships[n].name
 
 extern char *AllowedShips[];
 
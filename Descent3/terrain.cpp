@@ -587,6 +587,9 @@ void DeformTerrain(vector* pos, int depth, float size)
 		}
 	}
 
+	if (!Dedicated_server)
+		RemeshTerrainArea(startx, startz, endx, endz);
+
 	int div = (1 << (MAX_TERRAIN_LOD - 1));
 
 	startx /= div;
@@ -279,6 +279,9 @@ extern int CheckToRenderSky (int);
 //Called after loading terrain. Will delete all cell meshes and then build new meshes. 
 void MeshTerrain();
 
+//Called after the terrain squares from x1,z1 to x2,z2 have been changed. Rebuilds the cell meshes touching them.
+void RemeshTerrainArea(int x1, int z1, int x2, int z2);
+
 
 //left,top,right,bot are optional parameters.  Omiting them (or setting them to -1) will
 //render to the whole screen.  Passing valid values will only render tiles visible in the
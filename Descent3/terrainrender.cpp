@@ -99,6 +99,24 @@ bool Rendering_main_view = true;
 //Terrain is meshed at the same size as the occlusion cells, for easier rendering. 
 MeshBuilder TerrainMeshes[OCCLUSION_SIZE * OCCLUSION_SIZE];
 
+//Each cell mesh holds a set of batches for every level of detail it could be meshed at.
+//Level n is made of quads (1 << n) terrain squares across, the same blocks the LOD deltas are kept for.
+struct TerrainCellMesh
+{
+	int num_lods;
+	int first_batch[MAX_TERRAIN_LOD];
+	int num_batches[MAX_TERRAIN_LOD];
+	float skirt_depth;
+	vector min_xyz, max_xyz;
+};
+
+static TerrainCellMesh TerrainCellMeshes[OCCLUSION_SIZE * OCCLUSION_SIZE];
+
+extern float TS_SimplifyCondition;
+
+// Takes a min,max vector and makes a surrounding cube from it
+void MakePointsFromMinMax(vector* corners, vector* minp, vector* maxp);
+
 struct SortableCell
 {
 	int x, z;
@@ -178,29 +196,143 @@ static float GetYClamped(unsigned int x, unsigned int z)
 	return Terrain_seg[z * TERRAIN_WIDTH + x].y;
 }
 
-//Meshes a OCCLUSION_SIZE * OCCLUSION_SIZE sized terrain cell. 
-//x and z are specified in terms of these cells, not absolute. 
-void MeshTerrainCell(int x, int z)
+//Returns how many levels of detail a cell can be meshed at. A level can't be used if one of its quads
+//would cover part of a hole, or the strip at the far edges that isn't meshed.
+static int GetTerrainCellLODs(int x, int z)
 {
-	MeshBuilder& mesh = TerrainMeshes[z * OCCLUSION_SIZE + x];
-	mesh.Destroy();
-	std::vector<SortableCell> sortcells(OCCLUSION_SIZE * OCCLUSION_SIZE);
-	//sortcells.reserve(OCCLUSION_SIZE * OCCLUSION_SIZE);
+	if (x == OCCLUSION_SIZE - 1 || z == OCCLUSION_SIZE - 1)
+		return 1;
+
+	int xstart = x * OCCLUSION_SIZE;
+	int zstart = z * OCCLUSION_SIZE;
+	for (int lod = 1; lod < MAX_TERRAIN_LOD; lod++)
+	{
+		int size = 1 << lod;
+		for (int bz = zstart; bz < zstart + OCCLUSION_SIZE; bz += size)
+		{
+			for (int bx = xstart; bx < xstart + OCCLUSION_SIZE; bx += size)
+			{
+				int invisible = Terrain_seg[bz * TERRAIN_WIDTH + bx].flags & TF_INVISIBLE;
+				for (int zcell = bz; zcell < bz + size; zcell++)
+				{
+					for (int xcell = bx; xcell < bx + size; xcell++)
+					{
+						if ((Terrain_seg[zcell * TERRAIN_WIDTH + xcell].flags & TF_INVISIBLE) != invisible)
+							return lod;
+					}
+				}
+			}
+		}
+	}
+
+	return MAX_TERRAIN_LOD;
+}
+
+//Raises error to how far the heights along an edge of size squares, starting at x,z and stepping
+//by dx,dz, are from the straight line a quad of that size puts there
+static void MaxTerrainEdgeError(float& error, int x, int z, int dx, int dz, int size)
+{
+	float y0 = GetYClamped(x, z);
+	float y1 = GetYClamped(x + dx * size, z + dz * size);
+
+	for (int i = 1; i < size; i++)
+	{
+		float diff = fabs(GetYClamped(x + dx * i, z + dz * i) - (y0 + (y1 - y0) * i / size));
+		if (diff > error)
+			error = diff;
+	}
+}
+
+//A neighbouring cell drawn at another level of detail can put the shared border anywhere within this
+//distance of where this cell puts it. Every level hangs a skirt this deep from the border to cover the crack.
+static float GetTerrainCellSkirtDepth(int x, int z)
+{
+	int xstart = x * OCCLUSION_SIZE; int xend = xstart + OCCLUSION_SIZE;
+	int zstart = z * OCCLUSION_SIZE; int zend = zstart + OCCLUSION_SIZE;
+	float depth = 0;
+
+	for (int lod = 1; lod < MAX_TERRAIN_LOD; lod++)
+	{
+		int size = 1 << lod;
+		for (int i = 0; i < OCCLUSION_SIZE; i += size)
+		{
+			//The borders at the far edges of the terrain have no neighbour
+			MaxTerrainEdgeError(depth, xstart + i, zstart, 1, 0, size);
+			MaxTerrainEdgeError(depth, xstart, zstart + i, 0, 1, size);
+			if (zend < TERRAIN_DEPTH - 1)
+				MaxTerrainEdgeError(depth, xstart + i, zend, 1, 0, size);
+			if (xend < TERRAIN_WIDTH - 1)
+				MaxTerrainEdgeError(depth, xend, zstart + i, 0, 1, size);
+		}
+	}
+
+	return depth;
+}
+
+//Adds the two triangles of a quad size squares across, with its upper left corner at x,z
+static void AddTerrainQuad(MeshBuilder& mesh, int x, int z, int size, terrain_segment& seg)
+{
+	//In theory I wouldn't need to have unique rend verts, but the rotation can cause different UVs
+	RendVertex verts[4] = {};
+
+	//Generate tl
+	GenerateVertex(verts[0], x, seg.y, z, x, z, seg, false);
+	//Generate tr
+	GenerateVertex(verts[1], x + size, GetYClamped(x + size, z), z, x, z, seg, true);
+	//Generate bl
+	GenerateVertex(verts[2], x + size, GetYClamped(x + size, z + size), z + size, x, z, seg, false);
+	//Generate br
+	GenerateVertex(verts[3], x, GetYClamped(x, z + size), z + size, x, z, seg, false);
+
+	//Generate indicies
+	int firstvert = mesh.NumVertices();
+	short indicies[6] = { firstvert + 0, firstvert + 3, firstvert + 1, firstvert + 1, firstvert + 3, firstvert + 2 };
+
+	//And add both
+	mesh.SetIndicies(6, indicies);
+	mesh.SetVertices(4, verts);
+}
+
+//Adds a strip hanging depth units down from the edge x0,z0 - x1,z1 of the quad at basex,basez
+static void AddTerrainSkirt(MeshBuilder& mesh, int x0, int z0, int x1, int z1, int basex, int basez, terrain_segment& seg, float depth)
+{
+	RendVertex verts[4] = {};
+
+	GenerateVertex(verts[0], x0, GetYClamped(x0, z0), z0, basex, basez, seg, false);
+	GenerateVertex(verts[1], x1, GetYClamped(x1, z1), z1, basex, basez, seg, false);
+	verts[2] = verts[1];
+	verts[2].position.y -= depth;
+	verts[3] = verts[0];
+	verts[3].position.y -= depth;
+
+	int firstvert = mesh.NumVertices();
+	short indicies[6] = { firstvert + 0, firstvert + 3, firstvert + 1, firstvert + 1, firstvert + 3, firstvert + 2 };
+
+	mesh.SetIndicies(6, indicies);
+	mesh.SetVertices(4, verts);
+}
 
-	//Gather all the cells for this region
+//Adds the batches for one level of detail of a cell
+static void MeshTerrainCellLOD(MeshBuilder& mesh, int x, int z, int lod, float skirt_depth)
+{
+	int size = 1 << lod;
+	std::vector<SortableCell> sortcells;
+	sortcells.reserve((OCCLUSION_SIZE / size) * (OCCLUSION_SIZE / size));
+
+	//Gather all the quads for this region. Above level 0 the squares of a quad always share a texture
+	//segment and lightmap, so the quad is textured the same as its squares.
 	int xstart = x * OCCLUSION_SIZE; int xend = xstart + OCCLUSION_SIZE;
 	int zstart = z * OCCLUSION_SIZE; int zend = zstart + OCCLUSION_SIZE;
-	int offset = 0;
-	for (int xcell = xstart; xcell < xend; xcell++)
+	for (int xcell = xstart; xcell < xend; xcell += size)
 	{
-		for (int zcell = zstart; zcell < zend; zcell++)
+		for (int zcell = zstart; zcell < zend; zcell += size)
 		{
-			SortableCell& cell = sortcells[offset];
+			SortableCell cell;
 			cell.x = xcell;
 			cell.z = zcell;
 			cell.texturehandle = Terrain_tex_seg[Terrain_seg[zcell * TERRAIN_WIDTH + xcell].texseg_index].tex_index;
 			cell.lmhandle = TerrainLightmaps[Terrain_seg[zcell * TERRAIN_WIDTH + xcell].lm_quad];
-			offset++;
+			sortcells.push_back(cell);
 		}
 	}
 
@@ -213,14 +345,14 @@ void MeshTerrainCell(int x, int z)
 	{
 		//Don't mesh the strip of terrain at cell 255 on either edge. 
 		//I don't know why they chose to do this and not have 257 vertices but
-		if (cell.z == (TERRAIN_WIDTH - 1) || cell.x == (TERRAIN_WIDTH - 1))
+		if (cell.z + size > (TERRAIN_WIDTH - 1) || cell.x + size > (TERRAIN_WIDTH - 1))
 			continue;
 
 		//I really appreciate the decision to make the terrain 256x256 quads but only store 256x256 vertices. 
 		int tl = cell.z * TERRAIN_WIDTH + cell.x;
 
 		ASSERT(tl < TERRAIN_WIDTH * TERRAIN_DEPTH); //This assert should never trip
-		terrain_segment& seg = Terrain_seg[cell.z * TERRAIN_WIDTH + cell.x];
+		terrain_segment& seg = Terrain_seg[tl];
 
 		//hole in the terrain?
 		if (seg.flags & TF_INVISIBLE)
@@ -233,27 +365,61 @@ void MeshTerrainCell(int x, int z)
 			lasttexhandle = cell.texturehandle;
 		}
 
-		//In theory I wouldn't need to have unique rend verts, but the rotation can cause different UVs
-		RendVertex verts[4] = {};
+		AddTerrainQuad(mesh, cell.x, cell.z, size, seg);
 
-		//Generate tl
-		GenerateVertex(verts[0], cell.x, seg.y, cell.z, cell.x, cell.z, seg, false);
-		//Generate tr
-		GenerateVertex(verts[1], cell.x + 1, GetYClamped(cell.x + 1, cell.z), cell.z, cell.x, cell.z, seg, true);
-		//Generate bl
-		GenerateVertex(verts[2], cell.x + 1, GetYClamped(cell.x + 1, cell.z + 1), cell.z + 1, cell.x, cell.z, seg, false);
-		//Generate br
-		GenerateVertex(verts[3], cell.x , GetYClamped(cell.x, cell.z + 1), cell.z + 1, cell.x, cell.z, seg, false);
-		
-		//Generate indicies
-		int firstvert = mesh.NumVertices();
-		short indicies[6] = { firstvert + 0, firstvert + 3, firstvert + 1, firstvert + 1, firstvert + 3, firstvert + 2 };
+		if (skirt_depth > 0)
+		{
+			if (cell.x == xstart)
+				AddTerrainSkirt(mesh, cell.x, cell.z, cell.x, cell.z + size, cell.x, cell.z, seg, skirt_depth);
+			if (cell.x + size == xend)
+				AddTerrainSkirt(mesh, cell.x + size, cell.z, cell.x + size, cell.z + size, cell.x, cell.z, seg, skirt_depth);
+			if (cell.z == zstart)
+				AddTerrainSkirt(mesh, cell.x, cell.z, cell.x + size, cell.z, cell.x, cell.z, seg, skirt_depth);
+			if (cell.z + size == zend)
+				AddTerrainSkirt(mesh, cell.x, cell.z + size, cell.x + size, cell.z + size, cell.x, cell.z, seg, skirt_depth);
+		}
+	}
+}
+
+//Meshes a OCCLUSION_SIZE * OCCLUSION_SIZE sized terrain cell. 
+//x and z are specified in terms of these cells, not absolute. 
+void MeshTerrainCell(int x, int z)
+{
+	MeshBuilder& mesh = TerrainMeshes[z * OCCLUSION_SIZE + x];
+	TerrainCellMesh& info = TerrainCellMeshes[z * OCCLUSION_SIZE + x];
+	mesh.Destroy();
+
+	info.num_lods = GetTerrainCellLODs(x, z);
+	info.skirt_depth = GetTerrainCellSkirtDepth(x, z);
+
+	for (int lod = 0; lod < info.num_lods; lod++)
+	{
+		info.first_batch[lod] = mesh.NumBatches();
+		MeshTerrainCellLOD(mesh, x, z, lod, info.skirt_depth);
+		info.num_batches[lod] = mesh.NumBatches() - info.first_batch[lod];
+	}
 
-		//And add both
-		mesh.SetIndicies(6, indicies);
-		mesh.SetVertices(4, verts);
+	//Bounds for culling, down to the bottom of the skirts
+	int xstart = x * OCCLUSION_SIZE; int xend = min(xstart + OCCLUSION_SIZE, TERRAIN_WIDTH - 1);
+	int zstart = z * OCCLUSION_SIZE; int zend = min(zstart + OCCLUSION_SIZE, TERRAIN_DEPTH - 1);
+	float miny = MAX_TERRAIN_HEIGHT, maxy = 0;
+	for (int zcell = zstart; zcell <= zend; zcell++)
+	{
+		for (int xcell = xstart; xcell <= xend; xcell++)
+		{
+			float y = Terrain_seg[zcell * TERRAIN_WIDTH + xcell].y;
+			miny = min(miny, y);
+			maxy = max(maxy, y);
+		}
 	}
 
+	info.min_xyz.x = xstart * TERRAIN_SIZE;
+	info.min_xyz.y = miny - info.skirt_depth;
+	info.min_xyz.z = zstart * TERRAIN_SIZE;
+	info.max_xyz.x = xend * TERRAIN_SIZE;
+	info.max_xyz.y = maxy;
+	info.max_xyz.z = zend * TERRAIN_SIZE;
+
 	//All vertices are created, so finalize the mesh.
 	mesh.Build();
 }
@@ -270,6 +436,110 @@ void MeshTerrain()
 	}
 }
 
+void RemeshTerrainArea(int x1, int z1, int x2, int z2)
+{
+	//Heights and normals at the edge of the area are shared with the squares around it
+	x1 = max(0, x1 - 1) / OCCLUSION_SIZE;
+	z1 = max(0, z1 - 1) / OCCLUSION_SIZE;
+	x2 = min(TERRAIN_WIDTH - 1, x2 + 1) / OCCLUSION_SIZE;
+	z2 = min(TERRAIN_DEPTH - 1, z2 + 1) / OCCLUSION_SIZE;
+
+	for (int x = x1; x <= x2; x++)
+	{
+		for (int z = z1; z <= z2; z++)
+		{
+			MeshTerrainCell(x, z);
+		}
+	}
+}
+
+//Returns the largest LOD delta of the blocks in a cell at a level of detail
+static float GetTerrainCellDelta(int x, int z, int lod)
+{
+	int size = 1 << lod;
+	int rowsize = TERRAIN_WIDTH / size;
+	float* deltas = TerrainDeltaBlocks[(MAX_TERRAIN_LOD - 1) - lod];
+	float maxdelta = 0;
+
+	for (int bz = z * OCCLUSION_SIZE; bz < (z + 1) * OCCLUSION_SIZE; bz += size)
+	{
+		for (int bx = x * OCCLUSION_SIZE; bx < (x + 1) * OCCLUSION_SIZE; bx += size)
+		{
+			float delta = deltas[(bz / size) * rowsize + (bx / size)];
+			//Invisible blocks aren't meshed at all
+			if (delta != SHUTOFF_LOD_INVISIBLE && delta > maxdelta)
+				maxdelta = delta;
+		}
+	}
+
+	return maxdelta;
+}
+
+//Picks the coarsest level of detail for a cell that the LOD engine would simplify to.  SimplifyVertex
+//weighs a block's error by its flat distance from the eye, which is zero right under it.  The flat
+//distance is never more than the full distance, so using the full distance to the closest point of
+//the cell instead keeps the test conservative for every block in the cell.
+static int PickTerrainCellLOD(int x, int z, vector* eye)
+{
+	TerrainCellMesh& info = TerrainCellMeshes[z * OCCLUSION_SIZE + x];
+
+#if (defined(EDITOR) || defined(NEWEDITOR))
+	if (View_mode == EDITOR_MODE && Editor_LOD_engine_off)
+		return 0;
+#endif
+
+	if (View_mode != EDITOR_MODE && Terrain_LOD_engine_off)
+		return 0;
+
+	vector closest;
+	closest.x = max(info.min_xyz.x, min(eye->x, info.max_xyz.x));
+	closest.y = max(info.min_xyz.y, min(eye->y, info.max_xyz.y));
+	closest.z = max(info.min_xyz.z, min(eye->z, info.max_xyz.z));
+
+	vector diff = *eye - closest;
+	float dist_squared = diff * diff;
+
+	for (int lod = info.num_lods - 1; lod > 0; lod--)
+	{
+		float delta = GetTerrainCellDelta(x, z, lod);
+		if (delta * delta <= TS_SimplifyCondition * dist_squared)
+			return lod;
+	}
+
+	return 0;
+}
+
+//Returns true if the cell could be seen from the occlusion cell src_occlusion_index (-1 if the
+//occlusion data isn't used) and its bounds are in the view cone.
+static bool TerrainCellMeshVisible(int cell, int src_occlusion_index)
+{
+	TerrainCellMesh& info = TerrainCellMeshes[cell];
+
+	if (src_occlusion_index != -1)
+	{
+		int occ_byte = cell / 8;
+		int occ_bit = cell % 8;
+
+		if (!(Terrain_occlusion_map[src_occlusion_index][occ_byte] & (1 << occ_bit)))
+			return false;
+	}
+
+	vector corners[8];
+	MakePointsFromMinMax(corners, &info.min_xyz, &info.max_xyz);
+
+	g3Point pnt;
+	ubyte andbyte = 0xff;
+	for (int t = 0; t < 8; t++)
+	{
+		ubyte ccode = g3_RotatePoint(&pnt, &corners[t]);
+		if (!ccode)
+			return true;
+		andbyte &= ccode;
+	}
+
+	return andbyte == 0;
+}
+
 void InitTerrainRenderSpeedups()
 {
 	// Figure out a table of values for rotated uv points
@@ -362,9 +632,6 @@ float GetTerrainDynamicScalar(vector* pos, int seg)
 	return scalar;
 }
 
-// Takes a min,max vector and makes a surrounding cube from it
-void MakePointsFromMinMax(vector* corners, vector* minp, vector* maxp);
-
 struct obj_sort_item
 {
 	int	objnum;
@@ -890,9 +1157,28 @@ void RenderTerrain(ubyte from_mine, int left, int top, int right, int bot)
 	rend_SetAlphaType(ATF_CONSTANT + ATF_TEXTURE);
 	rend_SetLighting(LS_NONE);
 	rend_SetWrapType(WT_WRAP); //Should this be clamp? Requires smarter logic for the UV calculations to handle discontinuities. 
-	for (MeshBuilder& mesh : TerrainMeshes)
+
+	//Cells behind the viewer, past the far plane or hidden by the occlusion data aren't drawn
+	int src_occlusion_index = -1;
+	if ((Terrain_checksum + 1) == Terrain_occlusion_checksum && !Terrain_from_mine)
 	{
-		mesh.Draw();
+		int oz = (Viewer_object->pos.z / TERRAIN_SIZE) / OCCLUSION_SIZE;
+		int ox = (Viewer_object->pos.x / TERRAIN_SIZE) / OCCLUSION_SIZE;
+		if (oz >= 0 && oz < OCCLUSION_SIZE && ox >= 0 && ox < OCCLUSION_SIZE)
+			src_occlusion_index = oz * OCCLUSION_SIZE + ox;
+	}
+
+	for (int z = 0; z < OCCLUSION_SIZE; z++)
+	{
+		for (int x = 0; x < OCCLUSION_SIZE; x++)
+		{
+			int cell = z * OCCLUSION_SIZE + x;
+			if (!TerrainCellMeshVisible(cell, src_occlusion_index))
+				continue;
+
+			int lod = PickTerrainCellLOD(x, z, &viewer_eye);
+			TerrainMeshes[cell].DrawBatches(TerrainCellMeshes[cell].first_batch[lod], TerrainCellMeshes[cell].num_batches[lod]);
+		}
 	}
 
 	rend_EndShaderTest();
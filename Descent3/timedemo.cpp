@@ -0,0 +1,210 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <string.h>
+#include <algorithm>
+#include <vector>
+
+#include "timedemo.h"
+#include "descent.h"
+#include "object.h"
+#include "demofile.h"
+#include "args.h"
+#include "CFILE.H"
+#include "mono.h"
+#include "renderer.h"
+
+bool Timedemo_on = false;
+double Timedemo_subsystem_time[TDS_NUM_SUBSYSTEMS];
+
+static char Timedemo_demo[_MAX_PATH * 2];
+static char Timedemo_report[_MAX_PATH * 2];
+
+static const char *Timedemo_subsystem_names[TDS_NUM_SUBSYSTEMS] = { "objects", "physics", "ai", "render", "sound" };
+
+// When the last frame ended, or -1 before the first frame of the demo
+static double Timedemo_last_frame_end = -1;
+
+// Milliseconds per frame, and per subsystem per frame
+static std::vector<float> Timedemo_frame_ms;
+static std::vector<float> Timedemo_subsystem_ms[TDS_NUM_SUBSYSTEMS];
+
+// The GL calls of each frame, when the null renderer is counting them
+#define TD_NUM_CALL_COUNTS	4
+static const char *Timedemo_call_names[TD_NUM_CALL_COUNTS] = { "draw_calls", "state_changes", "texture_uploads", "upload_bytes" };
+static std::vector<float> Timedemo_call_counts[TD_NUM_CALL_COUNTS];
+static bool Timedemo_have_calls = false;
+
+bool TimedemoInit()
+{
+	int arg = FindArg("-timedemo");
+	if (!arg)
+		return false;
+
+	Timedemo_on = true;
+	strncpy(Timedemo_demo, GameArgs[arg + 1], sizeof(Timedemo_demo) - 1);
+
+	arg = FindArg("-timedemoreport");
+	if (arg)
+		strncpy(Timedemo_report, GameArgs[arg + 1], sizeof(Timedemo_report) - 1);
+
+	return true;
+}
+
+const char *TimedemoFile()
+{
+	return Timedemo_demo;
+}
+
+void TimedemoEndFrame()
+{
+	if (!Timedemo_on)
+		return;
+
+	double now = timer_GetTime64();
+
+	// The first frame holds the level load, and the frames outside the demo don't count
+	if (Demo_flags == DF_PLAYBACK && Timedemo_last_frame_end >= 0)
+	{
+		Timedemo_frame_ms.push_back((now - Timedemo_last_frame_end) * 1000.0);
+		for (int i = 0; i < TDS_NUM_SUBSYSTEMS; i++)
+			Timedemo_subsystem_ms[i].push_back(Timedemo_subsystem_time[i] * 1000.0);
+
+		tRendererCallStats calls;
+		Timedemo_have_calls = rend_GetCallStatistics(&calls);
+		if (Timedemo_have_calls)
+		{
+			Timedemo_call_counts[0].push_back(calls.draw_calls);
+			Timedemo_call_counts[1].push_back(calls.state_changes);
+			Timedemo_call_counts[2].push_back(calls.texture_uploads);
+			Timedemo_call_counts[3].push_back(calls.upload_bytes);
+		}
+	}
+
+	Timedemo_last_frame_end = (Demo_flags == DF_PLAYBACK) ? now : -1;
+	for (int i = 0; i < TDS_NUM_SUBSYSTEMS; i++)
+		Timedemo_subsystem_time[i] = 0;
+}
+
+// Writes "name":{"mean":..,"p50":..,"p90":..,"p99":..,"max":..} for a set of samples
+static void WriteTimedemoStats(CFILE *cfp, const char *name, const std::vector<float> &samples, bool last)
+{
+	std::vector<float> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+
+	double total = 0;
+	for (float ms : sorted)
+		total += ms;
+
+	int n = sorted.size();
+	cfprintf(cfp, "\t\t\"%s\": {\"mean\": %.4f, \"p50\": %.4f, \"p90\": %.4f, \"p99\": %.4f, \"max\": %.4f}%s\n",
+		name, total / n, sorted[(n - 1) / 2], sorted[(int)((n - 1) * 0.9f)], sorted[(int)((n - 1) * 0.99f)], sorted[n - 1],
+		last ? "" : ",");
+}
+
+void TimedemoWriteReport()
+{
+	if (!Timedemo_on)
+		return;
+
+	int n = Timedemo_frame_ms.size();
+	if (n == 0)
+	{
+		mprintf((0, "Timedemo: no frames were played back from %s\n", Timedemo_demo));
+		return;
+	}
+
+	char path[_MAX_PATH * 2];
+	if (Timedemo_report[0])
+		strcpy(path, Timedemo_report);
+	else
+		ddio_MakePath(path, User_directory, "timedemo.json", NULL);
+
+	CFILE *cfp = cfopen(path, "wt");
+	if (!cfp)
+	{
+		mprintf((0, "Timedemo: couldn't write the report to %s\n", path));
+		return;
+	}
+
+	double total = 0;
+	for (float ms : Timedemo_frame_ms)
+		total += ms;
+
+	char demo[_MAX_PATH * 2];
+	int len = 0;
+	for (const char *c = Timedemo_demo; *c && len < (int)sizeof(demo) - 2; c++)
+	{
+		// Escape the path for JSON
+		if (*c == '\\' || *c == '"')
+			demo[len++] = '\\';
+		demo[len++] = *c;
+	}
+	demo[len] = 0;
+
+	cfprintf(cfp, "{\n");
+	cfprintf(cfp, "\t\"demo\": \"%s\",\n", demo);
+	cfprintf(cfp, "\t\"frames\": %d,\n", n);
+	cfprintf(cfp, "\t\"seconds\": %.4f,\n", total / 1000.0);
+	cfprintf(cfp, "\t\"fps\": %.2f,\n", n / (total / 1000.0));
+
+	cfprintf(cfp, "\t\"ms\": {\n");
+	WriteTimedemoStats(cfp, "frame", Timedemo_frame_ms, false);
+	for (int i = 0; i < TDS_NUM_SUBSYSTEMS; i++)
+		WriteTimedemoStats(cfp, Timedemo_subsystem_names[i], Timedemo_subsystem_ms[i], i == TDS_NUM_SUBSYSTEMS - 1);
+	cfprintf(cfp, "\t},\n");
+
+	if (Timedemo_have_calls)
+	{
+		cfprintf(cfp, "\t\"calls\": {\n");
+		for (int i = 0; i < TD_NUM_CALL_COUNTS; i++)
+			WriteTimedemoStats(cfp, Timedemo_call_names[i], Timedemo_call_counts[i], i == TD_NUM_CALL_COUNTS - 1);
+		cfprintf(cfp, "\t},\n");
+	}
+
+	// One row per frame, in the order of columns
+	cfprintf(cfp, "\t\"columns\": [\"frame\"");
+	for (int i = 0; i < TDS_NUM_SUBSYSTEMS; i++)
+		cfprintf(cfp, ", \"%s\"", Timedemo_subsystem_names[i]);
+	if (Timedemo_have_calls)
+	{
+		for (int i = 0; i < TD_NUM_CALL_COUNTS; i++)
+			cfprintf(cfp, ", \"%s\"", Timedemo_call_names[i]);
+	}
+	cfprintf(cfp, "],\n");
+
+	cfprintf(cfp, "\t\"per_frame\": [\n");
+	for (int f = 0; f < n; f++)
+	{
+		cfprintf(cfp, "\t\t[%.4f", Timedemo_frame_ms[f]);
+		for (int i = 0; i < TDS_NUM_SUBSYSTEMS; i++)
+			cfprintf(cfp, ", %.4f", Timedemo_subsystem_ms[i][f]);
+		if (Timedemo_have_calls)
+		{
+			for (int i = 0; i < TD_NUM_CALL_COUNTS; i++)
+				cfprintf(cfp, ", %d", (int)Timedemo_call_counts[i][f]);
+		}
+		cfprintf(cfp, "]%s\n", (f == n - 1) ? "" : ",");
+	}
+	cfprintf(cfp, "\t]\n");
+	cfprintf(cfp, "}\n");
+
+	cfclose(cfp);
+
+	mprintf((0, "Timedemo: %d frames in %.2f seconds (%.2f fps), report written to %s\n", n, total / 1000.0, n / (total / 1000.0), path));
+}
@@ -0,0 +1,62 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TIMEDEMO_H
+#define TIMEDEMO_H
+
+#include "ddio.h"
+
+// Timedemo: -timedemo <file.dem> plays a demo back through the game gauge path as fast as it will
+// go, with no vsync and no frame cap, and quits when it ends.  Each frame steps the simulation by
+// the frame time recorded in the demo, so every run does the same work.  How long each frame took,
+// and how much of it went to each subsystem, is written to timedemo.json in the user directory
+// (or the file given with -timedemoreport <file>).  With -nullrenderer the report also holds the
+// GL calls each frame would have made.
+
+// The subsystems a frame is split into.  Objects is all of ObjDoFrameAll, so it also holds the
+// physics and the per object AI time.
+enum
+{
+	TDS_OBJECTS,
+	TDS_PHYSICS,
+	TDS_AI,
+	TDS_RENDER,
+	TDS_SOUND,
+	TDS_NUM_SUBSYSTEMS
+};
+
+extern bool Timedemo_on;
+extern double Timedemo_subsystem_time[TDS_NUM_SUBSYSTEMS];
+
+// Marks the start of a subsystem's work, for TIMEDEMO_END
+#define TIMEDEMO_START(var) double var = Timedemo_on ? timer_GetTime64() : 0
+// Adds the time since TIMEDEMO_START to a subsystem's total for this frame
+#define TIMEDEMO_END(subsystem,var) do { if (Timedemo_on) Timedemo_subsystem_time[subsystem] += timer_GetTime64() - (var); } while (0)
+
+// Reads -timedemo and -timedemoreport.  Returns true if a timedemo is to be run
+bool TimedemoInit();
+
+// Returns the demo file to play back
+const char *TimedemoFile();
+
+// Called at the end of every game frame.  Records the frame if a demo is playing back
+void TimedemoEndFrame();
+
+// Writes the report of the frames recorded
+void TimedemoWriteReport();
+
+#endif
@@ -34,6 +34,7 @@
 
 vclip GameVClips[MAX_VCLIPS];
 int Num_vclips = 0;
+tNameIndex<MAX_VCLIPS> VClip_names(GameVClips[0].name, sizeof(vclip));
 
 #define DEFAULT_FRAMETIME	.07f
 
@@ -59,6 +60,7 @@ void InitVClips()
 {
 	for (int i = 0; i < MAX_VCLIPS; i++)
 		GameVClips[i].used = 0;
+	VClip_names.clear();
 
 	atexit(FreeAllVClips);
 }
@@ -74,6 +76,7 @@ int AllocVClip()
 		if (GameVClips[i].used == 0)
 		{
 			memset(&GameVClips[i], 0, sizeof(vclip));
+			VClip_names.update(i);
 			GameVClips[i].frames = (short*)mem_malloc(VCLIP_MAX_FRAMES * sizeof(short));
 			GameVClips[i].allocated_frames = VCLIP_MAX_FRAMES;
 			ASSERT(GameVClips[i].frames);
@@ -105,6 +108,9 @@ void FreeVClip(int num)
 
 	mem_free(GameVClips[num].frames);
 
+	GameVClips[num].name[0] = 0;
+	VClip_names.update(num);
+
 	Num_vclips--;
 	ASSERT(Num_vclips >= 0);
 }
@@ -357,6 +363,7 @@ int AllocLoadVClip(char* filename, int texture_size, int mipped, int pageable, i
 
 	ASSERT(vcnum >= 0);
 	strncpy(GameVClips[vcnum].name, name, PAGENAME_LEN);
+	VClip_names.update(vcnum);
 
 	if (mipped)
 		GameVClips[vcnum].flags |= VCF_WANTS_MIPPED;
@@ -552,6 +559,7 @@ int AllocLoadIFLVClip(char* filename, int texture_size, int mipped, int format)
 	}
 
 	strcpy(vc->name, name);
+	VClip_names.update(vcnum);
 	return vcnum;
 }
 
@@ -575,13 +583,7 @@ void ChangeVClipName(char* src, char* dest)
 // or index of vclip with name
 int FindVClipName(char* name)
 {
-	int i;
-
-	for (i = 0; i < MAX_VCLIPS; i++)
-		if (GameVClips[i].used && !stricmp(GameVClips[i].name, name))
-			return i;
-
-	return -1;
+	return VClip_names.find(name);
 }
 
 // Returns frame "frame" of vclip "vclip".  Will mod the frame so that there
@@ -23,6 +23,7 @@
 #include "pstypes.h"
 #include "fix.h"
 #include "manage.h"
+#include "nameindex.h"
 
 
 #define MAX_VCLIPS		200
@@ -44,6 +45,7 @@ struct vclip
 };
 
 extern vclip GameVClips[MAX_VCLIPS];
+extern tNameIndex<MAX_VCLIPS> VClip_names;	// call VClip_names.update(n) after changing GameVClips[n].name
 extern int Num_vclips;
 
 // Simply sets all vclips to unused
@@ -48,6 +48,7 @@
 
 weapon Weapons[MAX_WEAPONS];
 int Num_weapons = 0;
+tNameIndex<MAX_WEAPONS> Weapon_names(Weapons[0].name, sizeof(weapon));
 
 const char* Static_weapon_names[] =
 {
@@ -141,6 +142,7 @@ void InitWeapons()
 		Weapons[i].used = 0;
 		Weapons[i].name[0] = 0;
 	}
+	Weapon_names.clear();
 	Num_weapons = 0;
 }
 
@@ -152,6 +154,7 @@ int AllocWeapon()
 		if (Weapons[i].used == 0)
 		{
 			memset(&Weapons[i], 0, sizeof(weapon));
+			Weapon_names.update(i);
 			for (int t = 0; t < MAX_WEAPON_SOUNDS; t++)
 				Weapons[i].sounds[t] = SOUND_NONE_INDEX;
 			Weapons[i].alpha = 1.0;
@@ -189,6 +192,7 @@ void FreeWeapon(int n)
 
 	Weapons[n].used = 0;
 	Weapons[n].name[0] = 0;
+	Weapon_names.update(n);
 	Num_weapons--;
 }
 
@@ -243,15 +247,9 @@ int GetPrevWeapon(int n)
 // or index of weapon with name
 int FindWeaponName(char* name)
 {
-	int i;
-
 	ASSERT(name != NULL);
 
-	for (i = 0; i < MAX_WEAPONS; i++)
-		if (Weapons[i].used && !stricmp(name, Weapons[i].name))
-			return i;
-
-	return -1;
+	return Weapon_names.find(name);
 }
 
 // Given a weapon handle, returns that weapons bitmap
@@ -388,10 +386,14 @@ int MatchWeaponToIndex(char* name, int dest_index)
 
 		new_index = AllocWeapon();
 		if (new_index >= 0) 	//DAJ -1FIX
+		{
 			memcpy(&Weapons[new_index], &Weapons[dest_index], sizeof(weapon));
+			Weapon_names.update(new_index);
+		}
 
 		// Now copy our new info over and free the old one
 		memcpy(&Weapons[dest_index], &Weapons[cur_index], sizeof(weapon));
+		Weapon_names.update(dest_index);
 		FreeWeapon(cur_index);
 	}
 	else
@@ -402,6 +404,7 @@ int MatchWeaponToIndex(char* name, int dest_index)
 		Num_weapons++;
 
 		memcpy(&Weapons[dest_index], &Weapons[cur_index], sizeof(weapon));
+		Weapon_names.update(dest_index);
 		FreeWeapon(cur_index);
 		return 0;
 	}
@@ -418,6 +421,7 @@ int MoveWeaponFromIndex(int index)
 
 	int new_index = AllocWeapon();
 	memcpy(&Weapons[new_index], &Weapons[index], sizeof(weapon));
+	Weapon_names.update(new_index);
 	FreeWeapon(index);
 
 	return new_index;
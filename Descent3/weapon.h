@@ -24,6 +24,7 @@
 #include "object.h"
 #include "objinfo.h"
 #include "weapon_external.h"
+#include "nameindex.h"
 
 #define MAX_PRIMARY_WEAPONS	10
 #define MAX_SECONDARY_WEAPONS	10
@@ -152,6 +153,7 @@ extern float Primary_ramp_time,Secondary_ramp_time;
 
 extern int Num_weapons;
 extern weapon Weapons[MAX_WEAPONS];
+extern tNameIndex<MAX_WEAPONS> Weapon_names;	// call Weapon_names.update(n) after changing Weapons[n].name
 extern const char *Static_weapon_names[];
 extern int Static_weapon_names_msg[];
 extern int Static_weapon_ckpt_names[][2];
@@ -240,11 +242,16 @@ void FireFlareFromPlayer(object *objp);
 // Does per frame weapon code
 void WeaponDoFrame(object *obj);
 
+// Does the parts of WeaponDoFrame() that only change the weapon itself, so its move can be worked
+// out on a copy ahead of the object pass.  Returns false if this frame would do more than that.
+bool WeaponStageFrame(object *obj);
+
 // Returns the position and the normal of a gun point
 bool WeaponCalcGun(vector *gun_point, vector *gun_normal, object *obj, int gun_num);
 
 // Checks for relation between weapons and other objects
 bool ObjectsAreRelated( int o1, int o2 );
+bool ObjectsAreRelated( const object *obj1, const object *obj2 );
 
 // A quick way to see where a weapon hits.  Weapons make debris.
 void CreateWeaponDebris(object *obj);
@@ -31,6 +31,7 @@
 #include "bumpmap.h"
 #include "mem.h"
 #include "psrand.h"
+#include "pixelops.h"
 
 #include "Macros.h"
 
@@ -1064,97 +1065,16 @@ ushort* bm_data(int handle, int miplevel)
 // Given a source bitmap, generates mipmaps for it
 void bm_GenerateMipMaps(int handle)
 {
-	int width = bm_w(handle, 0);
-	int height = bm_h(handle, 0);
-	int jump = 2;	// how many pixels to jump in x and y on source
-
 	//mprintf ((0,"We got a mipper! %d \n",handle));
 
 	ASSERT(GameBitmaps[handle].used);
 	GameBitmaps[handle].flags |= BF_MIPMAPPED;
 
 	int levels = bm_miplevels(handle);
+	ushort* data = bm_data(handle, 0);
 
-	ushort* destdata;
-	for (int miplevel = 1; miplevel < levels; miplevel++)
-	{
-		width /= 2; height /= 2;
-
-		for (int i = 0; i < height; i++)
-		{
-			int adjheight = (i * jump) * bm_w(handle, miplevel - 1); // find our y offset
-
-			for (int t = 0; t < width; t++)
-			{
-				int adjwidth = (t * jump);		// find our x offset
-				ushort* srcptr = bm_data(handle, miplevel - 1);
-				srcptr += (adjheight + adjwidth);
-
-				int rsum, gsum, bsum, asum;
-				rsum = gsum = bsum = asum = 0;
-				ushort destpix;
-				if (GameBitmaps[handle].format == BITMAP_FORMAT_1555)
-				{
-					for (int y = 0; y < 2; y++)
-						for (int x = 0; x < 2; x++)
-						{
-							ushort pix = srcptr[y * bm_w(handle, miplevel - 1) + x];
-							int r = (pix >> 10) & 0x1f;
-							int g = (pix >> 5) & 0x1f;
-							int b = (pix & 0x1f);
-
-							if (!(pix & OPAQUE_FLAG))
-								asum++;
-							else
-							{
-								rsum += r;
-								gsum += g;
-								bsum += b;
-							}
-						}
-					// Average our source pixels
-					rsum /= 4;
-					gsum /= 4;
-					bsum /= 4;
-					destpix = OPAQUE_FLAG | (rsum << 10) | (gsum << 5) | bsum;
-
-					if (asum > 2)
-						destpix = NEW_TRANSPARENT_COLOR;
-				}
-				else if (GameBitmaps[handle].format == BITMAP_FORMAT_4444)
-				{
-					for (int y = 0; y < 2; y++)
-						for (int x = 0; x < 2; x++)
-						{
-							ushort pix = srcptr[y * bm_w(handle, miplevel - 1) + x];
-							int a = (pix >> 12) & 0x0f;
-							int r = (pix >> 8) & 0x0f;
-							int g = (pix >> 4) & 0x0f;
-							int b = (pix & 0x0f);
-
-							asum += a;
-							rsum += r;
-							gsum += g;
-							bsum += b;
-
-						}
-					// Average our source pixels
-					rsum /= 4;
-					gsum /= 4;
-					bsum /= 4;
-					asum /= 4;
-					destpix = (asum << 12) | (rsum << 8) | (gsum << 4) | bsum;
-				}
-				else
-				{
-					Int3();
-				}
-				destdata = bm_data(handle, miplevel);
-				int sw = bm_w(handle, miplevel);
-				destdata[(i * sw) + t] = destpix;
-			}
-		}
-	}
+	// Each level is a 2x2 box filter of the one above it
+	bm_BuildMipChain(data, GameBitmaps[handle].width, GameBitmaps[handle].height, levels, GameBitmaps[handle].format);
 }
 
 // Gets bits per pixel for a particular bitmap
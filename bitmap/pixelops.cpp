@@ -0,0 +1,310 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pixelops.h"
+#include "grdefs.h"
+#include "bitmap.h"
+#include "cpufeatures.h"
+
+static inline ushort Convert565To1555(ushort pixel)
+{
+	if (pixel == 0x07e0)
+		return NEW_TRANSPARENT_COLOR;
+
+	// Red and the top 5 bits of green both move down one bit, blue stays put
+	return OPAQUE_FLAG | ((pixel >> 1) & 0x7fe0) | (pixel & 0x001f);
+}
+
+// Averages the 2x2 block of 1555 pixels at column x*2 of two rows
+static inline ushort BoxFilterPixel1555(const ushort *row0, const ushort *row1, int x)
+{
+	ushort pix[4] = {row0[x * 2], row0[x * 2 + 1], row1[x * 2], row1[x * 2 + 1]};
+	int rsum = 0, gsum = 0, bsum = 0, asum = 0;
+
+	for (int i = 0; i < 4; i++)
+	{
+		if (!(pix[i] & OPAQUE_FLAG))
+			asum++;
+		else
+		{
+			rsum += (pix[i] >> 10) & 0x1f;
+			gsum += (pix[i] >> 5) & 0x1f;
+			bsum += pix[i] & 0x1f;
+		}
+	}
+
+	if (asum > 2)
+		return NEW_TRANSPARENT_COLOR;
+
+	return OPAQUE_FLAG | ((rsum / 4) << 10) | ((gsum / 4) << 5) | (bsum / 4);
+}
+
+// Averages the 2x2 block of 4444 pixels at column x*2 of two rows
+static inline ushort BoxFilterPixel4444(const ushort *row0, const ushort *row1, int x)
+{
+	ushort pix[4] = {row0[x * 2], row0[x * 2 + 1], row1[x * 2], row1[x * 2 + 1]};
+	ushort destpix = 0;
+
+	for (int shift = 0; shift < 16; shift += 4)
+	{
+		int sum = 0;
+		for (int i = 0; i < 4; i++)
+			sum += (pix[i] >> shift) & 0x0f;
+		destpix |= (sum / 4) << shift;
+	}
+
+	return destpix;
+}
+
+#ifdef CPU_SIMD
+
+CPU_TARGET("sse2") static void FillPixels16SSE2(ushort *dest, ushort pixel, int count)
+{
+	__m128i value = _mm_set1_epi16((short)pixel);
+	int i;
+
+	for (i = 0; i + 8 <= count; i += 8)
+		_mm_storeu_si128((__m128i *)(dest + i), value);
+
+	for (; i < count; i++)
+		dest[i] = pixel;
+}
+
+CPU_TARGET("sse2") static void Convert565To1555SSE2(ushort *data, int count)
+{
+	const __m128i key = _mm_set1_epi16(0x07e0);
+	const __m128i rg_mask = _mm_set1_epi16(0x7fe0);
+	const __m128i b_mask = _mm_set1_epi16(0x001f);
+	const __m128i opaque = _mm_set1_epi16((short)OPAQUE_FLAG);
+	const __m128i transparent = _mm_set1_epi16(NEW_TRANSPARENT_COLOR);
+	int i;
+
+	for (i = 0; i + 8 <= count; i += 8)
+	{
+		__m128i pixels = _mm_loadu_si128((const __m128i *)(data + i));
+		__m128i converted = _mm_or_si128(opaque, _mm_or_si128(_mm_and_si128(_mm_srli_epi16(pixels, 1), rg_mask), _mm_and_si128(pixels, b_mask)));
+		__m128i is_key = _mm_cmpeq_epi16(pixels, key);
+
+		converted = _mm_or_si128(_mm_andnot_si128(is_key, converted), _mm_and_si128(is_key, transparent));
+		_mm_storeu_si128((__m128i *)(data + i), converted);
+	}
+
+	for (; i < count; i++)
+		data[i] = Convert565To1555(data[i]);
+}
+
+// Adds up each horizontal pair of 16 bit fields, across two rows, into 32 bit sums
+CPU_TARGET("sse2") static inline __m128i SumPairs(__m128i row0, __m128i row1)
+{
+	const __m128i ones = _mm_set1_epi16(1);
+
+	return _mm_add_epi32(_mm_madd_epi16(row0, ones), _mm_madd_epi16(row1, ones));
+}
+
+// Sums one field of 8 source pixels from each of two rows down to 4 results
+CPU_TARGET("sse2") static inline __m128i SumField(__m128i row0, __m128i row1, int shift, int mask)
+{
+	const __m128i m = _mm_set1_epi16((short)mask);
+
+	const __m128i count = _mm_cvtsi32_si128(shift);
+
+	return SumPairs(_mm_and_si128(_mm_srl_epi16(row0, count), m), _mm_and_si128(_mm_srl_epi16(row1, count), m));
+}
+
+// Sums one field of 8 source pixels from each of two rows, leaving out transparent pixels
+CPU_TARGET("sse2") static inline __m128i SumOpaqueField(__m128i row0, __m128i row1, __m128i opaque0, __m128i opaque1, int shift)
+{
+	const __m128i m = _mm_set1_epi16(0x1f);
+	const __m128i count = _mm_cvtsi32_si128(shift);
+
+	return SumPairs(_mm_and_si128(_mm_and_si128(_mm_srl_epi16(row0, count), m), opaque0), _mm_and_si128(_mm_and_si128(_mm_srl_epi16(row1, count), m), opaque1));
+}
+
+// Packs two sets of 4 sums (all small and positive) into 8 16 bit lanes
+CPU_TARGET("sse2") static inline __m128i PackSums(__m128i lo, __m128i hi)
+{
+	return _mm_packs_epi32(lo, hi);
+}
+
+CPU_TARGET("sse2") static void BoxFilter1555SSE2(const ushort *src, int src_w, ushort *dest, int w, int h)
+{
+	for (int y = 0; y < h; y++)
+	{
+		const ushort *row0 = src + (y * 2) * src_w;
+		const ushort *row1 = row0 + src_w;
+		ushort *out = dest + y * w;
+		int x;
+
+		for (x = 0; x + 8 <= w; x += 8)
+		{
+			__m128i sum[4][2];	// r, g, b and transparent count for each half
+
+			for (int half = 0; half < 2; half++)
+			{
+				__m128i a = _mm_loadu_si128((const __m128i *)(row0 + x * 2 + half * 8));
+				__m128i b = _mm_loadu_si128((const __m128i *)(row1 + x * 2 + half * 8));
+
+				// All ones where a pixel is opaque
+				__m128i opaque_a = _mm_srai_epi16(a, 15);
+				__m128i opaque_b = _mm_srai_epi16(b, 15);
+
+				sum[0][half] = SumOpaqueField(a, b, opaque_a, opaque_b, 10);
+				sum[1][half] = SumOpaqueField(a, b, opaque_a, opaque_b, 5);
+				sum[2][half] = SumOpaqueField(a, b, opaque_a, opaque_b, 0);
+				sum[3][half] = SumPairs(_mm_andnot_si128(opaque_a, _mm_set1_epi16(1)), _mm_andnot_si128(opaque_b, _mm_set1_epi16(1)));
+			}
+
+			__m128i r = _mm_srli_epi16(PackSums(sum[0][0], sum[0][1]), 2);
+			__m128i g = _mm_srli_epi16(PackSums(sum[1][0], sum[1][1]), 2);
+			__m128i b = _mm_srli_epi16(PackSums(sum[2][0], sum[2][1]), 2);
+			__m128i transparent = _mm_cmpgt_epi16(PackSums(sum[3][0], sum[3][1]), _mm_set1_epi16(2));
+
+			__m128i pixels = _mm_or_si128(_mm_set1_epi16((short)OPAQUE_FLAG), _mm_or_si128(_mm_slli_epi16(r, 10), _mm_or_si128(_mm_slli_epi16(g, 5), b)));
+			pixels = _mm_or_si128(_mm_andnot_si128(transparent, pixels), _mm_and_si128(transparent, _mm_set1_epi16(NEW_TRANSPARENT_COLOR)));
+
+			_mm_storeu_si128((__m128i *)(out + x), pixels);
+		}
+
+		for (; x < w; x++)
+			out[x] = BoxFilterPixel1555(row0, row1, x);
+	}
+}
+
+CPU_TARGET("sse2") static void BoxFilter4444SSE2(const ushort *src, int src_w, ushort *dest, int w, int h)
+{
+	for (int y = 0; y < h; y++)
+	{
+		const ushort *row0 = src + (y * 2) * src_w;
+		const ushort *row1 = row0 + src_w;
+		ushort *out = dest + y * w;
+		int x;
+
+		for (x = 0; x + 8 <= w; x += 8)
+		{
+			__m128i a0 = _mm_loadu_si128((const __m128i *)(row0 + x * 2));
+			__m128i b0 = _mm_loadu_si128((const __m128i *)(row1 + x * 2));
+			__m128i a1 = _mm_loadu_si128((const __m128i *)(row0 + x * 2 + 8));
+			__m128i b1 = _mm_loadu_si128((const __m128i *)(row1 + x * 2 + 8));
+			__m128i pixels = _mm_setzero_si128();
+
+			for (int shift = 0; shift < 16; shift += 4)
+			{
+				__m128i field = _mm_srli_epi16(PackSums(SumField(a0, b0, shift, 0x0f), SumField(a1, b1, shift, 0x0f)), 2);
+				pixels = _mm_or_si128(pixels, _mm_sll_epi16(field, _mm_cvtsi32_si128(shift)));
+			}
+
+			_mm_storeu_si128((__m128i *)(out + x), pixels);
+		}
+
+		for (; x < w; x++)
+			out[x] = BoxFilterPixel4444(row0, row1, x);
+	}
+}
+
+#endif	// CPU_SIMD
+
+// Sets count pixels to the same value
+void bm_FillPixels16(ushort *dest, ushort pixel, int count)
+{
+#ifdef CPU_SIMD
+	if (cpu_HaveSSE2())
+	{
+		FillPixels16SSE2(dest, pixel, count);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < count; i++)
+		dest[i] = pixel;
+}
+
+// Converts 565 pixels to 1555 in place
+void bm_Convert565To1555(ushort *data, int count)
+{
+#ifdef CPU_SIMD
+	if (cpu_HaveSSE2())
+	{
+		Convert565To1555SSE2(data, count);
+		return;
+	}
+#endif
+
+	for (int i = 0; i < count; i++)
+		data[i] = Convert565To1555(data[i]);
+}
+
+// Builds a 1555 mip level by averaging each 2x2 block of the level above
+void bm_BoxFilter1555(const ushort *src, int src_w, ushort *dest, int w, int h)
+{
+#ifdef CPU_SIMD
+	if (cpu_HaveSSE2())
+	{
+		BoxFilter1555SSE2(src, src_w, dest, w, h);
+		return;
+	}
+#endif
+
+	for (int y = 0; y < h; y++)
+	{
+		const ushort *row0 = src + (y * 2) * src_w;
+		const ushort *row1 = row0 + src_w;
+
+		for (int x = 0; x < w; x++)
+			dest[y * w + x] = BoxFilterPixel1555(row0, row1, x);
+	}
+}
+
+// Builds a 4444 mip level by averaging each 2x2 block of the level above
+void bm_BoxFilter4444(const ushort *src, int src_w, ushort *dest, int w, int h)
+{
+#ifdef CPU_SIMD
+	if (cpu_HaveSSE2())
+	{
+		BoxFilter4444SSE2(src, src_w, dest, w, h);
+		return;
+	}
+#endif
+
+	for (int y = 0; y < h; y++)
+	{
+		const ushort *row0 = src + (y * 2) * src_w;
+		const ushort *row1 = row0 + src_w;
+
+		for (int x = 0; x < w; x++)
+			dest[y * w + x] = BoxFilterPixel4444(row0, row1, x);
+	}
+}
+
+// Builds mip levels 1 and up in place from level 0
+void bm_BuildMipChain(ushort *data, int w, int h, int levels, int format)
+{
+	ushort *src = data;
+
+	for (int m = 1; m < levels; m++)
+	{
+		int src_w = w >> (m - 1);
+		ushort *dest = src + src_w * (h >> (m - 1));
+
+		if (format == BITMAP_FORMAT_4444)
+			bm_BoxFilter4444(src, src_w, dest, w >> m, h >> m);
+		else
+			bm_BoxFilter1555(src, src_w, dest, w >> m, h >> m);
+
+		src = dest;
+	}
+}
@@ -0,0 +1,40 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef _PIXELOPS_H
+#define _PIXELOPS_H
+
+#include "pstypes.h"
+
+// Bulk pixel routines used when loading bitmaps.  These use SSE2 when the cpu has it.
+
+// Sets count pixels to the same value
+void bm_FillPixels16(ushort *dest, ushort pixel, int count);
+
+// Converts 565 pixels (as stored in older ogfs) to 1555 in place.  0x07e0 becomes transparent.
+void bm_Convert565To1555(ushort *data, int count);
+
+// Builds a w x h mip from the 2w wide level above it by averaging each 2x2 block.
+// For 1555, transparent pixels add black, and a block with 3 or more of them is transparent.
+void bm_BoxFilter1555(const ushort *src, int src_w, ushort *dest, int w, int h);
+void bm_BoxFilter4444(const ushort *src, int src_w, ushort *dest, int w, int h);
+
+// Fills in levels 1 through levels-1 of a w x h mip chain from level 0.  Each level follows
+// the one before it in data, which is how bm_data() lays them out.
+void bm_BuildMipChain(ushort *data, int w, int h, int levels, int format);
+
+#endif
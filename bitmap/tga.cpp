@@ -22,61 +22,48 @@
 #include "bitmap.h"
 #include "mono.h"
 #include "grdefs.h"
+#include "pixelops.h"
 #include "texture.h"
 #include <string.h>
 #include "mem.h"
 
 #include <stdlib.h>
 
-ubyte* Tga_file_data = NULL;
-int Fake_pos = 0;
-int Bad_tga = 0;
-int Fake_file_size = 0;
-
-inline char tga_read_byte()
+// Where an ogf is decoded from.  Bitmaps are paged in on several threads at once, so each
+// decode gets its own reader.
+struct tga_reader
 {
-	// Check for bad file
-	if (Fake_pos + 1 > Fake_file_size)
-	{
-		Bad_tga = 1;
-		return 0;
-	}
-
-	return Tga_file_data[Fake_pos++];
-}
-
-inline int tga_read_int()
+	const ubyte* data;
+	bool owned;
+	int pos;
+	int size;
+	int bad;
+};
+
+// Gets the rest of an ogf for decoding.  Files in a mapped hog are decoded in place, anything else is read into a buffer.
+static void tga_get_file_data(tga_reader* rd, CFILE* infile, int numleft)
 {
-	// Check for bad file
-	if (Fake_pos + 4 > Fake_file_size)
+	rd->pos = 0;
+	rd->bad = 0;
+	rd->size = numleft;
+
+	rd->data = cf_GetDataPointer(infile, numleft);
+	rd->owned = (rd->data == NULL);
+	if (rd->owned)
 	{
-		Bad_tga = 1;
-		return 0;
+		ubyte* buf = (ubyte*)malloc(numleft);
+		ASSERT(buf != NULL);
+		cf_ReadBytes(buf, numleft, infile);
+		rd->data = buf;
 	}
-
-	int i = Tga_file_data[Fake_pos] |
-		(Tga_file_data[Fake_pos + 1] << 8) |
-		(Tga_file_data[Fake_pos + 2] << 16) |
-		(Tga_file_data[Fake_pos + 3] << 24);
-
-	Fake_pos += 4;
-	return i;
 }
 
-inline short tga_read_short()
+static void tga_free_file_data(tga_reader* rd)
 {
-	// Check for bad file
-	if (Fake_pos + 2 > Fake_file_size)
-	{
-		Bad_tga = 1;
-		return 0;
-	}
-
-	short i = Tga_file_data[Fake_pos] |
-		(Tga_file_data[Fake_pos + 1] << 8);
-
-	Fake_pos += 2;
-	return i;
+	if (rd->owned)
+		free((void*)rd->data);
+	rd->data = NULL;
+	rd->owned = false;
 }
 
 ushort bm_tga_translate_pixel(int pixel, int format)
@@ -110,121 +97,106 @@ ushort bm_tga_translate_pixel(int pixel, int format)
 	return newpix;
 }
 
-int bm_tga_read_outrage_compressed16(CFILE* infile, int n, int num_mips, int type)
+// Decodes one mip level of outrage RLE pixels straight out of the file data.  Each command
+// byte is followed by a pixel: 0 means one raw pixel, 2-250 is a run of that many.
+// Returns 0 if the data runs out.
+static int tga_decode_rle16(tga_reader* rd, const char* name, ushort* dest_data, int total)
 {
-	ushort* dest_data;
-	ushort pixel;
-	int width, height;
-	int m;
+	const ubyte* data = rd->data;
+	int pos = rd->pos;
+	int count = 0;
+	bool mipwarning = false;
 
-	for (m = 0; m < num_mips; m++)
+	while (count != total)
 	{
-		width = bm_w(n, m);
-		height = bm_h(n, m);
+		if (count >= total && !mipwarning)
+		{
+			//This condition doesn't abort, but it will stop reading data. This is so that the correct amount of data is read. 
+			mprintf((1, "Bad pixel data in image %s: count %d exceeds total %d!\n", name, total, count));
+			mipwarning = true;
+		}
 
-		int total = height * width;
-		int count = 0;
-		bool mipwarning = false;
+		if (pos + 1 > rd->size)
+		{
+			rd->bad = 1;
+			return 0;
+		}
 
-		dest_data = (ushort*)bm_data(n, m);
+		ubyte command = data[pos];
 
-		while (count != total)
+		if (command == 0 || (command >= 2 && command <= 250))
 		{
-			if (count >= total && !mipwarning)
+			if (pos + 3 > rd->size)
 			{
-				//This condition doesn't abort, but it will stop reading data. This is so that the correct amount of data is read. 
-				mprintf((1, "Bad pixel data in image %s: count %d exceeds total %d!\n", infile->name, total, count));
-				mipwarning = true;
+				rd->bad = 1;
+				return 0;
 			}
 
-			ubyte command = tga_read_byte();
-
-			if (Bad_tga)
-				return 0;
+			ushort pixel = data[pos + 1] | (data[pos + 2] << 8);
+			int run = (command == 0) ? 1 : command;
 
-			if (command == 0)	// next pixel is raw
-			{
-				pixel = tga_read_short();
+			pos += 3;
 
-				if (Bad_tga)
-					return 0;
+			if (count < total)
+				bm_FillPixels16(dest_data + count, pixel, (run < total - count) ? run : total - count);
 
-				if (type != OUTRAGE_1555_COMPRESSED_MIPPED && type != OUTRAGE_4444_COMPRESSED_MIPPED)
-				{
-					if (pixel == 0x07e0)
-						pixel = NEW_TRANSPARENT_COLOR;
-					else
-					{
-						int r = ((pixel & 0xF800) >> 11) << 3;
-						int g = ((pixel & 0x07e0) >> 5) << 2;
-						int b = (pixel & 0x001f) << 3;
+			count += run;
+		}
+		else
+		{
+			pos++;
+			Int3();		// bad compression run
+		}
+	}
 
-						pixel = OPAQUE_FLAG | GR_RGB16(r, g, b);
-					}
-				}
+	rd->pos = pos;
+	return 1;
+}
 
-				if (count < total)
-				{
-					int i = count / width;
-					int t = count % width;
-					dest_data[i * width + t] = pixel;
-				}
-				count++;
-			}
-			else if (command >= 2 && command <= 250)	// next pixel is run of pixels
-			{
-				pixel = tga_read_short();
+// Decodes the mips stored in an outrage ogf into data, laid out the way bm_data() finds them.
+// If the file has mips, levels num_mips through mip_levels-1 are filled by point sampling.
+static int tga_read_outrage_compressed16(tga_reader* rd, const char* name, ushort* data, int w, int h, int num_mips, int mip_levels, int type)
+{
+	int width, height;
+	int m;
+	ushort* dest_data = data;
 
-				if (Bad_tga)
-					return 0;
+	for (m = 0; m < num_mips; m++)
+	{
+		width = w >> m;
+		height = h >> m;
 
-				if (type != OUTRAGE_1555_COMPRESSED_MIPPED && type != OUTRAGE_4444_COMPRESSED_MIPPED)
-				{
-					if (pixel == 0x07e0)
-						pixel = NEW_TRANSPARENT_COLOR;
-					else
-					{
-						int r = ((pixel & 0xF800) >> 11) << 3;
-						int g = ((pixel & 0x07e0) >> 5) << 2;
-						int b = (pixel & 0x001f) << 3;
+		if (!tga_decode_rle16(rd, name, dest_data, width * height))
+			return 0;
 
-						pixel = OPAQUE_FLAG | GR_RGB16(r, g, b);
-					}
-				}
+		// Older files store 565 pixels, with 0x07e0 as the transparent color
+		if (type != OUTRAGE_1555_COMPRESSED_MIPPED && type != OUTRAGE_4444_COMPRESSED_MIPPED)
+			bm_Convert565To1555(dest_data, width * height);
 
-				for (int k = 0; k < command; k++)
-				{
-					int i = count / width;
-					int t = count % width;
-					dest_data[i * width + t] = pixel;
-					count++;
-				}
-			}
-			else 
-				Int3();		// bad compression run
-		}
+		dest_data += width * height;
 	}
 
 	//DAJ added to fill out the mip maps down to the 1x1 size (memory is already there)
 	//does not average since we are only a pixel or two in size
 	if (num_mips > 1) {
-		GameBitmaps[n].mip_levels = bm_miplevels(n);
-		for (m = num_mips; m < bm_miplevels(n); m++) 
+		for (m = num_mips; m < mip_levels; m++) 
 		{
-			width = bm_w(n, m);
-			height = bm_h(n, m);
+			width = w >> m;
+			height = h >> m;
 
-			ushort w_prev = bm_w(n, m - 1);
-			ushort* dst = bm_data(n, m);
-			ushort* src = bm_data(n, m - 1);
+			ushort w_prev = w >> (m - 1);
+			ushort* dst = dest_data;
+			ushort* src = dest_data - w_prev * (h >> (m - 1));
 
-			for (int h_inc = 0; h_inc < height; h_inc++)
+			for (int h_inc = 0; h_inc < height; h_inc++, dst += width)
 			{
+				const ushort* src_row = src + 2 * h_inc * w_prev;
+
 				for (int w_inc = 0; w_inc < width; w_inc++)
-				{
-					dst[h_inc * width + w_inc] = src[2 * (h_inc * w_prev + w_inc)];
-				}
+					dst[w_inc] = src_row[2 * w_inc];
 			}
+
+			dest_data += width * height;
 		}
 	}
 
@@ -425,15 +397,20 @@ int bm_tga_alloc_file(CFILE* infile, char* name, int format)
 
 		cfseek(infile, savepos, SEEK_SET);
 
-		Tga_file_data = (ubyte*)mem_malloc(numleft);
-		ASSERT(Tga_file_data != NULL);
-		Fake_pos = 0;
-		Bad_tga = 0;
-		Fake_file_size = numleft;
+		tga_reader rd;
+		tga_get_file_data(&rd, infile, numleft);
 
-		cf_ReadBytes((ubyte*)Tga_file_data, numleft, infile);
+		int levels = 1;
+		if (num_mips > 1)
+		{
+			levels = bm_miplevels(n);
+			GameBitmaps[n].mip_levels = levels;
+		}
 
-		read_ok = bm_tga_read_outrage_compressed16(infile, n, num_mips, image_type);
+		read_ok = tga_read_outrage_compressed16(&rd, infile->name, GameBitmaps[n].data16, width, height, num_mips, levels, image_type);
+
+		tga_free_file_data(&rd);
+		cfseek(infile, savepos + rd.pos, SEEK_SET);
 	}
 
 	else
@@ -443,44 +420,37 @@ int bm_tga_alloc_file(CFILE* infile, char* name, int format)
 		Int3();
 	//bm_tga_read_outrage_compressed8 (infile,n);
 
-	if (Tga_file_data != NULL)
-	{
-		mem_free(Tga_file_data);
-		Tga_file_data = NULL;
-		cfseek(infile, savepos + Fake_pos, SEEK_SET);
-	}
-
 	if (!read_ok)
 		return -1;
 	else
 		return (n);
 }
 
-extern int paged_in_count;
-extern int paged_in_num;
-// Pages in bitmap index n.  Returns 1 if successful, 0 if not
-int bm_page_in_file(int n)
+// Number of mip levels a bitmap this wide gets, counted the way bm_miplevels() does
+static int tga_count_mip_levels(int n, int width)
+{
+	int levels = 0;
+
+	if (GameBitmaps[n].mip_levels)
+		return GameBitmaps[n].mip_levels;
+
+	for (int tmp = width; tmp > 0; tmp = tmp >> 1)
+		levels++;
+
+	return levels;
+}
+
+// Reads the header and pixels of a paged out bitmap's file.  Returns 1 if successful, 0 if not
+static int tga_decode_page_file(CFILE* infile, int n, bm_decoded_file* dest)
 {
 	ubyte image_id_len, color_map_type, image_type, pixsize, descriptor;
-	ubyte upside_down = 0;
 	ushort width, height;
-	int i, data8bit = 0, savepos;
+	int i, savepos;
 	int mipped = 0, file_mipped = 0;
 	int num_mips = 1;
+	int format;
 	char name[BITMAP_NAME_LEN];
-	CFILE* infile;
 
-	ASSERT((GameBitmaps[n].flags & BF_NOT_RESIDENT));
-
-	infile = (CFILE*)cfopen(GameBitmaps[n].name, "rb");
-	if (!infile)
-	{
-		mprintf((0, "Couldn't page in bitmap %s!\n", GameBitmaps[n].name));
-		return 0;
-	}
-	//Used for progress bar when loading the level
-	paged_in_count += cfilelength(infile);
-	paged_in_num++;
 	image_id_len = cf_ReadByte(infile);
 	color_map_type = cf_ReadByte(infile);
 	image_type = cf_ReadByte(infile);
@@ -488,12 +458,9 @@ int bm_page_in_file(int n)
 	if (color_map_type != 0 || (image_type != 10 && image_type != 2 && image_type != OUTRAGE_TGA_TYPE && image_type != OUTRAGE_COMPRESSED_OGF && image_type != OUTRAGE_COMPRESSED_MIPPED && image_type != OUTRAGE_NEW_COMPRESSED_MIPPED && image_type != OUTRAGE_1555_COMPRESSED_MIPPED && image_type != OUTRAGE_4444_COMPRESSED_MIPPED))
 	{
 		mprintf((0, "bm_tga: Can't read this type of TGA.\n"));
-		return -1;
+		return 0;
 	}
 
-	if (image_type == OUTRAGE_COMPRESSED_OGF_8BIT)
-		data8bit = 1;
-
 	if (image_type == OUTRAGE_4444_COMPRESSED_MIPPED || image_type == OUTRAGE_1555_COMPRESSED_MIPPED || image_type == OUTRAGE_NEW_COMPRESSED_MIPPED || image_type == OUTRAGE_TGA_TYPE || image_type == OUTRAGE_COMPRESSED_MIPPED || image_type == OUTRAGE_COMPRESSED_OGF || image_type == OUTRAGE_COMPRESSED_OGF_8BIT)
 	{
 		if (image_type == OUTRAGE_4444_COMPRESSED_MIPPED || image_type == OUTRAGE_1555_COMPRESSED_MIPPED || image_type == OUTRAGE_NEW_COMPRESSED_MIPPED)
@@ -513,6 +480,11 @@ int bm_page_in_file(int n)
 		if (num_mips > 1)
 			file_mipped = 1;
 	}
+	else
+	{
+		Int3();		// Get Jason
+		return 0;
+	}
 
 	for (i = 0; i < 9; i++)			// ingore next 9 bytes
 		cf_ReadByte(infile);
@@ -540,86 +512,155 @@ int bm_page_in_file(int n)
 	if ((GameBitmaps[n].flags & BF_WANTS_MIP) || file_mipped)
 		mipped = 1;
 
-	int size = (width * height * 2) + (mipped * ((width * height * 2) / 3)) + 2;
-	GameBitmaps[n].data16 = (ushort*)mem_malloc(size);
-	if (!GameBitmaps[n].data16)
+	if ((GameBitmaps[n].flags & BF_WANTS_4444) || image_type == OUTRAGE_4444_COMPRESSED_MIPPED)
+		format = BITMAP_FORMAT_4444;
+	else
+		format = BITMAP_FORMAT_STANDARD;
+
+	dest->size = (width * height * 2) + (mipped * ((width * height * 2) / 3)) + 2;
+	dest->data = (ushort*)malloc(dest->size);
+	if (!dest->data)
 	{
 		mprintf((0, "Out of memory in bm_page_in_file!\n"));
 		return 0;
 	}
 
-	Bitmap_memory_used += size;
+	dest->width = width;
+	dest->height = height;
+	dest->format = format;
+	dest->mipped = mipped;
+	dest->mip_levels = mipped ? tga_count_mip_levels(n, width) : 0;
+	strcpy(dest->name, name);
 
+	if (image_type == OUTRAGE_COMPRESSED_OGF_8BIT)
+	{
+		Int3();
+		return 0;
+	}
 
-	if ((GameBitmaps[n].flags & BF_WANTS_4444) || image_type == OUTRAGE_4444_COMPRESSED_MIPPED)
-		GameBitmaps[n].format = BITMAP_FORMAT_4444;
-	else
-		GameBitmaps[n].format = BITMAP_FORMAT_STANDARD;
-
-	GameBitmaps[n].width = width;
-	GameBitmaps[n].height = height;
-	GameBitmaps[n].flags &= ~BF_NOT_RESIDENT;
+	// read this ogf in all at once (much faster)
+	savepos = cftell(infile);
+	cfseek(infile, 0, SEEK_END);
+	int numleft = cftell(infile) - savepos;
+	cfseek(infile, savepos, SEEK_SET);
 
-	// Copy the name
-//	if ((stricmp(GameBitmaps[n].name,name)))
-//			Int3(); //Get Jason!
+	tga_reader rd;
+	tga_get_file_data(&rd, infile, numleft);
 
-	strcpy(GameBitmaps[n].name, name);
+	int read_ok = tga_read_outrage_compressed16(&rd, GameBitmaps[n].name, dest->data, width, height, num_mips, file_mipped ? dest->mip_levels : 1, image_type);
 
-	mprintf((0, "Paging in bitmap %s!\n", GameBitmaps[n].name));
+	tga_free_file_data(&rd);
 
-	if (file_mipped)
-		GameBitmaps[n].flags |= BF_MIPMAPPED;
+	// A short file still pages in with whatever was read
+	if (!read_ok)
+		mprintf((0, "Bitmap %s is missing pixel data!\n", GameBitmaps[n].name));
 
-	upside_down = (descriptor & 0x20) >> 5;
-	upside_down = 1 - upside_down;
+	// Files without mips of their own get a box filtered chain
+	if (mipped && !file_mipped)
+		bm_BuildMipChain(dest->data, width, height, dest->mip_levels, format);
 
-	// Load the actual bitmap data in, converting it from 32 bit to 16 bit, and replacing
-	// that pesky transparency color without our replacement
-	if (image_type == OUTRAGE_4444_COMPRESSED_MIPPED || image_type == OUTRAGE_1555_COMPRESSED_MIPPED || image_type == OUTRAGE_NEW_COMPRESSED_MIPPED || image_type == OUTRAGE_COMPRESSED_MIPPED || image_type == OUTRAGE_COMPRESSED_OGF || image_type == OUTRAGE_COMPRESSED_OGF_8BIT) // COMPRESSED OGF
-	{
-		// read this ogf in all at once (much faster)
+	// Generated chains leave mip_levels alone, like bm_GenerateMipMaps() does
+	if (!file_mipped)
+		dest->mip_levels = 0;
 
-		savepos = cftell(infile);
-		cfseek(infile, 0, SEEK_END);
-		int lastpos = cftell(infile);
-		int numleft = lastpos - savepos;
+	return 1;
+}
 
-		cfseek(infile, savepos, SEEK_SET);
+// Reads and decodes the file for a paged out bitmap into dest, without touching the bitmap itself.
+// Only the bitmap's name and flags are read, so different bitmaps can be decoded at the same time.
+void bm_DecodeBitmapFile(int n, bm_decoded_file* dest)
+{
+	CFILE* infile;
 
-		Tga_file_data = (ubyte*)mem_malloc(numleft);
-		ASSERT(Tga_file_data != NULL);
-		Fake_pos = 0;
-		Bad_tga = 0;
-		Fake_file_size = numleft;
+	memset(dest, 0, sizeof(*dest));
+	dest->handle = n;
 
-		cf_ReadBytes((ubyte*)Tga_file_data, numleft, infile);
+	ASSERT((GameBitmaps[n].flags & BF_NOT_RESIDENT));
 
-		bm_tga_read_outrage_compressed16(infile, n, num_mips, image_type);
+	infile = (CFILE*)cfopen(GameBitmaps[n].name, "rb");
+	if (!infile)
+	{
+		mprintf((0, "Couldn't page in bitmap %s!\n", GameBitmaps[n].name));
+		return;
 	}
 
-	else
-		Int3();		// Get Jason
-
-	if (image_type == OUTRAGE_COMPRESSED_OGF_8BIT)
-		Int3();
-	//bm_tga_read_outrage_compressed8 (infile,n);
+	dest->file_size = cfilelength(infile);
 
-	if (Tga_file_data != NULL)
+	try
 	{
-		mem_free(Tga_file_data);
-		Tga_file_data = NULL;
-		cfseek(infile, savepos + Fake_pos, SEEK_SET);
+		dest->result = tga_decode_page_file(infile, n, dest);
+	}
+	catch (cfile_error*)
+	{
+		mprintf((0, "Error reading bitmap %s!\n", GameBitmaps[n].name));
+		dest->result = 0;
 	}
 
 	cfclose(infile);
 
+	if (!dest->result && dest->data)
+	{
+		free(dest->data);
+		dest->data = NULL;
+	}
+}
+
+extern int paged_in_count;
+extern int paged_in_num;
+// Moves a decoded file into its bitmap, which takes over the decode buffer.  Must be called on the main thread.
+// Returns 1 if the bitmap was paged in, 0 if not
+int bm_CommitBitmapFile(bm_decoded_file* src)
+{
+	int n = src->handle;
+
+	if (!src->file_size)
+		return 0;
+
+	//Used for progress bar when loading the level
+	paged_in_count += src->file_size;
+	paged_in_num++;
+
+	if (!src->result)
+		return 0;
 
-	if ((GameBitmaps[n].flags & BF_WANTS_MIP) && !file_mipped)
+	// The bitmap takes the decode buffer as is
+	GameBitmaps[n].data16 = (ushort*)mem_adopt(src->data, src->size);
+	src->data = NULL;
+	if (!GameBitmaps[n].data16)
 	{
-		bm_GenerateMipMaps(n);
+		mprintf((0, "Out of memory in bm_page_in_file!\n"));
+		return 0;
 	}
 
+	Bitmap_memory_used += src->size;
+
+	GameBitmaps[n].format = src->format;
+	GameBitmaps[n].width = src->width;
+	GameBitmaps[n].height = src->height;
+	GameBitmaps[n].flags &= ~BF_NOT_RESIDENT;
+
+	// Copy the name
+//	if ((stricmp(GameBitmaps[n].name,name)))
+//			Int3(); //Get Jason!
+
+	strcpy(GameBitmaps[n].name, src->name);
+
+	mprintf((0, "Paging in bitmap %s!\n", GameBitmaps[n].name));
+
+	if (src->mipped)
+		GameBitmaps[n].flags |= BF_MIPMAPPED;
+	if (src->mip_levels)
+		GameBitmaps[n].mip_levels = src->mip_levels;
+
 	return 1;
 }
 
+// Pages in bitmap index n.  Returns 1 if successful, 0 if not
+int bm_page_in_file(int n)
+{
+	bm_decoded_file decoded;
+
+	bm_DecodeBitmapFile(n, &decoded);
+
+	return bm_CommitBitmapFile(&decoded);
+}
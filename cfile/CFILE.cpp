@@ -23,6 +23,7 @@
 #include <errno.h>
 #include <ctype.h>
 #include <stdint.h>
+#include <mutex>
 #ifndef __LINUX__
 //Non-Linux Build Includes
 #include <io.h>
@@ -38,6 +39,23 @@
 #include "hogfile.h"		//info about library file
 #include "mem.h"
 
+#ifdef __LINUX__
+#include <sys/stat.h>
+#include <dirent.h>
+#include <limits.h>
+#endif
+
+//Entry in the file name index.  Every file in every open library, and on Linux every file
+//in the search paths, has one of these, hashed by its case folded name.
+struct index_node
+{
+	uint		hash;				//hash of the case folded name
+	const char	*name;				//name as stored in the library or on disk
+	library		*lib;				//library the file is in, or NULL if it's in a search path
+	int			entry;				//index of the library entry, or the search path number
+	index_node	*next;				//next node in the same bucket
+};
+
 //Library structures
 struct library_entry
 {
@@ -48,6 +66,15 @@ struct library_entry
 	int		flags;					//misc flags
 };
 
+//Memory image of a library file.  Reference counted, since files opened from the library
+//keep reading from the image after the library itself has been closed.
+struct library_map
+{
+	ubyte	*data;
+	int		size;
+	int		refs;
+};
+
 struct library 
 {
 	char 			name[_MAX_PATH];	//includes path + filename
@@ -56,6 +83,8 @@ struct library
 	library			*next;
 	int				handle;				//indentifier for this lib
 	FILE			*file;				//pointer to file for this lib, if no one using it
+	library_map		*map;				//memory image of the lib, or NULL if reading through FILEs
+	index_node		*nodes;				//index nodes for the entries
 };
 
 //entry in extension->path table
@@ -70,6 +99,12 @@ struct path_entry
 {
 	char	path[_MAX_PATH];
 	ubyte	specific;			//if non-zero, only for specific extensions
+#ifdef __LINUX__
+	bool		indexed;			//true if the contents of the directory are in the index
+	int			nnodes;
+	index_node	*nodes;				//index nodes for the files in the directory
+	char		*names;				//storage for the file names
+#endif
 };
 
 #define MAX_PATHS			100
@@ -80,7 +115,13 @@ ext_entry extensions[MAX_EXTENSIONS];
 int N_extensions;
 library *Libraries=NULL;
 int lib_handle=0;
+bool Library_mapping=true;
+//Opening and closing hand library FILEs and map references back and forth, so files opened
+//from more than one thread (bitmap page-in workers) go through this lock.  So do changes to
+//the library list and the search paths, which those opens look through.
+static std::mutex Cfile_open_lock;
 void cf_Close();
+CFILE *open_file_in_directory(const char *filename,const char *mode,const char *directory);
 //Structure thrown on disk error
 cfile_error cfe;
 //The message for unexpected end of file
@@ -94,6 +135,329 @@ void ThrowCFileError(int type,CFILE *file,char *msg)
 	throw &cfe;
 }
 
+//Maps a library into memory.  data_end is the end of the last file in the library, which
+//the image must cover.  Returns NULL if the library couldn't be mapped.
+static library_map *MapLibrary(const char *libname,int data_end)
+{
+	library_map *map;
+	ubyte *data;
+	int size;
+
+	data = (ubyte *) ddio_MapFile(libname,&size);
+	if (!data)
+		return NULL;
+	//Truncated library; leave it to the FILE code to report the read errors
+	if (size < data_end)
+	{
+		ddio_UnmapFile(data,size);
+		return NULL;
+	}
+	map = (library_map *) mem_malloc(sizeof(*map));
+	if (!map)
+	{
+		ddio_UnmapFile(data,size);
+		return NULL;
+	}
+	map->data = data;
+	map->size = size;
+	map->refs = 1;
+	return map;
+}
+
+//Drops a reference to a library image, and unmaps it if no one is using it anymore
+static void ReleaseLibraryMap(library_map *map)
+{
+	if (--map->refs == 0)
+	{
+		ddio_UnmapFile(map->data,map->size);
+		mem_free(map);
+	}
+}
+
+//Sets whether libraries opened from now on are memory mapped
+void cf_SetLibraryMapping(bool enable)
+{
+	Library_mapping = enable;
+}
+
+//The file name index, a hash table of all the files we know about.  Nodes for a library are
+//added at the front of their buckets, so a search finds the most recently opened library
+//first, the same order a walk of the Libraries list would.
+#define MIN_INDEX_BUCKETS	4096
+index_node **File_index = NULL;
+int File_index_size = 0;	//number of buckets, always a power of 2
+int File_index_count = 0;	//number of nodes
+
+//Hashes the case folded form of a file name
+static uint IndexHash(const char *name)
+{
+	uint hash = 2166136261u;
+	for (; *name; name++)
+	{
+		hash ^= (ubyte) tolower(*name);
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+static void IndexAddNode(index_node *node)
+{
+	index_node **bucket = &File_index[node->hash & (File_index_size-1)];
+	node->next = *bucket;
+	*bucket = node;
+	File_index_count++;
+}
+
+static void IndexRemoveNode(index_node *node)
+{
+	index_node **link = &File_index[node->hash & (File_index_size-1)];
+	while (*link != node)
+	{
+		ASSERT(*link != NULL);
+		link = &(*link)->next;
+	}
+	*link = node->next;
+	File_index_count--;
+}
+
+static void IndexAddLibrary(library *lib)
+{
+	for (int i = 0; i < lib->nfiles; i++)
+		IndexAddNode(&lib->nodes[i]);
+}
+
+//Adds the libraries from lib to the end of the list, oldest first, so the newest end up at the front of the buckets
+static void IndexAddLibraries(library *lib)
+{
+	if (!lib)
+		return;
+	IndexAddLibraries(lib->next);
+	IndexAddLibrary(lib);
+}
+
+//Makes sure the index has room for count more nodes, and rebuilds it with more buckets if not
+static void IndexReserve(int count)
+{
+	int size = File_index_size ? File_index_size : MIN_INDEX_BUCKETS;
+	while (File_index_count + count > size)
+		size *= 2;
+	if (size == File_index_size)
+		return;
+
+	if (File_index)
+		mem_free(File_index);
+	File_index = (index_node **) mem_malloc(sizeof(index_node *) * size);
+	if (!File_index)
+		Error("Out of memory in IndexReserve()");
+	memset(File_index, 0, sizeof(index_node *) * size);
+	File_index_size = size;
+	File_index_count = 0;
+
+	IndexAddLibraries(Libraries);
+#ifdef __LINUX__
+	for (int p = 0; p < N_paths; p++)
+		for (int i = 0; i < paths[p].nnodes; i++)
+			IndexAddNode(&paths[p].nodes[i]);
+#endif
+}
+
+//Finds a file in the open libraries.  If lib is non-NULL, only that library is searched.
+static index_node *IndexFindInLibraries(const char *filename, library *lib)
+{
+	if (!File_index)
+		return NULL;
+	uint hash = IndexHash(filename);
+	for (index_node *node = File_index[hash & (File_index_size-1)]; node; node = node->next)
+	{
+		if (node->hash == hash && node->lib && (!lib || node->lib == lib) && !stricmp(node->name, filename))
+			return node;
+	}
+	return NULL;
+}
+
+#ifdef __LINUX__
+//Drops the index of a search path
+static void IndexFreeSearchPath(int pathnum)
+{
+	path_entry *pe = &paths[pathnum];
+	for (int i = 0; i < pe->nnodes; i++)
+		IndexRemoveNode(&pe->nodes[i]);
+	if (pe->nodes)
+		mem_free(pe->nodes);
+	if (pe->names)
+		mem_free(pe->names);
+	pe->nodes = NULL;
+	pe->names = NULL;
+	pe->nnodes = 0;
+	pe->indexed = false;
+}
+
+//Tells if a directory entry is a file (or a link to one), and not a subdirectory, "." or ".."
+static bool IsRegularFile(const char *directory, struct dirent *ent)
+{
+	if (ent->d_type == DT_REG)
+		return true;
+	if (ent->d_type != DT_UNKNOWN && ent->d_type != DT_LNK)
+		return false;
+
+	//The file system didn't say, or it's a link, so look at what it is
+	char path[_MAX_PATH*2];
+	struct stat info;
+	ddio_MakePath(path, directory, ent->d_name, NULL);
+	return (stat(path, &info) == 0 && S_ISREG(info.st_mode));
+}
+
+//Reads the files in a search path's directory into the index, if they aren't there already.
+//The directory is only read once; after that, the index is trusted until the path is
+//invalidated by IndexFileWritten().  Files put in a search path by other means than cfopen()
+//won't be found until then.
+static void IndexSearchPath(int pathnum)
+{
+	path_entry *pe = &paths[pathnum];
+	if (pe->indexed)
+		return;
+	pe->indexed = true;
+
+	DIR *dir = opendir(pe->path);
+	if (!dir)
+		return;
+
+	//Count the files and their names' lengths, then fill in the nodes
+	int count = 0, names_len = 0;
+	struct dirent *ent;
+	while ((ent = readdir(dir)) != NULL)
+	{
+		if (!IsRegularFile(pe->path, ent))
+			continue;
+		count++;
+		names_len += strlen(ent->d_name) + 1;
+	}
+	if (count)
+	{
+		pe->nodes = (index_node *) mem_malloc(sizeof(index_node) * count);
+		pe->names = (char *) mem_malloc(names_len);
+		if (!pe->nodes || !pe->names)
+			Error("Out of memory in IndexUpdateSearchPath()");
+
+		rewinddir(dir);
+		char *name = pe->names;
+		while ((ent = readdir(dir)) != NULL && pe->nnodes < count)
+		{
+			if (!IsRegularFile(pe->path, ent))
+				continue;
+			int len = strlen(ent->d_name) + 1;
+			if ((name - pe->names) + len > names_len)
+				break;		//directory grew while we were reading it
+			memcpy(name, ent->d_name, len);
+
+			index_node *node = &pe->nodes[pe->nnodes++];
+			node->name = name;
+			node->hash = IndexHash(name);
+			node->lib = NULL;
+			node->entry = pathnum;
+			name += len;
+		}
+		//If the index gets rebuilt, this path is added along with the rest
+		int old_size = File_index_size;
+		IndexReserve(pe->nnodes);
+		if (File_index_size == old_size)
+		{
+			for (int i = 0; i < pe->nnodes; i++)
+				IndexAddNode(&pe->nodes[i]);
+		}
+	}
+	closedir(dir);
+}
+
+//Finds a file in a search path.  Returns the name the file has on disk, or NULL if it isn't there.
+static const char *IndexFindInSearchPath(const char *filename, int pathnum)
+{
+	const char *found = NULL;
+	IndexSearchPath(pathnum);
+	if (!paths[pathnum].nnodes)
+		return NULL;
+
+	uint hash = IndexHash(filename);
+	for (index_node *node = File_index[hash & (File_index_size-1)]; node; node = node->next)
+	{
+		if (node->hash == hash && !node->lib && node->entry == pathnum && !stricmp(node->name, filename))
+		{
+			//An exact match wins over one that only differs by case
+			if (!strcmp(node->name, filename))
+				return node->name;
+			if (!found)
+				found = node->name;
+		}
+	}
+	return found;
+}
+
+//Tells if a file is in a search path.  realname is set to the file's name on disk.
+static bool FindInSearchPath(const char *filename, int pathnum, const char **realname)
+{
+	*realname = IndexFindInSearchPath(filename, pathnum);
+	return (*realname != NULL);
+}
+
+//Called when cfopen() opens a file for writing.  If the file is new to a search path that's
+//already been read, that path is read again the next time something is looked for in it.
+static void IndexFileWritten(const char *filename)
+{
+	char path[_MAX_PATH*2], fname[_MAX_PATH*2], ext[_MAX_EXT];
+	char name[_MAX_PATH*2], dir[PATH_MAX];
+	ddio_SplitPath(filename, path, fname, ext);
+	//Search paths are stored as full paths, so compare against the full path of the file's directory
+	if (!realpath(strlen(path) ? path : ".", dir))
+		return;
+	snprintf(name, sizeof(name), "%s%s", fname, ext);
+
+	for (int i = 0; i < N_paths; i++)
+	{
+		if (!paths[i].indexed || strcmp(paths[i].path, dir))
+			continue;
+		const char *realname = IndexFindInSearchPath(name, i);
+		if (!realname || strcmp(realname, name))
+			IndexFreeSearchPath(i);
+	}
+}
+
+//Opens a file from a search path, using the name the file has on disk
+static CFILE *open_file_in_search_path(const char *filename, const char *mode, int pathnum)
+{
+	const char *realname;
+	if (!FindInSearchPath(filename, pathnum, &realname))
+		return NULL;
+	return open_file_in_directory(realname, mode, paths[pathnum].path);
+}
+
+//Looks for a file in the search paths, in the same order cfopen() does.  Returns the number of the
+//search path the file was found in, or -1 if it wasn't found.
+static int FindInSearchPaths(const char *filename, const char *ext)
+{
+	const char *realname;
+	int i;
+	//First look in the directories for this file's extension
+	for (i=0;i<N_extensions;i++) 
+	{
+		if (! strnicmp(extensions[i].ext,ext+1,_MAX_EXT)) //found ext
+		{
+			if (FindInSearchPath(filename, extensions[i].pathnum, &realname))
+				return extensions[i].pathnum;
+		}
+	}
+	//Next look in the general directories
+	for (i=0;i<N_paths;i++) 
+	{
+		if (!paths[i].specific) 
+		{
+			if (FindInSearchPath(filename, i, &realname))
+				return i;
+		}
+	}
+	return -1;
+}
+#endif
+
 //Opens a HOG file.  Future calls to cfopen(), etc. will look in this HOG.
 //Parameters:  libname - the path & filename of the HOG file 
 //NOTE:	libname must be valid for the entire execution of the program.  Therefore, it should either
@@ -133,6 +497,8 @@ int cf_OpenLibrary(const char *libname)
 	}
 	strncpy(lib->name, libname, sizeof(lib->name));
 	lib->name[sizeof(lib->name) - 1] = '\0';
+	lib->map = NULL;
+	lib->nodes = NULL;
 
 	//read HOG header
 	if (!ReadHogHeader(fp, &header)) 
@@ -151,8 +517,6 @@ int cf_OpenLibrary(const char *libname)
 		mem_free(lib);
 		return 0;
 	}
-	lib->next = Libraries;
-	Libraries = lib;
 	//set data offset of first file
 	offset = header.file_data_offset;
 	//Go to index start
@@ -164,6 +528,8 @@ int cf_OpenLibrary(const char *libname)
 		if (!ReadHogEntry(fp, &entry)) 
 		{
 			fclose(fp);
+			mem_free(lib->entries);
+			mem_free(lib);
 			return 0;
 		}
 		//Make sure files are in order
@@ -176,10 +542,39 @@ int cf_OpenLibrary(const char *libname)
 		lib->entries[i].timestamp  = entry.timestamp;
 		offset += lib->entries[i].length;
 	}
-	//assign a handle
-	lib->handle = ++lib_handle;
+	//Make the index nodes for the files
+	lib->nodes = (index_node *) mem_malloc(sizeof(index_node) * lib->nfiles);
+	if (!lib->nodes && lib->nfiles)
+		Error("Out of memory in cf_OpenLibrary()");
+	for (i = 0; i < lib->nfiles; i++)
+	{
+		lib->nodes[i].name = lib->entries[i].name;
+		lib->nodes[i].hash = IndexHash(lib->entries[i].name);
+		lib->nodes[i].lib = lib;
+		lib->nodes[i].entry = i;
+	}
+	//Map the library if we can, in which case files are read out of the image and the FILE isn't needed
+	if (Library_mapping)
+		lib->map = MapLibrary(libname, offset);
+	if (lib->map)
+	{
+		fclose(fp);
+		fp = NULL;
+	}
 	//Save the file pointer
 	lib->file = fp;
+
+	//The library is ready, so let everyone else see it
+	std::lock_guard<std::mutex> lock(Cfile_open_lock);
+	//assign a handle
+	lib->handle = ++lib_handle;
+	lib->next = Libraries;
+	Libraries = lib;
+	//If the index gets rebuilt, this library is added along with the rest
+	int old_size = File_index_size;
+	IndexReserve(lib->nfiles);
+	if (File_index_size == old_size)
+		IndexAddLibrary(lib);
 	//Sucess.  Return the handle
 	return lib->handle;
 }
@@ -188,6 +583,7 @@ int cf_OpenLibrary(const char *libname)
 //Parameters:  handle: the handle returned by cf_OpenLibrary()
 void cf_CloseLibrary(int handle)
 {
+	std::lock_guard<std::mutex> lock(Cfile_open_lock);
 	library *lib,*prev=NULL;
 	for (lib=Libraries;lib;prev=lib,lib=lib->next) 
 	{
@@ -199,6 +595,11 @@ void cf_CloseLibrary(int handle)
 				Libraries = lib->next;
 			if (lib->file)
 				fclose(lib->file);
+			if (lib->map)
+				ReleaseLibraryMap(lib->map);
+			for (int i = 0; i < lib->nfiles; i++)
+				IndexRemoveNode(&lib->nodes[i]);
+			mem_free(lib->nodes);
 			mem_free(lib->entries);
 			mem_free(lib);
 			return; //sucessful close
@@ -213,10 +614,20 @@ void cf_Close()
 	while (Libraries) 
 	{
 		next = Libraries->next;
+		if (Libraries->map)
+			ReleaseLibraryMap(Libraries->map);
+		if (Libraries->nodes)
+			mem_free(Libraries->nodes);
 		mem_free(Libraries->entries);
 		mem_free(Libraries);
 		Libraries = next;
 	}
+	if (File_index)
+	{
+		mem_free(File_index);
+		File_index = NULL;
+		File_index_size = File_index_count = 0;
+	}
 }
 
 //Specify a directory to look in for files
@@ -226,12 +637,20 @@ void cf_Close()
 //Returns:		true if directory added, else false
 int cf_SetSearchPath(const char *path,char *ext,...)
 {
+	std::lock_guard<std::mutex> lock(Cfile_open_lock);
 	if (strlen(path) >= _MAX_PATH)
 		return 0;
 	if (N_paths >= MAX_PATHS)
 		return 0;
 	//Get & store full path
 	ddio_GetFullPath(paths[N_paths].path,path);
+#ifdef __LINUX__
+	//The directory gets read the first time something is looked for in it
+	paths[N_paths].indexed = false;
+	paths[N_paths].nnodes = 0;
+	paths[N_paths].nodes = NULL;
+	paths[N_paths].names = NULL;
+#endif
 	//Set extenstions for this path
 	if (ext == NULL)
 		paths[N_paths].specific = 0;
@@ -257,18 +676,73 @@ int cf_SetSearchPath(const char *path,char *ext,...)
 //Removes all search paths that have been added by cf_SetSearchPath
 void cf_ClearAllSearchPaths(void)
 {
+	std::lock_guard<std::mutex> lock(Cfile_open_lock);
+#ifdef __LINUX__
+	for (int i = 0; i < N_paths; i++)
+		IndexFreeSearchPath(i);
+#endif
 	N_paths = 0;
 	N_extensions = 0;
 }
 
+//Opens entry i of a library for reading.  Files in a mapped library read from the library
+//image; otherwise the file gets the library's FILE, or a new one if someone else has it.
+static CFILE *open_library_entry(library *lib,int i,const char *filename)
+{
+	CFILE *cfile;
+	FILE *fp = NULL;
+	int r;
+
+	if (!lib->map)
+	{
+		//See if there's an available FILE
+		if (lib->file) 
+		{
+			fp = lib->file;
+			lib->file = NULL;
+		}
+		else 
+		{
+			fp = fopen(lib->name,"rb");
+			if (!fp) 
+			{
+				mprintf((1,"Error opening library <%s> when opening file <%s>; errno=%d.",lib->name,filename,errno));
+				Int3();
+				return NULL;
+			}
+		}
+	}
+
+	cfile = (CFILE *) mem_malloc(sizeof(*cfile));
+	if (!cfile)
+		Error("Out of memory in open_file_in_lib()");
+	cfile->name = lib->entries[i].name;
+	cfile->file = fp;
+	cfile->lib_handle = lib->handle;
+	cfile->size = lib->entries[i].length;
+	cfile->lib_offset = lib->entries[i].offset;
+	cfile->position = 0;
+	cfile->flags = 0;
+	cfile->map = lib->map;
+	if (cfile->map)
+		cfile->map->refs++;
+	else
+	{
+		r = fseek(fp,cfile->lib_offset,SEEK_SET);
+		ASSERT(r == 0);
+	}
+	return cfile;
+}
+
 // Opens a file for reading in a library, given the library id
 CFILE *cf_OpenFileInLibrary(const char *filename,int libhandle)
 {
 	if(libhandle<=0)
 		return NULL;
 
+	std::lock_guard<std::mutex> lock(Cfile_open_lock);
+
 	library *lib;
-	CFILE *cfile;
 	lib = Libraries;
 
 	// find the library that we want to use
@@ -285,130 +759,21 @@ CFILE *cf_OpenFileInLibrary(const char *filename,int libhandle)
 		return NULL;
 	}
 
-	// now do a binary search for the file entry
-	int i;
-	int first = 0,last = lib->nfiles-1,c,found=0;
-
-	for (;;)
-	{
-		i = (first + last) / 2;
-		c = stricmp(filename, lib->entries[i].name);	//compare to current
-		if (c == 0) //found it
-		{
-			found = 1;
-			break;
-		}
-		if (first >= last)	//exhausted search
-			break;
-		if (c > 0)			//search key after check key
-			first = i + 1;
-		else				//search key before check key
-			last = i - 1;
-	}
-
-	if(!found)
+	// now look up the file entry
+	index_node *node = IndexFindInLibraries(filename,lib);
+	if(!node)
 		return NULL;	// file not in library
 
-	// open the file for reading
-  	FILE *fp;
-  	int r;
-	//See if there's an available FILE
-	if (lib->file) 
-	{
-		fp = lib->file;
-		lib->file = NULL;
-	}
-	else 
-	{
-	  	fp = fopen(lib->name,"rb");
-  		if (!fp) 
-		{
-			mprintf((1,"Error opening library <%s> when opening file <%s>; errno=%d.",lib->name,filename,errno));
-  			Int3();
-  			return NULL;
-	  	}
-	}
-
-  	cfile = (CFILE *)mem_malloc(sizeof(*cfile));
-  	if (!cfile)
-  		Error("Out of memory in open_file_in_lib()");
-  	cfile->name = lib->entries[i].name;
-  	cfile->file = fp;
-	cfile->lib_handle = lib->handle;
-  	cfile->size = lib->entries[i].length;
-  	cfile->lib_offset = lib->entries[i].offset;
-  	cfile->position = 0;
-  	cfile->flags = 0;
-  	r = fseek(fp,cfile->lib_offset,SEEK_SET);
-  	ASSERT(r == 0);
-  	return cfile;
+	return open_library_entry(lib,node->entry,filename);
 }
 
 //searches through the open HOG files, and opens a file if it finds it in any of the libs
 CFILE *open_file_in_lib(const char *filename)
 {
-	library *lib;
-	CFILE *cfile;
-	lib = Libraries;
-	while (lib) 
-	{
-		int i;
-		//Do binary search for the file
-		int first = 0, last = lib->nfiles-1, c,found=0;
-		for (;;)
-		{
-			i = (first + last) / 2;
-			c = stricmp(filename, lib->entries[i].name);	//compare to current
-			if (c == 0) //found it
-			{
-				found = 1;
-				break;
-			}
-			if (first >= last)	//exhausted search
-				break;
-			if (c > 0)				//search key after check key
-				first = i + 1;
-			else						//search key before check key
-				last = i - 1;
-		}
-
-		if (found) 
-		{
-  			FILE *fp;
-  			int r;
-			//See if there's an available FILE
-			if (lib->file) 
-			{
-				fp = lib->file;
-				lib->file = NULL;
-			}
-			else 
-			{
-	  			fp = fopen(lib->name,"rb");
-  				if (!fp) 
-				{
-					mprintf((1,"Error opening library <%s> when opening file <%s>; errno=%d.",lib->name,filename,errno));
-  					Int3();
-  					return NULL;
-	  			}
-			}
-  			cfile = (CFILE *) mem_malloc(sizeof(*cfile));
-  			if (!cfile)
-  				Error("Out of memory in open_file_in_lib()");
-  			cfile->name = lib->entries[i].name;
-  			cfile->file = fp;
-			cfile->lib_handle = lib->handle;
-  			cfile->size = lib->entries[i].length;
-  			cfile->lib_offset = lib->entries[i].offset;
-  			cfile->position = 0;
-  			cfile->flags = 0;
-  			r = fseek(fp,cfile->lib_offset,SEEK_SET);
-  			ASSERT(r == 0);
-  			return cfile;
-		}
-		lib = lib->next;
-	}
-	return NULL;
+	index_node *node = IndexFindInLibraries(filename,NULL);
+	if (!node)
+		return NULL;
+	return open_library_entry(node->lib,node->entry,filename);
 }
 
 #ifdef __LINUX__
@@ -706,6 +1071,7 @@ CFILE *open_file_in_directory(const char *filename,const char *mode,const char *
 		cfile->lib_offset = 0;		//0 means on disk, not in HOG
 		cfile->position = 0;
 		cfile->flags=0;
+		cfile->map = NULL;
 		return cfile;
 	}else
 	{
@@ -733,6 +1099,7 @@ CFILE *open_file_in_directory(const char *filename,const char *mode,const char *
 			cfile->lib_offset = 0;		//0 means on disk, not in HOG
 			cfile->position = 0;
 			cfile->flags=0;
+			cfile->map = NULL;
 			return cfile;
 		}
 	}
@@ -754,6 +1121,7 @@ CFILE *open_file_in_directory(const char *filename,const char *mode,const char *
 		cfile->lib_offset = 0; //0 means on disk, not in HOG
 		cfile->position = 0;
 		cfile->flags=0;
+		cfile->map = NULL;
 		return cfile;
 	}
 #endif
@@ -767,6 +1135,7 @@ CFILE *open_file_in_directory(const char *filename,const char *mode,const char *
 //Returns:		the CFile handle, or NULL if file not opened
 CFILE *cfopen(const char * filename, const char * mode)
 {
+	std::lock_guard<std::mutex> lock(Cfile_open_lock);
 	CFILE *cfile;
 	char path[_MAX_PATH*2], fname[_MAX_PATH*2], ext[_MAX_EXT];
 	int i;
@@ -781,6 +1150,11 @@ CFILE *cfopen(const char * filename, const char * mode)
 	if (strlen(path) || (mode[0]=='w')) 
 	{								//found a path
 		cfile = open_file_in_directory(filename,mode,NULL);	//use path specified with file
+#ifdef __LINUX__
+		//A new file in a search path has to go in that path's index
+		if (cfile && (mode[0]=='w'))
+			IndexFileWritten(filename);
+#endif
 		goto got_file;														//don't look in libs, etc.
 	}
 
@@ -789,7 +1163,14 @@ CFILE *cfopen(const char * filename, const char * mode)
 	{
 		if (! strnicmp(extensions[i].ext,ext+1,_MAX_EXT)) //found ext
 		{
+#ifdef __LINUX__
+			//The index knows what's in the search paths, so we only go to the disk for a file
+			//that's there, and we already have the case it's stored with.  A miss doesn't
+			//touch the disk at all.
+			cfile = open_file_in_search_path(filename,mode,extensions[i].pathnum);
+#else
 			cfile = open_file_in_directory(filename,mode,paths[extensions[i].pathnum].path);
+#endif
 			if (cfile)// || (errno != ENOENT)) //Tempoary fix so Kevin can run the game!
 				goto got_file;
 		}
@@ -799,7 +1180,11 @@ CFILE *cfopen(const char * filename, const char * mode)
 	{
 		if (!paths[i].specific) 
 		{
+#ifdef __LINUX__
+			cfile = open_file_in_search_path(filename,mode,i);
+#else
 			cfile = open_file_in_directory(filename,mode,paths[i].path);
+#endif
 			if (cfile)// || (errno != ENOENT)) //Tempoary fix so Kevin can run the game!
 				goto got_file;
 		}
@@ -829,6 +1214,8 @@ int cfilelength( CFILE *cfp )
 //Parameters:  cfile - the file pointer returned by cfopen()
 void cfclose( CFILE * cfp )
 {
+	std::lock_guard<std::mutex> lock(Cfile_open_lock);
+
 	//Either give the file back to the library, or close it
 	if (cfp->lib_handle != -1) {
 		library *lib;
@@ -849,6 +1236,9 @@ void cfclose( CFILE * cfp )
 	//If the file handle wasn't given back to library, close the file
 	if (cfp->file) 
 		fclose(cfp->file);
+	//let go of the library image
+	if (cfp->map)
+		ReleaseLibraryMap(cfp->map);
 	//free the name, if allocated
 	if (!cfp->lib_offset)
 		mem_free(cfp->name);
@@ -863,6 +1253,21 @@ int cfgetc( CFILE * cfp )
 	int c;
 	static unsigned char ch[3] = "\0\0";
 	if (cfp->position >= cfp->size ) return EOF;
+
+	//Mapped files read straight out of the library image
+	if (cfp->map)
+	{
+		const ubyte *data = cfp->map->data + cfp->lib_offset;
+		c = data[cfp->position++];
+		if ((cfp->flags & CF_TEXT) && (c == 13 || c == 10))
+		{
+			//swallow the LF of a CR/LF pair
+			if (c == 13 && cfp->position < cfp->size && data[cfp->position] == 10)
+				cfp->position++;
+			c = '\n';
+		}
+		return c;
+	}
 	
 	fread(ch,sizeof(char),1,cfp->file);
 	c = ch[0];
@@ -917,6 +1322,13 @@ int cfseek( CFILE *cfp, long int offset, int where )
 		default:
 			return 1;
 	}	
+	if (cfp->map)
+	{
+		if (goal_position < 0)
+			return 1;
+		cfp->position = goal_position;
+		return 0;
+	}
 	c = fseek( cfp->file, cfp->lib_offset + goal_position, SEEK_SET );
 	cfp->position = ftell(cfp->file) - cfp->lib_offset;
 	return c;
@@ -941,6 +1353,20 @@ int cfexist( const char * filename )
 {
 	CFILE *cfp;
 	int ret;
+
+#ifdef __LINUX__
+	//If there's no path, the index can tell us without opening anything
+	char path[_MAX_PATH*2], fname[_MAX_PATH*2], ext[_MAX_EXT];
+	ddio_SplitPath(filename, path, fname, ext);
+	if (!strlen(path))
+	{
+		//The first look in a search path reads its directory, so keep out of the way of cfopen()
+		std::lock_guard<std::mutex> lock(Cfile_open_lock);
+		if (FindInSearchPaths(filename,ext) != -1)
+			return CF_ON_DISK;
+		return IndexFindInLibraries(filename,NULL) ? CF_IN_LIBRARY : CF_NOT_FOUND;
+	}
+#endif
 	
 	cfp = cfopen(filename,"rb");
 	if (!cfp) {							//Didn't get file.  Why?
@@ -955,6 +1381,24 @@ int cfexist( const char * filename )
 	return ret;
 }
 
+//Returns a pointer to the next count bytes of the file and advances the position past them.
+//Returns NULL, without moving, if the file isn't read from a mapped library.
+//Throws an exception of type (cfile_error *) if there are fewer than count bytes left
+const ubyte *cf_GetDataPointer(CFILE *cfp, int count)
+{
+	const ubyte *data;
+	if (!cfp->map)
+		return NULL;
+	if (cfp->position + count > cfp->size)
+	{
+		mprintf((1,"Error getting %d bytes from position %d of file <%s>.",count,cfp->position,cfp->name));
+		ThrowCFileError(CFE_READING,cfp,eof_error);
+	}
+	data = cfp->map->data + cfp->lib_offset + cfp->position;
+	cfp->position += count;
+	return data;
+}
+
 //Reads the specified number of bytes from a file into the buffer
 //DO NOT USE THIS TO READ STRUCTURES.  This function is for byte
 //data, such as a string or a bitmap of 8-bit pixels.
@@ -965,6 +1409,11 @@ int cf_ReadBytes(ubyte *buf, int count, CFILE *cfp)
 	int i;
 	char *error_msg = eof_error;		//default error
 	ASSERT(! (cfp->flags & CF_TEXT));
+	if (cfp->map && (cfp->position + count <= cfp->size)) {
+		memcpy(buf, cfp->map->data + cfp->lib_offset + cfp->position, count);
+		cfp->position += count;
+		return count;
+	}
 	if (cfp->position + count <= cfp->size) {
 		i = fread ( buf, 1, count, cfp->file );
 		if (i == count) {
@@ -1287,7 +1736,11 @@ void cf_ChangeFileAttributes (const char *name,int attr)
 //	rewinds cfile position
 void cf_Rewind(CFILE *fp)
 {
-	if (fp->lib_offset) 
+	if (fp->map)
+	{
+		//mapped files have nothing to seek
+	}
+	else if (fp->lib_offset) 
 	{
 		int r = fseek(fp->file,fp->lib_offset,SEEK_SET);
 		ASSERT(r==0);
@@ -1334,6 +1787,17 @@ unsigned int cf_CalculateFileCRC (CFILE *infile)
 	}
 
 	crc = 0xffffffffl;
+
+	//Mapped files can be checksummed in place
+	int maplen = infile->size - infile->position;
+	const ubyte *data = cf_GetDataPointer(infile, maplen);
+	if (data)
+	{
+		for (int a = 0; a < maplen; a++)
+			crc = ((crc>>8)&0x00FFFFFFL) ^ CRCTable[((int)crc^data[a])&0xff];
+		return crc^0xffffffffl;
+	}
+
 	while (!cfeof(infile))
 	{
 		if((infile->size - infile->position)<CRC_BUFFER_SIZE)
@@ -1468,59 +1932,31 @@ void cf_LibraryFindClose(void)
 // returns hog cfile info, using a library handle opened via cf_OpenLibrary.
 bool cf_ReadHogFileEntry(int libr, const char *filename, tHogFileEntry *entry, int *fileoffset)
 {
-	//searches through the open HOG files, and opens a file if it finds it in any of the libs
-	library *lib;
-
-	lib = Libraries;
+	//searches through the open HOG files, or just the one asked for
+	library *lib = NULL;
 
-	while (lib) 
+	if (libr != -1)
 	{
-		int i;
-
-		if (lib->handle == libr || libr == -1) 
+		for (lib = Libraries; lib; lib = lib->next)
 		{
-			//Do binary search for the file
-			int first = 0, last = lib->nfiles-1, c,found=0;
-			do 
-			{
-				i = (first + last) / 2;
-				c = stricmp(filename,lib->entries[i].name);	//compare to current
-		
-				if (c == 0) //found it
-				{
-					found = 1;
-					break;
-				}
-
-				if (first >= last)	//exhausted search
-					break;
-
-				if (c > 0)				//search key after check key
-					first = i+1;
-				else						//search key before check key
-					last = i-1;
-
-			} while (1);
-	
-			if (found) 
-			{
-				strcpy(entry->name, lib->entries[i].name);
-				entry->len = lib->entries[i].length;
-				entry->flags = lib->entries[i].flags;
-				entry->timestamp = lib->entries[i].timestamp;
-				*fileoffset = lib->entries[i].offset;
-				return true;
-			}
-			else if (lib->handle == libr) 
-			{
+			if (lib->handle == libr)
 				break;
-			}
 		}
-
-		lib = lib->next;
+		if (!lib)
+			return false;
 	}
 
-	return false;
+	index_node *node = IndexFindInLibraries(filename,lib);
+	if (!node)
+		return false;
+
+	library_entry *le = &node->lib->entries[node->entry];
+	strcpy(entry->name, le->name);
+	entry->len = le->length;
+	entry->flags = le->flags;
+	entry->timestamp = le->timestamp;
+	*fileoffset = le->offset;
+	return true;
 }
 
 
@@ -15,6 +15,7 @@
 * You should have received a copy of the GNU General Public License
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <chrono>
 #include <memory.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -22,20 +23,40 @@
 #include "ssl_lib.h"
 #include "mixer.h"
 #include "pserror.h"
+#include "args.h"
+#include "cpufeatures.h"
 
 #define MIN_SOUND_MIX_VOLUME    0.0f
 #define MAX_WRITE_AHEAD         0.04f // Seconds to write ahead of the play position (in seconds)
 #define VOLUME_FIX_BITS			1024
 
-inline void	opti_8m_mix(unsigned char *cur_sample_8bit, const int num_write, int &samples_played, short *mixer_buffer16, const float l_volume, const float r_volume);
-inline void	opti_8s_mix(unsigned char *cur_sample_8bit, const int num_write, int &samples_played, short *mixer_buffer16, const float l_volume, const float r_volume);
-inline void	opti_16m_mix(short *cur_sample_16bit, const int num_write, int &samples_played, short *mixer_buffer16, const float l_volume, const float r_volume);
-inline void	opti_16s_mix(short *cur_sample_16bit, const int num_write, int &samples_played, short *mixer_buffer16, const float l_volume, const float r_volume);
+// Adds num_write frames of a sound into the 32 bit stereo accumulator, ramping the
+// volume by l_step/r_step each frame
+typedef void (*mix_func)(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step);
+
+// A set of mixing kernels for one instruction set
+typedef struct
+{
+	const char *name;
+	mix_func mix_8m;
+	mix_func mix_8s;
+	mix_func mix_16m;
+	mix_func mix_16s;
+	void (*pack)(const int *acc, short *dest, int count);
+} mix_kernels;
+
+static mix_kernels *GetMixKernels(bool f_avx2);
+static void BenchmarkMixer(void);
+
+// The kernels picked for this cpu
+static mix_kernels *Mix = NULL;
 
 software_mixer::software_mixer()
 {
 	m_init = false;
 	m_buffer = NULL;
+	Fast_mixer = NULL;
+	Fast_mixer_len = 0;
 }
 
 software_mixer::~software_mixer()
@@ -44,6 +65,11 @@ software_mixer::~software_mixer()
 	{
 		free(m_buffer);
 	}
+
+	if(Fast_mixer)
+	{
+		free(Fast_mixer);
+	}
 }
 
 bool software_mixer::Initialize(tMixerInit *mi)
@@ -87,6 +113,12 @@ bool software_mixer::Initialize(tMixerInit *mi)
 		m_buffer = (unsigned char *)malloc(m_BufferSize);
 	}
 
+	Mix = GetMixKernels(true);
+	mprintf((0,"Mixer: Using %s kernels\n",Mix->name));
+
+	if(FindArg("-mixbench"))
+		BenchmarkMixer();
+
 	return true;
 }
 
@@ -107,7 +139,7 @@ void software_mixer::DoFrame(void)
 void software_mixer::StreamMixer(char *ptr, int len)
 {
 	int i;
-	short *mixer_buffer16 = (short *) ptr;
+	int *mix_acc;
 	int current_slot = 0;
 	bool f_loop;
 	bool f_mono;
@@ -132,14 +164,24 @@ void software_mixer::StreamMixer(char *ptr, int len)
 		return;
 	}
 	
-	memset((char *)ptr, 0, len);
+	// Everything is summed at 32 bits and clamped once at the end
+	if(Fast_mixer_len < buff_len * 2)
+	{
+		if(Fast_mixer)
+			free(Fast_mixer);
+
+		Fast_mixer_len = buff_len * 2;
+		Fast_mixer = (int *)malloc(Fast_mixer_len * sizeof(int));
+	}
+
+	memset(Fast_mixer, 0, buff_len * 2 * sizeof(int));
 
 	// Mix the sound slots
 	while(current_slot < (*m_max_sounds_available) )
 	{
 		sound_buffer_info *cur_buf = &m_sound_cache[current_slot];
 		int num_samples = buff_len;
-		mixer_buffer16 = (short *) ptr;
+		mix_acc = Fast_mixer;
 		f_mono = true;
 
 		// Find slots with sounds in them
@@ -147,6 +189,24 @@ void software_mixer::StreamMixer(char *ptr, int len)
 		{
 			float l_volume = cur_buf->play_info->left_volume;
 			float r_volume = cur_buf->play_info->right_volume;
+
+			// Ramp from the volume we mixed at last time to avoid clicks when it changes.
+			// A new sound starts straight at its volume.
+			if(cur_buf->m_mix_unique_id != cur_buf->m_unique_id)
+			{
+				cur_buf->m_mix_unique_id = cur_buf->m_unique_id;
+				cur_buf->m_mix_l_volume = l_volume;
+				cur_buf->m_mix_r_volume = r_volume;
+			}
+
+			const float l_start_volume = cur_buf->m_mix_l_volume;
+			const float r_start_volume = cur_buf->m_mix_r_volume;
+			const float l_step = (l_volume - l_start_volume) / buff_len;
+			const float r_step = (r_volume - r_start_volume) / buff_len;
+			float l_mix_volume, r_mix_volume;
+
+			cur_buf->m_mix_l_volume = l_volume;
+			cur_buf->m_mix_r_volume = r_volume;
 			int skip_interval = cur_buf->play_info->sample_skip_interval;
 			int samples_played = cur_buf->play_info->m_samples_played;
 			short *sample_16bit;
@@ -243,7 +303,7 @@ void software_mixer::StreamMixer(char *ptr, int len)
 					num_samples -= num_write;
 					ASSERT(num_samples > 0);
 
-					mixer_buffer16 += num_write << 1;  // update to the new start position 
+					mix_acc += num_write << 1;  // update to the new start position 
 					                                   // (2x because of left and right channels)
 					samples_played = loop_start;
 				}
@@ -296,7 +356,8 @@ void software_mixer::StreamMixer(char *ptr, int len)
 				}
 
 				// Optimization for silent sounds  
-				if(l_volume <= MIN_SOUND_MIX_VOLUME && r_volume <= MIN_SOUND_MIX_VOLUME)
+				if(l_volume <= MIN_SOUND_MIX_VOLUME && r_volume <= MIN_SOUND_MIX_VOLUME &&
+					l_start_volume <= MIN_SOUND_MIX_VOLUME && r_start_volume <= MIN_SOUND_MIX_VOLUME)
 				{
 					cur_buf->play_info->m_samples_played += num_write;
 					goto done;
@@ -310,38 +371,29 @@ void software_mixer::StreamMixer(char *ptr, int len)
 				goto done;
 			}
 
+			// Where the volume ramp is at for the first frame of this piece
+			l_mix_volume = l_start_volume + l_step * (float)((mix_acc - Fast_mixer) >> 1);
+			r_mix_volume = r_start_volume + r_step * (float)((mix_acc - Fast_mixer) >> 1);
+
 			// Mix at 16 bits per sample 
 			if(skip_interval == 0)
 			{
-				short *cur_sample_16bit = sample_16bit;
-				unsigned char *cur_sample_8bit = sample_8bit;
-
 				if(f_mono)
 				{
 					if(sample_8bit)
-					{
-						cur_sample_8bit += samples_played;
-						opti_8m_mix(cur_sample_8bit, num_write, samples_played, mixer_buffer16, l_volume, r_volume);
-					}
+						(*Mix->mix_8m)(sample_8bit + samples_played, num_write, mix_acc, l_mix_volume, r_mix_volume, l_step, r_step);
 					else
-					{
-						cur_sample_16bit += samples_played;
-						opti_16m_mix(cur_sample_16bit, num_write, samples_played, mixer_buffer16, l_volume, r_volume);
-					}
+						(*Mix->mix_16m)(sample_16bit + samples_played, num_write, mix_acc, l_mix_volume, r_mix_volume, l_step, r_step);
 				}
 				else
 				{
 					if(sample_8bit)
-					{
-						cur_sample_8bit += (samples_played<<1);
-						opti_8s_mix(cur_sample_8bit, num_write, samples_played, mixer_buffer16, l_volume, r_volume);
-					}
+						(*Mix->mix_8s)(sample_8bit + (samples_played<<1), num_write, mix_acc, l_mix_volume, r_mix_volume, l_step, r_step);
 					else
-					{
-						cur_sample_16bit += (samples_played<<1);
-						opti_16s_mix(cur_sample_16bit, num_write, samples_played, mixer_buffer16, l_volume, r_volume);
-					}
+						(*Mix->mix_16s)(sample_16bit + (samples_played<<1), num_write, mix_acc, l_mix_volume, r_mix_volume, l_step, r_step);
 				}
+
+				samples_played += num_write;
 			}
 			else
 			// Account for lower-sampling rate
@@ -378,16 +430,8 @@ void software_mixer::StreamMixer(char *ptr, int len)
 
 						ASSERT(i >= 0 && (i + 1 < num_samples * 2));
 
-						int l_sample = mixer_buffer16[i] + (sample * l_volume);
-						int r_sample =	mixer_buffer16[i + 1] + (sample * r_volume);
-
-						if(l_sample < -32767) l_sample = -32767;
-						if(l_sample > 32767) l_sample = 32767;
-						if(r_sample < -32767) r_sample = -32767;
-						if(r_sample > 32767) r_sample = 32767;
-
-						mixer_buffer16[i] = (short)l_sample;
-						mixer_buffer16[i + 1] = (short)r_sample;
+						mix_acc[i] += (int)(sample * (l_mix_volume + l_step * (float)(i >> 1)));
+						mix_acc[i + 1] += (int)(sample * (r_mix_volume + r_step * (float)(i >> 1)));
 					}
 				}
 				else
@@ -444,16 +488,8 @@ void software_mixer::StreamMixer(char *ptr, int len)
 
 						ASSERT(i >= 0 && (i + 1 < num_samples * 2));
 
-						int l_sample = mixer_buffer16[i] + (sample * l_volume);
-						int r_sample =	mixer_buffer16[i + 1] + (sample * r_volume);
-
-						if(l_sample < -32767) l_sample = -32767;
-						if(l_sample > 32767) l_sample = 32767;
-						if(r_sample < -32767) r_sample = -32767;
-						if(r_sample > 32767) r_sample = 32767;
-
-						mixer_buffer16[i] = (short)l_sample;
-						mixer_buffer16[i + 1] = (short)r_sample;
+						mix_acc[i] += (int)(sample * (l_mix_volume + l_step * (float)(i >> 1)));
+						mix_acc[i + 1] += (int)(sample * (r_mix_volume + r_step * (float)(i >> 1)));
 					}
 				}
 			}
@@ -529,134 +565,440 @@ stream_done:
 	error_bail:
 		current_slot++;
 	}
+
+	(*Mix->pack)(Fast_mixer, (short *)ptr, buff_len * 2);
+}
+
+// ---------------------------------------------------------------------------
+// Mixing kernels
+//
+// Each kernel adds num_write frames of a sound into the 32 bit stereo accumulator.
+// The volume for frame k is volume + step * k, so a slot's volume can be ramped
+// across the buffer.  The SIMD kernels do the same float math in the same order
+// as the scalar ones, so they only differ where the x87 keeps extra precision.
+// ---------------------------------------------------------------------------
+
+#define MIX_8BIT_SAMPLE(x)	((((int)(x)) - 128) << 8)
+
+static void mix_8m_range(const unsigned char *src, int start, int end, int *acc, const float l_volume, const float r_volume, const float l_step, const float r_step)
+{
+	for(int k = start; k < end; k++)
+	{
+		const float sample = (float)MIX_8BIT_SAMPLE(src[k]);
+
+		acc[k * 2] += (int)(sample * (l_volume + l_step * (float)k));
+		acc[k * 2 + 1] += (int)(sample * (r_volume + r_step * (float)k));
+	}
 }
 
-inline void	opti_8m_mix(unsigned char *cur_sample_8bit, const int num_write, int &samples_played, short *mixer_buffer16, const float l_volume, const float r_volume)
+static void mix_8s_range(const unsigned char *src, int start, int end, int *acc, const float l_volume, const float r_volume, const float l_step, const float r_step)
 {
-	int i;
-	short *mb = mixer_buffer16;
+	for(int k = start; k < end; k++)
+	{
+		acc[k * 2] += (int)((float)MIX_8BIT_SAMPLE(src[k * 2]) * (l_volume + l_step * (float)k));
+		acc[k * 2 + 1] += (int)((float)MIX_8BIT_SAMPLE(src[k * 2 + 1]) * (r_volume + r_step * (float)k));
+	}
+}
 
-	for(i = 0; i < (num_write << 1); i += 2)
+static void mix_16m_range(const short *src, int start, int end, int *acc, const float l_volume, const float r_volume, const float l_step, const float r_step)
+{
+	for(int k = start; k < end; k++)
 	{
-		short sample; 
-		int l_sample;
-		int r_sample;
+		const float sample = (float)src[k];
 
-		sample = (((short)(*cur_sample_8bit)) - (short)128) << 8;
-		cur_sample_8bit++;
+		acc[k * 2] += (int)(sample * (l_volume + l_step * (float)k));
+		acc[k * 2 + 1] += (int)(sample * (r_volume + r_step * (float)k));
+	}
+}
 
-		l_sample = *mb + (sample * l_volume);
-		r_sample =	*(mb + 1) + (sample * r_volume);
+static void mix_16s_range(const short *src, int start, int end, int *acc, const float l_volume, const float r_volume, const float l_step, const float r_step)
+{
+	for(int k = start; k < end; k++)
+	{
+		acc[k * 2] += (int)((float)src[k * 2] * (l_volume + l_step * (float)k));
+		acc[k * 2 + 1] += (int)((float)src[k * 2 + 1] * (r_volume + r_step * (float)k));
+	}
+}
 
-		samples_played++;
+static void mix_8m_scalar(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	mix_8m_range((const unsigned char *)src, 0, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
 
-		if(l_sample < -32767) l_sample = -32767;
-		if(l_sample > 32767) l_sample = 32767;
-		if(r_sample < -32767) r_sample = -32767;
-		if(r_sample > 32767) r_sample = 32767;
+static void mix_8s_scalar(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	mix_8s_range((const unsigned char *)src, 0, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
 
-		*mb = (short)l_sample;
-		mb++;
-		*mb = (short)r_sample;
-		mb++;
+static void mix_16m_scalar(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	mix_16m_range((const short *)src, 0, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
+
+static void mix_16s_scalar(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	mix_16s_range((const short *)src, 0, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
+
+// Clamps the accumulator down to 16 bit samples
+static void mix_pack_scalar(const int *acc, short *dest, int count)
+{
+	for(int i = 0; i < count; i++)
+	{
+		int sample = acc[i];
+
+		if(sample < -32767) sample = -32767;
+		if(sample > 32767) sample = 32767;
+
+		dest[i] = (short)sample;
 	}
 }
 
-inline void	opti_8s_mix(unsigned char *cur_sample_8bit, const int num_write, int &samples_played, short *mixer_buffer16, const float l_volume, const float r_volume)
+#ifdef CPU_SIMD
+
+// Mixes two frames of interleaved samples (l0 r0 l1 r1) starting at frame k
+CPU_TARGET("sse2") static inline void sse2_mix2(int *acc, __m128 samples, __m128 frame, const __m128 &volume, const __m128 &step)
 {
-	int i;
-	short *mb = mixer_buffer16;
+	__m128 vol = _mm_add_ps(volume, _mm_mul_ps(step, frame));
+	__m128i mixed = _mm_cvttps_epi32(_mm_mul_ps(samples, vol));
+
+	_mm_storeu_si128((__m128i *)acc, _mm_add_epi32(_mm_loadu_si128((const __m128i *)acc), mixed));
+}
+
+// Turns 4 mono samples into two interleaved pairs of frames and mixes them
+CPU_TARGET("sse2") static inline void sse2_mix4_mono(int *acc, __m128i samples, int k, const __m128 &volume, const __m128 &step)
+{
+	__m128 s = _mm_cvtepi32_ps(samples);
+	__m128 frame_lo = _mm_set_ps((float)(k + 1), (float)(k + 1), (float)k, (float)k);
+	__m128 frame_hi = _mm_add_ps(frame_lo, _mm_set1_ps(2.0f));
+
+	sse2_mix2(acc, _mm_unpacklo_ps(s, s), frame_lo, volume, step);
+	sse2_mix2(acc + 4, _mm_unpackhi_ps(s, s), frame_hi, volume, step);
+}
+
+// Mixes 4 stereo frames, given as two interleaved pairs
+CPU_TARGET("sse2") static inline void sse2_mix4_stereo(int *acc, __m128i lo, __m128i hi, int k, const __m128 &volume, const __m128 &step)
+{
+	__m128 frame_lo = _mm_set_ps((float)(k + 1), (float)(k + 1), (float)k, (float)k);
+	__m128 frame_hi = _mm_add_ps(frame_lo, _mm_set1_ps(2.0f));
+
+	sse2_mix2(acc, _mm_cvtepi32_ps(lo), frame_lo, volume, step);
+	sse2_mix2(acc + 4, _mm_cvtepi32_ps(hi), frame_hi, volume, step);
+}
 
-	for(i = 0; i < (num_write << 1); i += 2)
+// Widens 4 unsigned 8 bit samples to signed 16 bit range ints
+CPU_TARGET("sse2") static inline __m128i sse2_widen_8bit(__m128i bytes)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i words = _mm_unpacklo_epi8(bytes, zero);
+	__m128i ints = _mm_unpacklo_epi16(words, zero);
+
+	return _mm_slli_epi32(_mm_sub_epi32(ints, _mm_set1_epi32(128)), 8);
+}
+
+CPU_TARGET("sse2") static void mix_8m_sse2(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	const unsigned char *s = (const unsigned char *)src;
+	const __m128 volume = _mm_set_ps(r_volume, l_volume, r_volume, l_volume);
+	const __m128 step = _mm_set_ps(r_step, l_step, r_step, l_step);
+	int k;
+
+	for(k = 0; k + 4 <= num_write; k += 4)
 	{
-		short lsample; 
-		short rsample;
-		int l_sample;
-		int r_sample;
-
-		lsample = (((short)(*cur_sample_8bit)) - (short)128) << 8;
-		cur_sample_8bit++;
-		rsample = (((short)(*cur_sample_8bit)) - (short)128) << 8;
-		cur_sample_8bit++;
-		
-		l_sample = *mb + (lsample * l_volume);
-		r_sample =	*(mb + 1) + (rsample * r_volume);
+		int bytes;
+		memcpy(&bytes, s + k, 4);
+		sse2_mix4_mono(acc + k * 2, sse2_widen_8bit(_mm_cvtsi32_si128(bytes)), k, volume, step);
+	}
+
+	mix_8m_range(s, k, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
+
+CPU_TARGET("sse2") static void mix_8s_sse2(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	const unsigned char *s = (const unsigned char *)src;
+	const __m128 volume = _mm_set_ps(r_volume, l_volume, r_volume, l_volume);
+	const __m128 step = _mm_set_ps(r_step, l_step, r_step, l_step);
+	int k;
+
+	for(k = 0; k + 4 <= num_write; k += 4)
+	{
+		__m128i bytes = _mm_loadl_epi64((const __m128i *)(s + k * 2));
+
+		sse2_mix4_stereo(acc + k * 2, sse2_widen_8bit(bytes), sse2_widen_8bit(_mm_srli_si128(bytes, 4)), k, volume, step);
+	}
+
+	mix_8s_range(s, k, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
 
-		samples_played++;
+CPU_TARGET("sse2") static void mix_16m_sse2(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	const short *s = (const short *)src;
+	const __m128 volume = _mm_set_ps(r_volume, l_volume, r_volume, l_volume);
+	const __m128 step = _mm_set_ps(r_step, l_step, r_step, l_step);
+	int k;
 
-		if(l_sample < -32767) l_sample = -32767;
-		if(l_sample > 32767) l_sample = 32767;
-		if(r_sample < -32767) r_sample = -32767;
-		if(r_sample > 32767) r_sample = 32767;
+	for(k = 0; k + 4 <= num_write; k += 4)
+	{
+		__m128i words = _mm_loadl_epi64((const __m128i *)(s + k));
 
-		*mb = (short)l_sample;
-		mb++;
-		*mb = (short)r_sample;
-		mb++;
+		// Sign extend to 32 bits
+		sse2_mix4_mono(acc + k * 2, _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16), k, volume, step);
 	}
+
+	mix_16m_range(s, k, num_write, acc, l_volume, r_volume, l_step, r_step);
 }
 
-inline void	opti_16m_mix(short *cur_sample_16bit, const int num_write, int &samples_played, short *mixer_buffer16, const float l_volume, const float r_volume)
+CPU_TARGET("sse2") static void mix_16s_sse2(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
 {
+	const short *s = (const short *)src;
+	const __m128 volume = _mm_set_ps(r_volume, l_volume, r_volume, l_volume);
+	const __m128 step = _mm_set_ps(r_step, l_step, r_step, l_step);
+	int k;
+
+	for(k = 0; k + 4 <= num_write; k += 4)
+	{
+		__m128i words = _mm_loadu_si128((const __m128i *)(s + k * 2));
+
+		sse2_mix4_stereo(acc + k * 2, _mm_srai_epi32(_mm_unpacklo_epi16(words, words), 16), _mm_srai_epi32(_mm_unpackhi_epi16(words, words), 16), k, volume, step);
+	}
+
+	mix_16s_range(s, k, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
+
+CPU_TARGET("sse2") static void mix_pack_sse2(const int *acc, short *dest, int count)
+{
+	const __m128i floor = _mm_set1_epi16(-32767);
 	int i;
-	short *mb = mixer_buffer16;
 
-	for(i = 0; i < (num_write << 1); i += 2)
+	for(i = 0; i + 8 <= count; i += 8)
 	{
-		short sample; 
-		int l_sample;
-		int r_sample;
+		__m128i lo = _mm_loadu_si128((const __m128i *)(acc + i));
+		__m128i hi = _mm_loadu_si128((const __m128i *)(acc + i + 4));
+
+		_mm_storeu_si128((__m128i *)(dest + i), _mm_max_epi16(_mm_packs_epi32(lo, hi), floor));
+	}
+
+	mix_pack_scalar(acc + i, dest + i, count - i);
+}
+
+// Mixes four frames of interleaved samples (l0 r0 .. l3 r3) starting at frame k
+CPU_TARGET("avx2") static inline void avx2_mix4(int *acc, __m256 samples, int k, const __m256 &volume, const __m256 &step)
+{
+	__m256 frame = _mm256_add_ps(_mm256_set1_ps((float)k), _mm256_set_ps(3.0f, 3.0f, 2.0f, 2.0f, 1.0f, 1.0f, 0.0f, 0.0f));
+	__m256 vol = _mm256_add_ps(volume, _mm256_mul_ps(step, frame));
+	__m256i mixed = _mm256_cvttps_epi32(_mm256_mul_ps(samples, vol));
+
+	_mm256_storeu_si256((__m256i *)acc, _mm256_add_epi32(_mm256_loadu_si256((const __m256i *)acc), mixed));
+}
+
+// Turns 8 mono samples into two sets of four interleaved frames and mixes them
+CPU_TARGET("avx2") static inline void avx2_mix8_mono(int *acc, __m256i samples, int k, const __m256 &volume, const __m256 &step)
+{
+	__m256 s = _mm256_cvtepi32_ps(samples);
+
+	avx2_mix4(acc, _mm256_permutevar8x32_ps(s, _mm256_set_epi32(3, 3, 2, 2, 1, 1, 0, 0)), k, volume, step);
+	avx2_mix4(acc + 8, _mm256_permutevar8x32_ps(s, _mm256_set_epi32(7, 7, 6, 6, 5, 5, 4, 4)), k + 4, volume, step);
+}
+
+// Widens 8 unsigned 8 bit samples to signed 16 bit range ints
+CPU_TARGET("avx2") static inline __m256i avx2_widen_8bit(__m128i bytes)
+{
+	return _mm256_slli_epi32(_mm256_sub_epi32(_mm256_cvtepu8_epi32(bytes), _mm256_set1_epi32(128)), 8);
+}
+
+CPU_TARGET("avx2") static void mix_8m_avx2(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	const unsigned char *s = (const unsigned char *)src;
+	const __m256 volume = _mm256_set_ps(r_volume, l_volume, r_volume, l_volume, r_volume, l_volume, r_volume, l_volume);
+	const __m256 step = _mm256_set_ps(r_step, l_step, r_step, l_step, r_step, l_step, r_step, l_step);
+	int k;
+
+	for(k = 0; k + 8 <= num_write; k += 8)
+		avx2_mix8_mono(acc + k * 2, avx2_widen_8bit(_mm_loadl_epi64((const __m128i *)(s + k))), k, volume, step);
+
+	mix_8m_range(s, k, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
+
+CPU_TARGET("avx2") static void mix_8s_avx2(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	const unsigned char *s = (const unsigned char *)src;
+	const __m256 volume = _mm256_set_ps(r_volume, l_volume, r_volume, l_volume, r_volume, l_volume, r_volume, l_volume);
+	const __m256 step = _mm256_set_ps(r_step, l_step, r_step, l_step, r_step, l_step, r_step, l_step);
+	int k;
+
+	for(k = 0; k + 8 <= num_write; k += 8)
+	{
+		__m128i bytes = _mm_loadu_si128((const __m128i *)(s + k * 2));
+
+		avx2_mix4(acc + k * 2, _mm256_cvtepi32_ps(avx2_widen_8bit(bytes)), k, volume, step);
+		avx2_mix4(acc + k * 2 + 8, _mm256_cvtepi32_ps(avx2_widen_8bit(_mm_srli_si128(bytes, 8))), k + 4, volume, step);
+	}
+
+	mix_8s_range(s, k, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
+
+CPU_TARGET("avx2") static void mix_16m_avx2(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	const short *s = (const short *)src;
+	const __m256 volume = _mm256_set_ps(r_volume, l_volume, r_volume, l_volume, r_volume, l_volume, r_volume, l_volume);
+	const __m256 step = _mm256_set_ps(r_step, l_step, r_step, l_step, r_step, l_step, r_step, l_step);
+	int k;
 
-		sample = *cur_sample_16bit;
-		cur_sample_16bit++;
+	for(k = 0; k + 8 <= num_write; k += 8)
+		avx2_mix8_mono(acc + k * 2, _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i *)(s + k))), k, volume, step);
 
-		l_sample = *mb + (sample * l_volume);
-		r_sample =	*(mb + 1) + (sample * r_volume);
+	mix_16m_range(s, k, num_write, acc, l_volume, r_volume, l_step, r_step);
+}
 
-		samples_played++;
+CPU_TARGET("avx2") static void mix_16s_avx2(const void *src, int num_write, int *acc, float l_volume, float r_volume, float l_step, float r_step)
+{
+	const short *s = (const short *)src;
+	const __m256 volume = _mm256_set_ps(r_volume, l_volume, r_volume, l_volume, r_volume, l_volume, r_volume, l_volume);
+	const __m256 step = _mm256_set_ps(r_step, l_step, r_step, l_step, r_step, l_step, r_step, l_step);
+	int k;
 
-		if(l_sample < -32767) l_sample = -32767;
-		if(l_sample > 32767) l_sample = 32767;
-		if(r_sample < -32767) r_sample = -32767;
-		if(r_sample > 32767) r_sample = 32767;
+	for(k = 0; k + 8 <= num_write; k += 8)
+	{
+		__m256i words = _mm256_loadu_si256((const __m256i *)(s + k * 2));
 
-		*mb = (short)l_sample;
-		mb++;
-		*mb = (short)r_sample;
-		mb++;
+		avx2_mix4(acc + k * 2, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_castsi256_si128(words))), k, volume, step);
+		avx2_mix4(acc + k * 2 + 8, _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(_mm256_extracti128_si256(words, 1))), k + 4, volume, step);
 	}
+
+	mix_16s_range(s, k, num_write, acc, l_volume, r_volume, l_step, r_step);
 }
 
-inline void	opti_16s_mix(short *cur_sample_16bit, const int num_write, int &samples_played, short *mixer_buffer16, const float l_volume, const float r_volume)
+CPU_TARGET("avx2") static void mix_pack_avx2(const int *acc, short *dest, int count)
 {
+	const __m256i floor = _mm256_set1_epi16(-32767);
 	int i;
-	short *mb = mixer_buffer16;
 
-	for(i = 0; i < (num_write << 1); i += 2)
+	for(i = 0; i + 16 <= count; i += 16)
 	{
-		short lsample; 
-		short rsample;
-		int l_sample;
-		int r_sample;
-
-		lsample = *cur_sample_16bit;
-		cur_sample_16bit++;
-		rsample = *cur_sample_16bit;
-		cur_sample_16bit++;
-		
-		l_sample = *mb + (lsample * l_volume);
-		r_sample =	*(mb + 1) + (rsample * r_volume);
+		__m256i lo = _mm256_loadu_si256((const __m256i *)(acc + i));
+		__m256i hi = _mm256_loadu_si256((const __m256i *)(acc + i + 8));
+
+		// packs works within each 128 bit lane, so put the lanes back in order afterwards
+		__m256i packed = _mm256_permute4x64_epi64(_mm256_packs_epi32(lo, hi), 0xd8);
 
-		samples_played++;
+		_mm256_storeu_si256((__m256i *)(dest + i), _mm256_max_epi16(packed, floor));
+	}
+
+	mix_pack_scalar(acc + i, dest + i, count - i);
+}
+
+#endif	// CPU_SIMD
+
+static mix_kernels Mix_scalar = {"scalar", mix_8m_scalar, mix_8s_scalar, mix_16m_scalar, mix_16s_scalar, mix_pack_scalar};
+#ifdef CPU_SIMD
+static mix_kernels Mix_sse2 = {"SSE2", mix_8m_sse2, mix_8s_sse2, mix_16m_sse2, mix_16s_sse2, mix_pack_sse2};
+static mix_kernels Mix_avx2 = {"AVX2", mix_8m_avx2, mix_8s_avx2, mix_16m_avx2, mix_16s_avx2, mix_pack_avx2};
+#endif
+
+// Returns the best set of kernels this cpu can run
+static mix_kernels *GetMixKernels(bool f_avx2)
+{
+#ifdef CPU_SIMD
+	if(f_avx2 && cpu_HaveAVX2())
+		return &Mix_avx2;
+	if(cpu_HaveSSE2())
+		return &Mix_sse2;
+#endif
+	return &Mix_scalar;
+}
+
+// Mixes voices through a set of kernels for a while, and returns samples mixed per second
+static double BenchmarkMixKernels(mix_kernels *kernels, int num_voices, const short *data16, const unsigned char *data8, int *acc, short *dest, int frames)
+{
+	const int num_passes = 200;
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	for(int pass = 0; pass < num_passes; pass++)
+	{
+		memset(acc, 0, frames * 2 * sizeof(int));
+
+		for(int v = 0; v < num_voices; v++)
+		{
+			float l_volume = (float)(v % 16) / 16.0f;
+			float r_volume = 1.0f - l_volume;
+			float step = 0.25f / frames;
 
-		if(l_sample < -32767) l_sample = -32767;
-		if(l_sample > 32767) l_sample = 32767;
-		if(r_sample < -32767) r_sample = -32767;
-		if(r_sample > 32767) r_sample = 32767;
+			// Each voice starts somewhere different in the data
+			int offset = (v * 37) % frames;
 
-		*mb = (short)l_sample;
-		mb++;
-		*mb = (short)r_sample;
-		*mb++;
+			switch(v % 4)
+			{
+				case 0: kernels->mix_8m(data8 + offset, frames, acc, l_volume, r_volume, step, -step); break;
+				case 1: kernels->mix_8s(data8 + offset * 2, frames, acc, l_volume, r_volume, step, -step); break;
+				case 2: kernels->mix_16m(data16 + offset, frames, acc, l_volume, r_volume, step, -step); break;
+				case 3: kernels->mix_16s(data16 + offset * 2, frames, acc, l_volume, r_volume, step, -step); break;
+			}
+		}
+
+		kernels->pack(acc, dest, frames * 2);
+	}
+
+	std::chrono::duration<double> secs = std::chrono::high_resolution_clock::now() - start;
+
+	return ((double)num_passes * num_voices * frames) / secs.count();
+}
+
+// Times all the kernel sets this cpu supports with 32, 64 and 128 voices and
+// compares what they mixed against the scalar kernels.  Run with -mixbench.
+static void BenchmarkMixer(void)
+{
+	const int frames = 1024;
+	const int voice_counts[] = {32, 64, 128};
+	mix_kernels *kernel_sets[3];
+	int num_sets = 0;
+
+	kernel_sets[num_sets++] = &Mix_scalar;
+#ifdef CPU_SIMD
+	if(GetMixKernels(false) != &Mix_scalar)
+		kernel_sets[num_sets++] = &Mix_sse2;
+	if(GetMixKernels(true) == &Mix_avx2)
+		kernel_sets[num_sets++] = &Mix_avx2;
+#endif
+
+	// Enough data for any voice's offset plus a full buffer of stereo frames
+	short *data16 = (short *)malloc(frames * 4 * sizeof(short));
+	unsigned char *data8 = (unsigned char *)malloc(frames * 4);
+	int *acc = (int *)malloc(frames * 2 * sizeof(int));
+	short *dest = (short *)malloc(frames * 2 * sizeof(short));
+	short *reference = (short *)malloc(frames * 2 * sizeof(short));
+
+	unsigned int seed = 0x1234567;
+	for(int i = 0; i < frames * 4; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		data16[i] = (short)(seed >> 16);
+		data8[i] = (unsigned char)(seed >> 24);
 	}
+
+	for(int c = 0; c < (int)(sizeof(voice_counts) / sizeof(voice_counts[0])); c++)
+	{
+		for(int k = 0; k < num_sets; k++)
+		{
+			double rate = BenchmarkMixKernels(kernel_sets[k], voice_counts[c], data16, data8, acc, dest, frames);
+
+			if(k == 0)
+				memcpy(reference, dest, frames * 2 * sizeof(short));
+
+			int max_diff = 0;
+			for(int i = 0; i < frames * 2; i++)
+			{
+				int diff = abs(reference[i] - dest[i]);
+				if(diff > max_diff)
+					max_diff = diff;
+			}
+
+			mprintf((0, "Mixer bench: %3d voices, %-6s %8.2f M samples/sec, max diff from scalar %d\n", voice_counts[c], kernel_sets[k]->name, rate / 1000000.0, max_diff));
+		}
+	}
+
+	free(data16);
+	free(data8);
+	free(acc);
+	free(dest);
+	free(reference);
 }
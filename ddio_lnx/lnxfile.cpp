@@ -67,6 +67,7 @@
 #include <stdarg.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/mman.h>
 #include <fcntl.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -140,6 +141,38 @@ int ddio_GetFileLength(FILE* filePtr)
   return size;
 }
 
+// maps a whole file into memory for reading
+void *ddio_MapFile(const char *name, int *length)
+{
+  int filedes = open(name, O_RDONLY);
+  if (filedes == -1)
+    return NULL;
+
+  struct stat info;
+  if (fstat(filedes, &info) == -1 || info.st_size <= 0){
+    close(filedes);
+    return NULL;
+  }
+
+  void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, filedes, 0);
+  //the mapping stays valid after the descriptor is closed
+  close(filedes);
+  if (data == MAP_FAILED){
+    mprintf((0, "Unable to map %s: %s\n", name, strerror(errno)));
+    return NULL;
+  }
+
+  *length = info.st_size;
+  return data;
+}
+
+// releases an image returned by ddio_MapFile
+void ddio_UnmapFile(void *data, int length)
+{
+  if (data)
+    munmap(data, length);
+}
+
 // Split a pathname into its component parts
 void ddio_SplitPath(const char* srcPath, char* path, char* filename, char* ext)
 {
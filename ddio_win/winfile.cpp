@@ -81,6 +81,52 @@ int	ddio_GetFileLength(FILE* filePtr)
 	return (filelength(fileno(filePtr)));
 }
 
+// maps a whole file into memory for reading
+void *ddio_MapFile(const char *name, int *length)
+{
+	HANDLE filehandle, maphandle;
+	void *data;
+	DWORD size;
+
+	filehandle = CreateFile(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (filehandle == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	size = GetFileSize(filehandle, NULL);
+	if (size == INVALID_FILE_SIZE || size == 0)
+	{
+		CloseHandle(filehandle);
+		return NULL;
+	}
+
+	maphandle = CreateFileMapping(filehandle, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (maphandle == NULL)
+	{
+		CloseHandle(filehandle);
+		return NULL;
+	}
+
+	//The view keeps the mapping alive, so both handles can be closed now
+	data = MapViewOfFile(maphandle, FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(maphandle);
+	CloseHandle(filehandle);
+	if (data == NULL)
+	{
+		mprintf((0, "Unable to map %s: error %d\n", name, GetLastError()));
+		return NULL;
+	}
+
+	*length = size;
+	return data;
+}
+
+// releases an image returned by ddio_MapFile
+void ddio_UnmapFile(void *data, int length)
+{
+	if (data)
+		UnmapViewOfFile(data);
+}
+
 // Split a pathname into its component parts
 void ddio_SplitPath(const char* srcPath, char* path, char* filename, char* ext)
 {
@@ -69,6 +69,20 @@ typedef struct chunked_bitmap
 	int *bm_array;						// array of bitmap handles.
 }
 chunked_bitmap;
+// A paged out bitmap's file, decoded by bm_DecodeBitmapFile() and waiting for bm_CommitBitmapFile()
+typedef struct
+{
+	int handle;
+	int result;							// 1 if the file decoded
+	ushort *data;						// malloc'd pixels, mips included
+	int size;							// size of data in bytes
+	int file_size;						// 0 if the file couldn't be opened
+	ushort width,height;
+	ubyte format;
+	ubyte mipped;
+	ubyte mip_levels;					// nonzero if the bitmap's mip_levels should be set
+	char name[BITMAP_NAME_LEN];
+} bm_decoded_file;
 extern bms_bitmap GameBitmaps[MAX_BITMAPS];
 extern ulong Bitmap_memory_used;
 extern ubyte Memory_map[];
@@ -156,4 +170,9 @@ void bm_FreeBitmapData(int handle);
 int bm_format (int handle);
 // Returns the number of mipmap levels
 int bm_miplevels (int handle);
+// Reads and decodes the file for a paged out bitmap without touching the bitmap.  Different
+// bitmaps can be decoded on different threads at the same time.
+void bm_DecodeBitmapFile (int handle,bm_decoded_file *dest);
+// Moves a decoded file into its bitmap.  Main thread only.  Returns 1 if the bitmap was paged in
+int bm_CommitBitmapFile (bm_decoded_file *src);
 #endif
@@ -0,0 +1,87 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+//	SIMD code paths are built with per-function target attributes and picked at runtime, so
+//	they don't need -msse2 and the game still runs on cpus without them.
+//		CPU_SIMD is defined where the x86 intrinsics can be used at all.
+//		CPU_TARGET("sse2") in front of a function lets it use that instruction set.
+//		cpu_HaveSSE2() and cpu_HaveAVX2() say whether it's safe to call such a function.
+//	the checks are only done once, so they can be called from any thread.
+
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#define CPU_SIMD
+#define CPU_TARGET(x)	__attribute__((target(x)))
+#include <immintrin.h>
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define CPU_SIMD
+#define CPU_TARGET(x)
+#include <intrin.h>
+#include <immintrin.h>
+#endif
+
+#ifdef CPU_SIMD
+
+inline bool cpu_CheckSSE2()
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	return (__builtin_cpu_supports("sse2") != 0);
+#else
+	//Only built for cpus that have it
+	return true;
+#endif
+}
+
+inline bool cpu_CheckAVX2()
+{
+#if defined(__GNUC__)
+	__builtin_cpu_init();
+	return (__builtin_cpu_supports("avx2") != 0);
+#else
+	int info[4];
+
+	__cpuid(info, 1);
+	// AVX needs the OS to save the ymm registers too
+	if (!(info[2] & (1 << 27)) || !(info[2] & (1 << 28)) || (_xgetbv(0) & 6) != 6)
+		return false;
+
+	__cpuidex(info, 7, 0);
+	return (info[1] & (1 << 5)) != 0;
+#endif
+}
+
+// Returns true if the cpu can run CPU_TARGET("sse2") functions
+inline bool cpu_HaveSSE2()
+{
+	static const bool have_sse2 = cpu_CheckSSE2();
+	return have_sse2;
+}
+
+// Returns true if the cpu and OS can run CPU_TARGET("avx2") functions
+inline bool cpu_HaveAVX2()
+{
+	static const bool have_avx2 = cpu_CheckAVX2();
+	return have_avx2;
+}
+
+#endif	// CPU_SIMD
+
+#endif
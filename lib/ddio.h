@@ -180,6 +180,14 @@ bool ddio_DirExists(const char* path);
 //  get a file length of a FILE
 int	ddio_GetFileLength(FILE* filePtr);
 
+//	maps a whole file into memory for reading.  length is filled in with the size of the file.
+//	Returns a pointer to the read-only file image, or NULL if the file couldn't be mapped.
+//	This pathname is *RELATIVE* not fully qualified
+void *ddio_MapFile(const char *name, int *length);
+
+//	releases an image returned by ddio_MapFile
+void ddio_UnmapFile(void *data, int length);
+
 //	check if two files are different
 //	This pathname is *RELATIVE* not fully qualified
 bool ddio_FileDiff(const char* fileNameA, const char* fileNameB);
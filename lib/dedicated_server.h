@@ -40,6 +40,23 @@ typedef struct
 
 extern bool Dedicated_server;
 
+// Fastest tick rate the fixed tick server loop can be set to
+#define MAX_DEDICATED_TICK_RATE	250
+
+// Simulation ticks per second for the fixed tick loop, or 0 to run frames like a client
+extern int Dedicated_tick_rate;
+
+// Timing of the fixed tick loop since the stats were last reset
+typedef struct
+{
+	int ticks;
+	int overruns;				// ticks that were already due when the last one finished
+	float cpu_time;			// total cpu time the game thread spent running ticks
+	float max_cpu_time;
+	float jitter;				// total time ticks started after they were due
+	float max_jitter;
+} tDedicatedTickStats;
+
 // Sets the value for a cvar INT type
 void SetCVarInt (int index,int val);
 
@@ -85,4 +102,14 @@ void ListenDedicatedSocket (void);
 //Init the socket and start listening
 void InitDedicatedSocket(ushort port);
 
+// Runs the clock for the fixed tick loop.  last_tick is when the tick that just ran was due.
+// Sleeps until the next tick is due, handling network and telnet traffic meanwhile, and returns when that is.
+double DedicatedWaitForTick(double last_tick);
+
+// Gets the fixed tick loop timing, and optionally starts a new sample
+void DedicatedGetTickStats(tDedicatedTickStats *stats,bool reset);
+
+// Prints the fixed tick loop timing since the last time it was printed
+void PrintDedicatedTickStats();
+
 #endif
\ No newline at end of file
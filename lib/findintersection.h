@@ -396,18 +396,133 @@ typedef struct fvi_face_room_list
 
 #define MAX_RECORDED_FACES 200
 
-// Recorded face list
-extern fvi_face_room_list Fvi_recorded_faces[MAX_RECORDED_FACES];
-extern int Fvi_num_recorded_faces;
+#define MAX_CELLS_VISITED (TERRAIN_DEPTH * TERRAIN_WIDTH)   // Maximum terrain cells visited in one fvi call
+
+#define FVI_MAX_INSTANCE_DEPTH	30
+
+// Saved state for instancing into a polymodel's submodels
+typedef struct fvi_instance_context
+{
+	matrix m;
+	vector p;
+	vector p0;
+	vector p1;
+	vector fvec;
+	vector uvec;
+} fvi_instance_context;
+
+// Everything a single fvi query works with.  Queries that share a context can't run at the same
+// time, so each thread that does collision queries needs a context of its own.  The calls that
+// don't take a context use Fvi_main_context, which belongs to the main thread.
+typedef struct fvi_context
+{
+	// Bit fields for quick 'already-checked' checking
+	unsigned char visit_list[MAX_ROOMS/8 + 1];
+	unsigned char terrain_visit_list[(TERRAIN_DEPTH * TERRAIN_WIDTH)/8 + 1];
+	unsigned char terrain_obj_visit_list[(TERRAIN_DEPTH * TERRAIN_WIDTH)/8 + 1];
+
+	// The number rooms and terrain cells that this fvi call visited.
+	int num_rooms_visited;
+	int num_cells_visited;
+	int num_cells_obj_visited;
+
+	// Unordered list of rooms and terrain cells that this fvi call visited.
+	ushort rooms_visited[MAX_ROOMS];
+	ushort cells_visited[MAX_CELLS_VISITED];
+	ushort cells_obj_visited[MAX_CELLS_VISITED];
+
+	// Should we do a terrain check.  If we do a terrain check, it always does a full check; so,
+	// we only have to do it once.
+	bool f_check_terrain;
+	bool zero_rad;
+
+	// Wall collision stuff
+	float wall_sphere_rad;
+	vector wall_sphere_offset;
+	vector wall_sphere_p0;
+	vector wall_sphere_p1;
+
+	float anim_sphere_rad;
+	vector anim_sphere_offset;
+	vector anim_sphere_p0;
+	vector anim_sphere_p1;
+
+	// The query being worked on and its results
+	fvi_info *hit_data_ptr;
+	fvi_query *query_ptr;
+
+	// Best collision's distance
+	float collision_dist;
+
+	// AABB for the movement
+	vector max_xyz;
+	vector min_xyz;
+	vector movement_delta;
+
+	// AABB for the movement against walls
+	vector wall_max_xyz;
+	vector wall_min_xyz;
+
+	int curobj;
+	int moveobj;
+
+	// While a move is worked out ahead of the object pass, staged_obj stands in for
+	// Objects[staged_objnum] as the object being moved (see fvi_GetObject())
+	int staged_objnum;
+	object *staged_obj;
+
+	// Faces passed through, for triggers (see FQ_RECORD)
+	fvi_face_room_list recorded_faces[MAX_RECORDED_FACES];
+	int num_recorded_faces;
+
+	// Polymodel collision state (newstyle_fi.cpp)
+	vector view_position;
+	matrix view_matrix;
+	vector ns_min_xyz;
+	vector ns_max_xyz;
+	vector move_fvec;
+	vector move_uvec;
+	bool do_orient;
+	bool f_normal;
+	bool check_param;
+	float hit_param;
+	fvi_instance_context instance_stack[FVI_MAX_INSTANCE_DEPTH];
+	int instance_depth;
+} fvi_context;
+
+extern fvi_context Fvi_main_context;
+
+// Returns the object a query should use for objnum
+inline object *fvi_GetObject(fvi_context *ctx, int objnum)
+{
+	if (ctx->staged_obj && objnum == ctx->staged_objnum)
+		return ctx->staged_obj;
+
+	return &Objects[objnum];
+}
+
+// Allocates and initializes a context for running fvi queries on another thread
+fvi_context *fvi_CreateContext(void);
+
+// Frees a context from fvi_CreateContext()
+void fvi_DestroyContext(fvi_context *ctx);
+
+// Sets up a context that wasn't made by fvi_CreateContext()
+void fvi_InitContext(fvi_context *ctx);
+
+// Same as above, using the given context
+extern int fvi_FindIntersection(fvi_context *ctx, fvi_query *fq, fvi_info *hit_data, bool no_subdivision = false);
 
 // Generates a list of faces(with corresponding room numbers) within a given distance to a position.
 // Return value is the number of faces in the list
 extern int fvi_QuickDistFaceList(int init_room_index, vector *pos, float rad, fvi_face_room_list *quick_fr_list, int max_elements);
+extern int fvi_QuickDistFaceList(fvi_context *ctx, int init_room_index, vector *pos, float rad, fvi_face_room_list *quick_fr_list, int max_elements);
 // Returns the number of cells that are approximately within the specified radius
 extern int fvi_QuickDistCellList(int init_cell_index, vector *pos, float rad, int *quick_cell_list, int max_elements);
 
 // Returns the number of objects that are approximately within the specified radius
 int fvi_QuickDistObjectList(vector *pos, int init_roomnum, float rad, short *object_index_list, int max_elements, bool f_lightmap_only, bool f_only_players_and_ais = false, bool f_include_non_collide_objects = false, bool f_stop_at_closed_doors = false);
+int fvi_QuickDistObjectList(fvi_context *ctx, vector *pos, int init_roomnum, float rad, short *object_index_list, int max_elements, bool f_lightmap_only, bool f_only_players_and_ais = false, bool f_include_non_collide_objects = false, bool f_stop_at_closed_doors = false);
 
 //finds the uv coords of the given point on the given seg & side
 //fills in u & v. if l is non-NULL fills it in also
@@ -421,13 +536,7 @@ extern int FVI_room_counter;
 
 bool fvi_QuickRoomCheck(vector *pos, room *cur_room, bool try_again = false);
 
-extern fvi_info * fvi_hit_data_ptr;
-extern fvi_query * fvi_query_ptr;
-extern float fvi_collision_dist;
-extern int fvi_curobj;
-extern int fvi_moveobj;
-
-bool PolyCollideObject(object *obj);
+bool PolyCollideObject(fvi_context *ctx, object *obj);
 
 bool BBoxPlaneIntersection(bool fast_exit, vector *collision_point, vector *collision_normal, object *obj, vector *new_pos, int nv, vector **vertex_ptr_list, vector *face_normal, matrix *orient);
 
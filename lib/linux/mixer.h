@@ -81,7 +81,7 @@ typedef struct DSLOOPSTREAM
 class sound_buffer_info 
 {
 public:
-	sound_buffer_info() {m_status = SSF_UNUSED;s=NULL; }
+	sound_buffer_info() {m_status = SSF_UNUSED;s=NULL;m_mix_unique_id = -1;m_mix_l_volume = m_mix_r_volume = 0.0f; }
 	
 	play_information *play_info;
 
@@ -98,6 +98,11 @@ public:
 	int sample_length;			// used for storage purposes.
 
 	float m_volume;
+
+	// Volumes this sound was last mixed at, so volume changes are ramped in by the software mixer
+	int m_mix_unique_id;
+	float m_mix_l_volume;
+	float m_mix_r_volume;
 	
 	bool stereo;
 	sbyte bps;
@@ -137,7 +142,7 @@ private:
 	llsSystem *m_ll_sound_ptr;
 	bool m_init;
 	sound_buffer *m_primary_buffer;
-	int *Fast_mixer;
+	int *Fast_mixer;		// 32 bit stereo accumulator, packed down to 16 bits once all the slots are mixed
 	int Fast_mixer_len;
 	int m_primary_alignment;
 	int m_BufferSize;
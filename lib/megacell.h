@@ -20,6 +20,7 @@
 
 #include "pstypes.h"
 #include "manage.h"
+#include "nameindex.h"
 #include "gametexture.h"
 
 #define MAX_MEGACELLS	100
@@ -43,6 +44,7 @@ typedef struct
 
 extern int Num_megacells;
 extern megacell Megacells[MAX_MEGACELLS];
+extern tNameIndex<MAX_MEGACELLS> Megacell_names;	// call Megacell_names.update(n) after changing Megacells[n].name
 
 // Sets all MEGACELLs to unused
 void InitMegacells ();
@@ -87,6 +87,7 @@
 #define mem_strdup(d) strdup(d)
 #define mem_size(d) _msize(d)
 #define mem_realloc(d,e) realloc(d,e)
+#define mem_adopt(d,s) (d)
 #else
 //Use this if your going to NOT run BoundsChecker
 #define mem_malloc(d)	mem_malloc_sub(d, __FILE__, __LINE__)	
@@ -94,6 +95,7 @@
 #define mem_strdup(d) mem_strdup_sub(d, __FILE__, __LINE__)
 #define mem_size(d) mem_size_sub(d)
 #define mem_realloc(d,e) mem_realloc_sub(d,e)
+#define mem_adopt(d,s) mem_adopt_sub(d, s, __FILE__, __LINE__)
 #endif
 
 extern bool Mem_low_memory_mode;
@@ -124,6 +126,10 @@ char * mem_strdup_sub(const char *src,char *file,int line);
 
 void * mem_realloc_sub(void * memblock,int size);
 
+// Takes over a block of size bytes that was allocated with malloc(), so it can be freed with mem_free().
+// Returns the block, or a copy of it if the library doesn't allocate with malloc().  NULL if out of memory.
+void *mem_adopt_sub(void *memblock, int size, const char *file, int line);
+
 int mem_size_sub(void *memblock);
 
 bool mem_dumpmallocstofile(char *filename);
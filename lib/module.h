@@ -90,6 +90,12 @@ void mod_GetRealModuleName(const char *modfilename,char *realmodfilename);
 //Returns true on success, false otherwise
 bool mod_LoadModule(module *handle,char *modfilename,int flags=MODF_LAZY);
 
+//Loads a dynamic module from an open file descriptor (such as a memfd), so it never has
+//	to exist on disk.  Only supported on Linux, elsewhere it always fails with MODERR_OTHER.
+//	The descriptor must stay open while the module is loaded.
+//Returns true on success, false otherwise
+bool mod_LoadModuleFromFD(module *handle,int fd,int flags=MODF_LAZY);
+
 //Frees a previously loaded module from memory, it can no longer be used
 //Returns true on success, false otherwise
 bool mod_FreeModule(module *handle);
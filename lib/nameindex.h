@@ -0,0 +1,120 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef NAMEINDEX_H
+#define NAMEINDEX_H
+
+#include <string.h>
+#include <ctype.h>
+
+//	tNameIndex
+//		a case-insensitive hash index over the name field of a fixed array of pages
+//		(GameTextures, Weapons, Sounds...) so the Find*Name functions don't have to scan
+//		the whole array.  the index points at the names in place, so whoever sets, changes
+//		or clears the name of slot n must call update(n) afterwards.
+
+//	to index an array, do this:
+//		tNameIndex<MAX_WEAPONS> Weapon_names(Weapons[0].name,sizeof(weapon));
+//		strcpy(Weapons[n].name,"Laser");
+//		Weapon_names.update(n);
+//		n = Weapon_names.find("laser");
+
+template <int t_LEN> class tNameIndex
+{
+	enum { TABLE_SIZE = t_LEN*2+1, EMPTY = -1, REMOVED = -2 };
+
+	const char *m_names;				// name of slot 0
+	int m_stride;						// bytes between the names of two slots
+	short m_table[TABLE_SIZE];			// slot numbers, open addressing
+	short m_pos[t_LEN];					// where each slot is in m_table, -1 if not in it
+	int m_removed;						// number of REMOVED entries in m_table
+
+	const char *name(int slot) const { return m_names + slot*m_stride; };
+
+	static unsigned hash(const char *s) {
+		unsigned h = 2166136261u;
+		while (*s)
+			h = (h ^ (unsigned char)tolower((unsigned char)*s++)) * 16777619u;
+		return h % TABLE_SIZE;
+	};
+
+	static bool same(const char *a, const char *b) {
+		while (*a && tolower((unsigned char)*a) == tolower((unsigned char)*b)) {
+			a++; b++;
+		}
+		return tolower((unsigned char)*a) == tolower((unsigned char)*b);
+	};
+
+	void place(int slot) {
+		int i = hash(name(slot));
+		while (m_table[i] >= 0)
+			if (++i == TABLE_SIZE) i = 0;
+		if (m_table[i] == REMOVED)
+			m_removed--;
+		m_table[i] = slot;
+		m_pos[slot] = i;
+	};
+
+//	drops the REMOVED entries so lookups don't have to step over them
+	void rebuild() {
+		memset(m_table, 0xff, sizeof(m_table));
+		m_removed = 0;
+		for (int slot = 0; slot < t_LEN; slot++)
+			if (m_pos[slot] != -1) place(slot);
+	};
+
+public:
+	tNameIndex(const char *first_name, int stride) { m_names = first_name; m_stride = stride; clear(); };
+
+//	forgets every name, call when the whole array is reset
+	void clear() {
+		memset(m_table, 0xff, sizeof(m_table));
+		memset(m_pos, 0xff, sizeof(m_pos));
+		m_removed = 0;
+	};
+
+//	call after the name of slot has been set, changed or cleared (an empty name isn't indexed)
+	void update(int slot) {
+		if (slot < 0 || slot >= t_LEN)
+			return;
+		if (m_pos[slot] != -1) {
+			m_table[m_pos[slot]] = REMOVED;
+			m_pos[slot] = -1;
+			m_removed++;
+		}
+		if (name(slot)[0]) {
+			if (m_removed > TABLE_SIZE/4)
+				rebuild();
+			place(slot);
+		}
+	};
+
+//	returns the lowest slot with this name, or -1.  same result as a linear stricmp scan
+	int find(const char *s) const {
+		int i = hash(s), found = -1;
+		while (m_table[i] != EMPTY) {
+			int slot = m_table[i];
+			if (slot >= 0 && (found == -1 || slot < found) && same(s, name(slot)))
+				found = slot;
+			if (++i == TABLE_SIZE) i = 0;
+		}
+		return found;
+	};
+};
+
+#endif
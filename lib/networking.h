@@ -455,6 +455,12 @@ int nw_RegisterCallback(NetworkReceiveCallback nfp, ubyte id);
 NetworkReceiveCallback nw_UnRegisterCallback(ubyte id);
 int nw_SendWithID(ubyte id,ubyte *data,int len,network_address *who_to);
 int nw_DoReceiveCallbacks(void);
+// Returns when the packet being handed to a receive callback came off the socket
+float nw_GetPacketReceiveTime();
+// Gets ready to sleep until packets arrive.  fd is set to a descriptor to wait on, or -1 for none.
+// Returns false if packets are already waiting.  Call nw_EndWait() when done waiting.
+bool nw_BeginWait(int *fd);
+void nw_EndWait();
 void nw_HandleConnectResponse(ubyte *data,int len,network_address *server_addr);
 int nw_RegisterCallback(NetworkReceiveCallback nfp, ubyte id);
 void nw_HandleUnreliableData(ubyte *data,int len,network_address *from_addr);
@@ -300,6 +300,7 @@
 #include "robotfirestruct.h"
 #include "polymodel_external.h"
 #include "object_external_struct.h"
+#include "nameindex.h"
 
 #define PM_COMPATIBLE_VERSION	1807
 #define PM_OBJFILE_VERSION		2300
@@ -312,6 +313,7 @@
 
 extern int Num_poly_models;
 extern poly_model Poly_models[];
+extern tNameIndex<MAX_POLY_MODELS> Poly_model_names;	// call Poly_model_names.update(n) after changing Poly_models[n].name
 
 extern int Polymodel_use_effect;
 extern polymodel_effect Polymodel_effect;
@@ -438,4 +440,15 @@ void FreePolymodelData (int i);
 // Sets the position and rotation of a polymodel.  Used for rendering and collision detection
 void SetModelAnglesAndPos (poly_model *po,float *normalized_time,uint subobj_flags=0xFFFFFFFF);
 
+// Calculates the position and rotation of each subobject of a timed polymodel into mod_pos and
+// angs, without changing the submodels
+void GetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subobj_flags,vector *mod_pos,angvec *angs);
+
+// Queues a polymodel to be drawn from its mesh on the card.  Lightdir is NULL for static lighting.
+// Returns false if the model has to be drawn with RenderPolygonModel
+bool DrawPolygonModelMesh (vector *pos,matrix *orient,int model_num,float *normalized_time,vector *lightdir,float r,float g,float b,uint f_render_sub,ubyte use_effect);
+
+// Frees the mesh of a polymodel
+void FreePolymodelMesh (int i);
+
 #endif
@@ -21,6 +21,7 @@
 
 #include "pstypes.h"
 #include "grdefs.h"
+#include "vecmat_external.h"
 
 //Declare this here so we don't need to include 3d.h
 struct g3Point;
@@ -246,11 +247,28 @@ struct tRendererStats
 	int poly_count;
 	int vert_count;
 	int texture_uploads;
+	int batch_count;
 };
 
 // returns rendering statistics for the frame
 void rend_GetStatistics(tRendererStats *stats);
 
+// GL calls recorded by the null renderer over a frame
+struct tRendererCallStats
+{
+	int draw_calls;
+	int vertices;			// vertices (or indices) sent by the draw calls
+	int state_changes;	// every call that changes state, including the binds below
+	int texture_binds;
+	int program_binds;
+	int texture_uploads;
+	int upload_bytes;		// texture and buffer data sent
+};
+
+// Gets the GL calls recorded over the last frame.  Returns false if the renderer isn't the null
+// renderer (selected by passing RENDERER_NONE to rend_Init), which is the only one that records them
+bool rend_GetCallStatistics(tRendererCallStats *stats);
+
 void rend_SetTextureType (texture_type);
 
 // Given a handle to a bitmap and nv point vertices, draws a 3D polygon
@@ -458,6 +476,39 @@ void rend_SetFrameBufferCopyState (bool state);
 
 void rend_UpdateCommon(float* projection, float* modelview);
 
+// A vertex of a model mesh, in the space of its submodel
+struct rend_model_vertex
+{
+	vector pos;
+	vector normal;
+	float u,v;
+	float alpha;
+	int submodel;		// which pose of the instance moves this vertex
+	int fullbright;		// 1 if the vertex ignores the instance lighting
+};
+
+// A run of a model mesh's indices that is drawn with one bitmap
+struct rend_model_batch
+{
+	int bm_handle;
+	int first_index;
+	int num_indices;
+};
+
+// Uploads a model mesh to the card.  Returns a handle, or -1 if it couldn't be created
+int rend_CreateModelMesh(int num_verts,rend_model_vertex *verts,int num_indices,ushort *indices);
+
+// Frees a mesh made by rend_CreateModelMesh
+void rend_FreeModelMesh(int handle);
+
+// Queues an instance of a model mesh.  Poses holds a 3x4 matrix (three rows of
+// x,y,z,translation) per submodel that takes the submodel into world space.  If
+// light_direction is NULL the model is lit with white, otherwise it is gouraud lit from
+// that world direction and tinted with r,g,b.  Instances of the same mesh are drawn together
+// with one instanced call when anything else is drawn or the state changes.
+// Returns false if the instance can't be drawn this way and must be drawn with polygons
+bool rend_QueueModelInstance(int handle,int num_batches,rend_model_batch *batches,int num_poses,float *poses,vector *light_direction,float r,float g,float b);
+
 //These are temporary, used to test shader code.
 //Use the test shader.
 void rend_UseShaderTest(void);
@@ -18,13 +18,13 @@
 #ifndef _RUN_TIME_PROFILING_
 #define _RUN_TIME_PROFILING_
 
-//uncomment the following if you want to enable Run-time Profiling
-#ifndef RELEASE
+//Run-time Profiling is compiled into every build (including release and dedicated server builds)
+//and costs one flag test per macro until a log is started.  Define NO_RTP to compile it out.
+#ifndef NO_RTP
 #define USE_RTP
 #endif
 
-#if defined(__LINUX__) || defined(MACINTOSH)
-//#if defined(__LINUX__)
+#if defined(MACINTOSH)
 	#ifdef USE_RTP
 		#undef USE_RTP	//no rtp for now
 	#endif
@@ -105,6 +105,25 @@ typedef struct{
 #define RTI_TEXTUREUPLOADS						0x00002000
 #define RTI_POLYSDRAWN							0x00004000
 
+//		Zones and counters
+// --------------------------------------------------
+// Each time member of tRTFrameInfo is also a zone and each value member a counter, named after
+// the member, and new code can add its own with RTP_ZONE/RTP_COUNTER.  Zones nest and can be
+// recorded from any thread; each thread writes into its own ring, which rtp_RecordFrame drains
+// once a frame.  While a log is running every zone is written to D3Trace.json (Chrome trace
+// format, open it in chrome://tracing or Perfetto) and the per frame totals of each zone and
+// counter are kept for the last RTP_ZONE_HISTORY frames for rtp_GetZoneStats.
+
+#define RTP_MAX_ZONES			128
+#define RTP_ZONE_HISTORY		256
+
+typedef struct{
+	const char *name;
+	int is_counter;
+	int num_frames;		//frames in the history (frames the zone or counter wasn't touched in are left out)
+	float p50,p90,p99,max;	//per frame totals, in milliseconds for zones
+}tRTZoneStats;
+
 //		Macros to be used internally and externally
 // --------------------------------------------------
 
@@ -125,6 +144,8 @@ typedef struct{
 #define RTP_ENDINCTIME(member)
 #define RTP_ENABLEFLAGS(flags)
 #define RTP_DISABLEFLAGS(flags)
+#define RTP_ZONE(name)
+#define RTP_COUNTER(name,amount)
 
 #else
 
@@ -152,13 +173,13 @@ typedef struct{
 // (external use)
 // member = the member of the tRTFrameInfo to increment
 // amount = how much to increment it
-#define RTP_INCRVALUE(member,amount) do{if(Runtime_performance_enabled){RTP_SingleFrame.member+=(amount);}}while(0)
+#define RTP_INCRVALUE(member,amount) do{if(Runtime_performance_enabled){RTP_SingleFrame.member+=(amount); RTP_ADDCOUNTER(member,amount);}}while(0)
 
 // decrements a value of a member of the current tRTFrameInfo frame
 // (external use)
 // member = the member of the tRTFrameInfo to decrement
 // amount = how much to decrement it
-#define RTP_DECRVALUE(member,amount) do{if(Runtime_performance_enabled){RTP_SingleFrame.member-=(amount);}}while(0)
+#define RTP_DECRVALUE(member,amount) do{if(Runtime_performance_enabled){RTP_SingleFrame.member-=(amount); RTP_ADDCOUNTER(member,-(amount));}}while(0)
 
 // returns the value of a member of the current tRTFrameInfo frame
 // (external use)
@@ -169,7 +190,7 @@ typedef struct{
 // starts a frame time calculation for a time member of the tRTFrameInfo frame
 // this version calls the clock to get the current time
 // member = member to start recording time on
-#define RTP_STARTTIME(member) do{if(Runtime_performance_enabled){RTP_SingleFrame.member = rtp_GetClock();}}while(0)
+#define RTP_STARTTIME(member) do{if(Runtime_performance_enabled){RTP_SingleFrame.member = rtp_GetClock(); RTP_BEGINZONE(member,RTP_SingleFrame.member);}}while(0)
 
 // starts a frame time calculation given a time to start it with (similar to the above
 // except you give it the starting time).  This should be used (along with 
@@ -177,14 +198,14 @@ typedef struct{
 // to reduce the number of calls to rtp_GetClock(), however, this way will give
 // a few cycles off, compared to the RTP_STARTTIME(member)/RTP_ENDTIME(member) way
 // member = member to start recording time on
-#define RTP_tSTARTTIME(member,time) do{if(Runtime_performance_enabled){RTP_SingleFrame.member = time;}}while(0)
+#define RTP_tSTARTTIME(member,time) do{if(Runtime_performance_enabled){RTP_SingleFrame.member = time; RTP_BEGINZONE(member,time);}}while(0)
 
 // ends a frame time calculation for a member of tRTFrameInfo frame
 // member = member to stop recording time for
-#define RTP_ENDTIME(member) do{if(Runtime_performance_enabled){RTP_SingleFrame.member = rtp_GetClock() - RTP_SingleFrame.member;}}while(0)
+#define RTP_ENDTIME(member) do{if(Runtime_performance_enabled){INT64 __end_time_ = rtp_GetClock(); RTP_SingleFrame.member = __end_time_ - RTP_SingleFrame.member; RTP_ENDZONE(member,__end_time_);}}while(0)
 
 // same as above, but will return the time that it stopped the recording time
-#define RTP_tENDTIME(member,time) do{if(Runtime_performance_enabled){time = rtp_GetClock(); RTP_SingleFrame.member = time - RTP_SingleFrame.member;}}while(0)
+#define RTP_tENDTIME(member,time) do{if(Runtime_performance_enabled){time = rtp_GetClock(); RTP_SingleFrame.member = time - RTP_SingleFrame.member; RTP_ENDZONE(member,time);}}while(0)
 
 // returns the current clock time
 #define RTP_GETCLOCK(time) do {if(Runtime_performance_enabled){time = rtp_GetClock();}}while(0)
@@ -192,10 +213,30 @@ typedef struct{
 // Starts a frame time calculation, but when ending the frame, it will increment the time by
 // the difference instead of just setting it
 // RTP_STARTINCTIME and RTP_ENDINCTIME must be in the same scope
-#define RTP_STARTINCTIME(member) INT64 __start_time_; do{if(Runtime_performance_enabled){__start_time_ = rtp_GetClock();}}while(0)
+#define RTP_STARTINCTIME(member) INT64 __start_time_ = 0; do{if(Runtime_performance_enabled){__start_time_ = rtp_GetClock(); RTP_BEGINZONE(member,__start_time_);}}while(0)
 
 // Ends a frame time calculation and increments the member by the time for that frame
-#define RTP_ENDINCTIME(member) do{ if(Runtime_performance_enabled){RTP_SingleFrame.member += (rtp_GetClock() - __start_time_); }} while(0)
+#define RTP_ENDINCTIME(member) do{ if(Runtime_performance_enabled && __start_time_){INT64 __end_time_ = rtp_GetClock(); RTP_SingleFrame.member += (__end_time_ - __start_time_); RTP_ENDZONE(member,__end_time_); }} while(0)
+
+// begins the zone "name" at the given clock time, ended by the next rtp_EndZone on this thread
+// (internal use, the zone is looked up once per call site)
+#define RTP_BEGINZONE(name,time) do{ static int __zone_ = rtp_RegisterZone(#name,0); rtp_BeginZone(__zone_,time); }while(0)
+
+// ends the zone "name" at the given clock time (internal use)
+#define RTP_ENDZONE(name,time) do{ static int __zone_ = rtp_RegisterZone(#name,0); rtp_EndZone(__zone_,time); }while(0)
+
+// adds amount to the counter "name" for this frame (internal use)
+#define RTP_ADDCOUNTER(name,amount) do{ static int __counter_ = rtp_RegisterZone(#name,1); rtp_AddCounter(__counter_,amount); }while(0)
+
+// times the rest of the enclosing scope as the zone "name"
+// (external use)
+// name = an identifier naming the zone, one RTP_ZONE per scope
+#define RTP_ZONE(name) static int __zone_##name = rtp_RegisterZone(#name,0); rtp_ScopedZone __scope_##name(__zone_##name)
+
+// adds amount to the counter "name" for this frame
+// (external use)
+// name = an identifier naming the counter
+#define RTP_COUNTER(name,amount) do{ if(Runtime_performance_enabled){RTP_ADDCOUNTER(name,amount);}}while(0)
 
 
 #endif
@@ -269,6 +310,61 @@ void rtp_WriteBufferLog
 */
 void rtp_WriteBufferLog(void);
 
+/*
+int rtp_RegisterZone
+	Returns the id of the zone (or counter if is_counter) called name, adding it if it's new.
+	name must stay valid for the life of the program.  Returns -1 if there are too many zones
+*/
+int rtp_RegisterZone(const char *name,int is_counter);
+
+/*
+void rtp_BeginZone / rtp_EndZone
+	Starts / ends the zone at the given clock time on this thread.  An end is only counted if it
+	matches the last zone started, so one whose start wasn't recorded is ignored
+*/
+void rtp_BeginZone(int zone,INT64 time);
+void rtp_EndZone(int zone,INT64 time);
+
+/*
+void rtp_AddCounter
+	Adds amount to the counter for this frame
+*/
+void rtp_AddCounter(int counter,int amount);
+
+/*
+int rtp_GetNumZones
+	Returns how many zones and counters have been registered, their ids are 0 to this - 1
+*/
+int rtp_GetNumZones(void);
+
+/*
+bool rtp_GetZoneStats
+	Fills in the percentiles of the per frame totals of a zone or counter over the last
+	RTP_ZONE_HISTORY frames it was active in.  Returns false if it has no history yet
+*/
+bool rtp_GetZoneStats(int zone,tRTZoneStats *stats);
+
+/*
+void rtp_ZonesStartLog / rtp_ZonesRecordFrame / rtp_ZonesStopLog
+	Internal, called by rtp_StartLog, rtp_RecordFrame and rtp_StopLog to open the trace,
+	drain the thread rings for the frame, and write the zone statistics and close the trace
+*/
+void rtp_ZonesStartLog(void);
+void rtp_ZonesRecordFrame(INT64 frame_start,INT64 frame_end);
+void rtp_ZonesStopLog(void);
+
+#ifdef USE_RTP
+// Times its lifetime as a zone, see RTP_ZONE
+class rtp_ScopedZone
+{
+	bool m_on;
+	int m_zone;
+public:
+	rtp_ScopedZone(int zone) { m_zone = zone; m_on = Runtime_performance_enabled!=0; if(m_on) rtp_BeginZone(zone,rtp_GetClock()); }
+	~rtp_ScopedZone() { if(m_on) rtp_EndZone(m_zone,rtp_GetClock()); }
+};
+#endif
+
 
 
 
@@ -19,9 +19,12 @@
 #define SOUNDLOAD_H_
 
 #include "ssl_lib.h"
+#include "nameindex.h"
 
 extern int Num_sounds;
 extern int Num_sound_files;
+extern tNameIndex<MAX_SOUNDS> Sound_names;				// call Sound_names.update(n) after changing Sounds[n].name
+extern tNameIndex<MAX_SOUND_FILES> Sound_file_names;	// call Sound_file_names.update(n) after changing SoundFiles[n].name
 
 // Allocs a sound file for use, returns -1 if error, else index on success
 int AllocSoundFile ();
@@ -150,6 +150,7 @@
 #include "manage.h"
 #include "door.h"
 #include "doorpage.h"
+#include "tablecache.h"
 #include "mono.h"
 #include "pserror.h"
 #include "polymodel.h"
@@ -384,6 +385,9 @@ int mng_FindSpecificDoorPage (char *name,mngs_door_page *doorpage,int offset)
 	
 	char tablename[TABLE_NAME_LEN];
 	
+	if (mng_FindTableCachePage (PAGETYPE_DOOR,name,doorpage,offset))
+		return 1;
+
 	if (Loading_locals)
 	{
 		infile=cfopen (LocalTableFilename,"rb");
@@ -488,6 +492,7 @@ int mng_AssignDoorPageToDoor(mngs_door_page *doorpage,int n)
 	// copy our values
 	memcpy (doorpointer,&doorpage->door_struct,sizeof(door));
 	strcpy (doorpointer->name,doorpage->door_struct.name);
+	Door_names.update(n);
 
 
 	// First see if our image differs from the one on the net
@@ -553,6 +558,27 @@ void mng_AssignDoorToDoorPage(int n,mngs_door_page *doorpage)
 		strcpy(doorpage->close_sound_name,"INVALID SOUND NAME");
 }
 
+// Loads a door page that has already been read from the net table file (or out of the
+// table cache)
+void mng_ApplyNetDoorPage(mngs_door_page *doorpage,bool overlay)
+{
+	int n;
+	n = FindDoorName(doorpage->door_struct.name);
+	if(n!=-1)
+	{
+		if(overlay)
+		{
+			mprintf((0,"OVERLAYING DOOR %s\n",doorpage->door_struct.name));
+			mng_FreePagetypePrimitives (PAGETYPE_DOOR,doorpage->door_struct.name,0);
+			mng_AssignDoorPageToDoor(doorpage,n);
+		}			
+		return;
+	}
+
+	int ret=mng_SetAndLoadDoor (doorpage);
+	ASSERT (ret>=0);
+}
+
 // Loads a door found in the net table file.  It then allocs a door and
 // then calls SetAndLoadDoor to actually load in any images/models associated
 // with it
@@ -562,23 +588,7 @@ void mng_LoadNetDoorPage(CFILE *infile,bool overlay)
 	memset(&doorpage, 0, sizeof(mngs_door_page));
 	
 	if (mng_ReadNewDoorPage (infile,&doorpage))
-	{
-		int n;
-		n = FindDoorName(doorpage.door_struct.name);
-		if(n!=-1)
-		{
-			if(overlay)
-			{
-				mprintf((0,"OVERLAYING DOOR %s\n",doorpage.door_struct.name));
-				mng_FreePagetypePrimitives (PAGETYPE_DOOR,doorpage.door_struct.name,0);
-				mng_AssignDoorPageToDoor(&doorpage,n);
-			}			
-			return;
-		}
-
-		int ret=mng_SetAndLoadDoor (&doorpage);
-		ASSERT (ret>=0);
-	}
+		mng_ApplyNetDoorPage (&doorpage,overlay);
 	else
 		mprintf ((0,"Could not load doorpage named %s!\n",doorpage.door_struct.name));
 }
@@ -70,4 +70,7 @@ void mng_LoadLocalDoorPage(CFILE *);
 // Reads in a page off the net
 void mng_LoadNetDoorPage (CFILE *,bool overlay=false);
 
+// Loads a page that has already been read off the net (or out of the table cache)
+void mng_ApplyNetDoorPage (mngs_door_page *doorpage,bool overlay=false);
+
 #endif
\ No newline at end of file
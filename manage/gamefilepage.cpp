@@ -26,6 +26,7 @@
 #include "ddio.h"
 #include "gamefile.h"
 #include "gamefilepage.h"
+#include "tablecache.h"
 #include "args.h"
 
 #include <string.h>
@@ -150,6 +151,9 @@ int mng_FindSpecificGamefilePage (char *name,mngs_gamefile_page *gamefilepage,in
 	int done=0,found=0;
 	char tablename[TABLE_NAME_LEN];
 
+	if (mng_FindTableCachePage (PAGETYPE_GAMEFILE,name,gamefilepage,offset))
+		return 1;
+
 	if (Loading_locals)
 	{
 		infile=cfopen (LocalTableFilename,"rb");
@@ -246,6 +250,7 @@ int mng_AssignGamefilePageToGamefile(mngs_gamefile_page *gamefilepage,int n)
 	// copy our values
 	memcpy (gamefilepointer,&gamefilepage->gamefile_struct,sizeof(gamefile));
 	strcpy (gamefilepointer->name,gamefilepage->gamefile_struct.name);
+	Gamefile_names.update(n);
 	strcpy (gamefilepointer->dir_name,gamefilepage->gamefile_struct.dir_name);
 
 	// First see if our image differs from the one on the net
@@ -291,6 +296,26 @@ void mng_AssignGamefileToGamefilePage(int n,mngs_gamefile_page *gamefilepage)
 	strcpy (gamefilepage->gamefile_struct.dir_name,gamefilepointer->dir_name);
 }
 
+// Loads a gamefile page that has already been read from the net table file (or out of the
+// table cache)
+void mng_ApplyNetGamefilePage(mngs_gamefile_page *gamefilepage,bool overlay)
+{
+	int n = FindGamefileName(gamefilepage->gamefile_struct.name);
+	if(n!=-1)
+	{
+		if(overlay)
+		{
+			mprintf((0,"OVERLAYING GAMEFILE %s\n",gamefilepage->gamefile_struct.name));
+			mng_FreePagetypePrimitives (PAGETYPE_GAMEFILE,gamefilepage->gamefile_struct.name,0);
+			mng_AssignGamefilePageToGamefile(gamefilepage,n);
+		}			
+		return;
+	}
+
+	int ret=mng_SetAndLoadGamefile (gamefilepage);
+	ASSERT (ret>=0);
+}
+
 // Loads a gamefile found in the net table file.  It then allocs a gamefile and
 // then calls SetAndLoadGamefile to actually load in any images/models associated
 // with it
@@ -300,22 +325,7 @@ void mng_LoadNetGamefilePage(CFILE *infile,bool overlay)
 	memset(&gamefilepage, 0, sizeof(mngs_gamefile_page));
 	
 	if (mng_ReadNewGamefilePage (infile,&gamefilepage))
-	{
-		int n = FindGamefileName(gamefilepage.gamefile_struct.name);
-		if(n!=-1)
-		{
-			if(overlay)
-			{
-				mprintf((0,"OVERLAYING GAMEFILE %s\n",gamefilepage.gamefile_struct.name));
-				mng_FreePagetypePrimitives (PAGETYPE_GAMEFILE,gamefilepage.gamefile_struct.name,0);
-				mng_AssignGamefilePageToGamefile(&gamefilepage,n);
-			}			
-			return;
-		}
-
-		int ret=mng_SetAndLoadGamefile (&gamefilepage);
-		ASSERT (ret>=0);
-	}
+		mng_ApplyNetGamefilePage (&gamefilepage,overlay);
 	else
 		mprintf ((0,"Could not load gamefilepage named %s!\n",gamefilepage.gamefile_struct.name));
 }
@@ -67,6 +67,9 @@ void mng_LoadLocalGamefilePage(CFILE *);
 // Reads in a page off the net
 void mng_LoadNetGamefilePage (CFILE *,bool overlay=false);
 
+// Loads a page that has already been read off the net (or out of the table cache)
+void mng_ApplyNetGamefilePage (mngs_gamefile_page *gamefilepage,bool overlay=false);
+
 // First searches through the gamefile index to see if the gamefile is already
 // loaded.  If not, searches in the table file and loads it.  
 // Returns index of gamefile if found, -1 if not
@@ -357,6 +357,7 @@
 #include "CFILE.H"
 #include "manage.h"
 #include "genericpage.h"
+#include "tablecache.h"
 #include "soundpage.h"
 #include "weaponpage.h"
 #include "mono.h"
@@ -1878,6 +1879,9 @@ int mng_FindSpecificGenericPage (char *name,mngs_generic_page *genericpage,int o
 	int first_try=1;
 	char tablename[TABLE_NAME_LEN];
 
+	if (mng_FindTableCachePage (PAGETYPE_GENERIC,name,genericpage,offset))
+		return 1;
+
 	if (Loading_locals)
 	{
 		infile=cfopen (LocalTableFilename,"rb");
@@ -2061,6 +2065,7 @@ int mng_AssignGenericPageToObjInfo(mngs_generic_page *genericpage,int n,CFILE *i
 //	memcpy (objinfopointer,&genericpage->objinfo_struct,sizeof(*objinfopointer));
 	memcpy (objinfopointer,&genericpage->objinfo_struct,sizeof(*objinfopointer)-sizeof(anim_elem *)-sizeof(otype_wb_info *)-sizeof(t_ai_info *));
 	strcpy (objinfopointer->name,genericpage->objinfo_struct.name);
+	Object_info_names.update(n);
 	if(objinfopointer->anim)
 		memcpy(objinfopointer->anim,&genericpage->anim,sizeof(genericpage->anim));
 
@@ -2402,6 +2407,26 @@ void mng_AssignObjInfoToGenericPage(int n,mngs_generic_page *genericpage)
 
 }
 
+// Loads a generic page that has already been read from the net table file (or out of the
+// table cache)
+void mng_ApplyNetGenericPage(mngs_generic_page *genericpage,bool overlay,CFILE *infile)
+{
+	int n = FindObjectIDName (genericpage->objinfo_struct.name);
+	if (n!=-1)
+	{
+		if(overlay)
+		{
+			mprintf((0,"OVERLAYING GENERIC %s\n",genericpage->objinfo_struct.name));
+			mng_FreePagetypePrimitives (PAGETYPE_GENERIC,genericpage->objinfo_struct.name,0);
+			mng_AssignGenericPageToObjInfo(genericpage,n);
+		}
+		return; // A weapon has already loaded this generic
+	}
+
+	int ret=mng_SetAndLoadGeneric (genericpage,infile);
+	ASSERT (ret>=0);
+}
+
 // Loads a generic found in the net table file.  It then allocs a generic and
 // then calls SetAndLoadgeneric to actually load in any images/models associated
 // with it
@@ -2411,22 +2436,7 @@ void mng_LoadNetGenericPage(CFILE *infile,bool overlay)
 	memset(&genericpage, 0, sizeof(mngs_generic_page));
 	
 	if (mng_ReadNewGenericPage (infile,&genericpage))
-	{
-		int n = FindObjectIDName (genericpage.objinfo_struct.name);
-		if (n!=-1)
-		{
-			if(overlay)
-			{
-				mprintf((0,"OVERLAYING GENERIC %s\n",genericpage.objinfo_struct.name));
-				mng_FreePagetypePrimitives (PAGETYPE_GENERIC,genericpage.objinfo_struct.name,0);
-				mng_AssignGenericPageToObjInfo(&genericpage,n);
-			}
-			return; // A weapon has already loaded this generic
-		}
-
-		int ret=mng_SetAndLoadGeneric (&genericpage,infile);
-		ASSERT (ret>=0);
-	}
+		mng_ApplyNetGenericPage (&genericpage,overlay,infile);
 	else
 		mprintf ((0,"Could not load genericpage named %s!\n",genericpage.objinfo_struct.name));
 }
@@ -81,6 +81,9 @@ void mng_LoadLocalGenericPage(CFILE *);
 // Reads in a page off the net
 void mng_LoadNetGenericPage (CFILE *,bool overlay=false);
 
+// Loads a page that has already been read off the net (or out of the table cache)
+void mng_ApplyNetGenericPage (mngs_generic_page *genericpage,bool overlay=false,CFILE *infile=NULL);
+
 // First searches through the object index to see if the object is already
 // loaded.  If not, searches in the table file and loads it.  
 // Returns index of object found, -1 if not
@@ -466,6 +466,10 @@
 #include "args.h"
 #include "vclip.h"
 #include "polymodel.h"
+#include "weapon.h"
+#include "objinfo.h"
+#include "soundload.h"
+#include "tablecache.h"
 int Old_table_method=0;
 void mng_WriteNewUnknownPage (CFILE *outfile);
 //	This is for levels
@@ -636,6 +640,67 @@ int mng_InitTableFiles()
 	}
 	return 1;
 }
+// The lookup the Find*Name functions did before the name indices, for comparison
+static int mng_LinearFindName (const char *first_name,int stride,int count,const char *name)
+{
+	for (int i=0;i<count;i++)
+	{
+		const char *n=first_name+i*stride;
+		if (n[0] && !stricmp (name,n))
+			return i;
+	}
+	return -1;
+}
+
+// Looks up every name in a page table (and as many misses) through its name index and
+// through a linear scan, checks they agree and prints how long each took
+template <int t_LEN> static void mng_BenchmarkNameIndex (const char *what,tNameIndex<t_LEN> *index,const char *first_name,int stride)
+{
+	const int rounds=50;
+	const char *miss="No such page";
+	int i,r,names=0,mismatches=0,found=0;
+
+	for (i=0;i<t_LEN;i++)
+	{
+		const char *n=first_name+i*stride;
+		if (!n[0])
+			continue;
+		names++;
+		if (index->find (n)!=mng_LinearFindName (first_name,stride,t_LEN,n))
+			mismatches++;
+	}
+
+	double start=timer_GetTime64();
+	for (r=0;r<rounds;r++)
+		for (i=0;i<t_LEN;i++)
+			if (first_name[i*stride])
+				found+=(index->find (first_name+i*stride)!=-1)+(index->find (miss)!=-1);
+	double index_time=timer_GetTime64()-start;
+
+	start=timer_GetTime64();
+	for (r=0;r<rounds;r++)
+		for (i=0;i<t_LEN;i++)
+			if (first_name[i*stride])
+				found+=(mng_LinearFindName (first_name,stride,t_LEN,first_name+i*stride)!=-1)+(mng_LinearFindName (first_name,stride,t_LEN,miss)!=-1);
+	double scan_time=timer_GetTime64()-start;
+
+	int lookups=rounds*names*2;
+	if (!lookups)
+		return;
+	mprintf ((0,"Name lookup benchmark: %s, %d names, %d mismatches, index %.3fus/lookup, scan %.3fus/lookup (%d)\n",
+		what,names,mismatches,index_time*1000000.0/lookups,scan_time*1000000.0/lookups,found));
+}
+
+// Compares the name indices against the old linear Find*Name scans.  Run with -namebench
+static void mng_BenchmarkNameLookups ()
+{
+	mng_BenchmarkNameIndex ("textures",&Texture_names,GameTextures[0].name,sizeof(texture));
+	mng_BenchmarkNameIndex ("weapons",&Weapon_names,Weapons[0].name,sizeof(weapon));
+	mng_BenchmarkNameIndex ("object ids",&Object_info_names,Object_info[0].name,sizeof(object_info));
+	mng_BenchmarkNameIndex ("sounds",&Sound_names,Sounds[0].name,sizeof(sound_info));
+	mng_BenchmarkNameIndex ("polymodels",&Poly_model_names,Poly_models[0].name,sizeof(poly_model));
+}
+
 // Loads our tables
 int mng_LoadTableFiles (int show_progress)
 {
@@ -678,7 +743,9 @@ int mng_LoadTableFiles (int show_progress)
 		#endif
 	}
 	RemapEverything();
-	
+
+	if (FindArg ("-namebench"))
+		mng_BenchmarkNameLookups ();
 	
 	if (!ret1 || !ret2)
 		return 0;
@@ -1220,6 +1287,7 @@ int mng_RenamePage (char *oldname,char *newname,int pagetype)
 			i=FindTextureName(oname);
 			ASSERT (i!=-1);
 			strcpy (GameTextures[i].name,newname);
+			Texture_names.update(i);
 			
 			l=mng_ReplacePage (oname,GameTextures[i].name,i,PAGETYPE_TEXTURE,0);
 			ASSERT (l==1);
@@ -1231,6 +1299,7 @@ int mng_RenamePage (char *oldname,char *newname,int pagetype)
 			i=FindDoorName(oname);
 			ASSERT (i!=-1);
 			strcpy (Doors[i].name,newname);
+			Door_names.update(i);
 			l=mng_ReplacePage (oname,Doors[i].name,i,PAGETYPE_DOOR,0);
 			if (mng_FindTrackLock (oname,PAGETYPE_DOOR)!=-1)
 				mng_ReplacePage (oname,Doors[i].name,i,PAGETYPE_DOOR,1);
@@ -1240,6 +1309,7 @@ int mng_RenamePage (char *oldname,char *newname,int pagetype)
 			i=FindObjectIDName(oname);
 			ASSERT (i!=-1);
 			strcpy (Object_info[i].name,newname);
+			Object_info_names.update(i);
 			
 			l=mng_ReplacePage (oname,Object_info[i].name,i,PAGETYPE_GENERIC,0);
 			
@@ -1252,6 +1322,7 @@ int mng_RenamePage (char *oldname,char *newname,int pagetype)
 			i=FindGamefileName(oname);
 			ASSERT (i!=-1);
 			strcpy (Gamefiles[i].name,newname);
+			Gamefile_names.update(i);
 			
 			l=mng_ReplacePage (oname,Gamefiles[i].name,i,PAGETYPE_GAMEFILE,0);
 			if (mng_FindTrackLock (oname,PAGETYPE_GAMEFILE)!=-1)
@@ -1262,6 +1333,7 @@ int mng_RenamePage (char *oldname,char *newname,int pagetype)
 			i=FindSoundName(oname);
 			ASSERT (i!=-1);
 			strcpy (Sounds[i].name,newname);
+			Sound_names.update(i);
 			l=mng_ReplacePage (oname,Sounds[i].name,i,PAGETYPE_SOUND,0);
 			if (mng_FindTrackLock (oname,PAGETYPE_SOUND)!=-1)
 				mng_ReplacePage (oname,Sounds[i].name,i,PAGETYPE_SOUND,1);
@@ -1271,6 +1343,7 @@ int mng_RenamePage (char *oldname,char *newname,int pagetype)
 			i=FindMegacellName(oname);
 			ASSERT (i!=-1);
 			strcpy (Megacells[i].name,newname);
+			Megacell_names.update(i);
 			l=mng_ReplacePage (oname,Megacells[i].name,i,PAGETYPE_MEGACELL,0);
 			
 			if (mng_FindTrackLock (oname,PAGETYPE_MEGACELL)!=-1)
@@ -1281,6 +1354,7 @@ int mng_RenamePage (char *oldname,char *newname,int pagetype)
 			i=FindShipName(oname);
 			ASSERT (i!=-1);
 			strcpy (Ships[i].name,newname);
+			Ship_names.update(i);
 			
 			l=mng_ReplacePage (oname,Ships[i].name,i,PAGETYPE_SHIP,0);
 			if (mng_FindTrackLock (oname,PAGETYPE_SHIP)!=-1)
@@ -1292,6 +1366,7 @@ int mng_RenamePage (char *oldname,char *newname,int pagetype)
 			i=FindWeaponName(oname);
 			ASSERT (i!=-1);
 			strcpy (Weapons[i].name,newname);
+			Weapon_names.update(i);
 			
 			l=mng_ReplacePage (oname,Weapons[i].name,i,PAGETYPE_WEAPON,0);
 			if (mng_FindTrackLock (oname,PAGETYPE_WEAPON)!=-1)
@@ -1323,6 +1398,12 @@ int mng_LoadNetPages (int show_progress)
 	mprintf ((0,"Loading pages..."));
 	if (Dedicated_server)
 		show_progress=0;	// turn off progress meter for dedicated server
+
+	// The table cache only knows about TableFilename and extra.gam
+	bool f_cache=(!Network_up && !Old_table_method);
+	if (f_cache && mng_LoadTableCache (show_progress))
+		return 1;
+
 	// If the network is up we still want to read from the local table because it
 	// will allow others to start the game at the same time
 	if (Network_up)
@@ -1439,7 +1520,11 @@ int mng_LoadNetPages (int show_progress)
 	strcpy(name_override,"extra.gam");
 	infile=cfopen (name_override,"rb");
 	if(!infile)
+	{
+		if (f_cache)
+			mng_SaveTableCache ();
 		return 1;
+	}
 
 	mprintf((0,"==================================================\n"));
 	mprintf((0,"              Loading extra.gam                   \n"));
@@ -1505,6 +1590,9 @@ int mng_LoadNetPages (int show_progress)
 	mprintf((0,"\n%d extra pages read.\n",n_pages));
 	TablefileNameOverride = NULL;
 	cfclose(infile);
+
+	if (f_cache)
+		mng_SaveTableCache ();
 	return 1;
 }
 // Loads and allocs all pages found locally
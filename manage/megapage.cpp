@@ -274,6 +274,7 @@ int mng_AssignMegacellPageToMegacell(mngs_megacell_page *megacellpage,int n)
 	// copy our values
 	memcpy (megacellpointer,&megacellpage->megacell_struct,sizeof(megacell));
 	strcpy (megacellpointer->name,megacellpage->megacell_struct.name);
+	Megacell_names.update(n);
 	// Try and load our megacell images from the disk
 	for (i=0;i<MAX_MEGACELL_WIDTH*MAX_MEGACELL_HEIGHT;i++)
 	{
@@ -309,6 +310,15 @@ void mng_AssignMegacellToMegacellPage(int n,mngs_megacell_page *megacellpage)
 			strcpy (megacellpage->cellname[i],"INVALID IMAGE NAME");
 	}
 }
+
+// Loads a megacell page that has already been read from the net table file (or out of the
+// table cache)
+void mng_ApplyNetMegacellPage(mngs_megacell_page *megacellpage)
+{
+	int ret=mng_SetAndLoadMegacell (megacellpage);
+	ASSERT (ret>=0);
+}
+
 // Loads a megacell found in the net table file.  It then allocs a megacell and
 // then calls SetAndLoadMegacell to actually load in any images/models associated
 // with it
@@ -318,10 +328,7 @@ void mng_LoadNetMegacellPage(CFILE *infile)
 	memset(&megacellpage, 0, sizeof(mngs_megacell_page));
 	
 	if (mng_ReadNewMegacellPage (infile,&megacellpage))
-	{
-		int ret=mng_SetAndLoadMegacell (&megacellpage);
-		ASSERT (ret>=0);
-	}
+		mng_ApplyNetMegacellPage (&megacellpage);
 	else
 		mprintf ((0,"Could not load megacellpage named %s!\n",megacellpage.megacell_struct.name));
 }
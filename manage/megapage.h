@@ -69,4 +69,7 @@ void mng_LoadLocalMegacellPage(CFILE *);
 // Reads in a page off the net
 void mng_LoadNetMegacellPage (CFILE *);
 
+// Loads a page that has already been read off the net (or out of the table cache)
+void mng_ApplyNetMegacellPage (mngs_megacell_page *megacellpage);
+
 #endif
\ No newline at end of file
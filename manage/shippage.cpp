@@ -204,6 +204,7 @@
 #include "manage.h"
 #include "ship.h"
 #include "shippage.h"
+#include "tablecache.h"
 #include "mono.h"
 #include "pserror.h"
 #include "polymodel.h"
@@ -879,6 +880,9 @@ int mng_FindSpecificShipPage (char *name,mngs_ship_page *shippage,int offset)
 	int first_try=1;
 	char tablename[TABLE_NAME_LEN];
 
+	if (mng_FindTableCachePage (PAGETYPE_SHIP,name,shippage,offset))
+		return 1;
+
 	if (Loading_locals)
 	{
 		infile=cfopen (LocalTableFilename,"rb");
@@ -993,6 +997,7 @@ int mng_AssignShipPageToShip(mngs_ship_page *shippage,int n,CFILE *infile)
 	// copy our values
 	memcpy (shippointer,&shippage->ship_struct,sizeof(ship));
 	strcpy (shippointer->name,shippage->ship_struct.name);
+	Ship_names.update(n);
 
 
 	// First see if our image differs from the one on the net
@@ -1269,6 +1274,25 @@ void mng_AssignShipToShipPage(int n,mngs_ship_page *shippage)
 
 }
 
+// Loads a ship page that has already been read from the net table file (or out of the
+// table cache)
+void mng_ApplyNetShipPage(mngs_ship_page *shippage,bool overlay,CFILE *infile)
+{
+	int n = FindShipName(shippage->ship_struct.name);
+	if(n!=-1)
+	{
+		if(overlay)
+		{
+			mprintf((0,"OVERLAYING SHIP %s\n",shippage->ship_struct.name));
+			mng_FreePagetypePrimitives (PAGETYPE_SHIP,shippage->ship_struct.name,0);
+			mng_AssignShipPageToShip(shippage,n);
+		}
+		return;
+	}
+	int ret=mng_SetAndLoadShip (shippage,infile);
+	ASSERT (ret>=0);
+}
+
 // Loads a ship found in the net table file.  It then allocs a ship and
 // then calls SetAndLoadShip to actually load in any images/models associated
 // with it
@@ -1280,21 +1304,7 @@ void mng_LoadNetShipPage(CFILE *infile,bool overlay)
 	memset(&shippage, 0, sizeof(mngs_ship_page));
 	
 	if (mng_ReadNewShipPage (infile,&shippage))
-	{
-		int n = FindShipName(shippage.ship_struct.name);
-		if(n!=-1)
-		{
-			if(overlay)
-			{
-				mprintf((0,"OVERLAYING SHIP %s\n",shippage.ship_struct.name));
-				mng_FreePagetypePrimitives (PAGETYPE_SHIP,shippage.ship_struct.name,0);
-				mng_AssignShipPageToShip(&shippage,n);
-			}
-			return;
-		}
-		int ret=mng_SetAndLoadShip (&shippage,infile);
-		ASSERT (ret>=0);
-	}
+		mng_ApplyNetShipPage (&shippage,overlay,infile);
 	else
 		mprintf ((0,"Could not load shippage named %s!\n",shippage.ship_struct.name));
 }
@@ -77,4 +77,7 @@ void mng_LoadLocalShipPage(CFILE *);
 // Reads in a page off the net
 void mng_LoadNetShipPage (CFILE *,bool overlay=false);
 
+// Loads a page that has already been read off the net (or out of the table cache)
+void mng_ApplyNetShipPage (mngs_ship_page *shippage,bool overlay=false,CFILE *infile=NULL);
+
 #endif
\ No newline at end of file
@@ -122,6 +122,7 @@
 #include "CFILE.H"
 #include "manage.h"
 #include "soundpage.h"
+#include "tablecache.h"
 #include "mono.h"
 #include "pserror.h"
 #include "soundload.h"
@@ -335,6 +336,10 @@ int mng_FindSpecificSoundPage (char *name,mngs_sound_page *soundpage,int offset)
 	ubyte pagetype;
 	int done=0,found=0;
 	char tablename[TABLE_NAME_LEN];
+
+	if (mng_FindTableCachePage (PAGETYPE_SOUND,name,soundpage,offset))
+		return 1;
+
 	if (Loading_locals)
 	{
 		infile=cfopen (LocalTableFilename,"rb");
@@ -429,6 +434,7 @@ int mng_AssignSoundPageToSound(mngs_sound_page *soundpage,int n)
 	// copy our values
 	memcpy (soundpointer,&soundpage->sound_struct,sizeof(sound_info));
 	strcpy (soundpointer->name,soundpage->sound_struct.name);
+	Sound_names.update(n);
 	// First see if our raw differs from the one on the net
 	// If it is, make a copy
 	// If its a release version, don't do any of this
@@ -468,6 +474,25 @@ void mng_AssignSoundToSoundPage(int n,mngs_sound_page *soundpage)
 	else 
 		strcpy (soundpage->raw_name,"");
 }
+// Loads a sound page that has already been read from the net table file (or out of the
+// table cache)
+void mng_ApplyNetSoundPage(mngs_sound_page *soundpage,bool overlay)
+{
+	int n = FindSoundName(soundpage->sound_struct.name);
+	if (n!=-1)
+	{
+		if(overlay)
+		{
+			mprintf((0,"OVERLAYING SOUND %s\n",soundpage->sound_struct.name));
+			mng_FreePagetypePrimitives (PAGETYPE_SOUND,soundpage->sound_struct.name,0);
+			mng_AssignSoundPageToSound(soundpage,n);
+		}
+		return;		// already in memory
+	}
+	int ret=mng_SetAndLoadSound (soundpage);
+	ASSERT (ret>=0);
+}
+
 // Loads a sound found in the net table file.  It then allocs a sound and
 // then calls SetAndLoadSound to actually load in any raws associated
 // with it
@@ -477,21 +502,7 @@ void mng_LoadNetSoundPage(CFILE *infile,bool overlay)
 	memset(&soundpage, 0, sizeof(mngs_sound_page));
 	
 	if (mng_ReadNewSoundPage (infile,&soundpage))
-	{
-		int n = FindSoundName(soundpage.sound_struct.name);
-		if (n!=-1)
-		{
-			if(overlay)
-			{
-				mprintf((0,"OVERLAYING SOUND %s\n",soundpage.sound_struct.name));
-				mng_FreePagetypePrimitives (PAGETYPE_SOUND,soundpage.sound_struct.name,0);
-				mng_AssignSoundPageToSound(&soundpage,n);
-			}
-			return;		// already in memory
-		}
-		int ret=mng_SetAndLoadSound (&soundpage);
-		ASSERT (ret>=0);
-	}
+		mng_ApplyNetSoundPage (&soundpage,overlay);
 	else
 		mprintf ((0,"Could not load soundpage named %s!\n",soundpage.sound_struct.name));
 }
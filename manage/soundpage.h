@@ -67,6 +67,9 @@ void mng_LoadLocalSoundPage(CFILE *);
 // Reads in a page off the net
 void mng_LoadNetSoundPage (CFILE *,bool overlay=false);
 
+// Loads a page that has already been read off the net (or out of the table cache)
+void mng_ApplyNetSoundPage (mngs_sound_page *soundpage,bool overlay=false);
+
 // First searches through the sound index to see if the sound is already
 // loaded.  If not, searches in the table file and loads it.  
 // Returns index of sound if found, -1 if not
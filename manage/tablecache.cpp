@@ -0,0 +1,574 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#if defined(WIN32)
+#include <windows.h>
+#elif defined(__LINUX__)
+#include "linux/linux_fix.h"
+#endif
+#include "descent.h"
+#include "manage.h"
+#include "tablecache.h"
+#include "gametexture.h"
+#include "texpage.h"
+#include "doorpage.h"
+#include "genericpage.h"
+#include "gamefilepage.h"
+#include "soundpage.h"
+#include "shippage.h"
+#include "weaponpage.h"
+#include "megapage.h"
+#include "CFILE.H"
+#include "ddio.h"
+#include "mem.h"
+#include "mono.h"
+#include "pserror.h"
+#include "args.h"
+#include "init.h"
+#include "stringtable.h"
+
+// The cache is a header followed by one record per page, in the order the pages are in
+// TableFilename and then extra.gam.  Each record is followed by the page struct, packed by
+// leaving out runs of zeros (most of a texture page is unused procedural arrays), and for
+// generic pages by the description.  Nothing in it points anywhere, all the handles are
+// looked up again when the pages are assigned, just like when they are read from the table.
+
+#define TABLE_CACHE_ID			"TBLC"
+#define TABLE_CACHE_VERSION	1
+
+#define NUM_TABLE_CACHE_PAGETYPES	(PAGETYPE_GENERIC+1)
+
+struct table_cache_header
+{
+	char id[4];
+	int version;
+	int size;										// size of the whole file, to catch partial writes
+	uint table_crc;								// crc of TableFilename
+	uint extra_crc;								// crc of extra.gam, 0xFFFFFFFF if there isn't one
+	int pagename_len;
+	int page_size[NUM_TABLE_CACHE_PAGETYPES];	// sizeof each page struct, 0 if it isn't cached
+	int num_records;
+};
+
+struct table_cache_record
+{
+	ubyte pagetype;
+	ubyte extra;						// 1 if the page is from extra.gam
+	short pad;
+	int offset;							// where the page starts in its table file
+	int packed_len;
+	int description_len;				// including the null, 0 if there's no description
+	char name[PAGENAME_LEN];
+};
+
+extern char *TablefileNameOverride;
+
+static char Table_cache_extra_name[]="extra.gam";
+
+// Set while mng_LoadTableCache is loading the pages
+static const ubyte *Table_cache_data=NULL;
+static int *Table_cache_records=NULL;
+static int Table_cache_num_records=0;
+
+// Returns the size of the page struct for pagetype, or 0 if pages of that type aren't cached
+static int table_cache_page_size (int pagetype)
+{
+	switch (pagetype)
+	{
+		case PAGETYPE_TEXTURE:	return sizeof(mngs_texture_page);
+		case PAGETYPE_DOOR:		return sizeof(mngs_door_page);
+		case PAGETYPE_GENERIC:	return sizeof(mngs_generic_page);
+		case PAGETYPE_GAMEFILE:	return sizeof(mngs_gamefile_page);
+		case PAGETYPE_SOUND:		return sizeof(mngs_sound_page);
+		case PAGETYPE_SHIP:		return sizeof(mngs_ship_page);
+		case PAGETYPE_WEAPON:	return sizeof(mngs_weapon_page);
+		case PAGETYPE_MEGACELL:	return sizeof(mngs_megacell_page);
+	}
+	return 0;
+}
+
+static char *table_cache_page_name (int pagetype,void *page)
+{
+	switch (pagetype)
+	{
+		case PAGETYPE_TEXTURE:	return ((mngs_texture_page *)page)->tex_struct.name;
+		case PAGETYPE_DOOR:		return ((mngs_door_page *)page)->door_struct.name;
+		case PAGETYPE_GENERIC:	return ((mngs_generic_page *)page)->objinfo_struct.name;
+		case PAGETYPE_GAMEFILE:	return ((mngs_gamefile_page *)page)->gamefile_struct.name;
+		case PAGETYPE_SOUND:		return ((mngs_sound_page *)page)->sound_struct.name;
+		case PAGETYPE_SHIP:		return ((mngs_ship_page *)page)->ship_struct.name;
+		case PAGETYPE_WEAPON:	return ((mngs_weapon_page *)page)->weapon_struct.name;
+		case PAGETYPE_MEGACELL:	return ((mngs_megacell_page *)page)->megacell_struct.name;
+	}
+	Int3();
+	return NULL;
+}
+
+static int table_cache_read_page (int pagetype,CFILE *infile,void *page)
+{
+	switch (pagetype)
+	{
+		case PAGETYPE_TEXTURE:	return mng_ReadNewTexturePage (infile,(mngs_texture_page *)page);
+		case PAGETYPE_DOOR:		return mng_ReadNewDoorPage (infile,(mngs_door_page *)page);
+		case PAGETYPE_GENERIC:	return mng_ReadNewGenericPage (infile,(mngs_generic_page *)page);
+		case PAGETYPE_GAMEFILE:	return mng_ReadNewGamefilePage (infile,(mngs_gamefile_page *)page);
+		case PAGETYPE_SOUND:		return mng_ReadNewSoundPage (infile,(mngs_sound_page *)page);
+		case PAGETYPE_SHIP:		return mng_ReadNewShipPage (infile,(mngs_ship_page *)page);
+		case PAGETYPE_WEAPON:	return mng_ReadNewWeaponPage (infile,(mngs_weapon_page *)page);
+		case PAGETYPE_MEGACELL:	return mng_ReadNewMegacellPage (infile,(mngs_megacell_page *)page);
+	}
+	return 0;
+}
+
+static int table_cache_max_page_size ()
+{
+	int max_size=0;
+
+	for (int i=0;i<NUM_TABLE_CACHE_PAGETYPES;i++)
+		if (table_cache_page_size (i)>max_size)
+			max_size=table_cache_page_size (i);
+
+	return max_size;
+}
+
+// Packs size bytes of src into dest as runs of (zero count, byte count, bytes).  dest must
+// have room for size*2+4 bytes.  Returns the packed length
+static int table_cache_pack (ubyte *dest,const ubyte *src,int size)
+{
+	int pos=0,len=0;
+
+	while (pos<size)
+	{
+		ushort run[2];
+		int zeros=0,count=0;
+
+		while (pos+zeros<size && !src[pos+zeros] && zeros<0xffff)
+			zeros++;
+		pos+=zeros;
+
+		// Copy bytes up to the next run of 8 zeros
+		while (pos+count<size && count<0xffff-8)
+		{
+			if (src[pos+count])
+			{
+				count++;
+				continue;
+			}
+
+			int z=0;
+			while (pos+count+z<size && !src[pos+count+z] && z<8)
+				z++;
+			if (z==8 || pos+count+z==size)
+				break;
+			count+=z;
+		}
+
+		run[0]=zeros;
+		run[1]=count;
+		memcpy (dest+len,run,sizeof(run));
+		memcpy (dest+len+sizeof(run),src+pos,count);
+		len+=sizeof(run)+count;
+		pos+=count;
+	}
+
+	return len;
+}
+
+// Unpacks what table_cache_pack made into size bytes of dest.  If dest is NULL, only checks
+// that the packed data fits.  Returns false if it doesn't
+static bool table_cache_unpack (ubyte *dest,int size,const ubyte *src,int len)
+{
+	int pos=0,spos=0;
+
+	if (dest)
+		memset (dest,0,size);
+
+	while (spos<len)
+	{
+		ushort run[2];
+
+		if (spos+(int)sizeof(run)>len)
+			return false;
+		memcpy (run,src+spos,sizeof(run));
+		spos+=sizeof(run);
+		pos+=run[0];
+
+		if (pos+run[1]>size || spos+run[1]>len)
+			return false;
+		if (dest)
+			memcpy (dest+pos,src+spos,run[1]);
+		pos+=run[1];
+		spos+=run[1];
+	}
+
+	return true;
+}
+
+static void table_cache_filename (char *filename,uint table_crc)
+{
+	char name[_MAX_PATH];
+
+	sprintf (name,"table%08x.cache",table_crc);
+	ddio_MakePath (filename,User_directory,"tablecache",name,NULL);
+}
+
+// Copies the page out of record n into page, which has room for the whole page struct
+static void table_cache_get_page (int n,table_cache_record *rec,void *page)
+{
+	const ubyte *data=Table_cache_data+Table_cache_records[n];
+
+	memcpy (rec,data,sizeof(*rec));
+	data+=sizeof(*rec);
+
+	table_cache_unpack ((ubyte *)page,table_cache_page_size (rec->pagetype),data,rec->packed_len);
+	data+=rec->packed_len;
+
+	if (rec->pagetype==PAGETYPE_GENERIC)
+	{
+		mngs_generic_page *genericpage=(mngs_generic_page *)page;
+		if (rec->description_len)
+		{
+			genericpage->objinfo_struct.description=(char *)mem_malloc (rec->description_len);
+			ASSERT (genericpage->objinfo_struct.description);
+			memcpy (genericpage->objinfo_struct.description,data,rec->description_len);
+		}
+		else
+			genericpage->objinfo_struct.description=NULL;
+	}
+}
+
+int mng_FindTableCachePage (int pagetype,char *name,void *page,int offset)
+{
+	if (!Table_cache_data || Loading_locals || Loading_addon_table!=-1)
+		return 0;
+
+	// While extra.gam is being loaded the FindSpecific functions search it first
+	int extra=TablefileNameOverride?1:0;
+
+	for (int i=0;i<Table_cache_num_records;i++)
+	{
+		table_cache_record rec;
+		memcpy (&rec,Table_cache_data+Table_cache_records[i],sizeof(rec));
+
+		if (rec.pagetype!=pagetype || rec.extra!=extra || rec.offset<offset || stricmp (rec.name,name))
+			continue;
+
+		table_cache_get_page (i,&rec,page);
+		return 1;
+	}
+
+	return 0;
+}
+
+// Checks the header and that every record fits in the file, and finds where the records are
+static bool table_cache_check (const ubyte *data,int length,uint table_crc,uint extra_crc)
+{
+	table_cache_header header;
+	int i,pos;
+
+	if (length<(int)sizeof(header))
+		return false;
+
+	memcpy (&header,data,sizeof(header));
+	if (strncmp (header.id,TABLE_CACHE_ID,4) || header.version!=TABLE_CACHE_VERSION ||
+		header.size!=length || header.table_crc!=table_crc || header.extra_crc!=extra_crc ||
+		header.pagename_len!=PAGENAME_LEN || header.num_records<=0)
+		return false;
+
+	for (i=0;i<NUM_TABLE_CACHE_PAGETYPES;i++)
+		if (header.page_size[i]!=table_cache_page_size (i))
+			return false;
+
+	Table_cache_records=(int *)mem_malloc (header.num_records*sizeof(int));
+	if (!Table_cache_records)
+		return false;
+
+	pos=sizeof(header);
+	for (i=0;i<header.num_records;i++)
+	{
+		table_cache_record rec;
+
+		if (pos+(int)sizeof(rec)>length)
+			return false;
+		memcpy (&rec,data+pos,sizeof(rec));
+		Table_cache_records[i]=pos;
+		pos+=sizeof(rec);
+
+		int size=table_cache_page_size (rec.pagetype);
+		if (!size || rec.name[PAGENAME_LEN-1] || rec.packed_len<0 || rec.description_len<0 ||
+			rec.packed_len>length-pos || rec.description_len>length-pos-rec.packed_len)
+			return false;
+
+		if (!table_cache_unpack (NULL,size,data+pos,rec.packed_len))
+			return false;
+		pos+=rec.packed_len;
+
+		if (rec.description_len && data[pos+rec.description_len-1])
+			return false;
+		pos+=rec.description_len;
+	}
+
+	Table_cache_num_records=header.num_records;
+	return pos==length;
+}
+
+int mng_LoadTableCache (int show_progress)
+{
+	char filename[_MAX_PATH];
+	int length,i;
+	int int_progress=0;
+
+	if (FindArg ("-notablecache"))
+		return 0;
+
+	uint table_crc=cf_GetfileCRC (TableFilename);
+	uint extra_crc=cf_GetfileCRC (Table_cache_extra_name);
+	if (table_crc==0xFFFFFFFF)
+		return 0;
+
+	table_cache_filename (filename,table_crc);
+
+	ubyte *data=(ubyte *)ddio_MapFile (filename,&length);
+	if (!data)
+		return 0;
+
+	if (!table_cache_check (data,length,table_crc,extra_crc))
+	{
+		mprintf ((0,"Table cache %s is out of date\n",filename));
+		if (Table_cache_records)
+			mem_free (Table_cache_records);
+		Table_cache_records=NULL;
+		Table_cache_num_records=0;
+		ddio_UnmapFile (data,length);
+		return 0;
+	}
+
+	float start_time=timer_GetTime();
+	void *page=mem_malloc (table_cache_max_page_size ());
+	ASSERT (page);
+
+	Table_cache_data=data;
+
+	for (i=0;i<Table_cache_num_records;i++)
+	{
+		table_cache_record rec;
+
+		if (show_progress)
+		{
+			float progress=(float)i/(float)Table_cache_num_records;
+			int temp_int_progress=progress*20;
+			if (temp_int_progress>int_progress)
+			{
+				int_progress=temp_int_progress;
+				InitMessage (TXT_INITDATA,progress);
+			}
+		}
+
+		table_cache_get_page (i,&rec,page);
+
+		// The FindSpecific functions look at TablefileNameOverride to know which table
+		// file they would be searching
+		TablefileNameOverride=rec.extra?Table_cache_extra_name:NULL;
+		bool overlay=rec.extra!=0;
+
+		switch (rec.pagetype)
+		{
+			case PAGETYPE_TEXTURE:
+				mng_ApplyNetTexturePage ((mngs_texture_page *)page,overlay);
+				break;
+			case PAGETYPE_DOOR:
+				mng_ApplyNetDoorPage ((mngs_door_page *)page,overlay);
+				break;
+			case PAGETYPE_GENERIC:
+				mng_ApplyNetGenericPage ((mngs_generic_page *)page,overlay);
+				break;
+			case PAGETYPE_GAMEFILE:
+				mng_ApplyNetGamefilePage ((mngs_gamefile_page *)page,overlay);
+				break;
+			case PAGETYPE_SOUND:
+				mng_ApplyNetSoundPage ((mngs_sound_page *)page,overlay);
+				break;
+			case PAGETYPE_SHIP:
+				mng_ApplyNetShipPage ((mngs_ship_page *)page,overlay);
+				break;
+			case PAGETYPE_WEAPON:
+				mng_ApplyNetWeaponPage ((mngs_weapon_page *)page,overlay);
+				break;
+			case PAGETYPE_MEGACELL:
+				mng_ApplyNetMegacellPage ((mngs_megacell_page *)page);
+				break;
+		}
+	}
+
+	TablefileNameOverride=NULL;
+	Table_cache_data=NULL;
+	mem_free (page);
+	mem_free (Table_cache_records);
+	Table_cache_records=NULL;
+	ddio_UnmapFile (data,length);
+
+	mprintf ((0,"\n%d pages loaded from table cache %s in %.1f seconds.\n",Table_cache_num_records,filename,timer_GetTime()-start_time));
+	Table_cache_num_records=0;
+	return 1;
+}
+
+// Adds the pages of one table file to the cache.  Returns false if the file has pages
+// mng_LoadNetPages wouldn't load from it
+static bool table_cache_write_pages (CFILE *fp,CFILE *infile,int extra,ubyte *page,ubyte *packed,int *num_records)
+{
+	while (!cfeof (infile))
+	{
+		table_cache_record rec;
+
+		rec.offset=cftell (infile);
+		rec.pagetype=cf_ReadByte (infile);
+		cf_ReadInt (infile);
+
+		if (rec.pagetype==PAGETYPE_UNKNOWN)
+			continue;
+
+		int size=table_cache_page_size (rec.pagetype);
+		if (!size || (extra && rec.pagetype==PAGETYPE_MEGACELL))
+			return false;
+
+		memset (page,0,size);
+		if (!table_cache_read_page (rec.pagetype,infile,page))
+			continue;
+
+		// Descriptions get written after the page
+		char *description=NULL;
+		if (rec.pagetype==PAGETYPE_GENERIC)
+		{
+			description=((mngs_generic_page *)page)->objinfo_struct.description;
+			((mngs_generic_page *)page)->objinfo_struct.description=NULL;
+		}
+
+		rec.extra=extra;
+		rec.pad=0;
+		rec.packed_len=table_cache_pack (packed,page,size);
+		rec.description_len=description?strlen (description)+1:0;
+		memset (rec.name,0,PAGENAME_LEN);
+		strncpy (rec.name,table_cache_page_name (rec.pagetype,page),PAGENAME_LEN-1);
+
+		cf_WriteBytes ((ubyte *)&rec,sizeof(rec),fp);
+		cf_WriteBytes (packed,rec.packed_len,fp);
+		if (description)
+		{
+			cf_WriteBytes ((ubyte *)description,rec.description_len,fp);
+			mem_free (description);
+		}
+
+		(*num_records)++;
+	}
+
+	return true;
+}
+
+void mng_SaveTableCache ()
+{
+	char dirname[_MAX_PATH],filename[_MAX_PATH],tempname[_MAX_PATH];
+
+	if (FindArg ("-notablecache"))
+		return;
+
+	uint table_crc=cf_GetfileCRC (TableFilename);
+	if (table_crc==0xFFFFFFFF)
+		return;
+
+	ddio_MakePath (dirname,User_directory,"tablecache",NULL);
+	if (!ddio_DirExists (dirname) && !ddio_CreateDir (dirname))
+		return;
+
+	table_cache_filename (filename,table_crc);
+
+	CFILE *infile=cfopen (TableFilename,"rb");
+	if (!infile)
+		return;
+
+	// Each writer gets its own temp file, so two servers sharing a user directory can't write into
+	// each other's
+	CFILE *fp=NULL;
+	if (ddio_GetTempFileName (dirname,"tbl",tempname))
+	{
+		fp=cfopen (tempname,"wb");
+		if (!fp)
+			ddio_DeleteFile (tempname);
+	}
+	if (!fp)
+	{
+		cfclose (infile);
+		return;
+	}
+
+	table_cache_header header;
+	memcpy (header.id,TABLE_CACHE_ID,4);
+	header.version=TABLE_CACHE_VERSION;
+	header.size=0;
+	header.table_crc=table_crc;
+	header.extra_crc=cf_GetfileCRC (Table_cache_extra_name);
+	header.pagename_len=PAGENAME_LEN;
+	for (int i=0;i<NUM_TABLE_CACHE_PAGETYPES;i++)
+		header.page_size[i]=table_cache_page_size (i);
+	header.num_records=0;
+	cf_WriteBytes ((ubyte *)&header,sizeof(header),fp);
+
+	int max_size=table_cache_max_page_size ();
+	ubyte *page=(ubyte *)mem_malloc (max_size);
+	ubyte *packed=(ubyte *)mem_malloc (max_size*2+4);
+	ASSERT (page && packed);
+
+	bool ok=table_cache_write_pages (fp,infile,0,page,packed,&header.num_records);
+	cfclose (infile);
+
+	if (ok)
+	{
+		infile=cfopen (Table_cache_extra_name,"rb");
+		if (infile)
+		{
+			ok=table_cache_write_pages (fp,infile,1,page,packed,&header.num_records);
+			cfclose (infile);
+		}
+	}
+
+	mem_free (page);
+	mem_free (packed);
+
+	// Now that the size is known, fill it in
+	header.size=cftell (fp);
+	cfseek (fp,0,SEEK_SET);
+	cf_WriteBytes ((ubyte *)&header,sizeof(header),fp);
+	cfclose (fp);
+
+	if (!ok)
+	{
+		mprintf ((0,"Table files have pages the table cache can't hold\n"));
+		ddio_DeleteFile (tempname);
+		return;
+	}
+
+	ddio_DeleteFile (filename);
+	if (!ddio_RenameFile (tempname,filename))
+	{
+		ddio_DeleteFile (tempname);
+		return;
+	}
+
+	mprintf ((0,"Saved %d pages to table cache %s\n",header.num_records,filename));
+}
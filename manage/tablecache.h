@@ -0,0 +1,39 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef TABLECACHE_H
+#define TABLECACHE_H
+
+// Table cache functions
+//---------------------------------------------------------------
+// The table cache holds every page of TableFilename and extra.gam already parsed, so
+// mng_LoadNetPages doesn't have to read the pages field by field and the FindSpecific
+// functions don't have to rescan the table files for pages that haven't been loaded yet.
+
+// Loads the net pages from the table cache.  Returns 1 on success, or 0 if there is no
+// cache for the current table files, in which case nothing has been loaded
+int mng_LoadTableCache (int show_progress);
+
+// Reads the pages of the table files and saves them to the table cache
+void mng_SaveTableCache ();
+
+// While mng_LoadTableCache is running, copies the page of type pagetype named "name" out
+// of the cache, searching the same table file the FindSpecific functions would (starting
+// at offset).  Returns 1 if it was found, 0 if the table file needs to be searched
+int mng_FindTableCachePage (int pagetype,char *name,void *page,int offset);
+
+#endif
@@ -267,6 +267,7 @@
 #include "mono.h"
 #include "pserror.h"
 #include "texpage.h"
+#include "tablecache.h"
 #include <string.h>
 #include "vclip.h"
 #include "ddio.h"
@@ -896,6 +897,9 @@ int mng_FindSpecificTexPage (char *name,mngs_texture_page *texpage,int offset)
 	int first_try=1;
 	char tablename[TABLE_NAME_LEN];
 
+	if (mng_FindTableCachePage (PAGETYPE_TEXTURE,name,texpage,offset))
+		return 1;
+
 	if (Loading_locals)
 	{
 		infile=cfopen (LocalTableFilename,"rb");
@@ -1008,6 +1012,7 @@ int mng_AssignTexPageToTexture(mngs_texture_page *texpage,int n,CFILE *infile)
 
 	// copy our values
 	memcpy (tex,&texpage->tex_struct,sizeof(texture));
+	Texture_names.update(n);
 
 	// Check to see if this image differs from the one on the net
 	// If so, make a local copy
@@ -1215,29 +1220,34 @@ void mng_AssignTextureToTexPage(int n,mngs_texture_page *texpage)
 	}
 }
 
+// Loads a texture page that has already been read from the net table file (or out of the
+// table cache)
+void mng_ApplyNetTexturePage(mngs_texture_page *texpage,bool overlay,CFILE *infile)
+{
+	int n;
+	n = FindTextureName(texpage->tex_struct.name);
+	if(n!=-1)
+	{
+		if(overlay)
+		{
+			mprintf((0,"OVERLAYING TEXTURE %s\n",texpage->tex_struct.name));
+			mng_FreePagetypePrimitives (PAGETYPE_TEXTURE,texpage->tex_struct.name,0);
+			mng_AssignTexPageToTexture(texpage,n);
+		}			
+		return;
+	}
+
+	int ret=mng_SetAndLoadTexture (texpage,infile);
+	ASSERT (ret>=0);
+}
+
 // Loads in a texture page
 void mng_LoadNetTexturePage(CFILE *infile,bool overlay)
 {
 	memset(&texpage1, 0, sizeof(mngs_texture_page));
 	
 	if (mng_ReadNewTexturePage (infile,&texpage1))
-	{
-		int n;
-		n = FindTextureName(texpage1.tex_struct.name);
-		if(n!=-1)
-		{
-			if(overlay)
-			{
-				mprintf((0,"OVERLAYING TEXTURE %s\n",texpage1.tex_struct.name));
-				mng_FreePagetypePrimitives (PAGETYPE_TEXTURE,texpage1.tex_struct.name,0);
-				mng_AssignTexPageToTexture(&texpage1,n);
-			}			
-			return;
-		}
-
-		int ret=mng_SetAndLoadTexture (&texpage1,infile);
-		ASSERT (ret>=0);
-	}
+		mng_ApplyNetTexturePage (&texpage1,overlay,infile);
 	else
 		mprintf ((0,"Could not load texpage named %s!\n",texpage1.tex_struct.name));
 }
@@ -83,6 +83,9 @@ void mng_LoadLocalTexturePage(CFILE *);
 // Reads in a page off the net
 void mng_LoadNetTexturePage (CFILE *,bool overlay=false);
 
+// Loads a page that has already been read off the net (or out of the table cache)
+void mng_ApplyNetTexturePage (mngs_texture_page *texpage,bool overlay=false,CFILE *infile=NULL);
+
 // Reads in the texpage named "name" into texpage struct
 // Returns 0 on error, else 1 if all is good
 int mng_FindSpecificTexPage (char *name,mngs_texture_page *texpage,int offset=0);
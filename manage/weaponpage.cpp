@@ -293,6 +293,7 @@
 #include "manage.h"
 #include "weapon.h"
 #include "weaponpage.h"
+#include "tablecache.h"
 #include "mono.h"
 #include "pserror.h"
 #include "vclip.h"
@@ -1193,6 +1194,9 @@ int mng_FindSpecificWeaponPage (char *name,mngs_weapon_page *weaponpage)
 	int first_try=1;
 	char tablename[TABLE_NAME_LEN];
 
+	if (mng_FindTableCachePage (PAGETYPE_WEAPON,name,weaponpage,0))
+		return 1;
+
 	if (Loading_locals)
 	{
 		infile=cfopen (LocalTableFilename,"rb");
@@ -1285,6 +1289,9 @@ int mng_FindSpecificWeaponPage (char *name,mngs_weapon_page *weaponpage,int offs
 	ubyte pagetype;
 	int done=0,found=0;
 	
+	if (mng_FindTableCachePage (PAGETYPE_WEAPON,name,weaponpage,offset))
+		return 1;
+
 	if (Loading_locals)
 	{
 		infile=cfopen (LocalTableFilename,"rb");
@@ -1436,6 +1443,7 @@ int mng_AssignWeaponPageToWeapon(mngs_weapon_page *weaponpage,int n,CFILE *infil
 	// copy our values
 	memcpy (weaponpointer,&weaponpage->weapon_struct,sizeof(weapon));
 	strcpy (weaponpointer->name,weaponpage->weapon_struct.name);
+	Weapon_names.update(n);
 
 
 	// First see if our image differs from the one on the net
@@ -1775,6 +1783,27 @@ void mng_AssignWeaponToWeaponPage(int n,mngs_weapon_page *weaponpage)
 
 }
 
+// Loads a weapon page that has already been read from the net table file (or out of the
+// table cache)
+void mng_ApplyNetWeaponPage(mngs_weapon_page *weaponpage,bool overlay,CFILE *infile)
+{
+	int n = FindWeaponName (weaponpage->weapon_struct.name);
+	if (n!=-1)
+	{
+		if(overlay)
+		{
+			mprintf((0,"OVERLAYING WEAPON %s\n",weaponpage->weapon_struct.name));
+			mng_FreePagetypePrimitives (PAGETYPE_WEAPON,weaponpage->weapon_struct.name,0);
+			mng_AssignWeaponPageToWeapon(weaponpage,n);
+		}
+		//mprintf ((0,"Found weapon dependency! You probably should reorder the netpages.\n"));
+		return;
+	}
+
+	int ret=mng_SetAndLoadWeapon (weaponpage,infile);
+	ASSERT (ret>=0);
+}
+
 // Loads a weapon found in the net table file.  It then allocs a weapon and
 // then calls SetAndLoadWeapon to actually load in any images/models associated
 // with it
@@ -1784,23 +1813,7 @@ void mng_LoadNetWeaponPage(CFILE *infile,bool overlay)
 	memset(&weaponpage, 0, sizeof(mngs_weapon_page));
 	
 	if (mng_ReadNewWeaponPage (infile,&weaponpage))
-	{
-		int n = FindWeaponName (weaponpage.weapon_struct.name);
-		if (n!=-1)
-		{
-			if(overlay)
-			{
-				mprintf((0,"OVERLAYING WEAPON %s\n",weaponpage.weapon_struct.name));
-				mng_FreePagetypePrimitives (PAGETYPE_WEAPON,weaponpage.weapon_struct.name,0);
-				mng_AssignWeaponPageToWeapon(&weaponpage,n);
-			}
-			//mprintf ((0,"Found weapon dependency! You probably should reorder the netpages.\n"));
-			return;
-		}
-
-		int ret=mng_SetAndLoadWeapon (&weaponpage,infile);
-		ASSERT (ret>=0);
-	}
+		mng_ApplyNetWeaponPage (&weaponpage,overlay,infile);
 	else
 		mprintf ((0,"Could not load weaponpage named %s!\n",weaponpage.weapon_struct.name));
 }
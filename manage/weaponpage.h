@@ -81,6 +81,9 @@ void mng_LoadLocalWeaponPage(CFILE *);
 // Reads in a page off the net
 void mng_LoadNetWeaponPage (CFILE *,bool overlay=false);
 
+// Loads a page that has already been read off the net (or out of the table cache)
+void mng_ApplyNetWeaponPage (mngs_weapon_page *weaponpage,bool overlay=false,CFILE *infile=NULL);
+
 int mng_GetGuaranteedWeaponPage (char *name,CFILE *infile=NULL);
 
 #endif
\ No newline at end of file
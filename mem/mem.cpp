@@ -305,6 +305,11 @@ void *mem_realloc_sub(void *mem,int size)
 {
 	return realloc(mem,size);
 }
+void *mem_adopt_sub(void *memblock,int size,const char *file,int line)
+{
+	LnxTotalMemUsed += size;
+	return memblock;
+}
 int mem_size_sub(void *memblock)
 {
 #if defined(MACOSX)
@@ -523,6 +528,18 @@ void *mem_realloc_sub(void *mem,int size)
 	}
 	return new_mem;
 }
+void *mem_adopt_sub(void *memblock,int size,const char *file,int line)
+{
+#ifdef USE_MALLOC
+	return memblock;
+#else
+	void *new_mem = mem_malloc_sub(size,file,line);
+	if(new_mem)
+		memcpy(new_mem,memblock,size);
+	free(memblock);
+	return new_mem;
+#endif
+}
 int mem_size_sub(void *memblock)
 {
 	return 0;
@@ -949,6 +966,19 @@ void * mem_realloc_sub(void * memblock,int size)
 	return retp;
 #endif
 }
+void *mem_adopt_sub(void *memblock,int size,const char *file,int line)
+{
+#ifdef MEM_USE_RTL
+	return memblock;
+#else
+	//The block isn't from our heap, so it has to be copied into it
+	void *new_mem = mem_malloc_sub(size,file,line);
+	if(new_mem)
+		memcpy(new_mem,memblock,size);
+	free(memblock);
+	return new_mem;
+#endif
+}
 int mem_size_sub(void *memblock)
 {
 #if defined(WIN32)
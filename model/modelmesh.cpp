@@ -0,0 +1,282 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Polymodels drawn from meshes kept on the card.  A model's faces are uploaded once, sorted
+// by texture, and every draw only sends the renderer a matrix per submodel.  Instances of the
+// same model are drawn together by the renderer.  Anything the mesh can't show (glows, facing
+// and custom submodels, alpha textures, lightmaps, most effects) is left to RenderPolygonModel.
+
+#include <algorithm>
+#include <vector>
+#include "polymodel.h"
+#include "renderer.h"
+#include "gametexture.h"
+#include "pserror.h"
+#include "mono.h"
+
+#define MESH_UNBUILT		0
+#define MESH_BUILT		1
+#define MESH_UNSUITED	2		// the model can't be drawn from a mesh
+
+// The submodel flags and effects the mesh can't show
+#define MESH_SUBMODEL_FLAGS	(SOF_GLOW|SOF_THRUSTER|SOF_FACING|SOF_CUSTOM|SOF_JITTER)
+#define MESH_EFFECTS				(PEF_COLOR|PEF_MED_RES|PEF_LO_RES|PEF_GLOW_SCALAR|PEF_THRUSTER_SCALAR|PEF_DRAW_HEADLIGHTS|PEF_NO_GLOWS|PEF_CUSTOM_GLOW)
+
+typedef struct
+{
+	ubyte state;
+	int handle;
+	int num_batches;
+	short batch_texnum[MAX_MODEL_TEXTURES];		// index into the model's textures
+	int batch_first[MAX_MODEL_TEXTURES];
+	int batch_count[MAX_MODEL_TEXTURES];
+} model_mesh;
+
+static model_mesh Model_meshes[MAX_POLY_MODELS];
+
+typedef struct
+{
+	short submodel;
+	short facenum;
+	short texnum;
+} mesh_face;
+
+static bool MeshFaceCompare (const mesh_face &a,const mesh_face &b)
+{
+	return a.texnum<b.texnum;
+}
+
+// Adds the faces of a submodel and its children, skipping the ones RenderSubmodel doesn't draw.
+// Returns false if one of them can't be drawn from a mesh
+static bool AddSubmodelFaces (poly_model *pm,int sn,std::vector<mesh_face> &faces)
+{
+	bsp_info *sm=&pm->submodel[sn];
+
+	if (IsNonRenderableSubmodel (pm,sn))
+		return true;
+
+	if (sm->flags & MESH_SUBMODEL_FLAGS)
+		return false;
+
+	for (int i=0;i<sm->num_faces;i++)
+	{
+		polyface *fp=&sm->faces[i];
+
+		if (fp->texnum==-1)
+			return false;
+
+		texture *texp=&GameTextures[pm->textures[fp->texnum]];
+		if ((texp->flags & (TF_ALPHA|TF_SATURATE)) || texp->slide_u!=0 || texp->slide_v!=0)
+			return false;
+
+		mesh_face face;
+		face.submodel=sn;
+		face.facenum=i;
+		face.texnum=fp->texnum;
+		faces.push_back (face);
+	}
+
+	for (int i=0;i<sm->num_children;i++)
+	{
+		if (!AddSubmodelFaces (pm,sm->children[i],faces))
+			return false;
+	}
+
+	return true;
+}
+
+// Uploads the faces of a model, if it can be drawn from a mesh
+static void BuildPolymodelMesh (int model_num)
+{
+	poly_model *pm=&Poly_models[model_num];
+	model_mesh *mm=&Model_meshes[model_num];
+	std::vector<mesh_face> faces;
+	int i,t;
+
+	mm->state=MESH_UNSUITED;
+	mm->handle=-1;
+
+	if (!pm->new_style || !(pm->flags & PMF_TIMED))
+		return;
+
+	for (i=0;i<pm->n_models;i++)
+	{
+		if (pm->submodel[i].parent==-1 && !AddSubmodelFaces (pm,i,faces))
+			return;
+	}
+
+	if (faces.empty())
+		return;
+
+	std::stable_sort (faces.begin(),faces.end(),MeshFaceCompare);
+
+	std::vector<rend_model_vertex> verts;
+	std::vector<ushort> indices;
+
+	mm->num_batches=0;
+	for (i=0;i<(int)faces.size();i++)
+	{
+		bsp_info *sm=&pm->submodel[faces[i].submodel];
+		polyface *fp=&sm->faces[faces[i].facenum];
+		int fullbright=(GameTextures[pm->textures[fp->texnum]].flags & TF_LIGHT)?1:0;
+		int first=verts.size();
+
+		if (first+fp->nverts>65536)
+		{
+			mprintf ((0,"Polymodel %s has too many vertices for a mesh\n",pm->name));
+			return;
+		}
+
+		if (i==0 || fp->texnum!=faces[i-1].texnum)
+		{
+			mm->batch_texnum[mm->num_batches]=fp->texnum;
+			mm->batch_first[mm->num_batches]=indices.size();
+			mm->batch_count[mm->num_batches]=0;
+			mm->num_batches++;
+		}
+
+		for (t=0;t<fp->nverts;t++)
+		{
+			int vn=fp->vertnums[t];
+			rend_model_vertex vert;
+
+			vert.pos=sm->verts[vn];
+			vert.normal=sm->vertnorms[vn];
+			vert.u=fp->u[t];
+			vert.v=fp->v[t];
+			vert.alpha=sm->alpha[vn];
+			vert.submodel=faces[i].submodel;
+			vert.fullbright=fullbright;
+			verts.push_back (vert);
+		}
+
+		// Same fan rend_DrawPolygon3D makes of the face
+		for (t=2;t<fp->nverts;t++)
+		{
+			indices.push_back (first);
+			indices.push_back (first+t-1);
+			indices.push_back (first+t);
+		}
+
+		mm->batch_count[mm->num_batches-1]+=(fp->nverts-2)*3;
+	}
+
+	mm->handle=rend_CreateModelMesh (verts.size(),verts.data(),indices.size(),indices.data());
+	if (mm->handle!=-1)
+		mm->state=MESH_BUILT;
+}
+
+// Frees the mesh of polymodel i.  It is built again the next time the model is drawn
+void FreePolymodelMesh (int i)
+{
+	if (Model_meshes[i].state==MESH_BUILT)
+		rend_FreeModelMesh (Model_meshes[i].handle);
+
+	Model_meshes[i].state=MESH_UNBUILT;
+	Model_meshes[i].handle=-1;
+}
+
+// Applies m to the vector v, the same way g3_StartInstanceMatrix places a point in its parent
+static inline vector MeshRotate (matrix *m,vector *v)
+{
+	return (v->x*m->rvec)+(v->y*m->uvec)+(v->z*m->fvec);
+}
+
+// Fills in the world matrices of a submodel and its children, the same way RenderSubmodel
+// instances them
+static void ComputeSubmodelPoses (poly_model *pm,int sn,vector *pos,matrix *orient,vector *mod_pos,angvec *angs,float *poses)
+{
+	bsp_info *sm=&pm->submodel[sn];
+	matrix local,world;
+	vector world_pos,temp_vec;
+
+	if (IsNonRenderableSubmodel (pm,sn))
+		return;
+
+	temp_vec=mod_pos[sn]+sm->offset;
+	world_pos=*pos+MeshRotate (orient,&temp_vec);
+
+	vm_AnglesToMatrix (&local,angs[sn].p,angs[sn].h,angs[sn].b);
+	world.rvec=MeshRotate (orient,&local.rvec);
+	world.uvec=MeshRotate (orient,&local.uvec);
+	world.fvec=MeshRotate (orient,&local.fvec);
+
+	float *row=&poses[sn*12];
+	row[0]=world.rvec.x;	row[1]=world.uvec.x;	row[2]=world.fvec.x;	row[3]=world_pos.x;
+	row[4]=world.rvec.y;	row[5]=world.uvec.y;	row[6]=world.fvec.y;	row[7]=world_pos.y;
+	row[8]=world.rvec.z;	row[9]=world.uvec.z;	row[10]=world.fvec.z;	row[11]=world_pos.z;
+
+	for (int i=0;i<sm->num_children;i++)
+		ComputeSubmodelPoses (pm,sm->children[i],&world_pos,&world,mod_pos,angs,poses);
+}
+
+// Queues a polymodel to be drawn from its mesh, building the mesh the first time.  Lightdir is
+// NULL for static lighting.  Returns false if the model has to be drawn with RenderPolygonModel
+bool DrawPolygonModelMesh (vector *pos,matrix *orient,int model_num,float *normalized_time,vector *lightdir,float r,float g,float b,uint f_render_sub,ubyte use_effect)
+{
+	poly_model *pm=&Poly_models[model_num];
+	model_mesh *mm=&Model_meshes[model_num];
+	rend_model_batch batches[MAX_MODEL_TEXTURES];
+	vector mod_pos[MAX_SUBOBJECTS];
+	angvec angs[MAX_SUBOBJECTS];
+	float poses[MAX_SUBOBJECTS*12];
+	int i;
+
+	if (!UseHardware || f_render_sub!=0xFFFFFFFF || Polymodel_outline_mode)
+		return false;
+	if (use_effect && (Polymodel_effect.type & ~MESH_EFFECTS))
+		return false;
+
+	if (mm->state==MESH_UNBUILT)
+		BuildPolymodelMesh (model_num);
+	if (mm->state!=MESH_BUILT)
+		return false;
+
+	for (i=0;i<mm->num_batches;i++)
+	{
+		int tex=pm->textures[mm->batch_texnum[i]];
+
+		// The textures may have been changed since the mesh was built
+		if (GameTextures[tex].flags & (TF_ALPHA|TF_SATURATE))
+			return false;
+
+		batches[i].bm_handle=GetTextureBitmap (tex,0);
+		batches[i].first_index=mm->batch_first[i];
+		batches[i].num_indices=mm->batch_count[i];
+	}
+
+	GetModelAnglesAndPosTimed (pm,normalized_time,f_render_sub,mod_pos,angs);
+
+	for (i=0;i<pm->n_models;i++)
+	{
+		if (pm->submodel[i].parent==-1)
+			ComputeSubmodelPoses (pm,i,pos,orient,mod_pos,angs,poses);
+	}
+
+	if (lightdir && use_effect && (Polymodel_effect.type & PEF_COLOR))
+	{
+		r*=Polymodel_effect.r;
+		g*=Polymodel_effect.g;
+		b*=Polymodel_effect.b;
+	}
+
+	rend_SetAlphaType (ATF_TEXTURE+ATF_VERTEX);
+	rend_SetWrapType (WT_WRAP);
+
+	return rend_QueueModelInstance (mm->handle,mm->num_batches,batches,pm->n_models,poses,lightdir,r,g,b);
+}
@@ -36,6 +36,7 @@
 
 int Num_poly_models=0;
 poly_model Poly_models[MAX_POLY_MODELS];
+tNameIndex<MAX_POLY_MODELS> Poly_model_names(Poly_models[0].name,sizeof(poly_model));
 
 g3Point Robot_points[MAX_POLYGON_VECS];
 
@@ -143,6 +144,7 @@ int AllocPolyModel ()
 		{
 			WBClearInfo(&Poly_models[i]);
 			memset (&Poly_models[i],0,sizeof(poly_model));
+			Poly_model_names.update(i);
 			Poly_models[i].used=1;
 			Poly_models[i].flags|=PMF_NOT_RESIDENT;		// not in memory yet!
 			return i;
@@ -156,6 +158,8 @@ int AllocPolyModel ()
 void FreePolymodelData (int i)
 {
 	int t;
+
+	FreePolymodelMesh (i);
 	
 	for (t=0;t<Poly_models[i].n_models;t++)
 	{
@@ -327,6 +331,8 @@ void FreePolyModel (int i)
 
 	Poly_models[i].used=0;
 	Poly_models[i].flags|=PMF_NOT_RESIDENT;
+	Poly_models[i].name[0]=0;
+	Poly_model_names.update(i);
 }
 
 void ReadModelVector (vector *vec,CFILE *infile)
@@ -1726,6 +1732,7 @@ int LoadPolyModel (char *filename,int pageable)
 		FreePolyModel (i);
 		
 		memset (&Poly_models[i],0,sizeof(poly_model));
+		Poly_model_names.update(i);
 		WBClearInfo(&Poly_models[i]);
 		Poly_models[i].used=old_used+1;
 		if (not_res)
@@ -1782,6 +1789,7 @@ int LoadPolyModel (char *filename,int pageable)
 
 	//mprintf ((0,"Loading model %s\n",name));
 	strcpy (Poly_models[polynum].name,name);
+	Poly_model_names.update(polynum);
 
 	int ret=0;
 	if (!pageable)	
@@ -1898,13 +1906,7 @@ void ChangePolyModelName (char *src,char *dest)
 // or index of polymodel with name
 int FindPolyModelName (char *name)
 {
-	int i;
-
-	for (i=0;i<MAX_POLY_MODELS;i++)
-		if (Poly_models[i].used && !stricmp (Poly_models[i].name,name))
-			return i;
-
-	return -1;
+	return Poly_model_names.find (name);
 }
 
 
@@ -2318,8 +2320,8 @@ void SetPolymodelEffect (polymodel_effect *poly_effect)
 }
 
 //Given a model pointer and an array of floats that go from 0..1, calculate the interpolated 
-//position/angle of each corresponding subobject
-void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subobj_flags)
+//position/angle of each corresponding subobject into mod_pos and angs, leaving the submodels alone
+void GetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subobj_flags,vector *mod_pos,angvec *angs)
 {
 	int i;
 
@@ -2340,13 +2342,13 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 			
 			if (sm->num_key_pos<=1)
 			{
-				vm_MakeZero(&sm->mod_pos);
+				vm_MakeZero(&mod_pos[i]);
 				goto do_angles;
 			}
 
 			if (normalized_time[i]==1.0)
 			{
-				sm->mod_pos=sm->keyframe_pos[sm->num_key_pos-1];
+				mod_pos[i]=sm->keyframe_pos[sm->num_key_pos-1];
 				goto do_angles;
 			}
 
@@ -2360,7 +2362,7 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 
 			if (current_frame==sm->num_key_pos-1)
 			{
-				sm->mod_pos=sm->keyframe_pos[sm->num_key_pos-1];
+				mod_pos[i]=sm->keyframe_pos[sm->num_key_pos-1];
 				goto do_angles;
 			}
 			else
@@ -2371,7 +2373,7 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 
 				vector subpos;
 				vm_SubVectors (&subpos,&sm->keyframe_pos[current_frame+1],&sm->keyframe_pos[current_frame]);
-				sm->mod_pos=sm->keyframe_pos[current_frame]+(subpos*normal_state_time);
+				mod_pos[i]=sm->keyframe_pos[current_frame]+(subpos*normal_state_time);
 			}
 
 
@@ -2382,15 +2384,15 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 			{
 				if (sm->num_key_angles<=1)
 				{
-					sm->angs.p=0;
-					sm->angs.h=0;
-					sm->angs.b=0;
+					angs[i].p=0;
+					angs[i].h=0;
+					angs[i].b=0;
 					continue;
 				}
 
 				if (normalized_time[i]==1.0)
 				{
-					vm_ExtractAnglesFromMatrix (&po->submodel[i].angs,&po->submodel[i].keyframe_matrix[sm->num_key_angles-1]);
+					vm_ExtractAnglesFromMatrix (&angs[i],&po->submodel[i].keyframe_matrix[sm->num_key_angles-1]);
 					continue;
 				}
 
@@ -2404,7 +2406,7 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 										
 				if (current_frame==sm->num_key_angles-1)
 				{
-					vm_ExtractAnglesFromMatrix (&po->submodel[i].angs,&po->submodel[i].keyframe_matrix[sm->num_key_angles-1]);
+					vm_ExtractAnglesFromMatrix (&angs[i],&po->submodel[i].keyframe_matrix[sm->num_key_angles-1]);
 					continue;
 				}
 				else
@@ -2418,7 +2420,7 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 					matrix dest_matrix=sm->keyframe_matrix[current_frame]+
 					((sm->keyframe_matrix[current_frame+1]-sm->keyframe_matrix[current_frame])*normal_state_time);
 
-					vm_ExtractAnglesFromMatrix (&sm->angs,&dest_matrix);
+					vm_ExtractAnglesFromMatrix (&angs[i],&dest_matrix);
 				}
 
 				
@@ -2444,7 +2446,7 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 						temp_vec=po->submodel[i].norm;
 
 					BuildModelAngleMatrix (&temp_matrix,fdiff*65535,&temp_vec);
-					vm_ExtractAnglesFromMatrix (&po->submodel[i].angs,&temp_matrix);
+					vm_ExtractAnglesFromMatrix (&angs[i],&temp_matrix);
 				}
 				else if (po->submodel[i].flags & SOF_TURRET)
 				{
@@ -2454,7 +2456,7 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 					else
 						BuildModelAngleMatrix (&temp_matrix,normalized_time[i]*65535,&po->submodel[i].norm);
 						
-					vm_ExtractAnglesFromMatrix (&po->submodel[i].angs,&temp_matrix);
+					vm_ExtractAnglesFromMatrix (&angs[i],&temp_matrix);
 				}
 			}
 
@@ -2465,17 +2467,36 @@ void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subob
 	{
 		for (i=0;i<po->n_models;i++)
 		{
-			po->submodel[i].mod_pos.x=0;
-			po->submodel[i].mod_pos.y=0;
-			po->submodel[i].mod_pos.z=0;
+			mod_pos[i].x=0;
+			mod_pos[i].y=0;
+			mod_pos[i].z=0;
 
-			po->submodel[i].angs.p=0;
-			po->submodel[i].angs.h=0;
-			po->submodel[i].angs.b=0;
+			angs[i].p=0;
+			angs[i].h=0;
+			angs[i].b=0;
 		}
 	}
 }
 
+//Given a model pointer and an array of floats that go from 0..1, calculate the interpolated 
+//position/angle of each corresponding subobject
+void SetModelAnglesAndPosTimed (poly_model *po,float *normalized_time,uint subobj_flags)
+{
+	vector mod_pos[MAX_SUBOBJECTS];
+	angvec angs[MAX_SUBOBJECTS];
+
+	GetModelAnglesAndPosTimed (po,normalized_time,subobj_flags,mod_pos,angs);
+
+	for (int i=0;i<po->n_models;i++)
+	{
+		if (normalized_time && !(subobj_flags & (1<<i)))
+			continue;
+
+		po->submodel[i].mod_pos=mod_pos[i];
+		po->submodel[i].angs=angs[i];
+	}
+}
+
 // Sets the position and rotation of a polymodel.  Used for rendering and collision detection
 void SetModelAnglesAndPos (poly_model *po,float *normalized_time,uint subobj_flags)
 {
@@ -2600,6 +2621,9 @@ void DrawPolygonModel(vector *pos,matrix *orient,int model_num,float *normalized
 
 	GetPolymodelPointer (model_num);
 
+	if (DrawPolygonModelMesh (pos,orient,model_num,normalized_time,NULL,r,g,b,f_render_sub,use_effect))
+		return;
+
 	Polymodel_use_effect=use_effect;
 	Polymodel_light_type=POLYMODEL_LIGHTING_STATIC;
 	Polylighting_static_red=r;
@@ -2691,6 +2715,9 @@ void DrawPolygonModel(vector *pos,matrix *orient,int model_num,float *normalized
 
 	GetPolymodelPointer (model_num);
 
+	if (DrawPolygonModelMesh (pos,orient,model_num,normalized_time,lightdir,r,g,b,f_render_sub,use_effect))
+		return;
+
 	rend_SetOverlayType (OT_NONE);
 	rend_SetLighting (LS_GOURAUD);
 	rend_SetColorModel (CM_RGB);
@@ -2869,6 +2896,7 @@ int InitModels ()
 		memset (&Poly_models[i],0,sizeof(poly_model));
 		Poly_models[i].used=0;
 	}
+	Poly_model_names.clear();
 
 	atexit (FreeAllModels);
 
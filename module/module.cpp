@@ -210,6 +210,48 @@ bool mod_LoadModule(module *handle,char *imodfilename,int flags)
 	//Success
 	return true;
 }
+//Loads a dynamic module from an open file descriptor (such as a memfd), so it never has
+//	to exist on disk.  Only supported on Linux, elsewhere it always fails with MODERR_OTHER.
+//	The descriptor must stay open while the module is loaded.
+//Returns true on success, false otherwise
+bool mod_LoadModuleFromFD(module *handle,int fd,int flags)
+{
+	if(!handle)
+	{
+		ModLastError = MODERR_INVALIDHANDLE;
+		return false;
+	}
+	handle->handle = NULL;
+#if defined(__LINUX__) && !defined(MACOSX)
+	if(fd<0)
+	{
+		ModLastError = MODERR_OTHER;
+		return false;
+	}
+	int f = 0;
+	if(flags&MODF_LAZY)
+		f |= RTLD_LAZY;
+	if(flags&MODF_NOW)
+		f |= RTLD_NOW;
+	if(flags&MODF_GLOBAL)
+		f |= RTLD_GLOBAL;
+
+	//the dynamic loader needs a path, so go through procfs
+	char fdpath[64];
+	sprintf(fdpath,"/proc/self/fd/%d",fd);
+	handle->handle = dlopen(fdpath,f);
+	if(!handle->handle)
+	{
+		mprintf((0,"Module Load Err: %s\n",dlerror()));
+		ModLastError = MODERR_INVALIDMOD;
+		return false;
+	}
+	return true;
+#else
+	ModLastError = MODERR_OTHER;
+	return false;
+#endif
+}
 //Frees a previously loaded module from memory, it can no longer be used
 //Returns true on success, false otherwise
 bool mod_FreeModule(module *handle)
@@ -40,6 +40,13 @@ typedef int socklen_t;
 #include <sys/time.h>
 #include <stdlib.h>
 #include <unistd.h>
+#if !MACOSX
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <errno.h>
+#include <atomic>
+#include <thread>
+#endif
 
 #define TRUE true
 #define FALSE false
@@ -279,6 +286,355 @@ typedef struct
 reliable_socket reliable_sockets[MAXRELIABLESOCKETS];
 //*******************************
 
+// When the packet being handed to a receive callback came off the socket
+static float Nw_packet_time = 0;
+
+#if defined(__LINUX__) && !MACOSX
+// Linux moves UDP socket I/O to its own thread, which reads and writes in batches with
+// recvmmsg()/sendmmsg().  Packets go between it and the game thread through two single
+// producer, single consumer rings.  -nonetthread keeps everything on the game thread.
+#define NW_IO_THREAD
+
+#define NW_IO_PACKET_SIZE	1500
+#define NW_IO_RING_SIZE		512		// must be a power of 2
+#define NW_IO_BATCH			32			// most packets moved by one system call
+
+typedef struct
+{
+	int len;
+	float time;							// when a received packet came off the socket
+	SOCKADDR_IN addr;
+	ubyte data[NW_IO_PACKET_SIZE];
+} nw_io_packet;
+
+// The producer adds packets at head, the consumer takes them from tail
+typedef struct
+{
+	nw_io_packet packets[NW_IO_RING_SIZE];
+	std::atomic<unsigned int> head;
+	std::atomic<unsigned int> tail;
+} nw_io_ring;
+
+static nw_io_ring Nw_recv_ring;
+static nw_io_ring Nw_send_ring;
+
+static std::thread Nw_io_thread;
+static bool Nw_io_running = false;
+static std::atomic<bool> Nw_io_quit(false);
+static std::atomic<bool> Nw_io_sleeping(false);
+static int Nw_io_wake_fd = -1;
+static std::atomic<bool> Nw_game_waiting(false);
+static int Nw_game_wake_fd = -1;			// tells a waiting game thread that packets came in
+static int Nw_send_dropped = 0;			// packets dropped because the send ring was full
+
+// Returns how many packets can be added to a ring
+static inline int nw_RingRoom(nw_io_ring *ring)
+{
+	return NW_IO_RING_SIZE - (ring->head.load(std::memory_order_relaxed) - ring->tail.load(std::memory_order_acquire));
+}
+
+// Returns how many packets are waiting in a ring
+static inline int nw_RingCount(nw_io_ring *ring)
+{
+	return ring->head.load(std::memory_order_acquire) - ring->tail.load(std::memory_order_relaxed);
+}
+
+// Returns the ring slot for a head or tail position
+static inline nw_io_packet *nw_RingPacket(nw_io_ring *ring,unsigned int pos)
+{
+	return &ring->packets[pos & (NW_IO_RING_SIZE-1)];
+}
+
+// Lets the I/O thread know there is something to send, if it is waiting
+static void nw_WakeIOThread()
+{
+	if (Nw_io_sleeping.exchange(false))
+	{
+		uint64_t one = 1;
+		if (write(Nw_io_wake_fd,&one,sizeof(one)) < 0)
+			mprintf((0,"Couldn't wake network I/O thread (%d)\n",errno));
+	}
+}
+
+// Reads as many packets as the receive ring has room for, up to a batch.  Returns how many were read
+static int nw_IOReceive()
+{
+	struct mmsghdr msgs[NW_IO_BATCH];
+	struct iovec iovs[NW_IO_BATCH];
+	nw_io_ring *ring = &Nw_recv_ring;
+	unsigned int head = ring->head.load(std::memory_order_relaxed);
+	int count = nw_RingRoom(ring);
+	int i, n;
+
+	if (count > NW_IO_BATCH)
+		count = NW_IO_BATCH;
+
+	for (i = 0; i < count; i++)
+	{
+		nw_io_packet *packet = nw_RingPacket(ring,head+i);
+
+		iovs[i].iov_base = packet->data;
+		iovs[i].iov_len = NW_IO_PACKET_SIZE;
+		memset(&msgs[i].msg_hdr,0,sizeof(msgs[i].msg_hdr));
+		msgs[i].msg_hdr.msg_name = &packet->addr;
+		msgs[i].msg_hdr.msg_namelen = sizeof(SOCKADDR_IN);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	n = recvmmsg(TCP_socket,msgs,count,MSG_DONTWAIT,NULL);
+	if (n <= 0)
+	{
+		if (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+			mprintf((0,"Read error on IP socket (%d)\n",errno));
+		return 0;
+	}
+
+	float now = timer_GetTime();
+	for (i = 0; i < n; i++)
+	{
+		nw_io_packet *packet = nw_RingPacket(ring,head+i);
+		packet->len = msgs[i].msg_len;
+		packet->time = now;
+	}
+
+	ring->head.store(head+n,std::memory_order_release);
+
+	if (Nw_game_waiting.exchange(false))
+	{
+		uint64_t one = 1;
+		if (write(Nw_game_wake_fd,&one,sizeof(one)) < 0)
+			mprintf((0,"Couldn't wake game thread (%d)\n",errno));
+	}
+
+	return n;
+}
+
+// Sends up to a batch of queued packets.  Returns how many left the queue
+static int nw_IOSend()
+{
+	struct mmsghdr msgs[NW_IO_BATCH];
+	struct iovec iovs[NW_IO_BATCH];
+	nw_io_ring *ring = &Nw_send_ring;
+	unsigned int tail = ring->tail.load(std::memory_order_relaxed);
+	int count = nw_RingCount(ring);
+	int i, n;
+
+	if (count > NW_IO_BATCH)
+		count = NW_IO_BATCH;
+	if (!count)
+		return 0;
+
+	for (i = 0; i < count; i++)
+	{
+		nw_io_packet *packet = nw_RingPacket(ring,tail+i);
+
+		iovs[i].iov_base = packet->data;
+		iovs[i].iov_len = packet->len;
+		memset(&msgs[i].msg_hdr,0,sizeof(msgs[i].msg_hdr));
+		msgs[i].msg_hdr.msg_name = &packet->addr;
+		msgs[i].msg_hdr.msg_namelen = sizeof(SOCKADDR_IN);
+		msgs[i].msg_hdr.msg_iov = &iovs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+	}
+
+	n = sendmmsg(TCP_socket,msgs,count,MSG_DONTWAIT);
+	if (n <= 0)
+	{
+		// Like a socket that isn't writable in nw_SendWithID(), the packet gets dropped
+		if (errno != EAGAIN && errno != EWOULDBLOCK)
+			mprintf((0,"Couldn't send data (%d)!\n",errno));
+		n = 1;
+	}
+
+	ring->tail.store(tail+n,std::memory_order_release);
+	return n;
+}
+
+static void nw_IOThread()
+{
+	struct pollfd fds[2];
+	int recv_calls = 0, recv_packets = 0;
+	int send_calls = 0, send_packets = 0;
+
+	while (!Nw_io_quit.load())
+	{
+		int n;
+
+		while (nw_RingCount(&Nw_send_ring))
+		{
+			send_packets += nw_IOSend();
+			send_calls++;
+		}
+
+		if (nw_RingRoom(&Nw_recv_ring) && (n = nw_IOReceive()) > 0)
+		{
+			recv_packets += n;
+			recv_calls++;
+			continue;
+		}
+
+		// Sleep until there is data on the socket or the game thread queues a send.  The send
+		// queue is checked again after saying we're asleep, so a wake up can't be missed.
+		Nw_io_sleeping.store(true);
+		if (nw_RingCount(&Nw_send_ring))
+		{
+			Nw_io_sleeping.store(false);
+			continue;
+		}
+
+		fds[0].fd = TCP_socket;
+		fds[0].events = nw_RingRoom(&Nw_recv_ring) ? POLLIN : 0;
+		fds[0].revents = 0;
+		fds[1].fd = Nw_io_wake_fd;
+		fds[1].events = POLLIN;
+		fds[1].revents = 0;
+
+		// If the receive ring is full, check back soon for the game thread to empty it
+		poll(fds,2,fds[0].events ? 100 : 1);
+		Nw_io_sleeping.store(false);
+
+		if (fds[1].revents & POLLIN)
+		{
+			uint64_t count;
+			if (read(Nw_io_wake_fd,&count,sizeof(count)) < 0)
+				mprintf((0,"Couldn't clear network I/O wake up (%d)\n",errno));
+		}
+	}
+
+	mprintf((0,"Network I/O: received %d packets in %d calls, sent %d packets in %d calls\n",recv_packets,recv_calls,send_packets,send_calls));
+}
+
+// Starts the I/O thread on the UDP socket
+static void nw_StartIOThread()
+{
+	Nw_io_wake_fd = eventfd(0,EFD_NONBLOCK);
+	Nw_game_wake_fd = eventfd(0,EFD_NONBLOCK);
+	if (Nw_io_wake_fd == -1 || Nw_game_wake_fd == -1)
+	{
+		mprintf((0,"Couldn't create network I/O wake up (%d), using the game thread\n",errno));
+		if (Nw_io_wake_fd != -1)
+			close(Nw_io_wake_fd);
+		if (Nw_game_wake_fd != -1)
+			close(Nw_game_wake_fd);
+		Nw_io_wake_fd = Nw_game_wake_fd = -1;
+		return;
+	}
+
+	Nw_recv_ring.head = Nw_recv_ring.tail = 0;
+	Nw_send_ring.head = Nw_send_ring.tail = 0;
+	Nw_io_quit = false;
+	Nw_io_sleeping = false;
+	Nw_game_waiting = false;
+	Nw_send_dropped = 0;
+	Nw_io_thread = std::thread(nw_IOThread);
+	Nw_io_running = true;
+
+	mprintf((0,"Network I/O thread started\n"));
+}
+
+// Stops the I/O thread.  Anything still queued to send is sent first
+static void nw_StopIOThread()
+{
+	if (!Nw_io_running)
+		return;
+
+	Nw_io_quit = true;
+	Nw_io_sleeping = true;
+	nw_WakeIOThread();
+	Nw_io_thread.join();
+	Nw_io_running = false;
+
+	while (nw_RingCount(&Nw_send_ring) && nw_IOSend())
+		;
+
+	if (Nw_send_dropped)
+		mprintf((0,"Network I/O: dropped %d packets with the send queue full\n",Nw_send_dropped));
+
+	close(Nw_io_wake_fd);
+	close(Nw_game_wake_fd);
+	Nw_io_wake_fd = Nw_game_wake_fd = -1;
+}
+
+// Queues a packet for the I/O thread to send.  Returns false, and drops the packet, if the queue
+// is full.  Sending it straight away instead would put it ahead of the ones still queued.
+static bool nw_QueueSend(ubyte *data,int len,SOCKADDR_IN *addr)
+{
+	nw_io_ring *ring = &Nw_send_ring;
+
+	ASSERT(len <= NW_IO_PACKET_SIZE);
+
+	if (!nw_RingRoom(ring))
+	{
+		Nw_send_dropped++;
+		return false;
+	}
+
+	unsigned int head = ring->head.load(std::memory_order_relaxed);
+	nw_io_packet *packet = nw_RingPacket(ring,head);
+
+	memcpy(packet->data,data,len);
+	packet->len = len;
+	packet->addr = *addr;
+	ring->head.store(head+1,std::memory_order_release);
+
+	nw_WakeIOThread();
+	return true;
+}
+#endif
+
+// Returns when the packet being handed to a receive callback came off the socket
+float nw_GetPacketReceiveTime()
+{
+	return Nw_packet_time;
+}
+
+// Gets ready for the game thread to sleep until packets arrive.  Sets fd to a descriptor that
+// becomes readable when they do, or -1 if there is nothing to wait on.  With the I/O thread
+// running that's Nw_game_wake_fd, which the I/O thread signals after queueing packets; its own
+// Nw_io_wake_fd is never handed out.  Otherwise it's the TCP socket.  Returns false, and
+// shouldn't be waited on, if packets are already waiting.  Call nw_EndWait() after waiting.
+bool nw_BeginWait(int *fd)
+{
+	*fd = -1;
+
+#ifdef NW_IO_THREAD
+	if (Nw_io_running)
+	{
+		// Say we're waiting before looking, so the I/O thread can't slip a packet in unnoticed
+		Nw_game_waiting.store(true);
+		if (nw_RingCount(&Nw_recv_ring))
+		{
+			Nw_game_waiting.store(false);
+			return false;
+		}
+
+		*fd = Nw_game_wake_fd;
+		return true;
+	}
+#endif
+
+	if (TCP_active)
+		*fd = (int)TCP_socket;
+
+	return true;
+}
+
+// Done waiting for packets
+void nw_EndWait()
+{
+#ifdef NW_IO_THREAD
+	if (Nw_io_running)
+	{
+		uint64_t count;
+
+		Nw_game_waiting.store(false);
+		if (read(Nw_game_wake_fd,&count,sizeof(count)) < 0 && errno != EAGAIN)
+			mprintf((0,"Couldn't clear game thread wake up (%d)\n",errno));
+	}
+#endif
+}
+
 void CloseNetworking()
 {
 	if (Sockets_initted!=1)
@@ -309,6 +665,10 @@ void CloseNetworking()
 		#endif
 	}
 
+#ifdef NW_IO_THREAD
+	nw_StopIOThread();
+#endif
+
 	if ( TCP_socket != INVALID_SOCKET ) 
 	{
 		shutdown( TCP_socket, 1 );
@@ -709,6 +1069,11 @@ init_tcp:
 	nw_psnet_buffer_init();
 	nw_RegisterCallback((NetworkReceiveCallback)nw_HandleUnreliableData,NWT_UNRELIABLE);
 
+#ifdef NW_IO_THREAD
+	if (TCP_active && !FindArg("-nonetthread"))
+		nw_StartIOThread();
+#endif
+
 }
 
 
@@ -1561,8 +1926,9 @@ void nw_WorkReliable(ubyte * data,int len,network_address *naddr)
 				}
 				
 			}
-			//Update the last recv variable so we don't need a heartbeat
-			rsocket->last_packet_received = timer_GetTime();
+			//Update the last recv variable so we don't need a heartbeat.  This uses the time the
+			//packet arrived, so pings don't include however long it waited for the game thread.
+			rsocket->last_packet_received = nw_GetPacketReceiveTime();
 
 			if(rcv_buff.type == RNT_HEARTBEAT)
 			{
@@ -2733,6 +3099,18 @@ int nw_SendWithID(ubyte id,ubyte *data,int len,network_address *who_to)
 	send_len = len;
 	send_data = (ubyte *)packet_data;
 
+#ifdef NW_IO_THREAD
+	// Let the I/O thread send it with the rest of its batch
+	if (Nw_io_running && who_to->connection_type == NP_TCP)
+	{
+		sock_addr.sin_family = AF_INET; 
+		memcpy(&sock_addr.sin_addr.s_addr, iaddr, 4);
+		sock_addr.sin_port = htons(port); 
+
+		return nw_QueueSend(send_data, send_len, &sock_addr) ? 1 : 0;
+	}
+#endif
+
 
 	FD_ZERO(&wfds);
 	FD_SET( send_sock, &wfds );
@@ -2803,19 +3181,72 @@ int nw_SendWithID(ubyte id,ubyte *data,int len,network_address *who_to)
 
 }
 
+// Hands a packet read from the UDP socket to the callback for its id
+static void nw_DispatchIPPacket(ubyte *packet_data,int read_len,SOCKADDR_IN *ip_addr)
+{
+	network_address	from_addr;
+
+	memset(&from_addr, 0x00, sizeof(network_address));
+	from_addr.connection_type = NP_TCP;
+	from_addr.port = ntohs( ip_addr->sin_port );
+	
+	#ifdef WIN32
+	memcpy(from_addr.address, &ip_addr->sin_addr.S_un.S_addr, 4);
+	#else
+	memcpy(from_addr.address, &ip_addr->sin_addr.s_addr, 4);
+	#endif
+	ubyte packet_id = (packet_data[0] & 0x0f);
+	if(Netcallbacks[packet_id])
+	{
+		//mprintf((0,"Calling network callback for id %d.\n",packet_id));
+		int rlen = read_len-1;
+		if(packet_id==NWT_UNRELIABLE)
+		{
+			NetStatistics.udp_total_packets_rec++;
+			NetStatistics.udp_total_bytes_rec+=rlen;
+		}else if(packet_id==NWT_RELIABLE)
+		{
+			NetStatistics.tcp_total_packets_rec++;
+			NetStatistics.tcp_total_bytes_rec+=rlen;
+		}
+		
+		Netcallbacks[packet_id](packet_data+1,rlen,&from_addr);
+	}
+}
+
 int nw_DoReceiveCallbacks(void)
 {
     #if __SUPPORT_IPX
 	SOCKADDR_IPX ipx_addr;			// IPX socket structure
+	network_address	from_addr;
     #endif
 	SOCKADDR_IN ip_addr;				// UDP/TCP socket structure		
 	socklen_t		read_len, from_len;
-	network_address	from_addr;
 
 	ubyte packet_data[1500];
 
 	nw_ReliableResend();
 
+#ifdef NW_IO_THREAD
+	// The I/O thread has already read the socket, so just take what it queued up
+	if (Nw_io_running)
+	{
+		nw_io_ring *ring = &Nw_recv_ring;
+		unsigned int tail = ring->tail.load(std::memory_order_relaxed);
+		int count = nw_RingCount(ring);
+
+		for (int i = 0; i < count; i++)
+		{
+			nw_io_packet *packet = nw_RingPacket(ring,tail+i);
+
+			Nw_packet_time = packet->time;
+			nw_DispatchIPPacket(packet->data,packet->len,&packet->addr);
+		}
+
+		ring->tail.store(tail+count,std::memory_order_release);
+	}
+	else
+#endif
 	while ( TCP_active ) 
 	{
 		// check if there is any data on the socket to be read.  The amount of data that can be 
@@ -2852,32 +3283,8 @@ int nw_DoReceiveCallbacks(void)
 			}
 			break;
 		}
-		memset(&from_addr, 0x00, sizeof(network_address));
-		from_addr.connection_type = NP_TCP;
-		from_addr.port = ntohs( ip_addr.sin_port );
-		
-		#ifdef WIN32
-		memcpy(from_addr.address, &ip_addr.sin_addr.S_un.S_addr, 4);
-		#else
-		memcpy(from_addr.address, &ip_addr.sin_addr.s_addr, 4);
-		#endif
-		ubyte packet_id = (packet_data[0] & 0x0f);
-		if(Netcallbacks[packet_id])
-		{
-			//mprintf((0,"Calling network callback for id %d.\n",packet_id));
-			int rlen = read_len-1;
-			if(packet_id==NWT_UNRELIABLE)
-			{
-				NetStatistics.udp_total_packets_rec++;
-				NetStatistics.udp_total_bytes_rec+=rlen;
-			}else if(packet_id==NWT_RELIABLE)
-			{
-				NetStatistics.tcp_total_packets_rec++;
-				NetStatistics.tcp_total_bytes_rec+=rlen;
-			}
-			
-			Netcallbacks[packet_id](packet_data+1,rlen,&from_addr);
-		}
+		Nw_packet_time = timer_GetTime();
+		nw_DispatchIPPacket(packet_data,read_len,&ip_addr);
 	}
 
     #if __SUPPORT_IPX
@@ -2923,6 +3330,7 @@ int nw_DoReceiveCallbacks(void)
 		memcpy(from_addr.net_id, &ipx_addr.sipx_network, 4);
 		#endif
 		
+		Nw_packet_time = timer_GetTime();
 		ubyte packet_id = (packet_data[0] & 0x0f);
 		if(Netcallbacks[packet_id])
 		{
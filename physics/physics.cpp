@@ -807,12 +807,292 @@ void PhysicsDoSimLinear(const object& obj, const vector& pos, const vector& forc
 	#endif
 }
 
+//	-----------------------------------------------------------------------------------------------------------
+//	Staged moves.  ObjDoFrameAll() works out the first movement query of simple weapons on the job
+//	workers before the object pass, against the world as it is at the start of the frame.  The object
+//	pass still runs do_physics_sim() in object order, and it takes a staged answer instead of calling
+//	fvi only when it asks exactly the same question and nothing the move could hit has changed since.
+
+#define MAX_STAGED_ROOMS	8
+#define MAX_STAGED_FACES	8
+
+// Everything that goes into the first movement query of an object's frame.  p0, startroom, rad and
+// thisobjnum all come from the object.
+typedef struct phys_move_query
+{
+	object obj;						// The object as fvi sees it
+	vector p1;
+	int flags;
+	matrix o_orient;
+	vector o_rotvel;
+	vector o_velocity;
+	vector o_thrust;
+	angle o_turnroll;
+
+	// What fvi hands back when nothing is hit
+	matrix end_orient;
+	vector end_rotvel;
+	vector end_velocity;
+	angle end_turnroll;
+	float end_time;
+} phys_move_query;
+
+typedef struct staged_move
+{
+	bool valid;
+	phys_move_query query;		// What was asked
+	fvi_info hit_info;			// and the answer
+
+	int num_rooms;					// The rooms it looked for objects in
+	short rooms[MAX_STAGED_ROOMS];
+
+	int num_recorded_faces;		// The faces it passed through
+	fvi_face_room_list recorded_faces[MAX_STAGED_FACES];
+} staged_move;
+
+static staged_move Staged_moves[MAX_OBJECTS];
+static int Num_staged_moves = 0;
+
+// Rooms where something a weapon can hit has moved, appeared or changed during the object pass
+static bool Staged_room_disturbed[MAX_ROOMS];
+
+// Fills in a query so two can be compared with memcmp()
+static void SetMoveQuery(phys_move_query *q, const object *obj, const fvi_query *fq, const fvi_info *hit_info)
+{
+	memset(q, 0, sizeof(phys_move_query));
+	memcpy(&q->obj, obj, sizeof(object));
+
+	// The rest of the laser info is smoke and timers, which fvi doesn't look at
+	memset(&q->obj.ctype, 0, sizeof(q->obj.ctype));
+	q->obj.ctype.laser_info.last_hit_handle = obj->ctype.laser_info.last_hit_handle;
+	q->obj.ctype.laser_info.hit_status = obj->ctype.laser_info.hit_status;
+
+	q->p1 = *fq->p1;
+	q->flags = fq->flags;
+	q->o_orient = *fq->o_orient;
+	q->o_rotvel = *fq->o_rotvel;
+	q->o_velocity = *fq->o_velocity;
+	q->o_thrust = *fq->o_thrust;
+	q->o_turnroll = *fq->o_turnroll;
+
+	q->end_orient = hit_info->hit_orient;
+	q->end_rotvel = hit_info->hit_rotvel;
+	q->end_velocity = hit_info->hit_velocity;
+	q->end_turnroll = hit_info->hit_turnroll;
+	q->end_time = hit_info->hit_time;
+}
+
+void PhysicsStageMove(fvi_context *ctx, int objnum, const object *staged_obj)
+{
+	staged_move *sm = &Staged_moves[objnum];
+	object obj;
+	physics_info *pi = &obj.mtype.phys_info;
+	int ignore_obj_list[1] = { -1 };
+	vector total_force;
+	fvi_query fq;
+	fvi_info *hit_info = &sm->hit_info;
+	int fate;
+
+	sm->valid = false;
+
+	memcpy(&obj, staged_obj, sizeof(object));
+
+	// Only plain weapons flying through the mine are staged
+	if(obj.type != OBJ_WEAPON || obj.movement_type != MT_PHYSICS || obj.ai_info != NULL || Frametime <= 0.0)
+		return;
+
+	if((obj.flags & (OF_DEAD | OF_ATTACHED)) || ROOMNUM_OUTSIDE(obj.roomnum) || obj.ctype.laser_info.hit_status != WPC_NOT_USED)
+		return;
+
+	// Weapons can only hit other weapons that are siblings with PF_HITS_SIBLINGS, so leaving those out
+	// means that other weapons moving can't change the answer (see PhysicsStagedMoveDisturb())
+	if(pi->flags & (PF_WIGGLE | PF_HOMING | PF_GUIDED | PF_DESTINATION_POS | PF_NO_COLLIDE | PF_HITS_SIBLINGS))
+		return;
+
+	// The rest follows the first pass through do_physics_sim()
+	if(obj.flags & OF_TEMP_GRAVITY)
+		pi->flags &= ~PF_GRAVITY;
+
+	if (pi->flags & PF_GRAVITY) 
+	{
+		total_force.x = total_force.z = 0.0;
+		total_force.y = Gravity_strength * pi->mass; 
+	} 
+	else if (pi->flags & PF_REVERSE_GRAVITY) 
+	{ 
+		total_force.x = total_force.z = 0.0;
+		total_force.y = -Gravity_strength * pi->mass; 
+	} 
+	else 
+	{
+		total_force.x = total_force.y = total_force.z = 0.0;
+	}
+
+	obj.flags &= (~OF_STOPPED_THIS_FRAME);
+
+	if (!(fabs(pi->velocity.x)  > .000001 || fabs(pi->velocity.y)  > .000001 || fabs(pi->velocity.z)  > .000001 || 
+		   fabs(pi->thrust.x)  > .000001 || fabs(pi->thrust.y)  > .000001 || fabs(pi->thrust.z)  > .000001 || 
+			fabs(pi->rotvel.x)  > .000001 || fabs(pi->rotvel.y)  > .000001 || fabs(pi->rotvel.z)  > .000001 || 
+		   fabs(pi->rotthrust.x)  > .000001 || fabs(pi->rotthrust.y)  > .000001 || fabs(pi->rotthrust.z)  > .000001 || 
+			(pi->flags & PF_GRAVITY) ||			
+			(Rooms[obj.roomnum].wind != Zero_vector))) 
+	{
+		return;
+	}
+
+	obj.flags |= OF_MOVED_THIS_FRAME;
+
+	if (pi->drag != 0.0) 
+	{
+		if (pi->flags & PF_USES_THRUST) 
+		{
+			total_force += pi->thrust;
+		}
+	}
+
+	vector start_pos = obj.pos;
+	vector start_vel = pi->velocity;
+	matrix start_orient = obj.orient;
+	vector start_rotvel = pi->rotvel;
+	angle start_turnroll = pi->turnroll;
+
+	matrix end_orient = start_orient;
+	vector end_rotvel = start_rotvel;
+	angle end_turnroll = start_turnroll;
+	vector end_vel = start_vel;
+
+	vector movement_vec;
+	vector movement_pos;
+
+	PhysicsDoSimRot(&obj, Frametime, &end_orient, &pi->rotthrust, &end_rotvel, &end_turnroll);
+	ObjSetOrient(&obj, &end_orient);
+
+	PhysicsDoSimLinear(obj, obj.pos, total_force, end_vel, movement_vec, movement_pos, Frametime, 0);
+
+	pi->velocity = (movement_pos - start_pos)/Frametime;
+
+	fq.p0						= &obj.pos;
+	fq.startroom			= obj.roomnum;
+	fq.p1						= &movement_pos;
+	fq.rad					= obj.size;
+	fq.thisobjnum			= objnum;
+	fq.ignore_obj_list	= ignore_obj_list;
+	fq.flags					= FQ_CHECK_OBJS | FQ_RECORD | FQ_NEW_RECORD_LIST | FQ_TRANSPOINT;
+
+	fq.o_orient          = &start_orient;
+	fq.o_rotvel          = &start_rotvel;
+	fq.o_rotthrust       = &pi->rotthrust;
+	fq.o_turnroll        = &start_turnroll;
+	fq.o_velocity        = &start_vel;
+	fq.o_thrust          = &total_force;
+
+	if(obj.flags & OF_FORCE_CEILING_CHECK)
+		fq.flags |= FQ_CHECK_CEILING;
+
+	if(obj.flags & OF_NO_OBJECT_COLLISIONS)
+		fq.flags &= ~FQ_CHECK_OBJS;
+
+	hit_info->hit_turnroll = end_turnroll;
+	hit_info->hit_orient = end_orient;
+	hit_info->hit_rotvel = end_rotvel;
+	hit_info->hit_velocity = end_vel;
+	hit_info->hit_time = Frametime;
+
+	SetMoveQuery(&sm->query, &obj, &fq, hit_info);
+
+	ctx->staged_objnum = objnum;
+	ctx->staged_obj = &obj;
+	fate = fvi_FindIntersection(ctx, &fq, hit_info);
+	ctx->staged_obj = NULL;
+	ctx->staged_objnum = -1;
+
+	// Hits need the collision code, and the terrain isn't tracked for changes, so those are done
+	// in the object pass
+	if(fate != HIT_NONE || ctx->num_cells_visited || ctx->num_cells_obj_visited)
+		return;
+
+	if(ctx->num_rooms_visited > MAX_STAGED_ROOMS || ctx->num_recorded_faces > MAX_STAGED_FACES)
+		return;
+
+	sm->num_rooms = ctx->num_rooms_visited;
+	for(int i = 0; i < sm->num_rooms; i++)
+		sm->rooms[i] = ctx->rooms_visited[i];
+
+	sm->num_recorded_faces = ctx->num_recorded_faces;
+	memcpy(sm->recorded_faces, ctx->recorded_faces, sm->num_recorded_faces * sizeof(fvi_face_room_list));
+
+	sm->valid = true;
+}
+
+void PhysicsUseStagedMoves(int count)
+{
+	if(count == 0)
+	{
+		// Drop whatever wasn't used, so the next frame starts out with nothing staged
+		for(int i = 0; i < Num_staged_moves; i++)
+			Staged_moves[i].valid = false;
+	}
+	else
+	{
+		memset(Staged_room_disturbed, 0, sizeof(Staged_room_disturbed));
+	}
+
+	Num_staged_moves = count;
+}
+
+void PhysicsStagedMoveDisturb(const object *obj)
+{
+	if(Num_staged_moves == 0 || obj->roomnum < 0 || ROOMNUM_OUTSIDE(obj->roomnum))
+		return;
+
+	// Staged moves are all weapons without PF_HITS_SIBLINGS
+	if(CollisionResult[OBJ_WEAPON][obj->type] == RESULT_NOTHING && CollisionResult[obj->type][OBJ_WEAPON] == RESULT_NOTHING)
+		return;
+
+	if(obj->type == OBJ_WEAPON && !(obj->mtype.phys_info.flags & PF_HITS_SIBLINGS))
+		return;
+
+	Staged_room_disturbed[obj->roomnum] = true;
+}
+
+// Answers the first movement query of obj's frame from its staged move, if it's still good
+static bool GetStagedMove(object *obj, const fvi_query *fq, fvi_info *hit_info)
+{
+	int objnum = OBJNUM(obj);
+	staged_move *sm;
+	phys_move_query q;
+	int i;
+
+	if(objnum >= Num_staged_moves || !Staged_moves[objnum].valid)
+		return false;
+
+	sm = &Staged_moves[objnum];
+	sm->valid = false;
+
+	for(i = 0; i < sm->num_rooms; i++)
+	{
+		if(Staged_room_disturbed[sm->rooms[i]])
+			return false;
+	}
+
+	SetMoveQuery(&q, obj, fq, hit_info);
+	if(memcmp(&q, &sm->query, sizeof(phys_move_query)))
+		return false;
+
+	*hit_info = sm->hit_info;
+
+	Fvi_main_context.num_recorded_faces = sm->num_recorded_faces;
+	memcpy(Fvi_main_context.recorded_faces, sm->recorded_faces, sm->num_recorded_faces * sizeof(fvi_face_room_list));
+
+	return true;
+}
+
 //	-----------------------------------------------------------------------------------------------------------
 //Simulate a physics object for this frame
 void do_physics_sim(object *obj)
 {
 	//Since we might not call FVI, set this here
-	Fvi_num_recorded_faces = 0;
+	Fvi_main_context.num_recorded_faces = 0;
 
 	int n_ignore_objs = 0;											// The number of ignored objects
 	int ignore_obj_list[MAX_IGNORE_OBJS+1];					// List of ignored objects
@@ -1232,7 +1512,10 @@ void do_physics_sim(object *obj)
 			fq.flags |= FQ_MULTI_POINT;
 		}
 
-		fate = fvi_FindIntersection(&fq,&hit_info);
+		if(count == 0 && GetStagedMove(obj, &fq, &hit_info))
+			fate = HIT_NONE;
+		else
+			fate = fvi_FindIntersection(&fq,&hit_info);
 
 		if(fate != HIT_NONE)
 		{
@@ -2486,7 +2769,7 @@ bool PhysValidateGroundPath(object *obj, vector *s, int sroom, vector *e, int er
 void do_walking_sim(object *obj)
 {
 	//Since we might not call FVI, set this here
-	Fvi_num_recorded_faces = 0;
+	Fvi_main_context.num_recorded_faces = 0;
 
 	int n_ignore_objs = 0;											// The number of ignored objects
 	int ignore_obj_list[MAX_IGNORE_OBJS+1];					// List of ignored objects
@@ -16,12 +16,18 @@
 * You should have received a copy of the GNU General Public License
 * along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
+#include <string.h>
 #include "gl_local.h"
 
 //The number of vertex attributes the legacy code used. 
 constexpr int NUM_LEGACY_VERTEX_ATTRIBS = 4;
-//The count of vertices that each buffer will store
-constexpr int NUM_VERTS_PER_BUFFER = 32000;
+//The count of vertices that the streaming ring will store. Indices are ushorts, so this can't go over 65536.
+constexpr int NUM_VERTS_PER_BUFFER = 65536;
+//The ring is split into sections. A fence is placed when a section is left and waited on before it is written again.
+constexpr int NUM_RING_SECTIONS = 4;
+constexpr int NUM_VERTS_PER_SECTION = NUM_VERTS_PER_BUFFER / NUM_RING_SECTIONS;
+//A fan of n vertices becomes n - 2 triangles, so a section never needs more than 3 indices per vertex.
+constexpr int NUM_INDICES_PER_SECTION = NUM_VERTS_PER_SECTION * 3;
 
 struct color_array
 {
@@ -41,13 +47,12 @@ struct gl_vertex
 	tex_array tex_coord2;
 };
 
-gl_vertex GL_vertices[100];
-
 float OpenGL_Alpha_factor = 1.0f;
 float Alpha_multiplier = 1.0f;
 
 int OpenGL_polys_drawn;
 int OpenGL_verts_processed;
+int OpenGL_batches_drawn;
 
 int Overlay_map = -1;
 int Bump_map = 0;
@@ -57,32 +62,96 @@ float Z_bias = 0.0f;
 
 bool OpenGL_blending_on = true;
 
-static GLuint drawbuffer;
-//The next committed vertex is where to start writing vertex data to the buffer
-static GLuint nextcommittedvertex; 
+static GLuint drawbuffer, drawindexbuffer;
 static ShaderProgram drawshaders[4];
 static int lastdrawshader = -1;
 
 static GLuint drawvao;
 
+//Where vertices and indices are written. When the ring is persistently mapped these point into the buffers,
+//otherwise they're a copy of the ring in system memory that is uploaded a batch at a time.
+static gl_vertex* ringvertices;
+static ushort* ringindices;
+static bool ringpersistent;
+static gl_vertex* shadowvertices;
+static ushort* shadowindices;
+static GLsync ringfences[NUM_RING_SECTIONS];
+static int ringsection;
+//The next free vertex and index in the ring
+static int nextvertex, nextindex;
+//The start of the batch that hasn't been drawn yet, and the primitive it's made of
+static int batchvertex, batchindex;
+static GLenum batchmode = GL_TRIANGLES;
+
 void GL_UseDrawVAO(void)
 {
 	glBindVertexArray(drawvao);
 }
 
-int GL_CopyVertices(int numvertices)
+//Draws everything added to the ring since the last flush with one call.
+//Must be called before anything that changes the state the pending polygons are drawn with.
+void GL_FlushDraws(void)
 {
-	glBindBuffer(GL_ARRAY_BUFFER, drawbuffer);
-	if (nextcommittedvertex + numvertices > NUM_VERTS_PER_BUFFER)
-		nextcommittedvertex = 0;
+	GL_FlushModelInstances();
 
-	int startoffset = nextcommittedvertex;
+	if (nextindex == batchindex)
+		return;
 
-	glBufferSubData(GL_ARRAY_BUFFER, startoffset * sizeof(gl_vertex), numvertices * sizeof(gl_vertex), GL_vertices);
+	if (!ringpersistent)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, drawbuffer);
+		glBufferSubData(GL_ARRAY_BUFFER, batchvertex * sizeof(gl_vertex), (nextvertex - batchvertex) * sizeof(gl_vertex), &ringvertices[batchvertex]);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, drawindexbuffer);
+		glBufferSubData(GL_COPY_WRITE_BUFFER, batchindex * sizeof(ushort), (nextindex - batchindex) * sizeof(ushort), &ringindices[batchindex]);
+	}
+
+	glDrawElements(batchmode, nextindex - batchindex, GL_UNSIGNED_SHORT, (const void*)(batchindex * sizeof(ushort)));
+	OpenGL_batches_drawn++;
 
-	nextcommittedvertex += numvertices;
+	batchvertex = nextvertex;
+	batchindex = nextindex;
 
-	return startoffset;
+	CHECK_ERROR(11)
+}
+
+//Makes room for numvertices vertices and numindices indices of the given primitive.
+//Returns the ring index of the first vertex. The caller writes them and advances nextvertex and nextindex.
+static int GL_ReserveVertices(GLenum mode, int numvertices, int numindices)
+{
+	//Queued model instances come before whatever is added to the ring
+	GL_FlushModelInstances();
+
+	if (mode != batchmode)
+	{
+		GL_FlushDraws();
+		batchmode = mode;
+	}
+
+	if (nextvertex + numvertices > (ringsection + 1) * NUM_VERTS_PER_SECTION ||
+		nextindex + numindices > (ringsection + 1) * NUM_INDICES_PER_SECTION)
+	{
+		GL_FlushDraws();
+
+		if (ringpersistent)
+			ringfences[ringsection] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+		ringsection = (ringsection + 1) % NUM_RING_SECTIONS;
+
+		//Don't write over a section the GPU may still be reading. Buffer updates through glBufferSubData are
+		//ordered by the driver, so this is only needed for the mapped ring.
+		if (ringfences[ringsection])
+		{
+			while (glClientWaitSync(ringfences[ringsection], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+				;
+			glDeleteSync(ringfences[ringsection]);
+			ringfences[ringsection] = 0;
+		}
+
+		nextvertex = batchvertex = ringsection * NUM_VERTS_PER_SECTION;
+		nextindex = batchindex = ringsection * NUM_INDICES_PER_SECTION;
+	}
+
+	return nextvertex;
 }
 
 void opengl_SetDrawDefaults(void)
@@ -102,15 +171,63 @@ void opengl_SetDrawDefaults(void)
 	lastdrawshader = -1;
 
 	//Init draw buffers
-	glGenBuffers(1, &drawbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, drawbuffer);
 	size_t buffersize = NUM_VERTS_PER_BUFFER * sizeof(gl_vertex);
-	glBufferData(GL_ARRAY_BUFFER, buffersize, nullptr, GL_DYNAMIC_DRAW);
+	size_t indexbuffersize = NUM_RING_SECTIONS * NUM_INDICES_PER_SECTION * sizeof(ushort);
 
-	//Init VAO and vertex state
+	//The fences of a previous context went away with it.
+	memset(ringfences, 0, sizeof(ringfences));
+	ringsection = nextvertex = nextindex = batchvertex = batchindex = 0;
+
+	//Init VAO and vertex state. The index buffer binding belongs to the VAO.
 	glGenVertexArrays(1, &drawvao);
 	glBindVertexArray(drawvao);
 
+	glGenBuffers(1, &drawbuffer);
+	glGenBuffers(1, &drawindexbuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, drawbuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawindexbuffer);
+
+	ringpersistent = false;
+	if (dglBufferStorage && opengl_CheckExtension("GL_ARB_buffer_storage"))
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		dglBufferStorage(GL_ARRAY_BUFFER, buffersize, nullptr, flags);
+		dglBufferStorage(GL_ELEMENT_ARRAY_BUFFER, indexbuffersize, nullptr, flags);
+		ringvertices = (gl_vertex*)glMapBufferRange(GL_ARRAY_BUFFER, 0, buffersize, flags);
+		ringindices = (ushort*)glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, indexbuffersize, flags);
+
+		if (ringvertices && ringindices)
+			ringpersistent = true;
+		else
+		{
+			//Immutable storage can't be respecified, so start over with new buffers.
+			mprintf((0, "Failed to map the draw ring, using buffer updates.\n"));
+			glDeleteBuffers(1, &drawbuffer);
+			glDeleteBuffers(1, &drawindexbuffer);
+			glGenBuffers(1, &drawbuffer);
+			glGenBuffers(1, &drawindexbuffer);
+			glBindBuffer(GL_ARRAY_BUFFER, drawbuffer);
+			glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, drawindexbuffer);
+		}
+	}
+
+	if (!ringpersistent)
+	{
+		glBufferData(GL_ARRAY_BUFFER, buffersize, nullptr, GL_DYNAMIC_DRAW);
+		glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexbuffersize, nullptr, GL_DYNAMIC_DRAW);
+
+		if (shadowvertices == nullptr)
+		{
+			shadowvertices = (gl_vertex*)mem_malloc(buffersize);
+			shadowindices = (ushort*)mem_malloc(indexbuffersize);
+		}
+		ringvertices = shadowvertices;
+		ringindices = shadowindices;
+	}
+
+	mprintf((0, "Draw ring is %s.\n", ringpersistent ? "persistently mapped" : "updated with glBufferSubData"));
+
 	size_t offset = 0;
 
 	//attrib 0: position
@@ -137,21 +254,30 @@ void opengl_SetDrawDefaults(void)
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 }
 
+//Call after using any program other than the draw shaders, so the next draw binds its shader again.
+void GL_InvalidateDrawShader(void)
+{
+	lastdrawshader = -1;
+}
+
 void GL_SelectDrawShader()
 {
-	//TODO: This will bind excessively because I don't know if the previous shader was overridden by something.
-	//This should probably be cleaned up
+	int shader;
 	if (OpenGL_state.cur_alpha_type == AT_SPECULAR)
-		drawshaders[3].Use();
+		shader = 3;
 	else if (OpenGL_state.cur_texture_quality == 0)
-		drawshaders[0].Use();
-	else if (OpenGL_state.cur_texture_quality != 0)
-	{
-		if (Overlay_type != OT_NONE)
-			drawshaders[2].Use();
-		else
-			drawshaders[1].Use();
-	}
+		shader = 0;
+	else if (Overlay_type != OT_NONE)
+		shader = 2;
+	else
+		shader = 1;
+
+	if (shader == lastdrawshader)
+		return;
+
+	GL_FlushDraws();
+	drawshaders[shader].Use();
+	lastdrawshader = shader;
 }
 
 // Takes nv vertices and draws the 3D polygon defined by those vertices.
@@ -163,6 +289,8 @@ void rend_DrawPolygon3D(int handle, g3Point** p, int nv, int map_type)
 	float fr, fg, fb;
 
 	ASSERT(nv < 100);
+	if (nv < 3)
+		return;
 
 	/*if (OpenGL_state.cur_texture_quality == 0)
 	{
@@ -215,7 +343,8 @@ void rend_DrawPolygon3D(int handle, g3Point** p, int nv, int map_type)
 
 	float alpha = Alpha_multiplier * OpenGL_Alpha_factor;
 
-	gl_vertex* vertp = GL_vertices;
+	int first = GL_ReserveVertices(GL_TRIANGLES, nv, (nv - 2) * 3);
+	gl_vertex* vertp = &ringvertices[first];
 
 	// Specify our coordinates
 	for (i = 0; i < nv; i++, vertp++)
@@ -300,9 +429,17 @@ void rend_DrawPolygon3D(int handle, g3Point** p, int nv, int map_type)
 		vertp->vert.z = -z;
 	}
 
-	// And draw!
-	int offset = GL_CopyVertices(nv);
-	glDrawArrays(GL_TRIANGLE_FAN, offset, nv);
+	// Turn the fan into triangles, it gets drawn with whatever follows it until the state changes
+	ushort* indexp = &ringindices[nextindex];
+	for (i = 2; i < nv; i++)
+	{
+		*indexp++ = first;
+		*indexp++ = first + i - 1;
+		*indexp++ = first + i;
+	}
+
+	nextvertex += nv;
+	nextindex += (nv - 2) * 3;
 	OpenGL_polys_drawn++;
 	OpenGL_verts_processed += nv;
 
@@ -453,6 +590,7 @@ void rend_FillRect(ddgr_color color, int x1, int y1, int x2, int y2)
 	x1 += OpenGL_state.clip_x1;
 	y1 += OpenGL_state.clip_y1;
 
+	GL_FlushDraws();
 	glEnable(GL_SCISSOR_TEST);
 	glScissor(x1, OpenGL_state.screen_height - (height + y1), width, height);
 	glClearColor((float)r / 255.0, (float)g / 255.0, (float)b / 255.0, 0);
@@ -474,18 +612,21 @@ void rend_SetPixel(ddgr_color color, int x, int y)
 
 	GL_SelectDrawShader();
 
-	GL_vertices[0].color.r = r;
-	GL_vertices[0].color.g = g;
-	GL_vertices[0].color.b = b;
-	GL_vertices[0].color.a = 1.0f;
+	int first = GL_ReserveVertices(GL_POINTS, 1, 1);
+	gl_vertex* vertp = &ringvertices[first];
+
+	vertp->color.r = r;
+	vertp->color.g = g;
+	vertp->color.b = b;
+	vertp->color.a = 1.0f;
 
-	GL_vertices[0].vert.x = x;
-	GL_vertices[0].vert.y = y;
-	GL_vertices[0].vert.z = 0;
+	vertp->vert.x = x;
+	vertp->vert.y = y;
+	vertp->vert.z = 0;
 
 	//please do not call this function if you can avoid it.
-	int offset = GL_CopyVertices(1);
-	glDrawArrays(GL_POINTS, offset, 1);
+	ringindices[nextindex++] = first;
+	nextvertex++;
 
 	/*glColor3ub(r, g, b);
 
@@ -498,6 +639,7 @@ void rend_SetPixel(ddgr_color color, int x, int y)
 ddgr_color rend_GetPixel(int x, int y)
 {
 	ddgr_color color[4];
+	GL_FlushDraws();
 	glReadPixels(x, (OpenGL_state.screen_height - 1) - y, 1, 1, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)color);
 	return color[0];
 }
@@ -562,22 +704,26 @@ void rend_DrawLine(int x1, int y1, int x2, int y2)
 
 	GL_SelectDrawShader();
 
-	GL_vertices[0].color.r = r;
-	GL_vertices[0].color.g = g;
-	GL_vertices[0].color.b = b;
-	GL_vertices[0].color.a = 1.0f;
-	GL_vertices[1].color = GL_vertices[0].color;
+	int first = GL_ReserveVertices(GL_LINES, 2, 2);
+	gl_vertex* vertp = &ringvertices[first];
+
+	vertp[0].color.r = r;
+	vertp[0].color.g = g;
+	vertp[0].color.b = b;
+	vertp[0].color.a = 1.0f;
+	vertp[1].color = vertp[0].color;
 
 	//hack to avoid line clipping but this isn't working correctly yet, causes one corner to vanish. 
-	GL_vertices[0].vert.x = x1 + 1.f;
-	GL_vertices[0].vert.y = y1 + 1.f;
-	GL_vertices[0].vert.z = 0;
-	GL_vertices[1].vert.x = x2 + 1.f;
-	GL_vertices[1].vert.y = y2 + 1.f;
-	GL_vertices[1].vert.z = 0;
+	vertp[0].vert.x = x1 + 1.f;
+	vertp[0].vert.y = y1 + 1.f;
+	vertp[0].vert.z = 0;
+	vertp[1].vert.x = x2 + 1.f;
+	vertp[1].vert.y = y2 + 1.f;
+	vertp[1].vert.z = 0;
 
-	int offset = GL_CopyVertices(2);
-	glDrawArrays(GL_LINES, offset, 2);
+	ringindices[nextindex++] = first;
+	ringindices[nextindex++] = first + 1;
+	nextvertex += 2;
 
 	rend_SetAlphaType(atype);
 	rend_SetLighting(ltype);
@@ -652,7 +798,10 @@ void rend_DrawSpecialLine(g3Point* p0, g3Point* p1)
 
 	alpha = Alpha_multiplier * OpenGL_Alpha_factor;
 
-	gl_vertex* vertp = GL_vertices;
+	GL_SelectDrawShader();
+
+	int first = GL_ReserveVertices(GL_LINES, 2, 2);
+	gl_vertex* vertp = &ringvertices[first];
 
 	// And draw!
 	for (i = 0; i < 2; i++, vertp++)
@@ -699,9 +848,9 @@ void rend_DrawSpecialLine(g3Point* p0, g3Point* p1)
 		//glVertex3f(pnt->p3_sx + x_add, pnt->p3_sy + y_add, -z);
 	}
 
-	GL_SelectDrawShader();
-	int offset = GL_CopyVertices(2);
-	glDrawArrays(GL_LINES, offset, 2);
+	ringindices[nextindex++] = first;
+	ringindices[nextindex++] = first + 1;
+	nextvertex += 2;
 }
 
 // Gets a pointer to a linear frame buffer
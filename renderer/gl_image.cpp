@@ -66,6 +66,7 @@ void opengl_FreeImages(void)
 	for (int i = 1; i < Cur_texture_object_num; i++)
 		delete_list[i] = i;
 
+	GL_FlushDraws();
 	if (Cur_texture_object_num > 1)
 		glDeleteTextures(Cur_texture_object_num, (const uint*)delete_list);
 
@@ -78,6 +79,8 @@ int opengl_MakeTextureObject(int tn)
 
 	Cur_texture_object_num++;
 
+	GL_FlushDraws();
+
 	if (texture_name_list[num] == 0)
 		glGenTextures(1, &texture_name_list[num]);
 
@@ -171,6 +174,7 @@ int opengl_MakeBitmapCurrent(int handle, int map_type, int tn)
 
 	if (OpenGL_last_bound[tn] != texnum)
 	{
+		GL_FlushDraws();
 		if (UseMultitexture && Last_texel_unit_set != tn)
 		{
 			glActiveTexture(GL_TEXTURE0 + tn);
@@ -205,6 +209,7 @@ void opengl_MakeWrapTypeCurrent(int handle, int map_type, int tn)
 	if (uwrap == dest_wrap)
 		return;
 	
+	GL_FlushDraws();
 	if (UseMultitexture && Last_texel_unit_set != tn)
 	{
 		glActiveTexture(GL_TEXTURE0 + tn);
@@ -269,6 +274,8 @@ void opengl_MakeFilterTypeCurrent(int handle, int map_type, int tn)
 
 	if (magf == dest_filter && mmip == dest_mip)
 		return;
+
+	GL_FlushDraws();
 	if (UseMultitexture && Last_texel_unit_set != tn)
 	{
 		glActiveTexture(GL_TEXTURE0 + tn);
@@ -551,6 +558,7 @@ void opengl_TranslateBitmapToOpenGL(int texnum, int bm_handle, int map_type, int
 	int w, h;
 	int size;
 
+	GL_FlushDraws();
 	if (UseMultitexture && Last_texel_unit_set != tn)
 	{
 		glActiveTexture(GL_TEXTURE0 + tn);
@@ -27,6 +27,7 @@ renderer_preferred_state OpenGL_preferred_state = { false, true, false, 32, 1.0
 rendering_state OpenGL_state;
 
 PFNWGLSWAPINTERVALEXTPROC dwglSwapIntervalEXT;
+PFNGLBUFFERSTORAGEPROC dglBufferStorage;
 PFNWGLCREATECONTEXTATTRIBSARBPROC dwglCreateContextAttribsARB;
 
 bool OpenGL_debugging_enabled;
@@ -296,6 +297,13 @@ die:
 // Check for OpenGL support, 
 int opengl_Setup(HDC glhdc)
 {
+	//The null renderer doesn't need a context
+	if (OpenGL_null)
+	{
+		GL_LoadNullProcs();
+		return 1;
+	}
+
 	if (!GL_GetWGLExtensionProcs())
 	{
 		mprintf((0, "Dummy GL context failed!\n"));
@@ -395,6 +403,7 @@ int opengl_Setup(HDC glhdc)
 	}
 
 	dwglSwapIntervalEXT = (PFNWGLSWAPINTERVALEXTPROC)opengl_GLADLoad("wglSwapIntervalEXT");
+	dglBufferStorage = (PFNGLBUFFERSTORAGEPROC)opengl_GLADLoad("glBufferStorage");
 
 	Already_loaded = true;
 
@@ -486,7 +495,9 @@ int opengl_Init(oeApplication* app, renderer_preferred_state* pref_state)
 	width = OpenGL_preferred_state.width;
 	height = OpenGL_preferred_state.height;
 
-	if (!opengl_Setup(app, &width, &height))
+	if (OpenGL_null)
+		GL_LoadNullProcs();
+	else if (!opengl_Setup(app, &width, &height))
 	{
 		opengl_Close();
 		return 0;
@@ -558,9 +569,12 @@ void opengl_Close()
 	opengl_CloseFramebuffer();
 
 #if defined(WIN32)
-	wglMakeCurrent(NULL, NULL);
+	if (!OpenGL_null)
+	{
+		wglMakeCurrent(NULL, NULL);
 
-	wglDeleteContext(ResourceContext);
+		wglDeleteContext(ResourceContext);
+	}
 
 #elif defined(__LINUX__)
 	// SDL_Quit() handles this for us.
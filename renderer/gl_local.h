@@ -49,6 +49,14 @@ extern HWND hOpenGLWnd;
 extern HDC hOpenGLDC;
 #endif
 
+//glBufferStorage is core in 4.4 and isn't part of the 3.3 glad loader. NULL if the driver doesn't have it.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+typedef void (GLAD_API_PTR* PFNGLBUFFERSTORAGEPROC)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+extern PFNGLBUFFERSTORAGEPROC dglBufferStorage;
+
 //gl_init.cpp
 extern bool OpenGL_packed_pixels;
 extern bool OpenGL_debugging_enabled;
@@ -103,8 +111,13 @@ extern bool OpenGL_blending_on;
 extern bool OpenGL_multitexture_state;
 extern int OpenGL_polys_drawn;
 extern int OpenGL_verts_processed;
+extern int OpenGL_batches_drawn;
 
 void opengl_SetDrawDefaults(void);
+//Draws the polygons batched up so far. Call before changing any GL state they're drawn with.
+void GL_FlushDraws(void);
+//Call after binding a program other than the draw shaders.
+void GL_InvalidateDrawShader(void);
 void rend_SetLightingState(light_state state);
 void rend_SetMipState(sbyte mipstate);
 void opengl_DrawMultitexturePolygon3D(int handle, g3Point** p, int nv, int map_type);
@@ -113,6 +126,18 @@ void opengl_DrawFlatPolygon3D(g3Point** p, int nv);
 //Call to ensure that the draw VAO is always ready to go when changing VAOs.
 void GL_UseDrawVAO(void);
 
+//gl_null.cpp
+//Set when the null renderer is in use. It has no window or context, and only counts the GL calls made.
+extern bool OpenGL_null;
+void GL_LoadNullProcs(void);
+void GL_NullEndFrame(void);
+
+//gl_model.cpp
+void GL_InitModels(void);
+void GL_CloseModels(void);
+//Draws the model instances queued so far. GL_FlushDraws does this first.
+void GL_FlushModelInstances(void);
+
 //gl_framebuffer.cpp
 class Framebuffer
 {
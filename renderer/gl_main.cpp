@@ -75,6 +75,9 @@ int rend_Init(renderer_type state, oeApplication* app, renderer_preferred_state*
 
 	mprintf((0, "Renderer init is set to %d\n", Renderer_initted));
 
+	//RENDERER_NONE gets the null renderer, which goes through all the same steps without a GPU.
+	OpenGL_null = (state == RENDERER_NONE);
+
 	retval = opengl_Init(app, pref_state);
 
 	extern const char* blitVertexSrc;
@@ -89,6 +92,8 @@ int rend_Init(renderer_type state, oeApplication* app, renderer_preferred_state*
 	extern const char* testFragmentSrc;
 	testshader.AttachSource(testVertexSrc, testFragmentSrc);
 
+	GL_InitModels();
+
 	//[ISB] moved here.. stupid. 
 	opengl_SetGammaValue(OpenGL_preferred_state.gamma);
 
@@ -105,6 +110,7 @@ void rend_Close(void)
 		return;
 
 	blitshader.Destroy();
+	GL_CloseModels();
 	opengl_Close();
 
 	Renderer_initted = false;
@@ -269,6 +275,7 @@ int rend_SetPreferredState(renderer_preferred_state* pref_state)
 
 void rend_StartFrame(int x1, int y1, int x2, int y2, int clear_flags)
 {
+	GL_FlushDraws();
 	if (clear_flags & RF_CLEAR_ZBUFFER)
 	{
 		glClear(GL_DEPTH_BUFFER_BIT);
@@ -291,11 +298,13 @@ void rend_StartFrame(int x1, int y1, int x2, int y2, int clear_flags)
 
 static int OpenGL_last_frame_polys_drawn = 0;
 static int OpenGL_last_frame_verts_processed = 0;
+static int OpenGL_last_frame_batches_drawn = 0;
 static int OpenGL_last_uploaded = 0;
 
 // Flips the screen
 void rend_Flip(void)
 {
+	GL_FlushDraws();
 #ifndef NDEBUG
 	GLenum err = glGetError();
 	if (err != GL_NO_ERROR)
@@ -303,13 +312,14 @@ void rend_Flip(void)
 		mprintf((0, "Error entering flip: %d\n", err));
 	}
 #endif
-#ifndef RELEASE
-	int i;
-
 	RTP_INCRVALUE(texture_uploads, OpenGL_uploads);
 	RTP_INCRVALUE(polys_drawn, OpenGL_polys_drawn);
+	RTP_COUNTER(batches_drawn, OpenGL_batches_drawn);
 
-	mprintf_at((1, 1, 0, "Uploads=%d    Polys=%d   Verts=%d   ", OpenGL_uploads, OpenGL_polys_drawn, OpenGL_verts_processed));
+#ifndef RELEASE
+	int i;
+
+	mprintf_at((1, 1, 0, "Uploads=%d    Polys=%d   Verts=%d   Batches=%d   ", OpenGL_uploads, OpenGL_polys_drawn, OpenGL_verts_processed, OpenGL_batches_drawn));
 	mprintf_at((1, 2, 0, "Sets= 0:%d   1:%d   2:%d   3:%d   ", OpenGL_sets_this_frame[0], OpenGL_sets_this_frame[1], OpenGL_sets_this_frame[2], OpenGL_sets_this_frame[3]));
 	mprintf_at((1, 3, 0, "Sets= 4:%d   5:%d  ", OpenGL_sets_this_frame[4], OpenGL_sets_this_frame[5]));
 	for (i = 0; i < 10; i++)
@@ -320,11 +330,13 @@ void rend_Flip(void)
 
 	OpenGL_last_frame_polys_drawn = OpenGL_polys_drawn;
 	OpenGL_last_frame_verts_processed = OpenGL_verts_processed;
+	OpenGL_last_frame_batches_drawn = OpenGL_batches_drawn;
 	OpenGL_last_uploaded = OpenGL_uploads;
 
 	OpenGL_uploads = 0;
 	OpenGL_polys_drawn = 0;
 	OpenGL_verts_processed = 0;
+	OpenGL_batches_drawn = 0;
 
 	if (OpenGL_preferred_state.gamma == 1.0)
 		framebuffers[framebuffer_current_draw].BlitToRaw(0, framebuffer_blit_x, framebuffer_blit_y, framebuffer_blit_w, framebuffer_blit_h);
@@ -333,6 +345,7 @@ void rend_Flip(void)
 		blitshader.Use();
 		framebuffers[framebuffer_current_draw].BlitTo(0, framebuffer_blit_x, framebuffer_blit_y, framebuffer_blit_w, framebuffer_blit_h);
 		glUseProgram(0);
+		GL_InvalidateDrawShader();
 	}
 
 	glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
@@ -345,11 +358,16 @@ void rend_Flip(void)
 	}
 #endif
 
+	if (OpenGL_null)
+		GL_NullEndFrame();
+	else
+	{
 #if defined(WIN32)	
-	SwapBuffers((HDC)hOpenGLDC);
+		SwapBuffers((HDC)hOpenGLDC);
 #elif defined(__LINUX__)
-	SDL_GL_SwapBuffers();
+		SDL_GL_SwapBuffers();
 #endif
+	}
 
 	framebuffer_current_draw = (framebuffer_current_draw + 1) % NUM_FBOS;
 	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffers[framebuffer_current_draw].Handle());
@@ -372,6 +390,7 @@ void rend_Flip(void)
 
 void rend_EndFrame(void)
 {
+	GL_FlushDraws();
 }
 
 
@@ -392,11 +411,13 @@ bool opengl_CheckExtension(char* extName)
 
 void opengl_SetGammaValue(float val)
 {
+	GL_FlushDraws();
 	blitshader.Use();
 
 	glUniform1f(blitshader_gamma, 1.f / val);
 
 	glUseProgram(0);
+	GL_InvalidateDrawShader();
 }
 
 void rend_SetFlatColor(ddgr_color color)
@@ -542,6 +563,7 @@ void rend_SetZBufferState(sbyte state)
 	if (state == OpenGL_state.cur_zbuffer_state)
 		return;	// No redundant state setting
 
+	GL_FlushDraws();
 	OpenGL_sets_this_frame[5]++;
 	OpenGL_state.cur_zbuffer_state = state;
 
@@ -587,6 +609,7 @@ void rend_ClearScreen(ddgr_color color)
 	int g = (color >> 8 & 0xFF);
 	int b = (color & 0xFF);
 
+	GL_FlushDraws();
 	glClearColor((float)r / 255.0f, (float)g / 255.0f, (float)b / 255.0f, 0);
 
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -595,6 +618,7 @@ void rend_ClearScreen(ddgr_color color)
 // Clears the zbuffer for the screen
 void rend_ClearZBuffer(void)
 {
+	GL_FlushDraws();
 	glClear(GL_DEPTH_BUFFER_BIT);
 }
 
@@ -721,6 +745,7 @@ void rend_SetAlphaType(sbyte atype)
 {
 	if (atype == OpenGL_state.cur_alpha_type)
 		return;		// don't set it redundantly
+	GL_FlushDraws();
 	if (UseMultitexture && Last_texel_unit_set != 0)
 	{
 		glActiveTexture(GL_TEXTURE0 + 0);
@@ -837,6 +862,7 @@ void rend_SetZBias(float z_bias)
 // Enables/disables writes the depth buffer
 void rend_SetZBufferWriteMask(int state)
 {
+	GL_FlushDraws();
 	OpenGL_sets_this_frame[5]++;
 	if (state)
 	{
@@ -874,6 +900,7 @@ float rend_GetAspectRatio(void)
 // This helps reduce z buffer artifacts
 void rend_SetCoplanarPolygonOffset(float factor)
 {
+	GL_FlushDraws();
 	if (factor == 0.0f)
 	{
 		glDisable(GL_POLYGON_OFFSET_FILL);
@@ -941,6 +968,7 @@ void rend_GetStatistics(tRendererStats* stats)
 	{
 		stats->poly_count = OpenGL_last_frame_polys_drawn;
 		stats->vert_count = OpenGL_last_frame_verts_processed;
+		stats->batch_count = OpenGL_last_frame_batches_drawn;
 		stats->texture_uploads = OpenGL_last_uploaded;
 	}
 	else
@@ -1027,6 +1055,7 @@ void rend_Screenshot(int bm_handle)
 
 	dest_data = bm_data(bm_handle, 0);
 
+	GL_FlushDraws();
 	glReadPixels(0, 0, OpenGL_state.screen_width, OpenGL_state.screen_height, GL_RGBA, GL_UNSIGNED_BYTE, (GLvoid*)temp_data);
 
 	for (i = 0; i < h; i++)
@@ -1048,6 +1077,7 @@ void rend_Screenshot(int bm_handle)
 
 void opengl_UpdateFramebuffer(void)
 {
+	GL_FlushDraws();
 	for (int i = 0; i < NUM_FBOS; i++)
 	{
 		framebuffers[i].Update(OpenGL_state.screen_width, OpenGL_state.screen_height, OpenGL_preferred_state.antialised);
@@ -1063,6 +1093,7 @@ void opengl_UpdateFramebuffer(void)
 
 void opengl_CloseFramebuffer(void)
 {
+	GL_FlushDraws();
 	for (int i = 0; i < NUM_FBOS; i++)
 	{
 		framebuffers[i].Destroy();
@@ -1076,10 +1107,13 @@ void opengl_CloseFramebuffer(void)
 //shader test
 void rend_UseShaderTest(void)
 {
+	GL_FlushDraws();
 	testshader.Use();
+	GL_InvalidateDrawShader();
 }
 
 void rend_EndShaderTest(void)
 {
 	glUseProgram(0);
+	GL_InvalidateDrawShader();
 }
@@ -192,12 +192,22 @@ void MeshBuilder::Reset()
 
 void MeshBuilder::Draw() const
 {
+	DrawBatches(0, m_interactions.size());
+}
+
+void MeshBuilder::DrawBatches(int first, int count) const
+{
+	if (count <= 0)
+		return;
+
+	GL_FlushDraws();
 	glBindVertexArray(m_handle);
 	if (m_indexhandle)
 		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexhandle);
 
-	for (const MeshBatch& batch : m_interactions)
+	for (int i = first; i < first + count; i++)
 	{
+		const MeshBatch& batch = m_interactions[i];
 		//Why have I not made a "make bitmap current" function yet?
 		if (batch.primaryhandle >= 0)
 		{
@@ -102,8 +102,17 @@ public:
 	//Draws the mesh with the currently bound shader.
 	void Draw() const;
 
+	//Draws count batches starting at first, in the order they were started.
+	void DrawBatches(int first, int count) const;
+
 	int NumVertices() const
 	{
 		return m_vertices.size();
 	}
+
+	//While building, this is the number of the next batch to be started.
+	int NumBatches() const
+	{
+		return m_interactions.size();
+	}
 };
@@ -0,0 +1,344 @@
+/*
+* Descent 3: Piccu Engine
+* Copyright (C) 2024 SaladBadger
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stddef.h>
+#include <string.h>
+#include <vector>
+#include "gl_local.h"
+
+//The instance buffer is a texture buffer of RGBA32F texels. GL 3.3 guarantees at least this many.
+constexpr int MAX_INSTANCE_TEXELS = 65536;
+//Each instance starts with the light direction and the tint, followed by three rows for each pose.
+constexpr int INSTANCE_HEADER_TEXELS = 2;
+//The texture unit the instance buffer is bound to, past the color texture and the lightmap.
+constexpr int INSTANCE_TEXTURE_UNIT = 2;
+
+struct gl_model_mesh
+{
+	GLuint vao, vertbuffer, indexbuffer;
+	int num_verts;
+	bool used;
+};
+
+//All the instances of one mesh that are drawn with the same bitmaps and texture state
+struct gl_model_group
+{
+	int mesh;
+	int num_poses;
+	wrap_type wrap;
+	sbyte bilinear, mip;
+	std::vector<rend_model_batch> batches;
+	std::vector<float> data;
+	int num_instances;
+};
+
+static std::vector<gl_model_mesh> modelmeshes;
+//Groups past numgroups are kept so their storage can be reused
+static std::vector<gl_model_group> modelgroups;
+static int numgroups;
+static int pendingtexels;
+static bool flushing;
+
+static ShaderProgram modelshader;
+static GLint modelshader_base = -1, modelshader_size = -1;
+static GLuint instancebuffer, instancetexture;
+
+void GL_InitModels(void)
+{
+	extern const char* modelVertexSrc;
+	extern const char* modelFragmentSrc;
+	modelshader.AttachSource(modelVertexSrc, modelFragmentSrc);
+	modelshader_base = modelshader.FindUniform("instancebase");
+	modelshader_size = modelshader.FindUniform("instancesize");
+
+	modelshader.Use();
+	glUniform1i(modelshader.FindUniform("instancedata"), INSTANCE_TEXTURE_UNIT);
+	glUseProgram(0);
+
+	glGenBuffers(1, &instancebuffer);
+	glBindBuffer(GL_TEXTURE_BUFFER, instancebuffer);
+	glBufferData(GL_TEXTURE_BUFFER, MAX_INSTANCE_TEXELS * sizeof(float[4]), nullptr, GL_STREAM_DRAW);
+
+	glGenTextures(1, &instancetexture);
+	glActiveTexture(GL_TEXTURE0 + INSTANCE_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, instancetexture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, instancebuffer);
+	glActiveTexture(GL_TEXTURE0 + Last_texel_unit_set);
+
+	GLenum err = glGetError();
+	if (err != GL_NO_ERROR)
+		Int3();
+}
+
+void GL_CloseModels(void)
+{
+	for (int i = 0; i < (int)modelmeshes.size(); i++)
+		rend_FreeModelMesh(i);
+	modelmeshes.clear();
+	modelgroups.clear();
+	numgroups = pendingtexels = 0;
+
+	if (instancetexture)
+	{
+		glDeleteTextures(1, &instancetexture);
+		instancetexture = 0;
+	}
+	if (instancebuffer)
+	{
+		glDeleteBuffers(1, &instancebuffer);
+		instancebuffer = 0;
+	}
+	modelshader.Destroy();
+}
+
+int rend_CreateModelMesh(int num_verts, rend_model_vertex* verts, int num_indices, ushort* indices)
+{
+	if (!modelshader.Handle() || num_verts <= 0 || num_verts > 65536 || num_indices <= 0)
+		return -1;
+
+	int handle;
+	for (handle = 0; handle < (int)modelmeshes.size(); handle++)
+	{
+		if (!modelmeshes[handle].used)
+			break;
+	}
+	if (handle == (int)modelmeshes.size())
+		modelmeshes.push_back(gl_model_mesh());
+
+	gl_model_mesh& mesh = modelmeshes[handle];
+	mesh.num_verts = num_verts;
+
+	GL_FlushDraws();
+	glGenVertexArrays(1, &mesh.vao);
+	glBindVertexArray(mesh.vao);
+
+	glGenBuffers(1, &mesh.vertbuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, mesh.vertbuffer);
+	glBufferData(GL_ARRAY_BUFFER, num_verts * sizeof(rend_model_vertex), verts, GL_STATIC_DRAW);
+
+	glGenBuffers(1, &mesh.indexbuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.indexbuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, num_indices * sizeof(ushort), indices, GL_STATIC_DRAW);
+
+	//Position
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(rend_model_vertex), (void*)offsetof(rend_model_vertex, pos));
+
+	//Normal
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(rend_model_vertex), (void*)offsetof(rend_model_vertex, normal));
+
+	//UV
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(rend_model_vertex), (void*)offsetof(rend_model_vertex, u));
+
+	//Alpha
+	glEnableVertexAttribArray(3);
+	glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(rend_model_vertex), (void*)offsetof(rend_model_vertex, alpha));
+
+	//Submodel and fullbright flag
+	glEnableVertexAttribArray(4);
+	glVertexAttribIPointer(4, 2, GL_INT, sizeof(rend_model_vertex), (void*)offsetof(rend_model_vertex, submodel));
+
+	GL_UseDrawVAO();
+
+	GLenum err = glGetError();
+	if (err != GL_NO_ERROR)
+	{
+		mprintf((0, "rend_CreateModelMesh: GL error %d creating a mesh of %d vertices\n", err, num_verts));
+		mesh.used = true;
+		rend_FreeModelMesh(handle);
+		return -1;
+	}
+
+	mesh.used = true;
+	return handle;
+}
+
+void rend_FreeModelMesh(int handle)
+{
+	if (handle < 0 || handle >= (int)modelmeshes.size() || !modelmeshes[handle].used)
+		return;
+
+	//Pending instances may still refer to it
+	GL_FlushDraws();
+
+	gl_model_mesh& mesh = modelmeshes[handle];
+	glDeleteBuffers(1, &mesh.indexbuffer);
+	glDeleteBuffers(1, &mesh.vertbuffer);
+	glDeleteVertexArrays(1, &mesh.vao);
+	mesh.vao = mesh.vertbuffer = mesh.indexbuffer = 0;
+	mesh.used = false;
+}
+
+static bool GL_SameModelGroup(const gl_model_group& group, int handle, int num_batches, rend_model_batch* batches, int num_poses)
+{
+	return group.mesh == handle && group.num_poses == num_poses &&
+		group.wrap == OpenGL_state.cur_wrap_type &&
+		group.bilinear == OpenGL_state.cur_bilinear_state && group.mip == OpenGL_state.cur_mip_state &&
+		(int)group.batches.size() == num_batches &&
+		!memcmp(group.batches.data(), batches, num_batches * sizeof(rend_model_batch));
+}
+
+bool rend_QueueModelInstance(int handle, int num_batches, rend_model_batch* batches, int num_poses, float* poses, vector* light_direction, float r, float g, float b)
+{
+	if (handle < 0 || handle >= (int)modelmeshes.size() || !modelmeshes[handle].used)
+		return false;
+	if (OpenGL_state.cur_texture_quality == 0)
+		return false;
+
+	int size = INSTANCE_HEADER_TEXELS + num_poses * 3;
+	if (size > MAX_INSTANCE_TEXELS)
+		return false;
+
+	//Polygons already in the ring have to be drawn before these, and the ring is empty while
+	//instances are queued, so a flush now only draws the ring.
+	if (numgroups == 0)
+		GL_FlushDraws();
+	else if (pendingtexels + size > MAX_INSTANCE_TEXELS)
+		GL_FlushModelInstances();
+
+	int i;
+	for (i = 0; i < numgroups; i++)
+	{
+		if (GL_SameModelGroup(modelgroups[i], handle, num_batches, batches, num_poses))
+			break;
+	}
+
+	if (i == numgroups)
+	{
+		if (numgroups == (int)modelgroups.size())
+			modelgroups.push_back(gl_model_group());
+
+		gl_model_group& group = modelgroups[numgroups++];
+		group.mesh = handle;
+		group.num_poses = num_poses;
+		group.wrap = OpenGL_state.cur_wrap_type;
+		group.bilinear = OpenGL_state.cur_bilinear_state;
+		group.mip = OpenGL_state.cur_mip_state;
+		group.batches.assign(batches, batches + num_batches);
+		group.data.clear();
+		group.num_instances = 0;
+	}
+
+	gl_model_group& group = modelgroups[i];
+	if (light_direction)
+	{
+		group.data.push_back(light_direction->x);
+		group.data.push_back(light_direction->y);
+		group.data.push_back(light_direction->z);
+		group.data.push_back(1.0f);
+	}
+	else
+	{
+		group.data.insert(group.data.end(), 4, 0.0f);
+		r = g = b = 1.0f;
+	}
+
+	group.data.push_back(r);
+	group.data.push_back(g);
+	group.data.push_back(b);
+	group.data.push_back(Alpha_multiplier * OpenGL_Alpha_factor);
+
+	group.data.insert(group.data.end(), poses, poses + num_poses * 12);
+	group.num_instances++;
+	pendingtexels += size;
+
+	return true;
+}
+
+//Draws the queued instances, one instanced call for each batch of each group.
+//Called by GL_FlushDraws, so it runs before anything changes the state they're drawn with.
+void GL_FlushModelInstances(void)
+{
+	if (numgroups == 0 || flushing)
+		return;
+
+	//The texture and state calls below flush too
+	flushing = true;
+
+	glBindBuffer(GL_TEXTURE_BUFFER, instancebuffer);
+	glBufferData(GL_TEXTURE_BUFFER, MAX_INSTANCE_TEXELS * sizeof(float[4]), nullptr, GL_STREAM_DRAW);
+	int offset = 0;
+	for (int i = 0; i < numgroups; i++)
+	{
+		gl_model_group& group = modelgroups[i];
+		glBufferSubData(GL_TEXTURE_BUFFER, offset * sizeof(float), group.data.size() * sizeof(float), group.data.data());
+		offset += group.data.size();
+	}
+
+	glActiveTexture(GL_TEXTURE0 + INSTANCE_TEXTURE_UNIT);
+	glBindTexture(GL_TEXTURE_BUFFER, instancetexture);
+	glActiveTexture(GL_TEXTURE0);
+	Last_texel_unit_set = 0;
+
+	modelshader.Use();
+	GL_InvalidateDrawShader();
+
+	//Front faces wind clockwise once projected, the same test RenderSubmodelFacesUnsorted does with the face normals
+	glEnable(GL_CULL_FACE);
+	glFrontFace(GL_CW);
+
+	wrap_type save_wrap = OpenGL_state.cur_wrap_type;
+	sbyte save_bilinear = OpenGL_state.cur_bilinear_state;
+	sbyte save_mip = OpenGL_state.cur_mip_state;
+
+	int base = 0;
+	for (int i = 0; i < numgroups; i++)
+	{
+		gl_model_group& group = modelgroups[i];
+		gl_model_mesh& mesh = modelmeshes[group.mesh];
+		int size = INSTANCE_HEADER_TEXELS + group.num_poses * 3;
+
+		OpenGL_state.cur_wrap_type = group.wrap;
+		OpenGL_state.cur_bilinear_state = group.bilinear;
+		OpenGL_state.cur_mip_state = group.mip;
+
+		glUniform1i(modelshader_base, base);
+		glUniform1i(modelshader_size, size);
+		glBindVertexArray(mesh.vao);
+
+		for (rend_model_batch& batch : group.batches)
+		{
+			opengl_MakeBitmapCurrent(batch.bm_handle, MAP_TYPE_BITMAP, 0);
+			opengl_MakeWrapTypeCurrent(batch.bm_handle, MAP_TYPE_BITMAP, 0);
+			opengl_MakeFilterTypeCurrent(batch.bm_handle, MAP_TYPE_BITMAP, 0);
+
+			glDrawElementsInstanced(GL_TRIANGLES, batch.num_indices, GL_UNSIGNED_SHORT, (const void*)(batch.first_index * sizeof(ushort)), group.num_instances);
+			OpenGL_batches_drawn++;
+			OpenGL_polys_drawn += batch.num_indices / 3 * group.num_instances;
+		}
+
+		OpenGL_verts_processed += mesh.num_verts * group.num_instances;
+		base += group.num_instances * size;
+	}
+
+	OpenGL_state.cur_wrap_type = save_wrap;
+	OpenGL_state.cur_bilinear_state = save_bilinear;
+	OpenGL_state.cur_mip_state = save_mip;
+
+	glDisable(GL_CULL_FACE);
+	glFrontFace(GL_CCW);
+	GL_UseDrawVAO();
+
+	numgroups = 0;
+	pendingtexels = 0;
+	flushing = false;
+
+	CHECK_ERROR(12)
+}
@@ -0,0 +1,368 @@
+/*
+* Descent 3: Piccu Engine
+* Copyright (C) 2024 SaladBadger
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+//The null renderer. Instead of loading the driver's GL functions, every GL function the renderer uses
+//is pointed at a stub that counts what it was asked to do. Everything above GL runs as normal, so the
+//counts are the draws, state changes and uploads a real context would have gotten, without a GPU.
+
+#include <string.h>
+#include "gl_local.h"
+#include "rtperformance.h"
+
+bool OpenGL_null = false;
+
+static tRendererCallStats Null_frame;
+static tRendererCallStats Null_last_frame;
+
+//Names handed out for buffers, textures, shaders, uniforms and so on. 0 is never used.
+static GLuint Null_next_name = 1;
+static GLint Null_viewport[4];
+
+static GLuint GL_NullName()
+{
+	return Null_next_name++;
+}
+
+static void GL_NullGenNames(GLsizei n, GLuint* names)
+{
+	for (int i = 0; i < n; i++)
+		names[i] = GL_NullName();
+}
+
+//Bytes in a pixel of the given format and type
+static int GL_NullPixelSize(GLenum format, GLenum type)
+{
+	switch (type)
+	{
+	case GL_UNSIGNED_SHORT_5_5_5_1:
+	case GL_UNSIGNED_SHORT_1_5_5_5_REV:
+	case GL_UNSIGNED_SHORT_4_4_4_4:
+	case GL_UNSIGNED_SHORT_4_4_4_4_REV:
+	case GL_UNSIGNED_SHORT_5_6_5:
+		return 2;
+	case GL_UNSIGNED_INT_8_8_8_8:
+	case GL_UNSIGNED_INT_8_8_8_8_REV:
+		return 4;
+	}
+
+	int components = 4;
+	if (format == GL_RED || format == GL_DEPTH_COMPONENT)
+		components = 1;
+	else if (format == GL_RG)
+		components = 2;
+	else if (format == GL_RGB || format == GL_BGR)
+		components = 3;
+
+	return (type == GL_FLOAT) ? components * 4 : components;
+}
+
+//State changes
+#define NULL_STATE(name, params) static void GLAD_API_PTR Null_##name params { Null_frame.state_changes++; }
+
+NULL_STATE(ActiveTexture, (GLenum))
+NULL_STATE(BlendFunc, (GLenum, GLenum))
+NULL_STATE(DepthFunc, (GLenum))
+NULL_STATE(DepthMask, (GLboolean))
+NULL_STATE(DepthRange, (GLdouble, GLdouble))
+NULL_STATE(Disable, (GLenum))
+NULL_STATE(Enable, (GLenum))
+NULL_STATE(FrontFace, (GLenum))
+NULL_STATE(Hint, (GLenum, GLenum))
+NULL_STATE(PixelStorei, (GLenum, GLint))
+NULL_STATE(PolygonOffset, (GLfloat, GLfloat))
+NULL_STATE(Scissor, (GLint, GLint, GLsizei, GLsizei))
+NULL_STATE(ClearColor, (GLfloat, GLfloat, GLfloat, GLfloat))
+NULL_STATE(TexParameteri, (GLenum, GLenum, GLint))
+NULL_STATE(BindBuffer, (GLenum, GLuint))
+NULL_STATE(BindBufferBase, (GLenum, GLuint, GLuint))
+NULL_STATE(BindFramebuffer, (GLenum, GLuint))
+NULL_STATE(BindVertexArray, (GLuint))
+NULL_STATE(EnableVertexAttribArray, (GLuint))
+NULL_STATE(VertexAttribPointer, (GLuint, GLint, GLenum, GLboolean, GLsizei, const void*))
+NULL_STATE(VertexAttribIPointer, (GLuint, GLint, GLenum, GLsizei, const void*))
+NULL_STATE(UniformBlockBinding, (GLuint, GLuint, GLuint))
+NULL_STATE(TexBuffer, (GLenum, GLenum, GLuint))
+NULL_STATE(FramebufferTexture2D, (GLenum, GLenum, GLenum, GLuint, GLint))
+NULL_STATE(Uniform1f, (GLint, GLfloat))
+NULL_STATE(Uniform1i, (GLint, GLint))
+
+static void GLAD_API_PTR Null_Viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+	Null_frame.state_changes++;
+	Null_viewport[0] = x; Null_viewport[1] = y;
+	Null_viewport[2] = width; Null_viewport[3] = height;
+}
+
+static void GLAD_API_PTR Null_BindTexture(GLenum, GLuint)
+{
+	Null_frame.state_changes++;
+	Null_frame.texture_binds++;
+}
+
+static void GLAD_API_PTR Null_UseProgram(GLuint)
+{
+	Null_frame.state_changes++;
+	Null_frame.program_binds++;
+}
+
+//Draws
+static void GLAD_API_PTR Null_DrawArrays(GLenum, GLint, GLsizei count)
+{
+	Null_frame.draw_calls++;
+	Null_frame.vertices += count;
+}
+
+static void GLAD_API_PTR Null_DrawElements(GLenum, GLsizei count, GLenum, const void*)
+{
+	Null_frame.draw_calls++;
+	Null_frame.vertices += count;
+}
+
+static void GLAD_API_PTR Null_DrawElementsInstanced(GLenum, GLsizei count, GLenum, const void*, GLsizei instancecount)
+{
+	Null_frame.draw_calls++;
+	Null_frame.vertices += count * instancecount;
+}
+
+static void GLAD_API_PTR Null_BlitFramebuffer(GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLint, GLbitfield, GLenum)
+{
+	Null_frame.draw_calls++;
+}
+
+static void GLAD_API_PTR Null_Clear(GLbitfield)
+{
+}
+
+//Uploads
+static void GLAD_API_PTR Null_TexImage2D(GLenum, GLint, GLint, GLsizei width, GLsizei height, GLint, GLenum format, GLenum type, const void* pixels)
+{
+	if (pixels)
+	{
+		Null_frame.texture_uploads++;
+		Null_frame.upload_bytes += width * height * GL_NullPixelSize(format, type);
+	}
+}
+
+static void GLAD_API_PTR Null_TexSubImage2D(GLenum, GLint, GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, const void*)
+{
+	Null_frame.texture_uploads++;
+	Null_frame.upload_bytes += width * height * GL_NullPixelSize(format, type);
+}
+
+static void GLAD_API_PTR Null_TexImage2DMultisample(GLenum, GLsizei, GLenum, GLsizei, GLsizei, GLboolean)
+{
+}
+
+static void GLAD_API_PTR Null_BufferData(GLenum, GLsizeiptr size, const void* data, GLenum)
+{
+	if (data)
+		Null_frame.upload_bytes += size;
+}
+
+static void GLAD_API_PTR Null_BufferSubData(GLenum, GLintptr, GLsizeiptr size, const void*)
+{
+	Null_frame.upload_bytes += size;
+}
+
+//Mapping always fails, so the draw ring is updated with glBufferSubData and its uploads are counted
+static void* GLAD_API_PTR Null_MapBufferRange(GLenum, GLintptr, GLsizeiptr, GLbitfield)
+{
+	return nullptr;
+}
+
+//Objects
+static void GLAD_API_PTR Null_GenBuffers(GLsizei n, GLuint* buffers) { GL_NullGenNames(n, buffers); }
+static void GLAD_API_PTR Null_GenTextures(GLsizei n, GLuint* textures) { GL_NullGenNames(n, textures); }
+static void GLAD_API_PTR Null_GenVertexArrays(GLsizei n, GLuint* arrays) { GL_NullGenNames(n, arrays); }
+static void GLAD_API_PTR Null_GenFramebuffers(GLsizei n, GLuint* framebuffers) { GL_NullGenNames(n, framebuffers); }
+static void GLAD_API_PTR Null_DeleteBuffers(GLsizei, const GLuint*) {}
+static void GLAD_API_PTR Null_DeleteTextures(GLsizei, const GLuint*) {}
+static void GLAD_API_PTR Null_DeleteVertexArrays(GLsizei, const GLuint*) {}
+static void GLAD_API_PTR Null_DeleteFramebuffers(GLsizei, const GLuint*) {}
+static GLsync GLAD_API_PTR Null_FenceSync(GLenum, GLbitfield) { return (GLsync)(size_t)GL_NullName(); }
+static GLenum GLAD_API_PTR Null_ClientWaitSync(GLsync, GLbitfield, GLuint64) { return GL_ALREADY_SIGNALED; }
+static void GLAD_API_PTR Null_DeleteSync(GLsync) {}
+
+//Shaders. Everything compiles and links, and every uniform exists.
+static GLuint GLAD_API_PTR Null_CreateShader(GLenum) { return GL_NullName(); }
+static GLuint GLAD_API_PTR Null_CreateProgram() { return GL_NullName(); }
+static void GLAD_API_PTR Null_ShaderSource(GLuint, GLsizei, const GLchar* const*, const GLint*) {}
+static void GLAD_API_PTR Null_CompileShader(GLuint) {}
+static void GLAD_API_PTR Null_AttachShader(GLuint, GLuint) {}
+static void GLAD_API_PTR Null_LinkProgram(GLuint) {}
+static void GLAD_API_PTR Null_DeleteShader(GLuint) {}
+static void GLAD_API_PTR Null_DeleteProgram(GLuint) {}
+static GLint GLAD_API_PTR Null_GetUniformLocation(GLuint, const GLchar*) { return GL_NullName(); }
+static GLuint GLAD_API_PTR Null_GetUniformBlockIndex(GLuint, const GLchar*) { return 0; }
+
+static void GLAD_API_PTR Null_GetShaderiv(GLuint, GLenum pname, GLint* params)
+{
+	*params = (pname == GL_COMPILE_STATUS) ? GL_TRUE : 0;
+}
+
+static void GLAD_API_PTR Null_GetProgramiv(GLuint, GLenum pname, GLint* params)
+{
+	*params = (pname == GL_LINK_STATUS) ? GL_TRUE : 0;
+}
+
+static void GLAD_API_PTR Null_GetInfoLog(GLuint, GLsizei bufSize, GLsizei* length, GLchar* infoLog)
+{
+	if (length)
+		*length = 0;
+	if (bufSize > 0)
+		infoLog[0] = '\0';
+}
+
+//Queries
+static GLenum GLAD_API_PTR Null_GetError() { return GL_NO_ERROR; }
+static GLenum GLAD_API_PTR Null_CheckFramebufferStatus(GLenum) { return GL_FRAMEBUFFER_COMPLETE; }
+static void GLAD_API_PTR Null_DebugMessageCallback(GLDEBUGPROC, const void*) {}
+
+static const GLubyte* GLAD_API_PTR Null_GetString(GLenum)
+{
+	return (const GLubyte*)"Null renderer";
+}
+
+static const GLubyte* GLAD_API_PTR Null_GetStringi(GLenum, GLuint)
+{
+	return (const GLubyte*)"";
+}
+
+static void GLAD_API_PTR Null_GetIntegerv(GLenum pname, GLint* data)
+{
+	if (pname == GL_VIEWPORT)
+		memcpy(data, Null_viewport, sizeof(Null_viewport));
+	else
+		*data = 0; //No extensions, among other things
+}
+
+static void GLAD_API_PTR Null_ReadPixels(GLint, GLint, GLsizei width, GLsizei height, GLenum format, GLenum type, void* pixels)
+{
+	memset(pixels, 0, width * height * GL_NullPixelSize(format, type));
+}
+
+//Points the GL functions at the stubs, in place of gladLoadGL
+void GL_LoadNullProcs(void)
+{
+	glad_glActiveTexture = Null_ActiveTexture;
+	glad_glBlendFunc = Null_BlendFunc;
+	glad_glDepthFunc = Null_DepthFunc;
+	glad_glDepthMask = Null_DepthMask;
+	glad_glDepthRange = Null_DepthRange;
+	glad_glDisable = Null_Disable;
+	glad_glEnable = Null_Enable;
+	glad_glFrontFace = Null_FrontFace;
+	glad_glHint = Null_Hint;
+	glad_glPixelStorei = Null_PixelStorei;
+	glad_glPolygonOffset = Null_PolygonOffset;
+	glad_glScissor = Null_Scissor;
+	glad_glClearColor = Null_ClearColor;
+	glad_glTexParameteri = Null_TexParameteri;
+	glad_glBindBuffer = Null_BindBuffer;
+	glad_glBindBufferBase = Null_BindBufferBase;
+	glad_glBindFramebuffer = Null_BindFramebuffer;
+	glad_glBindVertexArray = Null_BindVertexArray;
+	glad_glEnableVertexAttribArray = Null_EnableVertexAttribArray;
+	glad_glVertexAttribPointer = Null_VertexAttribPointer;
+	glad_glVertexAttribIPointer = Null_VertexAttribIPointer;
+	glad_glUniformBlockBinding = Null_UniformBlockBinding;
+	glad_glTexBuffer = Null_TexBuffer;
+	glad_glFramebufferTexture2D = Null_FramebufferTexture2D;
+	glad_glUniform1f = Null_Uniform1f;
+	glad_glUniform1i = Null_Uniform1i;
+	glad_glViewport = Null_Viewport;
+	glad_glBindTexture = Null_BindTexture;
+	glad_glUseProgram = Null_UseProgram;
+
+	glad_glDrawArrays = Null_DrawArrays;
+	glad_glDrawElements = Null_DrawElements;
+	glad_glDrawElementsInstanced = Null_DrawElementsInstanced;
+	glad_glBlitFramebuffer = Null_BlitFramebuffer;
+	glad_glClear = Null_Clear;
+
+	glad_glTexImage2D = Null_TexImage2D;
+	glad_glTexSubImage2D = Null_TexSubImage2D;
+	glad_glTexImage2DMultisample = Null_TexImage2DMultisample;
+	glad_glBufferData = Null_BufferData;
+	glad_glBufferSubData = Null_BufferSubData;
+	glad_glMapBufferRange = Null_MapBufferRange;
+
+	glad_glGenBuffers = Null_GenBuffers;
+	glad_glGenTextures = Null_GenTextures;
+	glad_glGenVertexArrays = Null_GenVertexArrays;
+	glad_glGenFramebuffers = Null_GenFramebuffers;
+	glad_glDeleteBuffers = Null_DeleteBuffers;
+	glad_glDeleteTextures = Null_DeleteTextures;
+	glad_glDeleteVertexArrays = Null_DeleteVertexArrays;
+	glad_glDeleteFramebuffers = Null_DeleteFramebuffers;
+	glad_glFenceSync = Null_FenceSync;
+	glad_glClientWaitSync = Null_ClientWaitSync;
+	glad_glDeleteSync = Null_DeleteSync;
+
+	glad_glCreateShader = Null_CreateShader;
+	glad_glCreateProgram = Null_CreateProgram;
+	glad_glShaderSource = Null_ShaderSource;
+	glad_glCompileShader = Null_CompileShader;
+	glad_glAttachShader = Null_AttachShader;
+	glad_glLinkProgram = Null_LinkProgram;
+	glad_glDeleteShader = Null_DeleteShader;
+	glad_glDeleteProgram = Null_DeleteProgram;
+	glad_glGetUniformLocation = Null_GetUniformLocation;
+	glad_glGetUniformBlockIndex = Null_GetUniformBlockIndex;
+	glad_glGetShaderiv = Null_GetShaderiv;
+	glad_glGetProgramiv = Null_GetProgramiv;
+	glad_glGetShaderInfoLog = Null_GetInfoLog;
+	glad_glGetProgramInfoLog = Null_GetInfoLog;
+
+	glad_glGetError = Null_GetError;
+	glad_glCheckFramebufferStatus = Null_CheckFramebufferStatus;
+	glad_glDebugMessageCallback = Null_DebugMessageCallback;
+	glad_glGetString = Null_GetString;
+	glad_glGetStringi = Null_GetStringi;
+	glad_glGetIntegerv = Null_GetIntegerv;
+	glad_glReadPixels = Null_ReadPixels;
+
+	//Not part of glad. Left out so the draw ring isn't mapped.
+	dglBufferStorage = nullptr;
+
+	memset(&Null_frame, 0, sizeof(Null_frame));
+	memset(&Null_last_frame, 0, sizeof(Null_last_frame));
+}
+
+//Called at the end of each frame by rend_Flip
+void GL_NullEndFrame(void)
+{
+	RTP_COUNTER(null_draw_calls, Null_frame.draw_calls);
+	RTP_COUNTER(null_state_changes, Null_frame.state_changes);
+	RTP_COUNTER(null_upload_bytes, Null_frame.upload_bytes);
+
+	Null_last_frame = Null_frame;
+	memset(&Null_frame, 0, sizeof(Null_frame));
+}
+
+bool rend_GetCallStatistics(tRendererCallStats* stats)
+{
+	if (!OpenGL_null)
+	{
+		memset(stats, 0, sizeof(tRendererCallStats));
+		return false;
+	}
+
+	*stats = Null_last_frame;
+	return true;
+}
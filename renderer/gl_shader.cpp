@@ -17,7 +17,7 @@
 */
 #include <string.h>
 #include <string>
-#include "gl_shader.h"
+#include "gl_local.h"
 #include "pserror.h"
 
 GLuint commonbuffername;
@@ -53,6 +53,7 @@ void rend_UpdateCommon(float* projection, float* modelview)
 	memcpy(newblock.projection, projection, sizeof(newblock.projection));
 	memcpy(newblock.modelview, modelview, sizeof(newblock.modelview));
 
+	GL_FlushDraws();
 	glBindBuffer(GL_COPY_WRITE_BUFFER, commonbuffername);
 	glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(CommonBlock), &newblock);
 
@@ -67,6 +68,7 @@ void GL_UpdateLegacyBlock(float* projection, float* modelview)
 	memcpy(newblock.projection, projection, sizeof(newblock.projection));
 	memcpy(newblock.modelview, modelview, sizeof(newblock.modelview));
 
+	GL_FlushDraws();
 	glBindBuffer(GL_COPY_WRITE_BUFFER, legacycommonbuffername);
 	glBufferSubData(GL_COPY_WRITE_BUFFER, 0, sizeof(CommonBlock), &newblock);
 
@@ -154,4 +154,72 @@ const char* genericFragBody =
 "		color = outcolor;\n"
 "	#endif\n"
 "}\n"
-"";
\ No newline at end of file
+"";
+//Draws the instances queued by rend_QueueModelInstance. Each instance is a run of texels in instancedata:
+//the light direction (w is 0 when the model is statically lit), the tint and alpha scale, then
+//three matrix rows for every submodel that take it into world space.
+const char* modelVertexSrc =
+"#version 330 core\n"
+"\n"
+"layout(std140) uniform CommonBlock\n"
+"{\n"
+"	mat4 projection;\n"
+"	mat4 modelview;\n"
+"} commons;\n"
+"\n"
+"uniform samplerBuffer instancedata;\n"
+"uniform int instancebase;\n"
+"uniform int instancesize;\n"
+"\n"
+"layout(location = 0) in vec3 position;\n"
+"layout(location = 1) in vec3 normal;\n"
+"layout(location = 2) in vec2 uv;\n"
+"layout(location = 3) in float alpha;\n"
+"layout(location = 4) in ivec2 submodel_fullbright;\n"
+"\n"
+"out vec2 outuv;\n"
+"out vec4 outcolor;\n"
+"\n"
+"void main()\n"
+"{\n"
+"	int base = instancebase + gl_InstanceID * instancesize;\n"
+"	vec4 light = texelFetch(instancedata, base);\n"
+"	vec4 tint = texelFetch(instancedata, base + 1);\n"
+"	int pose = base + 2 + submodel_fullbright.x * 3;\n"
+"	vec4 row0 = texelFetch(instancedata, pose);\n"
+"	vec4 row1 = texelFetch(instancedata, pose + 1);\n"
+"	vec4 row2 = texelFetch(instancedata, pose + 2);\n"
+"\n"
+"	vec4 local = vec4(position, 1.0);\n"
+"	vec3 world = vec3(dot(row0, local), dot(row1, local), dot(row2, local));\n"
+"	vec3 worldnormal = vec3(dot(row0.xyz, normal), dot(row1.xyz, normal), dot(row2.xyz, normal));\n"
+"\n"
+"	float val = light.w != 0.0 ? (1.0 - dot(light.xyz, worldnormal)) * 0.5 : 1.0;\n"
+"	if (submodel_fullbright.y != 0)\n"
+"		outcolor = vec4(1.0, 1.0, 1.0, alpha * tint.a);\n"
+"	else\n"
+"		outcolor = vec4(tint.rgb * val, alpha * tint.a);\n"
+"	outuv = uv;\n"
+"\n"
+"	vec4 temp = commons.modelview * vec4(world, 1.0);\n"
+"	gl_Position = commons.projection * vec4(temp.xy, -temp.z, temp.w);\n"
+"	//Write the same depth as the polygons rend_DrawPolygon3D draws, 1 - 1/z\n"
+"	gl_Position.z = gl_Position.w - 2.0;\n"
+"}\n"
+"";
+
+const char* modelFragmentSrc =
+"#version 330 core\n"
+"\n"
+"uniform sampler2D colortexture;\n"
+"\n"
+"in vec2 outuv;\n"
+"in vec4 outcolor;\n"
+"\n"
+"out vec4 color;\n"
+"\n"
+"void main()\n"
+"{\n"
+"	color = texture(colortexture, outuv) * outcolor;\n"
+"}\n"
+"";
@@ -69,6 +69,10 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
+#if !defined(WIN32) && !defined(MACINTOSH)
+#include <chrono>
+#endif
 
 
 float rtp_startlog_time;
@@ -87,6 +91,7 @@ unsigned char Runtime_performance_enabled = 0;
 tRTFrameInfo RTP_SingleFrame;
 #ifdef USE_RTP
 tRTFrameInfo RTP_FrameBuffer[MAX_RTP_SAMPLES];
+static INT64 Runtime_performance_frame_start = 0;
 #endif
 
 
@@ -104,7 +109,7 @@ void rtp_WriteBufferLog(void)
 	unsigned int counter;
 	char buffer[4096];
 
-	Num_frames = min(Runtime_performance_counter,MAX_RTP_SAMPLES);
+	Num_frames = std::min(Runtime_performance_counter,(unsigned int)MAX_RTP_SAMPLES);
 
 	// Open the log file for writing
 	ddio_MakePath(buffer,User_directory,"D3Performance.txt",NULL);	
@@ -189,7 +194,7 @@ void rtp_WriteBufferLog(void)
 				processkeys_time,fi->texture_uploads,fi->polys_drawn,ct_flying_time,ct_aidoframe_time,ct_weaponframe_time,
 				ct_explosionframe_time,ct_debrisframe_time,ct_splinterframe_time,mt_physicsframe_time,mt_walkingframe_time,
 				mt_shockwave_time,obj_doeffect_time,obj_move_player_time,obj_d3xint_time,obj_objlight_time,normalevent_time,cycle_anim,
-				vis_eff_move,phys_link,obj_do_frm,fi->fvi_calls,fi->fvi_time);
+				vis_eff_move,phys_link,obj_do_frm,fi->fvi_calls,fvi_time);
 			
 			
 			cf_WriteString(file,buffer);
@@ -213,6 +218,9 @@ void rtp_RecordFrame(void)
 	if ( Runtime_performance_enabled ){
 		//	do our saving of information
 		// --------------------------------
+		INT64 frame_end = rtp_GetClock();
+		rtp_ZonesRecordFrame(Runtime_performance_frame_start,frame_end);
+		Runtime_performance_frame_start = frame_end;
 
 		RTP_SingleFrame.frame_num = Runtime_performance_frame_counter;	//save the frame num
 
@@ -253,8 +261,10 @@ void rtp_Init(void)
 	Runtime_performance_counter = 0;
 	Runtime_performance_enabled = 0;
 
-	#ifdef MACINTOSH
+	#if defined(MACINTOSH)
 		Runtime_performance_clockfreq = 1000000;	//micoseconds
+	#elif !defined(WIN32)
+		Runtime_performance_clockfreq = std::chrono::steady_clock::period::den / std::chrono::steady_clock::period::num;
 	#else
 	LARGE_INTEGER freq;
 	if(!QueryPerformanceFrequency(&freq)) {
@@ -320,6 +330,8 @@ void rtp_StartLog(void)
 	Runtime_performance_enabled = 1;
 	memset(&RTP_SingleFrame,0,sizeof(tRTFrameInfo));
 	rtp_startlog_time = timer_GetTime();
+	rtp_ZonesStartLog();
+	Runtime_performance_frame_start = rtp_GetClock();
 #endif
 }
 
@@ -338,6 +350,7 @@ void rtp_StopLog(void)
 	rtp_WriteBufferLog();
 
 	Runtime_performance_enabled = 0;
+	rtp_ZonesStopLog();
 #endif
 }
 
@@ -362,6 +375,7 @@ void rtp_ResumeLog(void)
 #ifdef USE_RTP
 	mprintf((0,"RTP: Resuming Log\n"));
 	Runtime_performance_enabled = 1;
+	Runtime_performance_frame_start = rtp_GetClock();
 #endif
 }
 
@@ -380,6 +394,8 @@ INT64 rtp_GetClock(void)
 		// Get the current time in microseconds
 		Microseconds((UnsignedWide*)(&currentTimeUI));
 		return currentTimeUI;
+	#elif !defined(WIN32)
+		return (INT64)std::chrono::steady_clock::now().time_since_epoch().count();
 	#else
 		LARGE_INTEGER t;
 		QueryPerformanceCounter(&t);
@@ -0,0 +1,450 @@
+/*
+* Descent 3
+* Copyright (C) 2024 Parallax Software
+*
+* This program is free software: you can redistribute it and/or modify
+* it under the terms of the GNU General Public License as published by
+* the Free Software Foundation, either version 3 of the License, or
+* (at your option) any later version.
+*
+* This program is distributed in the hope that it will be useful,
+* but WITHOUT ANY WARRANTY; without even the implied warranty of
+* MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+* GNU General Public License for more details.
+*
+* You should have received a copy of the GNU General Public License
+* along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// Run time performance zones and counters.  See rtperformance.h
+
+#include "rtperformance.h"
+#include "pstypes.h"
+#include "mono.h"
+#include "descent.h"
+#include "ddio.h"
+#include "CFILE.H"
+
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+
+#ifdef USE_RTP
+
+#define RTP_MAX_THREADS		32
+#define RTP_RING_SIZE		65536		// events per thread, must be a power of 2
+#define RTP_MAX_DEPTH		64			// deepest zone nesting that gets timed
+
+enum {RTPE_BEGIN,RTPE_END,RTPE_COUNTER};
+
+typedef struct{
+	INT64 time;
+	short zone;
+	short type;
+	int value;
+}tRTEvent;
+
+// A thread's events.  The thread is the only writer of events and head, rtp_ZonesRecordFrame
+// the only reader and writer of tail and everything below it
+typedef struct{
+	tRTEvent events[RTP_RING_SIZE];
+	std::atomic<unsigned int> head,tail;
+	std::atomic<unsigned int> dropped;
+	std::atomic<bool> exited;		// the thread is gone, the ring can be reused once it's drained
+	int tid;
+
+	unsigned int last_dropped;
+	int depth;
+	short open_zone[RTP_MAX_DEPTH];
+	INT64 open_time[RTP_MAX_DEPTH];
+}tRTRing;
+
+typedef struct{
+	const char *name;
+	int is_counter;
+	INT64 frame_total;
+	int frame_hits;
+	float history[RTP_ZONE_HISTORY];
+	int num_history,next_history;
+}tRTZone;
+
+static tRTZone RTP_zones[RTP_MAX_ZONES];
+static std::atomic<int> RTP_num_zones(0);
+static std::mutex RTP_zone_lock;
+
+static std::atomic<tRTRing *> RTP_rings[RTP_MAX_THREADS];
+static std::atomic<int> RTP_num_rings(0);
+static thread_local tRTRing *RTP_this_ring = NULL;
+static thread_local bool RTP_no_ring = false;
+
+// Hands the ring back when its thread exits
+struct tRTRingOwner{
+	~tRTRingOwner() { if(RTP_this_ring) RTP_this_ring->exited.store(true); }
+};
+static thread_local tRTRingOwner RTP_ring_owner;
+
+static CFILE *RTP_trace = NULL;
+static bool RTP_trace_first;
+static INT64 RTP_trace_start;
+
+/*
+int rtp_RegisterZone
+	Returns the id of the zone (or counter if is_counter) called name, adding it if it's new.
+	name must stay valid for the life of the program.  Returns -1 if there are too many zones
+*/
+int rtp_RegisterZone(const char *name,int is_counter)
+{
+	std::lock_guard<std::mutex> lock(RTP_zone_lock);
+
+	int num_zones = RTP_num_zones.load();
+	for(int i=0;i<num_zones;i++){
+		// the same name can be a different string in each file that uses it
+		if(RTP_zones[i].is_counter==is_counter && !strcmp(RTP_zones[i].name,name))
+			return i;
+	}
+
+	if(num_zones==RTP_MAX_ZONES){
+		mprintf((0,"RTP: Out of zones, not timing %s\n",name));
+		return -1;
+	}
+
+	memset(&RTP_zones[num_zones],0,sizeof(tRTZone));
+	RTP_zones[num_zones].name = name;
+	RTP_zones[num_zones].is_counter = is_counter;
+	RTP_num_zones.store(num_zones+1);
+	return num_zones;
+}
+
+// Returns this thread's ring, making it the first time the thread records anything
+static tRTRing *rtp_GetRing(void)
+{
+	if(RTP_this_ring || RTP_no_ring)
+		return RTP_this_ring;
+
+	(void)&RTP_ring_owner;	// make sure this thread's owner is constructed
+
+	// take over the ring of a thread that has finished, once its events have been read
+	int num_rings = std::min(RTP_num_rings.load(),RTP_MAX_THREADS);
+	for(int i=0;i<num_rings;i++){
+		tRTRing *ring = RTP_rings[i].load();
+		bool exited = true;
+		if(ring && ring->tail.load()==ring->head.load() && ring->exited.compare_exchange_strong(exited,false)){
+			RTP_this_ring = ring;
+			return ring;
+		}
+	}
+
+	int slot = RTP_num_rings.fetch_add(1);
+	if(slot>=RTP_MAX_THREADS){
+		RTP_no_ring = true;
+		return NULL;
+	}
+
+	// rings are never freed, a new thread gets the ring of a finished one instead
+	tRTRing *ring = new tRTRing;
+	ring->head = ring->tail = ring->dropped = 0;
+	ring->exited = false;
+	ring->last_dropped = 0;
+	ring->depth = 0;
+	ring->tid = slot+1;
+
+	RTP_this_ring = ring;
+	RTP_rings[slot].store(ring);
+	return ring;
+}
+
+static void rtp_PushEvent(int type,int zone,INT64 time,int value)
+{
+	if(zone<0)
+		return;
+
+	tRTRing *ring = rtp_GetRing();
+	if(!ring)
+		return;
+
+	unsigned int head = ring->head.load(std::memory_order_relaxed);
+	if(head - ring->tail.load(std::memory_order_acquire) >= RTP_RING_SIZE){
+		ring->dropped.fetch_add(1,std::memory_order_relaxed);
+		return;
+	}
+
+	tRTEvent *ev = &ring->events[head & (RTP_RING_SIZE-1)];
+	ev->time = time;
+	ev->zone = zone;
+	ev->type = type;
+	ev->value = value;
+	ring->head.store(head+1,std::memory_order_release);
+}
+
+/*
+void rtp_BeginZone / rtp_EndZone
+	Starts / ends the zone at the given clock time on this thread.  A zone that couldn't be
+	registered (-1) records neither, so its end can't close the zone around it
+*/
+void rtp_BeginZone(int zone,INT64 time)
+{
+	rtp_PushEvent(RTPE_BEGIN,zone,time,0);
+}
+
+void rtp_EndZone(int zone,INT64 time)
+{
+	rtp_PushEvent(RTPE_END,zone,time,0);
+}
+
+/*
+void rtp_AddCounter
+	Adds amount to the counter for this frame
+*/
+void rtp_AddCounter(int counter,int amount)
+{
+	rtp_PushEvent(RTPE_COUNTER,counter,0,amount);
+}
+
+/*
+int rtp_GetNumZones
+	Returns how many zones and counters have been registered, their ids are 0 to this - 1
+*/
+int rtp_GetNumZones(void)
+{
+	return RTP_num_zones.load();
+}
+
+// Returns clock time t in microseconds since the trace started
+static double rtp_TraceTime(INT64 t)
+{
+	return (double)(t - RTP_trace_start) * 1000000.0 / (double)Runtime_performance_clockfreq;
+}
+
+static void rtp_TraceSeparator(void)
+{
+	if(!RTP_trace_first)
+		cf_WriteBytes((const ubyte *)",\n",2,RTP_trace);
+	RTP_trace_first = false;
+}
+
+// Reads everything one thread has recorded since the last frame
+static void rtp_DrainRing(tRTRing *ring)
+{
+	unsigned int tail = ring->tail.load(std::memory_order_relaxed);
+	unsigned int head = ring->head.load(std::memory_order_acquire);
+
+	for(;tail!=head;tail++){
+		tRTEvent *ev = &ring->events[tail & (RTP_RING_SIZE-1)];
+
+		switch(ev->type){
+		case RTPE_BEGIN:
+			if(ring->depth<RTP_MAX_DEPTH){
+				ring->open_zone[ring->depth] = ev->zone;
+				ring->open_time[ring->depth] = ev->time;
+			}
+			ring->depth++;
+			break;
+
+		case RTPE_END:
+			if(ring->depth==0)
+				break;	// started before the log was
+			if(ring->depth<=RTP_MAX_DEPTH && ring->open_zone[ring->depth-1]!=ev->zone)
+				break;	// started before the log was, inside a zone that's still open
+			ring->depth--;
+			if(ring->depth<RTP_MAX_DEPTH){
+				tRTZone *zone = &RTP_zones[ring->open_zone[ring->depth]];
+				INT64 start = ring->open_time[ring->depth];
+
+				zone->frame_total += ev->time - start;
+				zone->frame_hits++;
+
+				if(RTP_trace){
+					rtp_TraceSeparator();
+					cfprintf(RTP_trace,"{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+						zone->name,ring->tid,rtp_TraceTime(start),rtp_TraceTime(ev->time)-rtp_TraceTime(start));
+				}
+			}
+			break;
+
+		case RTPE_COUNTER:
+			RTP_zones[ev->zone].frame_total += ev->value;
+			RTP_zones[ev->zone].frame_hits++;
+			break;
+		}
+	}
+
+	ring->tail.store(tail,std::memory_order_release);
+
+	// a dropped begin or end would pair up the wrong zones from here on, so start over
+	unsigned int dropped = ring->dropped.load(std::memory_order_relaxed);
+	if(dropped!=ring->last_dropped){
+		mprintf((0,"RTP: Thread %d dropped %d events\n",ring->tid,dropped-ring->last_dropped));
+		ring->last_dropped = dropped;
+		ring->depth = 0;
+	}
+}
+
+/*
+void rtp_ZonesRecordFrame
+	Drains every thread's ring and adds the totals of the frame to the history of each zone
+*/
+void rtp_ZonesRecordFrame(INT64 frame_start,INT64 frame_end)
+{
+	static int frame_zone = rtp_RegisterZone("frame",0);
+
+	int num_rings = std::min(RTP_num_rings.load(),RTP_MAX_THREADS);
+	for(int i=0;i<num_rings;i++){
+		tRTRing *ring = RTP_rings[i].load();
+		if(ring)
+			rtp_DrainRing(ring);
+	}
+
+	if(frame_zone>=0 && frame_start){
+		RTP_zones[frame_zone].frame_total += frame_end - frame_start;
+		RTP_zones[frame_zone].frame_hits++;
+	}
+
+	int num_zones = RTP_num_zones.load();
+	for(int i=0;i<num_zones;i++){
+		tRTZone *zone = &RTP_zones[i];
+		if(!zone->frame_hits)
+			continue;
+
+		float value;
+		if(zone->is_counter){
+			value = (float)zone->frame_total;
+			if(RTP_trace){
+				rtp_TraceSeparator();
+				cfprintf(RTP_trace,"{\"name\":\"%s\",\"ph\":\"C\",\"pid\":1,\"ts\":%.3f,\"args\":{\"value\":%d}}",
+					zone->name,rtp_TraceTime(frame_end),(int)zone->frame_total);
+			}
+		}else
+			value = (float)((double)zone->frame_total * 1000.0 / (double)Runtime_performance_clockfreq);
+
+		zone->history[zone->next_history] = value;
+		zone->next_history = (zone->next_history+1) % RTP_ZONE_HISTORY;
+		if(zone->num_history<RTP_ZONE_HISTORY)
+			zone->num_history++;
+
+		zone->frame_total = 0;
+		zone->frame_hits = 0;
+	}
+}
+
+/*
+bool rtp_GetZoneStats
+	Fills in the percentiles of the per frame totals of a zone or counter over the last
+	RTP_ZONE_HISTORY frames it was active in.  Returns false if it has no history yet
+*/
+bool rtp_GetZoneStats(int zone,tRTZoneStats *stats)
+{
+	if(zone<0 || zone>=RTP_num_zones.load())
+		return false;
+
+	tRTZone *z = &RTP_zones[zone];
+	stats->name = z->name;
+	stats->is_counter = z->is_counter;
+	stats->num_frames = z->num_history;
+	if(!z->num_history)
+		return false;
+
+	float sorted[RTP_ZONE_HISTORY];
+	int n = z->num_history;
+	memcpy(sorted,z->history,n*sizeof(float));
+	std::sort(sorted,sorted+n);
+
+	stats->p50 = sorted[(n-1)*50/100];
+	stats->p90 = sorted[(n-1)*90/100];
+	stats->p99 = sorted[(n-1)*99/100];
+	stats->max = sorted[n-1];
+	return true;
+}
+
+/*
+void rtp_ZonesStartLog
+	Clears the zone history and opens the trace
+*/
+void rtp_ZonesStartLog(void)
+{
+	char path[_MAX_PATH];
+
+	// finish the old log first, its stats are written from the history cleared below
+	if(RTP_trace)
+		rtp_ZonesStopLog();
+
+	// throw away whatever was recorded while the log wasn't running
+	int num_rings = std::min(RTP_num_rings.load(),RTP_MAX_THREADS);
+	for(int i=0;i<num_rings;i++){
+		tRTRing *ring = RTP_rings[i].load();
+		if(ring){
+			ring->tail.store(ring->head.load(std::memory_order_acquire),std::memory_order_release);
+			ring->depth = 0;
+		}
+	}
+
+	int num_zones = RTP_num_zones.load();
+	for(int i=0;i<num_zones;i++){
+		RTP_zones[i].frame_total = 0;
+		RTP_zones[i].frame_hits = 0;
+		RTP_zones[i].num_history = 0;
+		RTP_zones[i].next_history = 0;
+	}
+
+	ddio_MakePath(path,User_directory,"D3Trace.json",NULL);
+	RTP_trace = cfopen(path,"wt");
+	if(!RTP_trace){
+		mprintf((0,"RTP: Unable to open trace for writing\n"));
+		return;
+	}
+
+	RTP_trace_first = true;
+	RTP_trace_start = rtp_GetClock();
+	cf_WriteString(RTP_trace,"[");
+	rtp_TraceSeparator();
+	cfprintf(RTP_trace,"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Descent 3\"}}");
+}
+
+/*
+void rtp_ZonesStopLog
+	Closes the trace and writes the percentiles of every zone and counter to D3Zones.txt
+*/
+void rtp_ZonesStopLog(void)
+{
+	char path[_MAX_PATH];
+
+	if(RTP_trace){
+		cf_WriteString(RTP_trace,"\n]");
+		cfclose(RTP_trace);
+		RTP_trace = NULL;
+	}
+
+	ddio_MakePath(path,User_directory,"D3Zones.txt",NULL);
+	CFILE *file = cfopen(path,"wt");
+	if(!file){
+		mprintf((0,"RTP: Unable to open zone stats for writing\n"));
+		return;
+	}
+
+	cf_WriteString(file,"Zone,Frames,P50,P90,P99,Max  (zones in ms per frame, counters per frame)");
+
+	int num_zones = RTP_num_zones.load();
+	for(int i=0;i<num_zones;i++){
+		tRTZoneStats stats;
+		if(!rtp_GetZoneStats(i,&stats))
+			continue;
+		cfprintf(file,"%s%s,%d,%f,%f,%f,%f\n",stats.is_counter?"#":"",stats.name,stats.num_frames,stats.p50,stats.p90,stats.p99,stats.max);
+	}
+
+	cfclose(file);
+}
+
+#else
+
+int rtp_RegisterZone(const char *name,int is_counter) {return -1;}
+void rtp_BeginZone(int zone,INT64 time) {}
+void rtp_EndZone(int zone,INT64 time) {}
+void rtp_AddCounter(int counter,int amount) {}
+int rtp_GetNumZones(void) {return 0;}
+bool rtp_GetZoneStats(int zone,tRTZoneStats *stats) {return false;}
+void rtp_ZonesStartLog(void) {}
+void rtp_ZonesRecordFrame(INT64 frame_start,INT64 frame_end) {}
+void rtp_ZonesStopLog(void) {}
+
+#endif
@@ -254,6 +254,8 @@
 
 int Num_sounds = 0;
 int Num_sound_files = 0;
+tNameIndex<MAX_SOUNDS> Sound_names(Sounds[0].name, sizeof(sound_info));
+tNameIndex<MAX_SOUND_FILES> Sound_file_names(SoundFiles[0].name, sizeof(sound_file_info));
 
 char *Static_sound_names[NUM_STATIC_SOUNDS] = {
 										TBL_SOUND("Default"),						//0	SOUND_NONE_INDEX				
@@ -315,6 +317,7 @@ int AllocSoundFile ()
 		if (SoundFiles[i].used == 0)
 		{
 			memset(&SoundFiles[i], 0, sizeof(sound_file_info));
+			Sound_file_names.update(i);
 			SoundFiles[i].used=1;
 			
 			Num_sound_files++;
@@ -333,6 +336,7 @@ void FreeSoundFile (int n)
 
 	SoundFiles[n].used = 0;
 	SoundFiles[n].name[0] = 0;
+	Sound_file_names.update(n);
 	if(SoundFiles[n].sample_8bit)
 	{
 		GlobalFree(SoundFiles[n].sample_8bit);
@@ -397,15 +401,9 @@ int GetPrevSoundFile (int n)
 // or index of sound with name
 int FindSoundFileName (char *name)
 {
-	int i;
-
 	ASSERT (name!=NULL);
 
-	for (i=0;i<MAX_SOUND_FILES;i++)
-		if (SoundFiles[i].used && !stricmp (name,SoundFiles[i].name))
-			return i;
-
-	return -1;
+	return Sound_file_names.find (name);
 }
 
 // gets the filename from a path, plus appends our .wav extension
@@ -458,6 +456,7 @@ int LoadSoundFile (char *filename, float import_volume, bool f_get_data)
 	}
 
 	strcpy(SoundFiles[sound_file_index].name, name);
+	Sound_file_names.update(sound_file_index);
 
 	// Load the file by its type (as defined by the extension)
 	strncpy (extension,&filename[len-3], 5);
@@ -492,6 +491,7 @@ void InitSounds ()
 		Sounds[i].name[0] = 0;
 		Sounds[i].flags = 0;
 	}
+	Sound_names.clear();
 	Num_sounds = 0;
 
 	for (i = 0;i<MAX_SOUND_FILES;i++)
@@ -499,6 +499,7 @@ void InitSounds ()
 		SoundFiles[i].name[0] = 0;
 		SoundFiles[i].used = 0;
 	}
+	Sound_file_names.clear();
 	Num_sound_files = 0;
 }
 
@@ -511,6 +512,7 @@ int AllocSound ()
 		if (Sounds[i].used==0)
 		{
 			memset(&Sounds[i], 0, sizeof(sound_info));
+			Sound_names.update(i);
 
 			Sounds[i].min_distance = 10.0;
 			Sounds[i].max_distance = 256.0;
@@ -538,6 +540,7 @@ void FreeSound (int n)
 
 	Sounds[n].used = 0;
 	Sounds[n].name[0] = 0;
+	Sound_names.update(n);
 	Sounds[n].flags = 0;
 	Num_sounds--;
 }
@@ -593,15 +596,9 @@ int GetPrevSound (int n)
 // or index of sound with name
 int FindSoundName (char *name)
 {
-	int i;
-
 	ASSERT (name!=NULL);
 
-	for (i=0;i<MAX_SOUNDS;i++)
-		if (Sounds[i].used && !stricmp (name,Sounds[i].name))
-			return i;
-
-	return -1;
+	return Sound_names.find (name);
 }
 
 // Given a filename, loads the sound.
@@ -632,6 +629,8 @@ void RemapSounds()
 				sound_info tsound = Sounds[i];
 				Sounds[i] = Sounds[cur_index];
 				Sounds[cur_index] = tsound;
+				Sound_names.update(i);
+				Sound_names.update(cur_index);
 				RemapAllSoundObjects(i,MAX_SOUNDS);
 				RemapAllSoundObjects(cur_index,i);
 				RemapAllSoundObjects(MAX_SOUNDS,cur_index);
@@ -639,6 +638,9 @@ void RemapSounds()
 			else {	//slot is unused, so just take it
 				Sounds[i] = Sounds[cur_index];
 				Sounds[cur_index].used = 0;
+				Sounds[cur_index].name[0] = 0;
+				Sound_names.update(i);
+				Sound_names.update(cur_index);
 				RemapAllSoundObjects(cur_index,i);
 			}
 		}